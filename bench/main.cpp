@@ -0,0 +1,612 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+#include "win32clipboard/backend.h"
+#include "win32clipboard/faultbackend.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/stats.h"
+#include "win32clipboard/version.h"
+
+#include "target.h"
+#include "report.h"
+
+using namespace win32clipboard;
+using namespace win32clipboard::bench;
+
+struct Options
+{
+  std::string backend;
+  std::string file;
+  std::string shm;
+  std::string filter;
+  std::string json;
+  std::string baseline;
+  double threshold;     //percent
+  size_t iterations;    //maximum number of operations of a scenario
+  size_t max_size;      //largest binary value
+  size_t max_files;     //largest list of files
+  size_t max_threads;   //largest number of concurrent readers
+  bool faults;          //true if faults are injected in the backend
+  FaultOptions fault_options;
+};
+
+typedef std::function<bool()> Operation;
+
+//Scenarios stop after this many bytes, which bounds the duration of the large values
+static const uint64_t SCENARIO_BYTES_BUDGET = 1024ull*1024*1024;
+
+static void printUsage()
+{
+  printf(
+    "win32clipboard %s - clipboard benchmark\n"
+    "\n"
+    "Usage: win32clipboard_bench [options]\n"
+    "\n"
+    "Options:\n"
+    "  --backend <name>     win32, memory, file or shm (Linux only). Default is memory.\n"
+    "  --file <path>        File of the file backend. Default is win32clipboard_bench.clip in the current directory.\n"
+    "  --shm <name>         Shared memory segment of the shm backend. Default is /win32clipboard_bench.\n"
+    "  --filter <text>      Only run the scenarios whose name contains the given text.\n"
+    "  --iterations <n>     Maximum number of operations of each scenario. Default is 200.\n"
+    "  --max-size <bytes>   Largest binary value. Default is 67108864, up to 1073741824.\n"
+    "  --max-files <n>      Largest list of drag and drop files. Default is 100000.\n"
+    "  --threads <n>        Largest number of concurrent readers. Default is 4.\n"
+    "  --json <path>        Write the results to the given JSON file.\n"
+    "  --baseline <path>    Compare the results with a JSON file written by a previous run.\n"
+    "  --threshold <pct>    Slowdown of the p50 or p99 latency reported as a regression. Default is 10.\n"
+    "\n"
+    "Fault injection (memory, file and shm backends):\n"
+    "  --seed <n>                 Seed of the injected faults. Default is 0.\n"
+    "  --open-failure-rate <p>    Probability that an attempt to open the clipboard fails, between 0 and 1.\n"
+    "  --open-attempts <n>        Attempts to open the clipboard before an operation fails. Default is 5.\n"
+    "  --retry-delay <us>         Delay between two attempts to open the clipboard. Default is 50000.\n"
+    "  --hold-time <us>           The clipboard is held opened for a random time up to this value.\n"
+    "  --slow-alloc-rate <p>      Probability that the allocation of a written format is slow.\n"
+    "  --slow-alloc-time <us>     Duration of a slow allocation.\n"
+    "  --partial-write-rate <p>   Probability that a write fails after storing part of the formats.\n"
+    "\n"
+    "Returns 1 if an operation failed or if a scenario regressed compared to the baseline.\n"
+    "Operations that fail because of the injected faults are reported but are not errors.\n",
+    WIN32CLIPBOARD_VERSION);
+}
+
+static bool parseOptions(int argc, char ** argv, Options & options)
+{
+  options.backend = "memory";
+  options.file = "win32clipboard_bench.clip";
+  options.shm = "/win32clipboard_bench";
+  options.threshold = 10.0;
+  options.iterations = 200;
+  options.max_size = 64*1024*1024;
+  options.max_files = 100000;
+  options.max_threads = 4;
+  options.faults = false;
+
+  for(int i=1; i<argc; i++)
+  {
+    const std::string name = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const std::string value = argv[++i];
+
+    if (name == "--backend")
+      options.backend = value;
+    else if (name == "--file")
+      options.file = value;
+    else if (name == "--shm")
+      options.shm = value;
+    else if (name == "--filter")
+      options.filter = value;
+    else if (name == "--iterations")
+      options.iterations = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--max-size")
+      options.max_size = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--max-files")
+      options.max_files = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--threads")
+      options.max_threads = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--json")
+      options.json = value;
+    else if (name == "--baseline")
+      options.baseline = value;
+    else if (name == "--threshold")
+      options.threshold = strtod(value.c_str(), NULL);
+    else if (name == "--seed")
+      options.fault_options.seed = strtoull(value.c_str(), NULL, 10);
+    else if (name == "--open-failure-rate")
+      options.fault_options.open_failure_rate = strtod(value.c_str(), NULL);
+    else if (name == "--open-attempts")
+      options.fault_options.open_attempts = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--retry-delay")
+      options.fault_options.open_retry_delay_us = (uint32_t)strtoul(value.c_str(), NULL, 10);
+    else if (name == "--hold-time")
+      options.fault_options.max_hold_time_us = (uint32_t)strtoul(value.c_str(), NULL, 10);
+    else if (name == "--slow-alloc-rate")
+      options.fault_options.slow_alloc_rate = strtod(value.c_str(), NULL);
+    else if (name == "--slow-alloc-time")
+      options.fault_options.slow_alloc_time_us = (uint32_t)strtoul(value.c_str(), NULL, 10);
+    else if (name == "--partial-write-rate")
+      options.fault_options.partial_write_rate = strtod(value.c_str(), NULL);
+    else
+      return false;
+
+    if (name == "--open-failure-rate" || name == "--open-attempts" || name == "--retry-delay" ||
+        name == "--hold-time" || name == "--slow-alloc-rate" || name == "--slow-alloc-time" || name == "--partial-write-rate")
+      options.faults = true;
+  }
+  return options.iterations > 0;
+}
+
+static std::string formatSize(uint64_t size)
+{
+  const char * units[] = { "B", "KiB", "MiB", "GiB" };
+  size_t unit = 0;
+  while (unit + 1 < sizeof(units)/sizeof(units[0]) && size >= 1024 && size % 1024 == 0)
+  {
+    size /= 1024;
+    unit++;
+  }
+  char buffer[64];
+  sprintf(buffer, "%llu%s", (unsigned long long)size, units[unit]);
+  return buffer;
+}
+
+static std::string formatCount(uint64_t count)
+{
+  char buffer[64];
+  sprintf(buffer, "%llu", (unsigned long long)count);
+  return buffer;
+}
+
+//Lines of printable text, like a copied document
+static std::string generateText(size_t size)
+{
+  static const char LINE[] = "The quick brown fox jumps over the lazy dog 0123456789.\r\n";
+  std::string text;
+  text.reserve(size);
+  while (text.size() < size)
+    text.append(LINE, std::min(sizeof(LINE) - 1, size - text.size()));
+  return text;
+}
+
+static std::string generateBinary(size_t size)
+{
+  std::string data(size, '\0');
+  uint32_t state = 0x12345678;
+  for(size_t i=0; i<size; i++)
+  {
+    state = state * 1664525 + 1013904223;
+    data[i] = (char)(state >> 24);
+  }
+  return data;
+}
+
+static Target::StringVector generateFiles(size_t count)
+{
+  Target::StringVector files(count);
+  char buffer[128];
+  for(size_t i=0; i<count; i++)
+  {
+    sprintf(buffer, "C:\\Users\\bench\\Documents\\project %04u\\file_%08u.txt", (unsigned)(i / 1000), (unsigned)i);
+    files[i] = buffer;
+  }
+  return files;
+}
+
+static size_t getIterations(const Options & options, uint64_t bytes)
+{
+  size_t iterations = options.iterations;
+  if (bytes > 0 && SCENARIO_BYTES_BUDGET / bytes < iterations)
+    iterations = (size_t)(SCENARIO_BYTES_BUDGET / bytes);
+  return iterations < 3 ? 3 : iterations;
+}
+
+static void printHeader()
+{
+  printf("%-32s %10s %12s %12s %12s %12s %12s %8s\n", "scenario", "count", "p50 (us)", "p99 (us)", "p999 (us)", "max (us)", "MiB/s", "failed");
+}
+
+static void printResult(const Result & r)
+{
+  printf("%-32s %10llu %12.1f %12.1f %12.1f %12.1f %12.1f %8llu\n",
+    r.name.c_str(),
+    (unsigned long long)r.iterations,
+    r.p50_ns / 1000.0,
+    r.p99_ns / 1000.0,
+    r.p999_ns / 1000.0,
+    r.max_ns / 1000.0,
+    r.throughput,
+    (unsigned long long)r.failures);
+  fflush(stdout);
+}
+
+class Runner
+{
+public:
+  Runner(const Options & iOptions, Report & iReport) : mOptions(iOptions), mReport(iReport) {}
+
+  bool isSelected(const std::string & name) const
+  {
+    return mOptions.filter.empty() || name.find(mOptions.filter) != std::string::npos;
+  }
+
+  //Run an operation repeatedly and record the duration of each run. The first run is a warmup.
+  void run(const std::string & name, uint64_t bytes, const Operation & operation)
+  {
+    if (!isSelected(name))
+      return;
+
+    Result result;
+    result.name = name;
+    result.bytes = bytes;
+    result.failures = operation() ? 0 : 1;
+
+    const size_t iterations = getIterations(mOptions, bytes);
+    std::vector<uint64_t> samples;
+    samples.reserve(iterations);
+    const uint64_t start = StatsRecorder::GetTimestamp();
+    for(size_t i=0; i<iterations; i++)
+    {
+      const uint64_t begin = StatsRecorder::GetTimestamp();
+      if (!operation())
+        result.failures++;
+      samples.push_back(StatsRecorder::GetTimestamp() - begin);
+    }
+    summarize_samples(samples, StatsRecorder::GetTimestamp() - start, result);
+    add(result);
+  }
+
+  void add(const Result & result)
+  {
+    printResult(result);
+    mReport.results.push_back(result);
+  }
+
+private:
+  const Options & mOptions;
+  Report & mReport;
+};
+
+static void runText(Runner & runner, Target & target)
+{
+  const size_t sizes[] = { 1024, 64*1024, 1024*1024 };
+  for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+  {
+    const std::string suffix = "/" + formatSize(sizes[i]);
+    const std::string text = generateText(sizes[i]);
+    std::string output;
+    runner.run("text.set" + suffix, text.size(), [&]() { return target.SetText(text); });
+    runner.run("text.get" + suffix, text.size(), [&]() { return target.GetAsText(output) && output.size() == text.size(); });
+
+    std::u16string unicode(text.begin(), text.end());
+    std::u16string unicode_output;
+    const uint64_t unicode_bytes = unicode.size() * sizeof(char16_t);
+    runner.run("unicode.set" + suffix, unicode_bytes, [&]() { return target.SetTextUnicode(unicode); });
+    runner.run("unicode.get" + suffix, unicode_bytes, [&]() { return target.GetAsTextUnicode(unicode_output) && unicode_output.size() == unicode.size(); });
+  }
+
+  const std::string fragment = "<p>" + generateText(64*1024) + "</p>";
+  std::string output;
+  runner.run("html.set/64KiB", fragment.size(), [&]() { return target.SetHtml(fragment, std::string()); });
+  runner.run("html.get/64KiB", fragment.size(), [&]() { return target.GetAsHtml(output) && output.size() == fragment.size(); });
+}
+
+static void runBinary(Runner & runner, Target & target, const Options & options)
+{
+  for(uint64_t size = 1024; size <= options.max_size; size *= 16)
+  {
+    const std::string suffix = "/" + formatSize(size);
+    if (!runner.isSelected("binary.set" + suffix) && !runner.isSelected("binary.get" + suffix))
+      continue;
+
+    const std::string data = generateBinary((size_t)size);
+    std::string output;
+    runner.run("binary.set" + suffix, size, [&]() { return target.SetBinary(data); });
+    runner.run("binary.get" + suffix, size, [&]() { return target.GetAsBinary(output) && output.size() == data.size(); });
+  }
+}
+
+static void runDragDropFiles(Runner & runner, Target & target, const Options & options)
+{
+  for(uint64_t count = 1; count <= options.max_files; count *= 10)
+  {
+    const std::string suffix = "/" + formatCount(count);
+    if (!runner.isSelected("dropfiles.set" + suffix) && !runner.isSelected("dropfiles.get" + suffix))
+      continue;
+
+    const Target::StringVector files = generateFiles((size_t)count);
+    const uint64_t bytes = get_dropfiles_size(files);
+    DropFileList output;
+    runner.run("dropfiles.set" + suffix, bytes, [&]() { return target.SetDragDropFiles(files); });
+    runner.run("dropfiles.get" + suffix, bytes, [&]() { return target.GetAsDragDropFiles(output) && output.GetCount() == files.size(); });
+  }
+}
+
+//Readers read the clipboard while a writer replaces its content
+static void runConcurrent(Runner & runner, Target & target, const Options & options)
+{
+  static const size_t VALUE_SIZE = 64*1024;
+  const std::string values[2] = { generateText(VALUE_SIZE), generateText(VALUE_SIZE - 1) };
+
+  for(size_t num_readers = 1; num_readers <= options.max_threads; num_readers *= 2)
+  {
+    const std::string suffix = "/" + formatCount(num_readers) + "readers";
+    if (!runner.isSelected("concurrent.read" + suffix) && !runner.isSelected("concurrent.write" + suffix))
+      continue;
+
+    const size_t iterations = getIterations(options, VALUE_SIZE);
+    target.SetText(values[0]);
+
+    std::atomic<size_t> running(num_readers);
+    std::atomic<uint64_t> read_failures(0);
+    std::vector< std::vector<uint64_t> > read_samples(num_readers);
+    std::vector<uint64_t> write_samples;
+    uint64_t write_failures = 0;
+
+    const uint64_t start = StatsRecorder::GetTimestamp();
+    std::vector<std::thread> readers;
+    for(size_t i=0; i<num_readers; i++)
+    {
+      readers.push_back(std::thread([&, i]()
+      {
+        //the writer uses the stream of the main thread
+        FaultBackend::SetThreadIndex(i + 1);
+        std::string output;
+        read_samples[i].reserve(iterations);
+        for(size_t j=0; j<iterations; j++)
+        {
+          const uint64_t begin = StatsRecorder::GetTimestamp();
+          if (!target.GetAsText(output) || output.size() < VALUE_SIZE - 1)
+            read_failures++;
+          read_samples[i].push_back(StatsRecorder::GetTimestamp() - begin);
+        }
+        running--;
+      }));
+    }
+
+    //the writer runs until the readers are done
+    for(size_t j=0; running.load() > 0; j++)
+    {
+      const uint64_t begin = StatsRecorder::GetTimestamp();
+      if (!target.SetText(values[j % 2]))
+        write_failures++;
+      write_samples.push_back(StatsRecorder::GetTimestamp() - begin);
+    }
+    const uint64_t elapsed = StatsRecorder::GetTimestamp() - start;
+    for(size_t i=0; i<readers.size(); i++)
+      readers[i].join();
+
+    std::vector<uint64_t> samples;
+    for(size_t i=0; i<read_samples.size(); i++)
+      samples.insert(samples.end(), read_samples[i].begin(), read_samples[i].end());
+
+    Result read;
+    read.name = "concurrent.read" + suffix;
+    read.bytes = VALUE_SIZE;
+    read.failures = read_failures.load();
+    summarize_samples(samples, elapsed, read);
+    if (runner.isSelected(read.name))
+      runner.add(read);
+
+    Result write;
+    write.name = "concurrent.write" + suffix;
+    write.bytes = VALUE_SIZE;
+    write.failures = write_failures;
+    summarize_samples(write_samples, elapsed, write);
+    if (runner.isSelected(write.name))
+      runner.add(write);
+  }
+}
+
+//Threads replace and read the clipboard at random, like applications that use the clipboard at the same time
+static void runContention(Runner & runner, Target & target, const Options & options)
+{
+  static const size_t VALUE_SIZE = 4*1024;
+  const std::string value = generateText(VALUE_SIZE);
+
+  for(size_t num_threads = 2; num_threads <= options.max_threads; num_threads *= 2)
+  {
+    const std::string name = "contention.mixed/" + formatCount(num_threads) + "threads";
+    if (!runner.isSelected(name))
+      continue;
+
+    const size_t iterations = getIterations(options, VALUE_SIZE);
+    target.SetText(value);
+
+    std::atomic<uint64_t> failures(0);
+    std::vector< std::vector<uint64_t> > thread_samples(num_threads);
+
+    const uint64_t start = StatsRecorder::GetTimestamp();
+    std::vector<std::thread> threads;
+    for(size_t i=0; i<num_threads; i++)
+    {
+      threads.push_back(std::thread([&, i]()
+      {
+        //each thread has its own deterministic sequence of operations and faults: one write for three reads
+        FaultBackend::SetThreadIndex(i + 1);
+        uint64_t state = options.fault_options.seed + i + 1;
+        std::string output;
+        thread_samples[i].reserve(iterations);
+        for(size_t j=0; j<iterations; j++)
+        {
+          state = state * 6364136223846793005ull + 1442695040888963407ull;
+          const bool write = ((state >> 33) % 4 == 0);
+
+          const uint64_t begin = StatsRecorder::GetTimestamp();
+          const bool success = (write ? target.SetText(value) : target.GetAsText(output) && output.size() == value.size());
+          if (!success)
+            failures++;
+          thread_samples[i].push_back(StatsRecorder::GetTimestamp() - begin);
+        }
+      }));
+    }
+    for(size_t i=0; i<threads.size(); i++)
+      threads[i].join();
+    const uint64_t elapsed = StatsRecorder::GetTimestamp() - start;
+
+    std::vector<uint64_t> samples;
+    for(size_t i=0; i<thread_samples.size(); i++)
+      samples.insert(samples.end(), thread_samples[i].begin(), thread_samples[i].end());
+
+    Result result;
+    result.name = name;
+    result.bytes = VALUE_SIZE;
+    result.failures = failures.load();
+    summarize_samples(samples, elapsed, result);
+    runner.add(result);
+  }
+}
+
+static void printFaultStats(const FaultBackend & backend)
+{
+  FaultStats stats;
+  backend.GetStats(stats);
+  printf("faults: %llu operations, %llu open retries, %llu open failures, %llu injected failures, %llu contended opens, %llu slow allocations, %llu partial writes\n",
+    (unsigned long long)stats.operations,
+    (unsigned long long)stats.open_retries,
+    (unsigned long long)stats.open_failures,
+    (unsigned long long)stats.injected_failures,
+    (unsigned long long)stats.contended_opens,
+    (unsigned long long)stats.slow_allocations,
+    (unsigned long long)stats.partial_writes);
+}
+
+static Backend * createBackend(const Options & options)
+{
+  if (options.backend == "memory")
+    return new MemoryBackend();
+  if (options.backend == "file")
+    return new FileBackend(options.file);
+#ifdef __linux__
+  if (options.backend == "shm")
+  {
+    //large enough for the largest binary value
+    SharedMemoryBackend * backend = new SharedMemoryBackend(options.shm, options.max_size + 1024*1024);
+    if (backend->IsValid() && backend->GetCapacity() >= options.max_size)
+      return backend;
+    fprintf(stderr, "Unable to map the shared memory segment %s\n", options.shm.c_str());
+    delete backend;
+    return NULL;
+  }
+#endif
+  fprintf(stderr, "Unknown backend: %s\n", options.backend.c_str());
+  return NULL;
+}
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage();
+    return 2;
+  }
+
+  Report baseline;
+  if (!options.baseline.empty() && !read_json_report(options.baseline, baseline))
+  {
+    fprintf(stderr, "Failed reading the baseline %s\n", options.baseline.c_str());
+    return 2;
+  }
+
+  Backend * backend = NULL;
+  FaultBackend * fault_backend = NULL;
+  Target * target = NULL;
+#ifdef _WIN32
+  if (options.backend == "win32")
+    target = new ClipboardTarget();
+#endif
+  if (target == NULL)
+  {
+    backend = createBackend(options);
+    if (backend == NULL)
+      return 2;
+    if (options.faults)
+      fault_backend = new FaultBackend(*backend, options.fault_options);
+    target = new BackendTarget(fault_backend != NULL ? *fault_backend : *backend);
+  }
+
+  Report report;
+  report.version = WIN32CLIPBOARD_VERSION;
+  report.backend = options.backend;
+
+  printf("backend: %s\n", options.backend.c_str());
+  printHeader();
+  Runner runner(options, report);
+  runText(runner, *target);
+  runDragDropFiles(runner, *target, options);
+  runBinary(runner, *target, options);
+  runConcurrent(runner, *target, options);
+  runContention(runner, *target, options);
+  printf("peak RSS: %.1f MiB\n", get_peak_rss() / (1024.0 * 1024.0));
+  if (fault_backend != NULL)
+    printFaultStats(*fault_backend);
+
+  delete target;
+  delete fault_backend;
+  delete backend;
+  if (options.backend == "file")
+    remove(options.file.c_str());
+#ifdef __linux__
+  if (options.backend == "shm")
+    SharedMemoryBackend::Remove(options.shm);
+#endif
+
+  int exit_code = 0;
+  for(size_t i=0; i<report.results.size(); i++)
+  {
+    if (report.results[i].failures > 0 && !options.faults)
+    {
+      fprintf(stderr, "Scenario %s failed %llu times.\n", report.results[i].name.c_str(), (unsigned long long)report.results[i].failures);
+      exit_code = 1;
+    }
+  }
+
+  if (!options.json.empty() && !write_json_report(report, options.json))
+  {
+    fprintf(stderr, "Failed writing %s\n", options.json.c_str());
+    return 2;
+  }
+
+  if (!options.baseline.empty())
+  {
+    const size_t regressions = compare_reports(baseline, report, options.threshold);
+    printf("%llu regression(s)\n", (unsigned long long)regressions);
+    if (regressions > 0)
+      exit_code = 1;
+  }
+
+  return exit_code;
+}
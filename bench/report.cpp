@@ -0,0 +1,355 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "report.h"
+
+namespace win32clipboard { namespace bench
+{
+  //Nearest-rank percentile of sorted samples
+  static uint64_t getPercentile(const std::vector<uint64_t> & samples, double percentile)
+  {
+    if (samples.empty())
+      return 0;
+    size_t rank = (size_t)ceil(percentile / 100.0 * (double)samples.size());
+    if (rank < 1)
+      rank = 1;
+    return samples[std::min(rank, samples.size()) - 1];
+  }
+
+  void summarize_samples(std::vector<uint64_t> & samples, uint64_t elapsed, Result & result)
+  {
+    std::sort(samples.begin(), samples.end());
+
+    uint64_t total = 0;
+    for(size_t i=0; i<samples.size(); i++)
+      total += samples[i];
+
+    result.iterations = samples.size();
+    result.mean_ns = samples.empty() ? 0.0 : (double)total / (double)samples.size();
+    result.p50_ns = getPercentile(samples, 50.0);
+    result.p99_ns = getPercentile(samples, 99.0);
+    result.p999_ns = getPercentile(samples, 99.9);
+    result.max_ns = samples.empty() ? 0 : samples.back();
+    result.throughput = 0.0;
+    if (elapsed > 0)
+      result.throughput = ((double)result.bytes * (double)samples.size() / (1024.0 * 1024.0)) / ((double)elapsed / 1e9);
+    result.peak_rss = get_peak_rss();
+  }
+
+  uint64_t get_peak_rss()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return 0;
+    return (uint64_t)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+      return 0;
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;         //bytes
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;  //kilobytes
+#endif
+#endif
+  }
+
+  static std::string escapeJson(const std::string & value)
+  {
+    std::string escaped;
+    for(size_t i=0; i<value.size(); i++)
+    {
+      const char c = value[i];
+      if (c == '"' || c == '\\')
+        escaped += '\\';
+      if ((unsigned char)c < 0x20)
+        continue;
+      escaped += c;
+    }
+    return escaped;
+  }
+
+  bool write_json_report(const Report & report, const std::string & path)
+  {
+    FILE * f = fopen(path.c_str(), "w");
+    if (f == NULL)
+      return false;
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", escapeJson(report.version).c_str());
+    fprintf(f, "  \"backend\": \"%s\",\n", escapeJson(report.backend).c_str());
+    fprintf(f, "  \"results\": [\n");
+    for(size_t i=0; i<report.results.size(); i++)
+    {
+      const Result & r = report.results[i];
+      fprintf(f, "    {\"name\": \"%s\", \"iterations\": %llu, \"failures\": %llu, \"bytes\": %llu, "
+                 "\"mean_ns\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, "
+                 "\"throughput_mib_s\": %.3f, \"peak_rss_bytes\": %llu}%s\n",
+        escapeJson(r.name).c_str(),
+        (unsigned long long)r.iterations,
+        (unsigned long long)r.failures,
+        (unsigned long long)r.bytes,
+        r.mean_ns,
+        (unsigned long long)r.p50_ns,
+        (unsigned long long)r.p99_ns,
+        (unsigned long long)r.p999_ns,
+        (unsigned long long)r.max_ns,
+        r.throughput,
+        (unsigned long long)r.peak_rss,
+        (i + 1 < report.results.size() ? "," : ""));
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+
+    const bool success = (ferror(f) == 0);
+    fclose(f);
+    return success;
+  }
+
+  // Minimal JSON reader for the documents written by write_json_report().
+  // Objects are flattened into a map of their string and number members; nested values are skipped.
+  class JsonReader
+  {
+  public:
+    typedef std::map<std::string, std::string> Object;
+
+    JsonReader(const std::string & iText) : mText(iText), mPos(0) {}
+
+    bool readReport(Report & report)
+    {
+      if (!expect('{'))
+        return false;
+      if (peek() == '}')
+        return expect('}');
+      for(;;)
+      {
+        std::string key;
+        if (!readString(key) || !expect(':'))
+          return false;
+        if (key == "results")
+        {
+          if (!readResults(report.results))
+            return false;
+        }
+        else
+        {
+          std::string value;
+          if (!readScalar(value))
+            return false;
+          if (key == "version")
+            report.version = value;
+          else if (key == "backend")
+            report.backend = value;
+        }
+        if (peek() == ',')
+        {
+          mPos++;
+          continue;
+        }
+        return expect('}');
+      }
+    }
+
+  private:
+    bool readResults(ResultList & results)
+    {
+      if (!expect('['))
+        return false;
+      if (peek() == ']')
+        return expect(']');
+      for(;;)
+      {
+        Object object;
+        if (!readObject(object))
+          return false;
+
+        Result r;
+        r.name = object["name"];
+        r.iterations = strtoull(object["iterations"].c_str(), NULL, 10);
+        r.failures = strtoull(object["failures"].c_str(), NULL, 10);
+        r.bytes = strtoull(object["bytes"].c_str(), NULL, 10);
+        r.mean_ns = strtod(object["mean_ns"].c_str(), NULL);
+        r.p50_ns = strtoull(object["p50_ns"].c_str(), NULL, 10);
+        r.p99_ns = strtoull(object["p99_ns"].c_str(), NULL, 10);
+        r.p999_ns = strtoull(object["p999_ns"].c_str(), NULL, 10);
+        r.max_ns = strtoull(object["max_ns"].c_str(), NULL, 10);
+        r.throughput = strtod(object["throughput_mib_s"].c_str(), NULL);
+        r.peak_rss = strtoull(object["peak_rss_bytes"].c_str(), NULL, 10);
+        if (r.name.empty())
+          return false;
+        results.push_back(r);
+
+        if (peek() == ',')
+        {
+          mPos++;
+          continue;
+        }
+        return expect(']');
+      }
+    }
+
+    bool readObject(Object & object)
+    {
+      if (!expect('{'))
+        return false;
+      if (peek() == '}')
+        return expect('}');
+      for(;;)
+      {
+        std::string key;
+        std::string value;
+        if (!readString(key) || !expect(':') || !readScalar(value))
+          return false;
+        object[key] = value;
+        if (peek() == ',')
+        {
+          mPos++;
+          continue;
+        }
+        return expect('}');
+      }
+    }
+
+    bool readScalar(std::string & value)
+    {
+      const char c = peek();
+      if (c == '"')
+        return readString(value);
+      const size_t begin = mPos;
+      while (mPos < mText.size() && strchr("+-.0123456789eEtruefalsn", mText[mPos]) != NULL)
+        mPos++;
+      value.assign(mText, begin, mPos - begin);
+      return !value.empty();
+    }
+
+    bool readString(std::string & value)
+    {
+      if (!expect('"'))
+        return false;
+      value.clear();
+      while (mPos < mText.size() && mText[mPos] != '"')
+      {
+        if (mText[mPos] == '\\' && mPos + 1 < mText.size())
+          mPos++;
+        value += mText[mPos++];
+      }
+      return expect('"');
+    }
+
+    char peek()
+    {
+      while (mPos < mText.size() && strchr(" \t\r\n", mText[mPos]) != NULL)
+        mPos++;
+      return mPos < mText.size() ? mText[mPos] : '\0';
+    }
+
+    bool expect(char c)
+    {
+      if (peek() != c)
+        return false;
+      mPos++;
+      return true;
+    }
+
+  private:
+    const std::string & mText;
+    size_t mPos;
+  };
+
+  bool read_json_report(const std::string & path, Report & report)
+  {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+      return false;
+    std::string text;
+    char buffer[4096];
+    size_t count = 0;
+    while ((count = fread(buffer, 1, sizeof(buffer), f)) > 0)
+      text.append(buffer, count);
+    fclose(f);
+
+    report = Report();
+    JsonReader reader(text);
+    return reader.readReport(report);
+  }
+
+  static double getChange(uint64_t baseline, uint64_t current)
+  {
+    if (baseline == 0)
+      return 0.0;
+    return ((double)current - (double)baseline) * 100.0 / (double)baseline;
+  }
+
+  size_t compare_reports(const Report & baseline, const Report & current, double threshold)
+  {
+    std::map<std::string, const Result *> index;
+    for(size_t i=0; i<baseline.results.size(); i++)
+      index[baseline.results[i].name] = &baseline.results[i];
+
+    printf("\ncomparison with the baseline (backend: %s, version: %s), threshold: %.1f%%\n", baseline.backend.c_str(), baseline.version.c_str(), threshold);
+    printf("%-32s %12s %12s %9s %12s %12s %9s\n", "scenario", "base p50", "p50 (us)", "change", "base p99", "p99 (us)", "change");
+
+    size_t regressions = 0;
+    for(size_t i=0; i<current.results.size(); i++)
+    {
+      const Result & r = current.results[i];
+      std::map<std::string, const Result *>::const_iterator it = index.find(r.name);
+      if (it == index.end())
+      {
+        printf("%-32s %12s\n", r.name.c_str(), "(new)");
+        continue;
+      }
+
+      const Result & b = *it->second;
+      const double p50_change = getChange(b.p50_ns, r.p50_ns);
+      const double p99_change = getChange(b.p99_ns, r.p99_ns);
+      const bool regression = (p50_change > threshold || p99_change > threshold);
+      if (regression)
+        regressions++;
+      printf("%-32s %12.1f %12.1f %8.1f%% %12.1f %12.1f %8.1f%%%s\n",
+        r.name.c_str(),
+        b.p50_ns / 1000.0, r.p50_ns / 1000.0, p50_change,
+        b.p99_ns / 1000.0, r.p99_ns / 1000.0, p99_change,
+        regression ? "  REGRESSION" : "");
+    }
+    return regressions;
+  }
+
+} //namespace bench
+} //namespace win32clipboard
@@ -0,0 +1,102 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_BENCH_REPORT_H
+#define WIN32CLIPBOARD_BENCH_REPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace win32clipboard { namespace bench
+{
+  /// <summary>
+  /// Measures of a benchmark scenario.
+  /// </summary>
+  struct Result
+  {
+    std::string name;
+    uint64_t iterations;
+    uint64_t failures;
+    uint64_t bytes;           //bytes processed by each operation
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    double throughput;        //MiB per second, over the whole scenario
+    uint64_t peak_rss;        //peak resident set size of the process after the scenario, in bytes
+  };
+
+  typedef std::vector<Result> ResultList;
+
+  /// <summary>
+  /// Results of a benchmark run.
+  /// </summary>
+  struct Report
+  {
+    std::string version;
+    std::string backend;
+    ResultList results;
+  };
+
+  /// <summary>
+  /// Compute the latency percentiles of a scenario from the duration of each operation.
+  /// </summary>
+  /// <param name="samples">The duration in nanoseconds of each operation. The samples are sorted by the function.</param>
+  /// <param name="elapsed">The duration in nanoseconds of the whole scenario, for the throughput.</param>
+  /// <param name="result">The output result. The name, bytes and failures fields must be set by the caller.</param>
+  void summarize_samples(std::vector<uint64_t> & samples, uint64_t elapsed, Result & result);
+
+  /// <summary>
+  /// Returns the peak resident set size of the process, in bytes. Returns 0 if not available.
+  /// </summary>
+  uint64_t get_peak_rss();
+
+  /// <summary>
+  /// Write a report as a JSON document.
+  /// </summary>
+  /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+  bool write_json_report(const Report & report, const std::string & path);
+
+  /// <summary>
+  /// Read a report written by write_json_report().
+  /// </summary>
+  /// <returns>Returns true if the function is successful. Returns false if the file cannot be read or is not a valid report.</returns>
+  bool read_json_report(const std::string & path, Report & report);
+
+  /// <summary>
+  /// Print the difference between the results of a run and a baseline.
+  /// </summary>
+  /// <param name="baseline">The baseline report.</param>
+  /// <param name="current">The report of the current run.</param>
+  /// <param name="threshold">The maximum slowdown of the median and 99th percentile latencies, in percent.</param>
+  /// <returns>Returns the number of scenarios slower than the baseline by more than the threshold.</returns>
+  size_t compare_reports(const Report & baseline, const Report & current, double threshold);
+
+} //namespace bench
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_BENCH_REPORT_H
@@ -0,0 +1,222 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+
+#include "target.h"
+
+#include "win32clipboard/html.h"
+
+#ifdef _WIN32
+#include "win32clipboard/win32clipboard.h"
+#endif
+
+namespace win32clipboard { namespace bench
+{
+  //Preferred DropEffect value of a copy operation
+  static const char DROP_EFFECT_COPY[4] = { 1, 0, 0, 0 };
+
+  //Remove the terminating \0 character of a text payload and everything after it.
+  template <typename T> static void trimTerminator(const std::string & payload, std::basic_string<T> & oText)
+  {
+    const T * text = (const T *)payload.data();
+    const size_t count = payload.size() / sizeof(T);
+    size_t length = 0;
+    while (length < count && text[length] != 0)
+      length++;
+    oText.assign(text, length);
+  }
+
+  Target::~Target()
+  {
+  }
+
+  BackendTarget::BackendTarget(Backend & iBackend) :
+    mBackend(iBackend)
+  {
+  }
+
+  BackendTarget::~BackendTarget()
+  {
+  }
+
+  bool BackendTarget::SetText(const std::string & iText)
+  {
+    Backend::ItemList items(1);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.reserve(iText.size() + 1);
+    items[0].data.assign(iText);
+    items[0].data += '\0';
+    return mBackend.Write(items);
+  }
+
+  bool BackendTarget::GetAsText(std::string & oText)
+  {
+    std::string payload;
+    if (!mBackend.Read(Backend::FORMAT_TEXT, payload))
+      return false;
+    const char * end = (const char *)memchr(payload.data(), '\0', payload.size());
+    oText.assign(payload.data(), end != NULL ? end - payload.data() : payload.size());
+    return true;
+  }
+
+  bool BackendTarget::SetTextUnicode(const std::u16string & iText)
+  {
+    Backend::ItemList items(1);
+    items[0].format = Backend::FORMAT_UNICODE;
+    items[0].data.assign((const char *)iText.c_str(), (iText.size() + 1) * sizeof(char16_t));
+    return mBackend.Write(items);
+  }
+
+  bool BackendTarget::GetAsTextUnicode(std::u16string & oText)
+  {
+    std::string payload;
+    if (!mBackend.Read(Backend::FORMAT_UNICODE, payload))
+      return false;
+    trimTerminator(payload, oText);
+    return true;
+  }
+
+  bool BackendTarget::SetBinary(const std::string & iMemoryBuffer)
+  {
+    Backend::ItemList items(1);
+    items[0].format = Backend::FORMAT_BINARY;
+    items[0].data = iMemoryBuffer;
+    return mBackend.Write(items);
+  }
+
+  bool BackendTarget::GetAsBinary(std::string & oMemoryBuffer)
+  {
+    return mBackend.Read(Backend::FORMAT_BINARY, oMemoryBuffer);
+  }
+
+  bool BackendTarget::SetHtml(const std::string & iFragment, const std::string & iText)
+  {
+    Backend::ItemList items(iText.empty() ? 1 : 2);
+    items[0].format = Backend::FORMAT_HTML;
+    items[0].data.resize(get_cf_html_size(iFragment.size()));
+    if (!encode_cf_html(iFragment.data(), iFragment.size(), &items[0].data[0], items[0].data.size()))
+      return false;
+    if (!iText.empty())
+    {
+      items[1].format = Backend::FORMAT_TEXT;
+      items[1].data.assign(iText.c_str(), iText.size() + 1);
+    }
+    return mBackend.Write(items);
+  }
+
+  bool BackendTarget::GetAsHtml(std::string & oFragment)
+  {
+    std::string payload;
+    HtmlView view;
+    if (!mBackend.Read(Backend::FORMAT_HTML, payload) || !parse_cf_html(payload.data(), payload.size(), view))
+      return false;
+    oFragment.assign(view.fragment, view.fragment_size);
+    return true;
+  }
+
+  bool BackendTarget::SetDragDropFiles(const StringVector & iFiles)
+  {
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_HDROP;
+    items[0].data.resize(get_dropfiles_size(iFiles));
+    if (!encode_dropfiles(iFiles, &items[0].data[0], items[0].data.size()))
+      return false;
+    items[1].format = Backend::FORMAT_DROP_EFFECT;
+    items[1].data.assign(DROP_EFFECT_COPY, sizeof(DROP_EFFECT_COPY));
+    return mBackend.Write(items);
+  }
+
+  bool BackendTarget::GetAsDragDropFiles(DropFileList & oFiles)
+  {
+    std::string payload;
+    bool is_wide = false;
+    if (!mBackend.Read(Backend::FORMAT_HDROP, payload))
+      return false;
+    return decode_dropfiles(payload.data(), payload.size(), oFiles, is_wide);
+  }
+
+#ifdef _WIN32
+  ClipboardTarget::ClipboardTarget()
+  {
+  }
+
+  ClipboardTarget::~ClipboardTarget()
+  {
+  }
+
+  bool ClipboardTarget::SetText(const std::string & iText)
+  {
+    return Clipboard::GetInstance().SetText(iText);
+  }
+
+  bool ClipboardTarget::GetAsText(std::string & oText)
+  {
+    return Clipboard::GetInstance().GetAsText(oText);
+  }
+
+  bool ClipboardTarget::SetTextUnicode(const std::u16string & iText)
+  {
+    return Clipboard::GetInstance().SetTextUnicode(iText);
+  }
+
+  bool ClipboardTarget::GetAsTextUnicode(std::u16string & oText)
+  {
+    return Clipboard::GetInstance().GetAsTextUnicode(oText);
+  }
+
+  bool ClipboardTarget::SetBinary(const std::string & iMemoryBuffer)
+  {
+    return Clipboard::GetInstance().SetBinary(iMemoryBuffer);
+  }
+
+  bool ClipboardTarget::GetAsBinary(std::string & oMemoryBuffer)
+  {
+    return Clipboard::GetInstance().GetAsBinary(oMemoryBuffer);
+  }
+
+  bool ClipboardTarget::SetHtml(const std::string & iFragment, const std::string & iText)
+  {
+    return Clipboard::GetInstance().SetHtml(iFragment, iText);
+  }
+
+  bool ClipboardTarget::GetAsHtml(std::string & oFragment)
+  {
+    return Clipboard::GetInstance().GetAsHtml(oFragment);
+  }
+
+  bool ClipboardTarget::SetDragDropFiles(const StringVector & iFiles)
+  {
+    return Clipboard::GetInstance().SetDragDropFiles(Clipboard::DragDropCopy, iFiles);
+  }
+
+  bool ClipboardTarget::GetAsDragDropFiles(DropFileList & oFiles)
+  {
+    Clipboard::DragDropType type = Clipboard::DragDropCopy;
+    return Clipboard::GetInstance().GetAsDragDropFiles(type, oFiles);
+  }
+#endif //_WIN32
+
+} //namespace bench
+} //namespace win32clipboard
@@ -0,0 +1,112 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_BENCH_TARGET_H
+#define WIN32CLIPBOARD_BENCH_TARGET_H
+
+#include <string>
+#include <vector>
+
+#include "win32clipboard/backend.h"
+#include "win32clipboard/dropfiles.h"
+
+namespace win32clipboard { namespace bench
+{
+  /// <summary>
+  /// The subset of the Clipboard API measured by the benchmark.
+  /// </summary>
+  /// <remarks>
+  /// ClipboardTarget calls the Clipboard singleton. BackendTarget encodes the values exactly like the
+  /// Clipboard does and stores them in a Backend, which measures the library on every platform.
+  /// </remarks>
+  class Target
+  {
+  public:
+    typedef std::vector<std::string> StringVector;
+
+    virtual ~Target();
+
+    virtual bool SetText(const std::string & iText) = 0;
+    virtual bool GetAsText(std::string & oText) = 0;
+    virtual bool SetTextUnicode(const std::u16string & iText) = 0;
+    virtual bool GetAsTextUnicode(std::u16string & oText) = 0;
+    virtual bool SetBinary(const std::string & iMemoryBuffer) = 0;
+    virtual bool GetAsBinary(std::string & oMemoryBuffer) = 0;
+    virtual bool SetHtml(const std::string & iFragment, const std::string & iText) = 0;
+    virtual bool GetAsHtml(std::string & oFragment) = 0;
+    virtual bool SetDragDropFiles(const StringVector & iFiles) = 0;
+    virtual bool GetAsDragDropFiles(DropFileList & oFiles) = 0;
+  };
+
+  /// <summary>
+  /// A target that stores the values in a Backend.
+  /// </summary>
+  class BackendTarget : public Target
+  {
+  public:
+    BackendTarget(Backend & iBackend);
+    virtual ~BackendTarget();
+
+    virtual bool SetText(const std::string & iText);
+    virtual bool GetAsText(std::string & oText);
+    virtual bool SetTextUnicode(const std::u16string & iText);
+    virtual bool GetAsTextUnicode(std::u16string & oText);
+    virtual bool SetBinary(const std::string & iMemoryBuffer);
+    virtual bool GetAsBinary(std::string & oMemoryBuffer);
+    virtual bool SetHtml(const std::string & iFragment, const std::string & iText);
+    virtual bool GetAsHtml(std::string & oFragment);
+    virtual bool SetDragDropFiles(const StringVector & iFiles);
+    virtual bool GetAsDragDropFiles(DropFileList & oFiles);
+
+  private:
+    Backend & mBackend;
+  };
+
+#ifdef _WIN32
+  /// <summary>
+  /// A target that calls the Clipboard singleton.
+  /// </summary>
+  class ClipboardTarget : public Target
+  {
+  public:
+    ClipboardTarget();
+    virtual ~ClipboardTarget();
+
+    virtual bool SetText(const std::string & iText);
+    virtual bool GetAsText(std::string & oText);
+    virtual bool SetTextUnicode(const std::u16string & iText);
+    virtual bool GetAsTextUnicode(std::u16string & oText);
+    virtual bool SetBinary(const std::string & iMemoryBuffer);
+    virtual bool GetAsBinary(std::string & oMemoryBuffer);
+    virtual bool SetHtml(const std::string & iFragment, const std::string & iText);
+    virtual bool GetAsHtml(std::string & oFragment);
+    virtual bool SetDragDropFiles(const StringVector & iFiles);
+    virtual bool GetAsDragDropFiles(DropFileList & oFiles);
+  };
+#endif //_WIN32
+
+} //namespace bench
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_BENCH_TARGET_H
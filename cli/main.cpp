@@ -0,0 +1,614 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "win32clipboard/backend.h"
+#include "win32clipboard/html.h"
+#include "win32clipboard/image.h"
+#include "win32clipboard/newline.h"
+#include "win32clipboard/png.h"
+#include "win32clipboard/stats.h"
+#include "win32clipboard/transcode.h"
+#include "win32clipboard/version.h"
+
+using namespace win32clipboard;
+
+enum ValueFormat { ValueText, ValueUnicode, ValueBinary, ValueHtml, ValueImage };
+enum Encoding { EncodingUtf8, EncodingUtf16 };
+enum Newline { NewlineKeep, NewlineCrlf, NewlineLf };
+
+struct Options
+{
+  std::string command;
+  ValueFormat format;
+  Encoding encoding;
+  Newline newline;
+  std::string backend;
+  std::string file;
+  std::string shm;
+  size_t shm_size;
+  size_t size;          //bench only
+  size_t iterations;    //bench only
+};
+
+static const size_t STREAM_CHUNK_SIZE = 64*1024;
+
+static void printUsage()
+{
+  printf(
+    "win32clipboard %s - command line clipboard tool\n"
+    "\n"
+    "Usage: win32clipboard_cli <command> [options]\n"
+    "\n"
+    "Commands:\n"
+    "  copy                 Copy stdin to the clipboard.\n"
+    "  paste                Write the clipboard content to stdout.\n"
+    "  formats              List the formats of the clipboard.\n"
+    "  clear                Empty the clipboard.\n"
+    "  bench                Measure the latency and throughput of copy and paste.\n"
+    "\n"
+    "Options:\n"
+    "  --format <name>      text, unicode, binary, html or image (PNG file). Default is text.\n"
+    "  --encoding <name>    Encoding of stdin and stdout for text values: utf8 or utf16 (little endian). Default is utf8.\n"
+    "  --newline <name>     Line endings of the output: keep, crlf or lf. Default is keep.\n"
+    "  --backend <name>     win32, memory, file or shm (Linux only). Default is win32 on Windows and file on other platforms.\n"
+    "  --file <path>        File of the file backend. Default is $WIN32CLIPBOARD_FILE or win32clipboard.clip in the temporary directory.\n"
+    "  --shm <name>         Shared memory segment of the shm backend. Default is /win32clipboard.\n"
+    "  --shm-size <bytes>   Capacity of the shared memory segment when it is created. Default is 67108864.\n"
+    "  --size <bytes>       Size of the values copied by the bench command. Default is 1048576.\n"
+    "  --iterations <n>     Number of copy and paste of the bench command. Default is 100.\n",
+    WIN32CLIPBOARD_VERSION);
+}
+
+static std::string getDefaultFilePath()
+{
+  const char * path = getenv("WIN32CLIPBOARD_FILE");
+  if (path != NULL && path[0] != '\0')
+    return path;
+
+  const char * names[] = { "TMPDIR", "TEMP", "TMP" };
+  std::string directory = "/tmp";
+  for(size_t i=0; i<sizeof(names)/sizeof(names[0]); i++)
+  {
+    const char * value = getenv(names[i]);
+    if (value != NULL && value[0] != '\0')
+    {
+      directory = value;
+      break;
+    }
+  }
+  return directory + "/win32clipboard.clip";
+}
+
+static bool parseOptions(int argc, char ** argv, Options & options)
+{
+  options.format = ValueText;
+  options.encoding = EncodingUtf8;
+  options.newline = NewlineKeep;
+#ifdef _WIN32
+  options.backend = "win32";
+#else
+  options.backend = "file";
+#endif
+  options.file = getDefaultFilePath();
+  options.shm = "/win32clipboard";
+  options.shm_size = 64*1024*1024;
+  options.size = 1024*1024;
+  options.iterations = 100;
+
+  if (argc < 2)
+    return false;
+  options.command = argv[1];
+
+  for(int i=2; i<argc; i += 2)
+  {
+    const std::string name = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const std::string value = argv[i + 1];
+
+    if (name == "--format")
+    {
+      if (value == "text")          options.format = ValueText;
+      else if (value == "unicode")  options.format = ValueUnicode;
+      else if (value == "binary")   options.format = ValueBinary;
+      else if (value == "html")     options.format = ValueHtml;
+      else if (value == "image")    options.format = ValueImage;
+      else return false;
+    }
+    else if (name == "--encoding")
+    {
+      if (value == "utf8")          options.encoding = EncodingUtf8;
+      else if (value == "utf16")    options.encoding = EncodingUtf16;
+      else return false;
+    }
+    else if (name == "--newline")
+    {
+      if (value == "keep")          options.newline = NewlineKeep;
+      else if (value == "crlf")     options.newline = NewlineCrlf;
+      else if (value == "lf")       options.newline = NewlineLf;
+      else return false;
+    }
+    else if (name == "--backend")
+      options.backend = value;
+    else if (name == "--file")
+      options.file = value;
+    else if (name == "--shm")
+      options.shm = value;
+    else if (name == "--shm-size")
+      options.shm_size = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--size")
+      options.size = (size_t)strtoull(value.c_str(), NULL, 10);
+    else if (name == "--iterations")
+      options.iterations = (size_t)strtoull(value.c_str(), NULL, 10);
+    else
+      return false;
+  }
+  return true;
+}
+
+static Backend * createBackend(const Options & options)
+{
+  if (options.backend == "memory")
+    return new MemoryBackend();
+  if (options.backend == "file")
+    return new FileBackend(options.file);
+#ifdef __linux__
+  if (options.backend == "shm")
+  {
+    SharedMemoryBackend * backend = new SharedMemoryBackend(options.shm, options.shm_size);
+    if (backend->IsValid())
+      return backend;
+    fprintf(stderr, "Unable to map the shared memory segment %s\n", options.shm.c_str());
+    delete backend;
+    return NULL;
+  }
+#endif
+#ifdef _WIN32
+  if (options.backend == "win32")
+    return new Win32Backend();
+#endif
+  fprintf(stderr, "Unknown backend: %s\n", options.backend.c_str());
+  return NULL;
+}
+
+static bool readStream(FILE * f, std::string & content)
+{
+  content.clear();
+  std::vector<char> buffer(STREAM_CHUNK_SIZE);
+  size_t read = 0;
+  while ((read = fread(&buffer[0], 1, buffer.size(), f)) > 0)
+    content.append(&buffer[0], read);
+  return (ferror(f) == 0);
+}
+
+static bool writeStream(FILE * f, const std::string & content)
+{
+  for(size_t offset = 0; offset < content.size(); offset += STREAM_CHUNK_SIZE)
+  {
+    const size_t size = (content.size() - offset < STREAM_CHUNK_SIZE ? content.size() - offset : STREAM_CHUNK_SIZE);
+    if (fwrite(content.data() + offset, 1, size, f) != size)
+      return false;
+  }
+  return (fflush(f) == 0);
+}
+
+//Convert an utf8 string to little endian utf16. Returns false if the string is not valid utf8.
+static bool utf8ToUtf16(const std::string & str, std::string & utf16)
+{
+  std::u16string units;
+  if (!transcode(str, units))
+    return false;
+  utf16.resize(units.size() * 2);
+  for(size_t i=0; i<units.size(); i++)
+  {
+    utf16[2*i + 0] = (char)(units[i] & 0xFF);
+    utf16[2*i + 1] = (char)(units[i] >> 8);
+  }
+  return true;
+}
+
+//Convert a little endian utf16 string to utf8. Returns false if the string is not valid utf16.
+static bool utf16ToUtf8(const std::string & utf16, std::string & str)
+{
+  str.clear();
+  if (utf16.size() % 2 != 0)
+    return false;
+  const unsigned char * s = (const unsigned char *)utf16.data();
+  std::u16string units(utf16.size() / 2, 0);
+  for(size_t i=0; i<units.size(); i++)
+    units[i] = (char16_t)(s[2*i] | (s[2*i + 1] << 8));
+  return transcode(units, str);
+}
+
+static void convertNewlines(Newline newline, std::string & text)
+{
+  if (newline == NewlineCrlf)
+  {
+    std::string converted(get_crlf_length(text.data(), text.size()), '\0');
+    if (!converted.empty())
+      lf_to_crlf(text.data(), text.size(), &converted[0]);
+    text.swap(converted);
+  }
+  else if (newline == NewlineLf && !text.empty())
+  {
+    text.resize(crlf_to_lf(text.data(), text.size(), &text[0]));
+  }
+}
+
+//Remove the terminating \0 character of a text payload and everything after it.
+static void trimTerminator(std::string & data, size_t char_size)
+{
+  if (char_size == 1)
+  {
+    const char * terminator = (const char *)memchr(data.data(), '\0', data.size());
+    if (terminator != NULL)
+      data.resize(terminator - data.data());
+    return;
+  }
+
+  for(size_t i=0; i + char_size <= data.size(); i += char_size)
+  {
+    bool terminator = true;
+    for(size_t j=0; j<char_size; j++)
+      terminator = terminator && (data[i + j] == '\0');
+    if (terminator)
+    {
+      data.resize(i);
+      return;
+    }
+  }
+  data.resize(data.size() - data.size() % char_size);
+}
+
+//Convert the input value to the formats published to the clipboard.
+static bool encodeValue(const Options & options, std::string & input, Backend::ItemList & items)
+{
+  items.clear();
+
+  if (options.format == ValueBinary)
+  {
+    items.resize(1);
+    items[0].format = Backend::FORMAT_BINARY;
+    items[0].data.swap(input);
+    return true;
+  }
+
+  if (options.format == ValueImage)
+  {
+    //publish the PNG file as is, and as a bitmap for the applications that do not read PNG images
+    Image image;
+    if (!decode_png(input.data(), input.size(), image))
+      return false;
+    items.resize(2);
+    items[0].format = Backend::FORMAT_DIBV5;
+    items[0].data.resize(get_dib_size(image));
+    if (!encode_dib(image, &items[0].data[0], items[0].data.size()))
+      return false;
+    items[1].format = Backend::FORMAT_PNG;
+    items[1].data.swap(input);
+    return true;
+  }
+
+  //text values are converted to utf8 first
+  std::string text;
+  if (options.encoding == EncodingUtf16)
+  {
+    if (!utf16ToUtf8(input, text))
+      return false;
+  }
+  else
+    text.swap(input);
+  convertNewlines(options.newline, text);
+
+  items.resize(1);
+  Backend::Item & item = items[0];
+  if (options.format == ValueText)
+  {
+    item.format = Backend::FORMAT_TEXT;
+    item.data.swap(text);
+    item.data += '\0';
+  }
+  else if (options.format == ValueUnicode)
+  {
+    item.format = Backend::FORMAT_UNICODE;
+    if (!utf8ToUtf16(text, item.data))
+      return false;
+    item.data.append(2, '\0');
+  }
+  else
+  {
+    item.format = Backend::FORMAT_HTML;
+    item.data.resize(get_cf_html_size(text.size()));
+    if (!encode_cf_html(text.data(), text.size(), &item.data[0], item.data.size()))
+      return false;
+  }
+  return true;
+}
+
+//Read the value of the clipboard in the requested format and convert it to the output format.
+static bool decodeValue(const Options & options, Backend & backend, std::string & output)
+{
+  output.clear();
+
+  if (options.format == ValueBinary)
+    return backend.Read(Backend::FORMAT_BINARY, output);
+
+  if (options.format == ValueImage)
+  {
+    //prefer the PNG file which does not need to be encoded
+    if (backend.Read(Backend::FORMAT_PNG, output))
+      return true;
+
+    const char * formats[] = { Backend::FORMAT_DIBV5, Backend::FORMAT_DIB };
+    for(size_t i=0; i<sizeof(formats)/sizeof(formats[0]); i++)
+    {
+      std::string dib;
+      DibView view;
+      if (!backend.Read(formats[i], dib) || !parse_dib(dib.data(), dib.size(), view))
+        continue;
+      Image image;
+      decode_dib(view, image);
+      return encode_png(image, output);
+    }
+    return false;
+  }
+
+  std::string text;
+  if (options.format == ValueText)
+  {
+    if (!backend.Read(Backend::FORMAT_TEXT, text))
+      return false;
+    trimTerminator(text, 1);
+  }
+  else if (options.format == ValueUnicode)
+  {
+    std::string utf16;
+    if (!backend.Read(Backend::FORMAT_UNICODE, utf16))
+      return false;
+    trimTerminator(utf16, 2);
+    if (!utf16ToUtf8(utf16, text))
+      return false;
+  }
+  else
+  {
+    std::string html;
+    HtmlView view;
+    if (!backend.Read(Backend::FORMAT_HTML, html) || !parse_cf_html(html.data(), html.size(), view))
+      return false;
+    text.assign(view.fragment, view.fragment_size);
+  }
+
+  convertNewlines(options.newline, text);
+  if (options.encoding == EncodingUtf16)
+    return utf8ToUtf16(text, output);
+  output.swap(text);
+  return true;
+}
+
+static int runCopy(const Options & options, Backend & backend)
+{
+  std::string input;
+  if (!readStream(stdin, input))
+  {
+    fprintf(stderr, "Failed reading stdin.\n");
+    return 1;
+  }
+
+  Backend::ItemList items;
+  if (!encodeValue(options, input, items))
+  {
+    fprintf(stderr, "Failed converting the input. Check the --format and --encoding options.\n");
+    return 1;
+  }
+  if (!backend.Write(items))
+  {
+    fprintf(stderr, "Failed writing to the clipboard.\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int runPaste(const Options & options, Backend & backend)
+{
+  std::string output;
+  if (!decodeValue(options, backend, output))
+  {
+    fprintf(stderr, "The clipboard does not contain a value of the requested format.\n");
+    return 1;
+  }
+  if (!writeStream(stdout, output))
+  {
+    fprintf(stderr, "Failed writing stdout.\n");
+    return 1;
+  }
+  return 0;
+}
+
+static int runFormats(Backend & backend)
+{
+  Backend::StringVector formats;
+  if (!backend.GetFormats(formats))
+  {
+    fprintf(stderr, "Failed reading the clipboard.\n");
+    return 1;
+  }
+  for(size_t i=0; i<formats.size(); i++)
+    printf("%s\n", formats[i].c_str());
+  return 0;
+}
+
+static int runClear(Backend & backend)
+{
+  if (!backend.Empty())
+  {
+    fprintf(stderr, "Failed clearing the clipboard.\n");
+    return 1;
+  }
+  return 0;
+}
+
+//Generate a value of the given size made of lines of printable characters.
+static std::string generateValue(const Options & options)
+{
+  if (options.format == ValueImage)
+  {
+    //a square image with a gradient, which compresses like a screenshot
+    size_t width = 1;
+    while ((width + 1) * (width + 1) * 4 <= options.size)
+      width++;
+    Image image;
+    image.Create(width, width);
+    unsigned char * pixels = image.GetPixels();
+    for(size_t y=0; y<width; y++)
+    {
+      for(size_t x=0; x<width; x++)
+      {
+        unsigned char * pixel = pixels + y * image.GetStride() + x * 4;
+        pixel[0] = (unsigned char)x;
+        pixel[1] = (unsigned char)y;
+        pixel[2] = (unsigned char)(x ^ y);
+        pixel[3] = 255;
+      }
+    }
+    std::string png;
+    encode_png(image, png);
+    return png;
+  }
+
+  std::string value(options.size, ' ');
+  for(size_t i=0; i<value.size(); i++)
+    value[i] = ((i % 80) == 79 ? '\n' : (char)('a' + (i * 7) % 26));
+  if (options.encoding == EncodingUtf16)
+  {
+    std::string utf16;
+    utf8ToUtf16(value, utf16);
+    value.swap(utf16);
+  }
+  return value;
+}
+
+static void printLatency(const char * name, const OperationStats & stats, size_t value_size)
+{
+  const LatencyHistogram & latency = stats.latency;
+  const double seconds = (double)latency.total_ns / 1e9;
+  const double throughput = (seconds > 0.0 ? (double)value_size * (double)stats.calls / seconds / (1024.0 * 1024.0) : 0.0);
+  printf("%-6s %10llu %12.1f %12.1f %12.1f %12.1f %14.1f\n",
+    name,
+    (unsigned long long)stats.calls,
+    (double)latency.total_ns / (double)(latency.count ? latency.count : 1) / 1000.0,
+    (double)latency.GetPercentile(50.0) / 1000.0,
+    (double)latency.GetPercentile(99.0) / 1000.0,
+    (double)latency.max_ns / 1000.0,
+    throughput);
+}
+
+static int runBench(const Options & options, Backend & backend)
+{
+  const std::string value = generateValue(options);
+
+  StatsRecorder recorder;
+  for(size_t i=0; i<options.iterations; i++)
+  {
+    //copy: the conversion to the clipboard formats is part of the measure
+    std::string input = value;
+    uint64_t start = StatsRecorder::GetTimestamp();
+    Backend::ItemList items;
+    bool success = encodeValue(options, input, items) && backend.Write(items);
+    recorder.Record(ClipboardStats::OperationSet, ClipboardStats::KindAll, success, value.size(), StatsRecorder::GetTimestamp() - start);
+    if (!success)
+    {
+      fprintf(stderr, "Failed copying to the clipboard.\n");
+      return 1;
+    }
+
+    //paste
+    std::string output;
+    start = StatsRecorder::GetTimestamp();
+    success = decodeValue(options, backend, output);
+    recorder.Record(ClipboardStats::OperationGet, ClipboardStats::KindAll, success, output.size(), StatsRecorder::GetTimestamp() - start);
+    if (!success || (options.format != ValueImage && options.newline == NewlineKeep && output != value))
+    {
+      fprintf(stderr, "Failed pasting from the clipboard.\n");
+      return 1;
+    }
+  }
+
+  ClipboardStats stats;
+  recorder.GetStats(stats);
+  printf("backend: %s, value size: %llu bytes, iterations: %llu\n", options.backend.c_str(), (unsigned long long)value.size(), (unsigned long long)options.iterations);
+  printf("%-6s %10s %12s %12s %12s %12s %14s\n", "op", "count", "mean (us)", "p50 (us)", "p99 (us)", "max (us)", "MiB/s");
+  printLatency("copy", stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindAll), value.size());
+  printLatency("paste", stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindAll), value.size());
+  return 0;
+}
+
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  if (!parseOptions(argc, argv, options))
+  {
+    printUsage();
+    return 2;
+  }
+
+#ifdef _WIN32
+  //values are streamed unmodified
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+  Backend * backend = createBackend(options);
+  if (backend == NULL)
+    return 2;
+
+  int exit_code = 2;
+  if (options.command == "copy")
+    exit_code = runCopy(options, *backend);
+  else if (options.command == "paste")
+    exit_code = runPaste(options, *backend);
+  else if (options.command == "formats")
+    exit_code = runFormats(*backend);
+  else if (options.command == "clear")
+    exit_code = runClear(*backend);
+  else if (options.command == "bench")
+    exit_code = runBench(options, *backend);
+  else
+    printUsage();
+
+  delete backend;
+  return exit_code;
+}
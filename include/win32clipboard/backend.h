@@ -0,0 +1,317 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_BACKEND_H
+#define WIN32CLIPBOARD_BACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Storage of the clipboard content as a list of formats identified by name, each holding a binary payload.
+  /// </summary>
+  /// <remarks>
+  /// Payloads are stored exactly as they are in the clipboard memory.
+  /// For instance, the payload of the CF_TEXT format includes the terminating \0 character.
+  /// </remarks>
+  class Backend
+  {
+  public:
+    /// <summary>
+    /// A format and its payload.
+    /// </summary>
+    struct Item
+    {
+      std::string format;
+      std::string data;
+    };
+
+    typedef std::vector<Item> ItemList;
+    typedef std::vector<std::string> StringVector;
+
+    //names of the formats used by the library
+    static const char * const FORMAT_TEXT;          //CF_TEXT
+    static const char * const FORMAT_UNICODE;       //CF_UNICODETEXT
+    static const char * const FORMAT_DIB;           //CF_DIB
+    static const char * const FORMAT_DIBV5;         //CF_DIBV5
+    static const char * const FORMAT_HDROP;         //CF_HDROP
+    static const char * const FORMAT_BINARY;        //Binary
+    static const char * const FORMAT_DROP_EFFECT;   //Preferred DropEffect
+    static const char * const FORMAT_HTML;          //HTML Format
+    static const char * const FORMAT_PNG;           //PNG
+
+    virtual ~Backend();
+
+    /// <summary>
+    /// Replace the content of the clipboard with the given formats.
+    /// </summary>
+    /// <param name="iItems">The formats and their payload.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool Write(const ItemList & iItems) = 0;
+
+    /// <summary>
+    /// Provides the payload of the given format.
+    /// </summary>
+    /// <param name="iFormat">The name of the format.</param>
+    /// <param name="oData">The output payload of the format.</param>
+    /// <returns>Returns true if the clipboard contains the given format. Returns false otherwise.</returns>
+    virtual bool Read(const std::string & iFormat, std::string & oData) = 0;
+
+    /// <summary>
+    /// Provides the names of the formats of the clipboard.
+    /// </summary>
+    /// <param name="oFormats">The output names of the formats.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool GetFormats(StringVector & oFormats) = 0;
+
+    /// <summary>
+    /// Clear the clipboard.
+    /// </summary>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool Empty() = 0;
+  };
+
+  /// <summary>
+  /// A clipboard that lives in the memory of the process.
+  /// </summary>
+  /// <remarks>
+  /// The backend is thread-safe. Each Write() publishes a new immutable snapshot of the content by swapping a pointer.
+  /// Readers never take a lock: they pin the current snapshot in a reader slot and retry only if a write replaced it meanwhile.
+  /// Replaced snapshots are deleted by the next writes, once no reader has them pinned.
+  /// </remarks>
+  class MemoryBackend : public Backend
+  {
+  public:
+    MemoryBackend();
+    virtual ~MemoryBackend();
+
+  private:
+    //non-copyable
+    MemoryBackend(const MemoryBackend &);
+    MemoryBackend & operator=(const MemoryBackend &);
+
+  public:
+    virtual bool Write(const ItemList & iItems);
+    virtual bool Read(const std::string & iFormat, std::string & oData);
+    virtual bool GetFormats(StringVector & oFormats);
+    virtual bool Empty();
+
+    /// <summary>
+    /// Returns the number of times the content of the clipboard changed.
+    /// </summary>
+    /// <returns>Returns the number of times the content of the clipboard changed.</returns>
+    uint64_t GetSequence() const;
+
+  private:
+    struct Snapshot;
+    struct ReaderSlot;
+
+    const Snapshot * pin(size_t & oSlot) const;
+    void unpin(size_t iSlot) const;
+    void publish(Snapshot * iSnapshot);
+    void reclaim();
+
+  private:
+    std::mutex mMutex;                        //serializes the writers
+    std::atomic<const Snapshot *> mSnapshot;  //current content
+    ReaderSlot * mSlots;                      //snapshots pinned by the readers
+    std::vector<const Snapshot *> mRetired;   //replaced snapshots that may still be pinned
+  };
+
+  /// <summary>
+  /// A clipboard stored in a file, which can be shared between processes.
+  /// </summary>
+  /// <remarks>
+  /// Write() replaces the file atomically: the content is written to a temporary file which is then renamed.
+  /// A missing file is an empty clipboard.
+  /// </remarks>
+  class FileBackend : public Backend
+  {
+  public:
+    /// <summary>
+    /// Create a backend stored in the given file.
+    /// </summary>
+    /// <param name="iPath">The path of the file.</param>
+    FileBackend(const std::string & iPath);
+    virtual ~FileBackend();
+
+    /// <summary>
+    /// Returns the path of the file of the backend.
+    /// </summary>
+    /// <returns>Returns the path of the file of the backend.</returns>
+    const std::string & GetPath() const;
+
+    virtual bool Write(const ItemList & iItems);
+    virtual bool Read(const std::string & iFormat, std::string & oData);
+    virtual bool GetFormats(StringVector & oFormats);
+    virtual bool Empty();
+
+  private:
+    bool load(ItemList & oItems);
+
+  private:
+    std::string mPath;
+  };
+
+#ifdef _WIN32
+  /// <summary>
+  /// The clipboard of Windows.
+  /// </summary>
+  /// <remarks>
+  /// Formats named after a standard clipboard format (for instance "CF_TEXT") use that format.
+  /// Other names are registered with RegisterClipboardFormat().
+  /// </remarks>
+  class Win32Backend : public Backend
+  {
+  public:
+    Win32Backend();
+    virtual ~Win32Backend();
+
+    virtual bool Write(const ItemList & iItems);
+    virtual bool Read(const std::string & iFormat, std::string & oData);
+    virtual bool GetFormats(StringVector & oFormats);
+    virtual bool Empty();
+  };
+#endif //_WIN32
+
+#ifdef __linux__
+  /// <summary>
+  /// A clipboard stored in a POSIX shared memory segment, which can be shared between processes.
+  /// </summary>
+  /// <remarks>
+  /// The segment is protected by a process-shared robust mutex. Open(), Clear(), SetData(), GetData() and Close() have the
+  /// same semantics as OpenClipboard(), EmptyClipboard(), SetClipboardData(), GetClipboardData() and CloseClipboard().
+  /// If a process dies while the clipboard is opened, the next process that opens the clipboard finds it empty.
+  /// The Backend functions open and close the clipboard by themselves.
+  /// A SharedMemoryBackend instance must not be opened by more than one thread at a time.
+  /// </remarks>
+  class SharedMemoryBackend : public Backend
+  {
+  public:
+    static const size_t MAX_FORMATS = 32;
+    static const size_t MAX_FORMAT_NAME_LENGTH = 63;
+
+    /// <summary>
+    /// Create or attach to the shared memory segment of the given name.
+    /// </summary>
+    /// <param name="iName">The name of the segment, for instance "/win32clipboard".</param>
+    /// <param name="iCapacity">The maximum size in bytes of the payloads of all formats. Ignored if the segment already exists.</param>
+    SharedMemoryBackend(const std::string & iName, size_t iCapacity);
+    virtual ~SharedMemoryBackend();
+
+  private:
+    //non-copyable
+    SharedMemoryBackend(const SharedMemoryBackend &);
+    SharedMemoryBackend & operator=(const SharedMemoryBackend &);
+
+  public:
+    /// <summary>
+    /// Returns true if the shared memory segment is mapped.
+    /// </summary>
+    /// <returns>Returns true if the shared memory segment is mapped. Returns false otherwise.</returns>
+    bool IsValid() const;
+
+    /// <summary>
+    /// Returns the maximum size in bytes of the payloads of all formats.
+    /// </summary>
+    /// <returns>Returns the maximum size in bytes of the payloads of all formats. Returns 0 if the segment is not mapped.</returns>
+    size_t GetCapacity() const;
+
+    /// <summary>
+    /// Remove the shared memory segment of the given name. Processes that are attached to the segment keep using it.
+    /// </summary>
+    /// <param name="iName">The name of the segment.</param>
+    /// <returns>Returns true if the segment was removed. Returns false otherwise.</returns>
+    static bool Remove(const std::string & iName);
+
+    /// <summary>
+    /// Open the clipboard for exclusive access.
+    /// </summary>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard is opened by another process for too long.</returns>
+    bool Open();
+
+    /// <summary>
+    /// Close the clipboard.
+    /// </summary>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard is not opened.</returns>
+    bool Close();
+
+    /// <summary>
+    /// Remove all formats of the opened clipboard.
+    /// </summary>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard is not opened.</returns>
+    bool Clear();
+
+    /// <summary>
+    /// Set the payload of a format of the opened clipboard.
+    /// </summary>
+    /// <param name="iFormat">The name of the format.</param>
+    /// <param name="iData">The payload.</param>
+    /// <param name="iSize">The size in bytes of the payload.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard is not opened or if the segment is full.</returns>
+    bool SetData(const std::string & iFormat, const void * iData, size_t iSize);
+
+    /// <summary>
+    /// Provides a view over the payload of a format of the opened clipboard, without copying it.
+    /// </summary>
+    /// <param name="iFormat">The name of the format.</param>
+    /// <param name="oData">The output address of the payload in the shared memory segment. The view is valid until the clipboard is closed.</param>
+    /// <param name="oSize">The output size in bytes of the payload.</param>
+    /// <returns>Returns true if the clipboard is opened and contains the given format. Returns false otherwise.</returns>
+    bool GetData(const std::string & iFormat, const char *& oData, size_t & oSize);
+
+    /// <summary>
+    /// Returns the number of times the content of the clipboard changed.
+    /// </summary>
+    /// <returns>Returns the number of times the content of the clipboard changed.</returns>
+    uint64_t GetSequence() const;
+
+    virtual bool Write(const ItemList & iItems);
+    virtual bool Read(const std::string & iFormat, std::string & oData);
+    virtual bool GetFormats(StringVector & oFormats);
+    virtual bool Empty();
+
+  private:
+    struct Segment;
+
+    bool lock();
+    void unlock();
+    bool setData(const std::string & iFormat, const void * iData, size_t iSize);
+
+  private:
+    Segment * mSegment;
+    size_t mMappingSize;
+    bool mOpened;
+  };
+#endif //__linux__
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_BACKEND_H
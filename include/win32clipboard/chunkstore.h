@@ -0,0 +1,220 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#ifndef WIN32CLIPBOARD_CHUNKSTORE_H
+#define WIN32CLIPBOARD_CHUNKSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "win32clipboard/backend.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Find the end of the first content-defined chunk of a buffer.
+  /// </summary>
+  /// <param name="data">The buffer to split.</param>
+  /// <param name="size">The size of the buffer in bytes.</param>
+  /// <param name="min_size">The minimum size of a chunk. No boundary is searched in the first min_size bytes.</param>
+  /// <param name="avg_size">The expected size of a chunk. Must be a power of 2.</param>
+  /// <param name="max_size">The maximum size of a chunk.</param>
+  /// <returns>Returns the size in bytes of the first chunk.</returns>
+  /// <remarks>
+  /// The boundaries are found with the FastCDC algorithm: a gear hash is rolled over the buffer and a boundary is placed
+  /// where the hash matches a mask. A stricter mask is used before avg_size and a looser one after it, which concentrates
+  /// the sizes of the chunks around avg_size. Boundaries only depend on the bytes around them: an edit only changes the
+  /// chunks that contain it.
+  /// </remarks>
+  size_t find_chunk_boundary(const char * data, size_t size, size_t min_size, size_t avg_size, size_t max_size);
+
+  /// <summary>
+  /// A deduplicating, content-addressed store of payloads in a directory.
+  /// </summary>
+  /// <remarks>
+  /// Payloads are split into content-defined chunks (see find_chunk_boundary()) and each distinct chunk is stored once,
+  /// so that successive versions of a document only use the space of the chunks that changed.
+  /// The directory contains three append-only files: the chunks (chunks.pack), the index of the chunks (chunks.idx)
+  /// and the list of chunks of each payload (payloads.idx). Incomplete records left by an interrupted write are ignored.
+  /// Payloads are reassembled by memory-mapping the chunks file and gathering their chunks.
+  /// Payloads and chunks are identified by a non-cryptographic 128 bit hash of their content. The bytes are compared
+  /// before an identifier is reused: a content whose identifier collides with a different stored content is rejected.
+  /// A ChunkStore instance is not thread-safe and a directory must not be written by more than one instance at a time.
+  /// </remarks>
+  class ChunkStore
+  {
+  public:
+    static const size_t DEFAULT_MIN_CHUNK_SIZE = 2 * 1024;
+    static const size_t DEFAULT_AVG_CHUNK_SIZE = 8 * 1024;
+    static const size_t DEFAULT_MAX_CHUNK_SIZE = 64 * 1024;
+
+    /// <summary>
+    /// The identifier of a payload.
+    /// </summary>
+    struct Id
+    {
+      uint64_t low;
+      uint64_t high;
+
+      bool operator==(const Id & iOther) const { return low == iOther.low && high == iOther.high; }
+      bool operator!=(const Id & iOther) const { return !(*this == iOther); }
+      bool operator<(const Id & iOther) const { return high < iOther.high || (high == iOther.high && low < iOther.low); }
+    };
+
+    /// <summary>
+    /// Open the store of the given directory.
+    /// </summary>
+    /// <param name="iDirectory">The directory of the store. The directory is created if it does not exist.</param>
+    /// <param name="iMinChunkSize">The minimum size of a chunk.</param>
+    /// <param name="iAvgChunkSize">The expected size of a chunk. Must be a power of 2.</param>
+    /// <param name="iMaxChunkSize">The maximum size of a chunk.</param>
+    ChunkStore(const std::string & iDirectory,
+      size_t iMinChunkSize = DEFAULT_MIN_CHUNK_SIZE,
+      size_t iAvgChunkSize = DEFAULT_AVG_CHUNK_SIZE,
+      size_t iMaxChunkSize = DEFAULT_MAX_CHUNK_SIZE);
+    virtual ~ChunkStore();
+
+  private:
+    //non-copyable
+    ChunkStore(const ChunkStore &);
+    ChunkStore & operator=(const ChunkStore &);
+
+  public:
+    /// <summary>
+    /// Returns true if the files of the store were loaded.
+    /// </summary>
+    /// <returns>Returns true if the files of the store were loaded. Returns false otherwise.</returns>
+    bool IsValid() const;
+
+    /// <summary>
+    /// Store a payload.
+    /// </summary>
+    /// <param name="iData">The payload.</param>
+    /// <param name="iSize">The size of the payload in bytes.</param>
+    /// <param name="oId">The output identifier of the payload.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise, including when the payload or one of its
+    /// chunks has the identifier of a different content of the store.</returns>
+    /// <remarks>Only the chunks that are not already in the store are written.</remarks>
+    bool Put(const char * iData, size_t iSize, Id & oId);
+    bool Put(const std::string & iPayload, Id & oId);
+
+    /// <summary>
+    /// Reassemble a payload.
+    /// </summary>
+    /// <param name="iId">The identifier of the payload.</param>
+    /// <param name="oPayload">The output payload.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the payload is not in the store.</returns>
+    bool Get(const Id & iId, std::string & oPayload);
+
+    /// <summary>
+    /// Query the store to know if it contains a payload.
+    /// </summary>
+    /// <param name="iId">The identifier of the payload.</param>
+    /// <returns>Returns true if the payload is in the store. Returns false otherwise.</returns>
+    bool Contains(const Id & iId) const;
+
+    /// <summary>
+    /// Store the content of a backend: each format is stored as a payload, followed by the list of formats.
+    /// </summary>
+    /// <param name="iBackend">The backend to save.</param>
+    /// <param name="oId">The output identifier of the snapshot.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    bool SaveSnapshot(Backend & iBackend, Id & oId);
+
+    /// <summary>
+    /// Replace the content of a backend with a snapshot.
+    /// </summary>
+    /// <param name="iId">The identifier of the snapshot.</param>
+    /// <param name="iBackend">The backend to restore.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    bool RestoreSnapshot(const Id & iId, Backend & iBackend);
+
+    /// <summary>
+    /// Returns the number of payloads in the store.
+    /// </summary>
+    /// <returns>Returns the number of payloads in the store.</returns>
+    size_t GetPayloadCount() const;
+
+    /// <summary>
+    /// Returns the number of distinct chunks in the store.
+    /// </summary>
+    /// <returns>Returns the number of distinct chunks in the store.</returns>
+    size_t GetChunkCount() const;
+
+    /// <summary>
+    /// Returns the size of all payloads of the store, as if they were stored without deduplication.
+    /// </summary>
+    /// <returns>Returns the size of all payloads of the store.</returns>
+    uint64_t GetPayloadBytes() const;
+
+    /// <summary>
+    /// Returns the size of the chunks stored on disk.
+    /// </summary>
+    /// <returns>Returns the size of the chunks stored on disk.</returns>
+    uint64_t GetChunkBytes() const;
+
+  private:
+    struct Chunk
+    {
+      uint64_t offset;  //offset in the chunks file
+      uint64_t size;
+    };
+
+    struct Payload
+    {
+      uint64_t size;
+      std::vector<Id> chunks;
+    };
+
+    typedef std::map<Id, Chunk> ChunkMap;
+    typedef std::map<Id, Payload> PayloadMap;
+
+    bool load();
+    std::string getPath(const char * iName) const;
+    bool map();
+    void unmap();
+    bool isStored(const Chunk & iChunk, const char * iData, size_t iSize);
+    bool isStored(const Payload & iPayload, const char * iData, size_t iSize);
+
+  private:
+    std::string mDirectory;
+    size_t mMinChunkSize;
+    size_t mAvgChunkSize;
+    size_t mMaxChunkSize;
+    bool mValid;
+    ChunkMap mChunks;
+    PayloadMap mPayloads;
+    uint64_t mPackSize;           //size of the valid part of the chunks file
+    uint64_t mChunkIndexSize;     //size of the valid part of the index of the chunks
+    uint64_t mPayloadIndexSize;   //size of the valid part of the index of the payloads
+    uint64_t mPayloadBytes;
+    const char * mMapping;        //view of the chunks file
+    uint64_t mMappingSize;
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_CHUNKSTORE_H
@@ -0,0 +1,83 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#ifndef WIN32CLIPBOARD_DELTA_H
+#define WIN32CLIPBOARD_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Checksums of the blocks of a base version, used to encode a new version as a delta against it.
+  /// </summary>
+  struct DeltaSignature
+  {
+    size_t block_size;                  //size in bytes of the blocks
+    size_t base_size;                   //size in bytes of the base version
+    uint64_t base_hash;                 //hash64() of the base version
+    std::vector<uint32_t> weak_sums;    //rolling checksum of each complete block
+    std::vector<uint64_t> strong_sums;  //hash64() of each complete block
+  };
+
+  /// <summary>
+  /// Compute the signature of a base version.
+  /// </summary>
+  /// <param name="base">The base version.</param>
+  /// <param name="base_size">The size of the base version in bytes.</param>
+  /// <param name="block_size">The size in bytes of the blocks. Smaller blocks find more matches but make bigger signatures.</param>
+  /// <param name="signature">The output signature.</param>
+  /// <remarks>The signature uses 12 bytes per block. The incomplete last block is not part of the signature.</remarks>
+  void compute_signature(const char * base, size_t base_size, size_t block_size, DeltaSignature & signature);
+
+  /// <summary>
+  /// Encode a new version as a delta against the base version of a signature.
+  /// </summary>
+  /// <param name="signature">The signature of the base version.</param>
+  /// <param name="target">The new version.</param>
+  /// <param name="target_size">The size of the new version in bytes.</param>
+  /// <param name="delta">The output delta: references to blocks of the base version and literal bytes.</param>
+  /// <remarks>
+  /// The delta is computed with the rsync algorithm: a rolling checksum is computed at every offset of the new version
+  /// and the blocks of the base version with the same checksum are confirmed with their strong hash.
+  /// Only the signature is required, not the base version itself.
+  /// </remarks>
+  void compute_delta(const DeltaSignature & signature, const char * target, size_t target_size, std::string & delta);
+
+  /// <summary>
+  /// Rebuild a new version from its base version and a delta.
+  /// </summary>
+  /// <param name="base">The base version.</param>
+  /// <param name="base_size">The size of the base version in bytes.</param>
+  /// <param name="delta">The delta computed by compute_delta().</param>
+  /// <param name="delta_size">The size of the delta in bytes.</param>
+  /// <param name="target">The output new version.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the delta is malformed or was not computed against the given base version.</returns>
+  bool apply_delta(const char * base, size_t base_size, const char * delta, size_t delta_size, std::string & target);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_DELTA_H
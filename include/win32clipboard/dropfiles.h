@@ -0,0 +1,161 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_DROPFILES_H
+#define WIN32CLIPBOARD_DROPFILES_H
+
+#include <stddef.h>
+#include <vector>
+#include <string>
+
+#include "win32clipboard/normalize.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Size in bytes of the DROPFILES structure that starts a CF_HDROP buffer.
+  /// </summary>
+  static const size_t DROPFILES_HEADER_SIZE = 20;
+
+  /// <summary>
+  /// A list of file paths stored in a single contiguous string pool.
+  /// </summary>
+  /// <remarks>
+  /// Each file path is stored NULL terminated in the pool and located with an offset index.
+  /// Adding N file paths requires O(log N) allocations instead of one allocation per file path.
+  /// </remarks>
+  class DropFileList
+  {
+  public:
+    DropFileList();
+
+    /// <summary>
+    /// Returns the number of file paths in the list.
+    /// </summary>
+    /// <returns>Returns the number of file paths in the list.</returns>
+    size_t GetCount() const;
+
+    /// <summary>
+    /// Returns the file path at the given index.
+    /// </summary>
+    /// <param name="index">The index of the file path.</param>
+    /// <returns>Returns a NULL terminated file path. The pointer is valid until the list is modified.</returns>
+    const char * GetPath(size_t index) const;
+
+    /// <summary>
+    /// Returns the length in bytes of the file path at the given index.
+    /// </summary>
+    /// <param name="index">The index of the file path.</param>
+    /// <returns>Returns the length in bytes of the file path, without the NULL terminating character.</returns>
+    size_t GetLength(size_t index) const;
+
+    /// <summary>
+    /// Add a file path at the end of the list.
+    /// </summary>
+    /// <param name="path">The file path to add.</param>
+    /// <param name="length">The length in bytes of the file path.</param>
+    void Append(const char * path, size_t length);
+
+    /// <summary>
+    /// Remove all file paths from the list.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Copy the file paths of the list to a vector of strings.
+    /// </summary>
+    /// <param name="files">The output list of file paths.</param>
+    void ToVector(std::vector<std::string> & files) const;
+
+    /// <summary>
+    /// Convert all file paths of the list to the given normalization form.
+    /// </summary>
+    /// <param name="form">The normalization form.</param>
+    /// <returns>Returns true if the function is successful. Returns false if a file path is not a valid utf8-encoded string.</returns>
+    /// <remarks>
+    /// File paths copied from macOS shares are usually decomposed (NFD) while Windows applications use composed file paths (NFC).
+    /// Normalizing both lists to the same form allows to compare them byte per byte.
+    /// The pool is not modified if all file paths are already normalized. File paths that are not valid UTF-8 are left unmodified.
+    /// </remarks>
+    bool Normalize(NormalizationForm form);
+
+  private:
+    friend bool decode_dropfiles(const void * buffer, size_t size, DropFileList & files, bool & is_wide);
+
+    std::string mPool;             //all file paths, each one NULL terminated
+    std::vector<size_t> mOffsets;  //offset of each file path in the pool
+  };
+
+  /// <summary>
+  /// Compute the exact size of the CF_HDROP buffer required for encoding the given list of files.
+  /// </summary>
+  /// <param name="files">The list of utf8-encoded file paths.</param>
+  /// <returns>Returns the size in bytes of the buffer required by encode_dropfiles().</returns>
+  /// <remarks>The size is computed without decoding or validating the file paths.</remarks>
+  size_t get_dropfiles_size(const std::vector<std::string> & files);
+
+  /// <summary>
+  /// Encode the given list of files as a CF_HDROP buffer (a DROPFILES structure followed by a list of wide-character file paths).
+  /// </summary>
+  /// <param name="files">The list of utf8-encoded file paths.</param>
+  /// <param name="buffer">The output buffer. Must be at least get_dropfiles_size() bytes.</param>
+  /// <param name="size">The size in bytes of the output buffer.</param>
+  /// <returns>Returns true if the function is successful. Returns false if a file path is not a valid utf8-encoded string or if the buffer is too small.</returns>
+  /// <remarks>The file paths are transcoded from UTF-8 to UTF-16 directly into the output buffer.</remarks>
+  bool encode_dropfiles(const std::vector<std::string> & files, void * buffer, size_t size);
+
+  /// <summary>
+  /// Decode a CF_HDROP buffer.
+  /// </summary>
+  /// <param name="buffer">The CF_HDROP buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="files">The output list of file paths.</param>
+  /// <param name="is_wide">Set to true if the buffer contains wide-character file paths. Set to false if the buffer contains ansi file paths.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the buffer is malformed.</returns>
+  /// <remarks>
+  /// Wide-character file paths are converted to UTF-8. Unpaired surrogates are replaced by U+FFFD.
+  /// Ansi file paths are returned unmodified.
+  /// The function runs in linear time: the buffer is decoded into a DropFileList whose file paths are then copied to the vector.
+  /// </remarks>
+  bool decode_dropfiles(const void * buffer, size_t size, std::vector<std::string> & files, bool & is_wide);
+
+  /// <summary>
+  /// Decode a CF_HDROP buffer into a pooled list of files.
+  /// </summary>
+  /// <param name="buffer">The CF_HDROP buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="files">The output list of file paths.</param>
+  /// <param name="is_wide">Set to true if the buffer contains wide-character file paths. Set to false if the buffer contains ansi file paths.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the buffer is malformed.</returns>
+  /// <remarks>
+  /// Wide-character file paths are converted to UTF-8. Unpaired surrogates are replaced by U+FFFD.
+  /// Ansi file paths are returned unmodified.
+  /// The size of the pool is computed exactly before the file paths are written to it: the function
+  /// runs in linear time and does not limit the length of the file paths.
+  /// </remarks>
+  bool decode_dropfiles(const void * buffer, size_t size, DropFileList & files, bool & is_wide);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_DROPFILES_H
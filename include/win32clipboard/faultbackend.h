@@ -0,0 +1,144 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_FAULTBACKEND_H
+#define WIN32CLIPBOARD_FAULTBACKEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <atomic>
+
+#include "win32clipboard/backend.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Faults and latencies injected by a FaultBackend.
+  /// </summary>
+  /// <remarks>The default values inject nothing and retry like the Windows clipboard of the library: 5 attempts, 50 ms apart.</remarks>
+  struct FaultOptions
+  {
+    FaultOptions();
+
+    uint64_t seed;                  //seed of the random decisions
+    double open_failure_rate;       //probability that an attempt to open the clipboard fails, like OpenClipboard() when another process holds it
+    size_t open_attempts;           //number of attempts to open the clipboard before the operation fails
+    uint32_t open_retry_delay_us;   //delay between two attempts, in microseconds
+    uint32_t max_hold_time_us;      //the clipboard is held opened for a random time up to this value, in microseconds
+    double slow_alloc_rate;         //probability that allocating the memory of a written format is slow
+    uint32_t slow_alloc_time_us;    //duration of a slow allocation, in microseconds
+    double partial_write_rate;      //probability that a write fails after storing only part of the formats
+  };
+
+  /// <summary>
+  /// Counters of a FaultBackend.
+  /// </summary>
+  struct FaultStats
+  {
+    uint64_t operations;            //number of Write(), Read(), GetFormats() and Empty() calls
+    uint64_t open_retries;          //number of failed attempts to open the clipboard that were retried
+    uint64_t open_failures;         //number of operations that failed because the clipboard could not be opened
+    uint64_t injected_failures;     //number of failed attempts caused by open_failure_rate
+    uint64_t contended_opens;       //number of failed attempts caused by an other thread holding the clipboard
+    uint64_t slow_allocations;
+    uint64_t partial_writes;
+  };
+
+  /// <summary>
+  /// A backend that injects the faults and latencies of a contended clipboard into an other backend.
+  /// </summary>
+  /// <remarks>
+  /// Each operation opens the decorated backend for exclusive access, like OpenClipboard(), and retries with the
+  /// delay and the number of attempts of the options. The decorated backend is only called while it is opened,
+  /// which also makes a backend that is not thread-safe usable from multiple threads.
+  /// Random decisions are derived from the seed, the index of the calling thread (see SetThreadIndex()) and the number of
+  /// operations of the thread so far: the same seed injects the same faults into the n-th operation of each thread,
+  /// whatever the scheduling of the other threads. Contention between the threads is not reproducible.
+  /// </remarks>
+  class FaultBackend : public Backend
+  {
+  public:
+    /// <summary>
+    /// Create a backend that injects faults into the given backend.
+    /// </summary>
+    /// <param name="iBackend">The decorated backend. The backend must outlive the FaultBackend.</param>
+    /// <param name="iOptions">The faults and latencies to inject.</param>
+    FaultBackend(Backend & iBackend, const FaultOptions & iOptions);
+    virtual ~FaultBackend();
+
+  private:
+    //non-copyable
+    FaultBackend(const FaultBackend &);
+    FaultBackend & operator=(const FaultBackend &);
+
+  public:
+    virtual bool Write(const ItemList & iItems);
+    virtual bool Read(const std::string & iFormat, std::string & oData);
+    virtual bool GetFormats(StringVector & oFormats);
+    virtual bool Empty();
+
+    /// <summary>
+    /// Returns the options of the backend.
+    /// </summary>
+    /// <returns>Returns the options of the backend.</returns>
+    const FaultOptions & GetOptions() const;
+
+    /// <summary>
+    /// Provides a snapshot of the counters of the backend.
+    /// </summary>
+    /// <param name="oStats">The output counters.</param>
+    void GetStats(FaultStats & oStats) const;
+
+    /// <summary>
+    /// Select the random stream of the calling thread for all FaultBackend instances.
+    /// </summary>
+    /// <param name="iIndex">The index of the thread. Threads that do not select an index use the index 0.</param>
+    /// <remarks>Threads that must inject different faults must use different indices.</remarks>
+    static void SetThreadIndex(uint64_t iIndex);
+
+  private:
+    void beginOperation();
+    void seekDecision(uint64_t iDecision);
+    uint64_t nextRandom();
+    bool decide(double iProbability);
+    bool open();
+
+  private:
+    Backend & mBackend;
+    FaultOptions mOptions;
+    std::mutex mMutex;                  //held while the clipboard is opened
+    uint64_t mInstance;                 //identifies the backend in the random streams of the threads
+    std::atomic<uint64_t> mOperations;
+    std::atomic<uint64_t> mOpenRetries;
+    std::atomic<uint64_t> mOpenFailures;
+    std::atomic<uint64_t> mInjectedFailures;
+    std::atomic<uint64_t> mContendedOpens;
+    std::atomic<uint64_t> mSlowAllocations;
+    std::atomic<uint64_t> mPartialWrites;
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_FAULTBACKEND_H
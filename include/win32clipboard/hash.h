@@ -0,0 +1,49 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_HASH_H
+#define WIN32CLIPBOARD_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Compute a fast non-cryptographic 64 bit hash of the given buffer.
+  /// </summary>
+  /// <param name="data">The buffer to hash.</param>
+  /// <param name="size">The size of the buffer in bytes.</param>
+  /// <param name="seed">The seed of the hash.</param>
+  /// <returns>Returns the 64 bit hash of the given buffer.</returns>
+  /// <remarks>
+  /// The hash is compatible with the XXH64 algorithm (see https://github.com/Cyan4973/xxHash).
+  /// The buffer is processed in 4 independent lanes of 8 bytes which allows the processor to hash 32 bytes per iteration.
+  /// The hash must not be used for security purposes.
+  /// </remarks>
+  uint64_t hash64(const void * data, size_t size, uint64_t seed = 0);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_HASH_H
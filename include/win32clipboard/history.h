@@ -0,0 +1,243 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_HISTORY_H
+#define WIN32CLIPBOARD_HISTORY_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <string>
+
+#include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/backend.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/image.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Bounded history of the clipboard content.
+  /// </summary>
+  /// <remarks>
+  /// Each recorded entry holds every known format of the clipboard at the time of the capture:
+  /// text, unicode text, image, binary data and the list of drag and drop files.
+  /// Entries are kept in a fixed-capacity ring and identified by a monotonically increasing sequence number.
+  /// The payloads of all formats of an entry are stored in a single contiguous block.
+  /// Blocks are allocated from an arena of 64 KiB chunks: small entries share a chunk and a chunk is released with its last block.
+  /// Blocks are deduplicated by content hash: recording content that is already in the history does not use more memory.
+  /// The oldest entries are evicted first when the capacity or the memory budget is exceeded.
+  /// </remarks>
+  class ClipboardHistory
+  {
+  public:
+#ifdef _WIN32
+    /// <summary>
+    /// Create an history that captures the content of the given clipboard.
+    /// </summary>
+    /// <param name="iClipboard">The clipboard to capture.</param>
+    /// <param name="iCapacity">The maximum number of entries kept in the history.</param>
+    /// <param name="iMaxBytes">The maximum number of bytes used by the payloads of all entries.</param>
+    /// <remarks>The Windows clipboard is only available on Windows. Other platforms capture a Backend.</remarks>
+    ClipboardHistory(Clipboard & iClipboard, size_t iCapacity, size_t iMaxBytes);
+#endif
+
+    /// <summary>
+    /// Create an history that captures the content of the given backend.
+    /// </summary>
+    /// <param name="iBackend">The backend to capture. The formats are read as stored by the Clipboard.</param>
+    /// <param name="iCapacity">The maximum number of entries kept in the history.</param>
+    /// <param name="iMaxBytes">The maximum number of bytes used by the payloads of all entries.</param>
+    ClipboardHistory(Backend & iBackend, size_t iCapacity, size_t iMaxBytes);
+
+    virtual ~ClipboardHistory();
+
+  private:
+    //non-copyable
+    ClipboardHistory(const ClipboardHistory &);
+    ClipboardHistory & operator=(const ClipboardHistory &);
+
+    struct Block;
+    struct Chunk;
+
+  public:
+    /// <summary>
+    /// A single capture of the clipboard content.
+    /// </summary>
+    class Entry
+    {
+      friend class ClipboardHistory;
+    public:
+      Entry();
+
+      /// <summary>
+      /// Returns the sequence number of the entry.
+      /// </summary>
+      /// <returns>Returns the sequence number of the entry.</returns>
+      uint64_t GetSequence() const;
+
+      /// <summary>
+      /// Returns the hash of the content of the entry.
+      /// </summary>
+      /// <returns>Returns the hash of the content of the entry.</returns>
+      uint64_t GetHash() const;
+
+      /// <summary>
+      /// Query the entry to know if it contains the given format.
+      /// </summary>
+      /// <param name="iClipboardFormat">The format to query.</param>
+      /// <returns>Returns true if the entry contains the given format. Returns false otherwise.</returns>
+      bool Contains(Clipboard::Format iClipboardFormat) const;
+
+      /// <summary>
+      /// Provides a read-only view of the payload of the given format.
+      /// </summary>
+      /// <param name="iClipboardFormat">The format to query.</param>
+      /// <param name="oData">The address of the payload. The view is valid until the entry is evicted from the history.</param>
+      /// <param name="oSize">The size in bytes of the payload.</param>
+      /// <returns>Returns true if the entry contains the given format. Returns false otherwise.</returns>
+      /// <remarks>The payload of FormatImage is a device independent bitmap (see parse_dib()).</remarks>
+      bool GetData(Clipboard::Format iClipboardFormat, const char *& oData, size_t & oSize) const;
+
+      /// <summary>
+      /// Provides the text value of the entry.
+      /// </summary>
+      /// <param name="oText">The output text value of the entry.</param>
+      /// <returns>Returns true if the entry contains a text value. Returns false otherwise.</returns>
+      bool GetAsText(std::string & oText) const;
+
+      /// <summary>
+      /// Provides the unicode text value of the entry.
+      /// </summary>
+      /// <param name="oText">The output unicode text value of the entry.</param>
+      /// <returns>Returns true if the entry contains an unicode text value. Returns false otherwise.</returns>
+      bool GetAsTextUnicode(std::wstring & oText) const;
+
+      /// <summary>
+      /// Provides the binary data of the entry.
+      /// </summary>
+      /// <param name="oMemoryBuffer">The output binary data of the entry.</param>
+      /// <returns>Returns true if the entry contains binary data. Returns false otherwise.</returns>
+      bool GetAsBinary(Clipboard::MemoryBuffer & oMemoryBuffer) const;
+
+      /// <summary>
+      /// Provides the image of the entry.
+      /// </summary>
+      /// <param name="oImage">The output image of the entry.</param>
+      /// <returns>Returns true if the entry contains an image. Returns false otherwise.</returns>
+      bool GetAsImage(Image & oImage) const;
+
+      /// <summary>
+      /// Provides the file operation and list of files of the entry.
+      /// </summary>
+      /// <param name="oDragDropType">The output file operation of the entry.</param>
+      /// <param name="oFiles">The output list of utf8-encoded files of the entry.</param>
+      /// <returns>Returns true if the entry contains a list of files. Returns false otherwise.</returns>
+      bool GetAsDragDropFiles(Clipboard::DragDropType & oDragDropType, DropFileList & oFiles) const;
+
+    private:
+      bool getSlot(size_t iSlot, const char *& oData, size_t & oSize) const;
+
+    private:
+      uint64_t mSequence;
+      Block * mBlock;
+    };
+
+    /// <summary>
+    /// Capture the current content of the clipboard and record it as a new entry.
+    /// </summary>
+    /// <returns>Returns true if a new entry was recorded. Returns false if the clipboard is empty,
+    /// if its content is identical to the most recent entry or if it is bigger than the memory budget.</returns>
+    virtual bool Update();
+
+    /// <summary>
+    /// Remove all entries from the history.
+    /// </summary>
+    virtual void Clear();
+
+    /// <summary>
+    /// Returns the number of entries in the history.
+    /// </summary>
+    /// <returns>Returns the number of entries in the history.</returns>
+    size_t GetCount() const;
+
+    /// <summary>
+    /// Returns the maximum number of entries in the history.
+    /// </summary>
+    /// <returns>Returns the maximum number of entries in the history.</returns>
+    size_t GetCapacity() const;
+
+    /// <summary>
+    /// Returns the number of bytes used by the payloads of all entries.
+    /// </summary>
+    /// <returns>Returns the number of bytes used by the payloads of all entries.</returns>
+    size_t GetMemoryUsage() const;
+
+    /// <summary>
+    /// Returns the sequence number of the oldest entry in the history.
+    /// </summary>
+    /// <returns>Returns the sequence number of the oldest entry in the history. Returns 0 if the history is empty.</returns>
+    uint64_t GetFirstSequence() const;
+
+    /// <summary>
+    /// Returns the sequence number of the most recent entry in the history.
+    /// </summary>
+    /// <returns>Returns the sequence number of the most recent entry in the history. Returns 0 if the history is empty.</returns>
+    uint64_t GetLastSequence() const;
+
+    /// <summary>
+    /// Find the entry matching the given sequence number.
+    /// </summary>
+    /// <param name="iSequence">The sequence number of the entry.</param>
+    /// <returns>Returns the matching entry. Returns NULL if the entry was evicted or does not exist.</returns>
+    const Entry * Find(uint64_t iSequence) const;
+
+  private:
+    void capture(std::string * oPayloads, bool * oPresent);
+    static bool isSameContent(const Entry & iEntry, const std::string * iPayloads, const bool * iPresent);
+    Block * acquireBlock(const std::string * iPayloads, const bool * iPresent);
+    void releaseBlock(Block * iBlock);
+    void * allocate(size_t iSize, Chunk *& oChunk);
+    void evictOldest();
+
+  private:
+    typedef std::multimap<uint64_t, Block *> BlockMap;
+
+    Clipboard * mClipboard;       //the captured clipboard, or NULL if a backend is captured
+    Backend * mBackend;
+    std::vector<Entry> mEntries;  //ring of entries
+    size_t mHead;                 //index of the oldest entry in the ring
+    size_t mCount;                //number of entries in the ring
+    size_t mMaxBytes;
+    size_t mUsedBytes;
+    uint64_t mNextSequence;
+    uint64_t mLastFingerprint;    //fingerprint of the clipboard at the last update
+    bool mHasLastFingerprint;
+    BlockMap mBlocks;             //blocks indexed by content hash
+    Chunk * mChunk;               //chunk of the arena where the next blocks are allocated
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_HISTORY_H
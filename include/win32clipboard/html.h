@@ -0,0 +1,76 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_HTML_H
+#define WIN32CLIPBOARD_HTML_H
+
+#include <stddef.h>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// A read-only view over the HTML document and fragment of a CF_HTML buffer.
+  /// </summary>
+  /// <remarks>The view does not copy the document. It is valid as long as the parsed buffer is valid.</remarks>
+  struct HtmlView
+  {
+    const char * html;      //utf8-encoded HTML document, without the CF_HTML header
+    size_t html_size;
+    const char * fragment;  //utf8-encoded HTML fragment, part of the document
+    size_t fragment_size;
+  };
+
+  /// <summary>
+  /// Returns the size of the CF_HTML buffer required for encoding the given HTML fragment.
+  /// </summary>
+  /// <param name="fragment_size">The size in bytes of the HTML fragment.</param>
+  /// <returns>Returns the size in bytes of the buffer required by encode_cf_html(), including the terminating \0 character.</returns>
+  size_t get_cf_html_size(size_t fragment_size);
+
+  /// <summary>
+  /// Encode an HTML fragment as a CF_HTML buffer.
+  /// </summary>
+  /// <param name="fragment">The utf8-encoded HTML fragment.</param>
+  /// <param name="fragment_size">The size in bytes of the HTML fragment.</param>
+  /// <param name="buffer">The output buffer. Must be at least get_cf_html_size() bytes.</param>
+  /// <param name="size">The size in bytes of the output buffer.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the buffer is too small.</returns>
+  /// <remarks>
+  /// The offsets of the header are written with a fixed width: the header is written once, directly followed by the document.
+  /// </remarks>
+  bool encode_cf_html(const char * fragment, size_t fragment_size, void * buffer, size_t size);
+
+  /// <summary>
+  /// Parse the header of a CF_HTML buffer to locate the HTML document and fragment.
+  /// </summary>
+  /// <param name="buffer">The CF_HTML buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="view">The output view over the document and the fragment.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the header is malformed or if the offsets are out of range.</returns>
+  /// <remarks>Only the header is read. The document itself is not scanned.</remarks>
+  bool parse_cf_html(const void * buffer, size_t size, HtmlView & view);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_HTML_H
@@ -0,0 +1,148 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_IMAGE_H
+#define WIN32CLIPBOARD_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// An image made of 32 bit RGBA pixels. Rows are stored top-down without padding.
+  /// </summary>
+  class Image
+  {
+  public:
+    Image();
+
+    /// <summary>
+    /// Allocate the pixels of the image. The content of the pixels is undefined.
+    /// </summary>
+    /// <param name="iWidth">The width of the image in pixels.</param>
+    /// <param name="iHeight">The height of the image in pixels.</param>
+    void Create(size_t iWidth, size_t iHeight);
+
+    /// <summary>
+    /// Returns the width of the image in pixels.
+    /// </summary>
+    /// <returns>Returns the width of the image in pixels.</returns>
+    size_t GetWidth() const;
+
+    /// <summary>
+    /// Returns the height of the image in pixels.
+    /// </summary>
+    /// <returns>Returns the height of the image in pixels.</returns>
+    size_t GetHeight() const;
+
+    /// <summary>
+    /// Returns the size in bytes of a row of pixels.
+    /// </summary>
+    /// <returns>Returns the size in bytes of a row of pixels.</returns>
+    size_t GetStride() const;
+
+    /// <summary>
+    /// Returns the pixels of the image.
+    /// </summary>
+    /// <returns>Returns the pixels of the image. Returns NULL if the image is empty.</returns>
+    unsigned char * GetPixels();
+    const unsigned char * GetPixels() const;
+
+  private:
+    size_t mWidth;
+    size_t mHeight;
+    std::vector<unsigned char> mPixels;
+  };
+
+  /// <summary>
+  /// A read-only view over the pixels of a device-independent bitmap (CF_DIB or CF_DIBV5) buffer.
+  /// </summary>
+  /// <remarks>The view does not copy the pixels. It is valid as long as the parsed buffer is valid.</remarks>
+  struct DibView
+  {
+    size_t width;
+    size_t height;
+    size_t bit_count;              //24 or 32 bits per pixel
+    size_t stride;                 //size in bytes of a row of pixels, including padding
+    bool bottom_up;                //true if the first row of pixels is the bottom row of the image
+    bool has_alpha;                //true if the alpha channel of 32 bit pixels is valid
+    const unsigned char * pixels;  //first row of pixels in BGR(A) order
+  };
+
+  /// <summary>
+  /// Parse the header of a device-independent bitmap buffer.
+  /// </summary>
+  /// <param name="buffer">The bitmap buffer, starting with a BITMAPINFOHEADER, BITMAPV4HEADER or BITMAPV5HEADER structure.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="view">The output view over the pixels of the buffer.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the buffer is malformed or uses an unsupported pixel format.</returns>
+  /// <remarks>Only uncompressed 24 and 32 bits per pixel bitmaps are supported.</remarks>
+  bool parse_dib(const void * buffer, size_t size, DibView & view);
+
+  /// <summary>
+  /// Decode the pixels of a device-independent bitmap into an image.
+  /// </summary>
+  /// <param name="view">The view over the pixels of the bitmap.</param>
+  /// <param name="image">The output image.</param>
+  /// <remarks>Row flipping, BGRA to RGBA conversion and 24 to 32 bits expansion are done in a single pass over the pixels.</remarks>
+  void decode_dib(const DibView & view, Image & image);
+
+  /// <summary>
+  /// Returns the size of the CF_DIBV5 buffer required for encoding the given image.
+  /// </summary>
+  /// <param name="image">The image to encode.</param>
+  /// <returns>Returns the size in bytes of the buffer required by encode_dib().</returns>
+  size_t get_dib_size(const Image & image);
+
+  /// <summary>
+  /// Encode an image as a CF_DIBV5 buffer (a BITMAPV5HEADER structure followed by bottom-up 32 bit BGRA pixels).
+  /// </summary>
+  /// <param name="image">The image to encode.</param>
+  /// <param name="buffer">The output buffer. Must be at least get_dib_size() bytes.</param>
+  /// <param name="size">The size in bytes of the output buffer.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the buffer is too small.</returns>
+  bool encode_dib(const Image & image, void * buffer, size_t size);
+
+  /// <summary>
+  /// Swap the red and blue channels of 32 bit pixels. Converts BGRA pixels to RGBA and RGBA pixels to BGRA.
+  /// </summary>
+  /// <param name="src">The source pixels.</param>
+  /// <param name="dst">The destination pixels. Can be the same as src.</param>
+  /// <param name="count">The number of pixels to convert.</param>
+  /// <param name="alpha">Bits OR-ed into the alpha channel. Use 0xFF to make the pixels opaque, 0 to keep the alpha channel.</param>
+  void swap_red_blue(const unsigned char * src, unsigned char * dst, size_t count, unsigned char alpha);
+
+  /// <summary>
+  /// Expand 24 bit BGR pixels to 32 bit opaque RGBA pixels.
+  /// </summary>
+  /// <param name="src">The source pixels.</param>
+  /// <param name="dst">The destination pixels. Must not overlap with src.</param>
+  /// <param name="count">The number of pixels to convert.</param>
+  void expand_bgr_to_rgba(const unsigned char * src, unsigned char * dst, size_t count);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_IMAGE_H
@@ -0,0 +1,235 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#ifndef WIN32CLIPBOARD_MIRROR_H
+#define WIN32CLIPBOARD_MIRROR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "win32clipboard/backend.h"
+#include "win32clipboard/delta.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// A channel that delivers messages in order between a MirrorSender and a MirrorReceiver.
+  /// </summary>
+  class Transport
+  {
+  public:
+    virtual ~Transport();
+
+    /// <summary>
+    /// Send a message to the other end of the channel.
+    /// </summary>
+    /// <param name="iMessage">The message to send.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool Send(const std::string & iMessage) = 0;
+
+    /// <summary>
+    /// Receive the next message sent by the other end of the channel, without waiting.
+    /// </summary>
+    /// <param name="oMessage">The output message.</param>
+    /// <returns>Returns true if a message was received. Returns false if there is no pending message.</returns>
+    virtual bool Receive(std::string & oMessage) = 0;
+  };
+
+  /// <summary>
+  /// One end of an in-process channel. Stands in for a pipe or a socket between two sessions.
+  /// </summary>
+  /// <remarks>The ends of a channel can be used from different threads.</remarks>
+  class LocalTransport : public Transport
+  {
+  public:
+    LocalTransport();
+    virtual ~LocalTransport();
+
+  private:
+    //non-copyable
+    LocalTransport(const LocalTransport &);
+    LocalTransport & operator=(const LocalTransport &);
+
+  public:
+    /// <summary>
+    /// Connect two ends of a channel: the messages sent by one end are received by the other end.
+    /// </summary>
+    /// <param name="iFirst">The first end of the channel.</param>
+    /// <param name="iSecond">The second end of the channel.</param>
+    static void Connect(LocalTransport & iFirst, LocalTransport & iSecond);
+
+    virtual bool Send(const std::string & iMessage);
+    virtual bool Receive(std::string & oMessage);
+
+    /// <summary>
+    /// Returns the number of bytes sent by this end of the channel.
+    /// </summary>
+    /// <returns>Returns the number of bytes sent by this end of the channel.</returns>
+    uint64_t GetBytesSent() const;
+
+  private:
+    LocalTransport * mPeer;
+    mutable std::mutex mMutex;
+    std::deque<std::string> mMessages;  //messages sent by the peer
+    uint64_t mBytesSent;
+  };
+
+  /// <summary>
+  /// Counters of a MirrorSender.
+  /// </summary>
+  struct MirrorStats
+  {
+    uint64_t updates;         //number of changes sent
+    uint64_t full_formats;    //number of formats sent in full
+    uint64_t delta_formats;   //number of formats sent as a delta
+    uint64_t payload_bytes;   //size of the payloads of the changed formats
+    uint64_t sent_bytes;      //size of the messages sent
+    uint64_t resyncs;         //number of resynchronizations requested by the receiver
+  };
+
+  /// <summary>
+  /// Watches a backend and sends its changes to a MirrorReceiver.
+  /// </summary>
+  /// <remarks>
+  /// Each change is sent as a single message with every format of the source backend.
+  /// Unchanged formats are sent as a hash. Large changed formats are sent as an rsync-style delta against the version
+  /// previously sent: only the blocks that are not found in the previous version are transferred.
+  /// The sender keeps the signature of the previous version of each format, not the payload itself.
+  /// </remarks>
+  class MirrorSender
+  {
+  public:
+    static const size_t DEFAULT_BLOCK_SIZE = 1024;
+
+    /// <summary>
+    /// Create a sender.
+    /// </summary>
+    /// <param name="iSource">The backend to watch.</param>
+    /// <param name="iTransport">The channel to the receiver.</param>
+    /// <param name="iBlockSize">The size in bytes of the blocks of the deltas. Payloads smaller than 4 blocks are always sent in full.</param>
+    MirrorSender(Backend & iSource, Transport & iTransport, size_t iBlockSize = DEFAULT_BLOCK_SIZE);
+    virtual ~MirrorSender();
+
+  private:
+    //non-copyable
+    MirrorSender(const MirrorSender &);
+    MirrorSender & operator=(const MirrorSender &);
+
+  public:
+    /// <summary>
+    /// Read the source backend and send its content if it changed since the last update.
+    /// </summary>
+    /// <returns>Returns true if a change was sent. Returns false if the content did not change or if the function failed.</returns>
+    /// <remarks>Resynchronization requests of the receiver are handled first: the next change is sent in full.</remarks>
+    virtual bool Update();
+
+    /// <summary>
+    /// Forget the versions previously sent. The next update sends every format in full.
+    /// </summary>
+    virtual void Reset();
+
+    /// <summary>
+    /// Provides the counters of the sender.
+    /// </summary>
+    /// <param name="oStats">The output counters.</param>
+    void GetStats(MirrorStats & oStats) const;
+
+  private:
+    struct FormatState
+    {
+      uint64_t hash;
+      DeltaSignature signature;
+    };
+    typedef std::map<std::string, FormatState> FormatStateMap;
+
+    Backend & mSource;
+    Transport & mTransport;
+    size_t mBlockSize;
+    FormatStateMap mFormats;  //versions previously sent
+    bool mReset;              //true if the next message must not refer to previous versions
+    MirrorStats mStats;
+  };
+
+  /// <summary>
+  /// Applies the changes sent by a MirrorSender to a backend.
+  /// </summary>
+  /// <remarks>
+  /// The receiver keeps the last version of each format to rebuild the deltas.
+  /// If a message cannot be applied (for instance after the receiver was restarted), the receiver asks the sender
+  /// to send the next change in full and ignores the messages until then.
+  /// </remarks>
+  class MirrorReceiver
+  {
+  public:
+    /// <summary>
+    /// Create a receiver.
+    /// </summary>
+    /// <param name="iDestination">The backend that receives the changes.</param>
+    /// <param name="iTransport">The channel to the sender.</param>
+    MirrorReceiver(Backend & iDestination, Transport & iTransport);
+    virtual ~MirrorReceiver();
+
+  private:
+    //non-copyable
+    MirrorReceiver(const MirrorReceiver &);
+    MirrorReceiver & operator=(const MirrorReceiver &);
+
+  public:
+    /// <summary>
+    /// Apply the pending messages of the sender to the destination backend.
+    /// </summary>
+    /// <returns>Returns true if at least one change was applied. Returns false otherwise.</returns>
+    virtual bool Update();
+
+    /// <summary>
+    /// Returns the number of messages that could not be applied.
+    /// </summary>
+    /// <returns>Returns the number of messages that could not be applied.</returns>
+    uint64_t GetErrorCount() const;
+
+  private:
+    bool apply(const std::string & iMessage);
+
+  private:
+    struct FormatVersion
+    {
+      uint64_t hash;
+      std::string data;
+    };
+    typedef std::map<std::string, FormatVersion> FormatVersionMap;
+
+    Backend & mDestination;
+    Transport & mTransport;
+    FormatVersionMap mFormats;  //versions last applied
+    bool mWaitingReset;         //true if a resynchronization was requested
+    uint64_t mErrors;
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_MIRROR_H
@@ -0,0 +1,65 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_NEWLINE_H
+#define WIN32CLIPBOARD_NEWLINE_H
+
+#include <stddef.h>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Returns the length of a string once its LF line endings are converted to CRLF.
+  /// </summary>
+  /// <param name="str">The string to measure.</param>
+  /// <param name="length">The length of the string in characters.</param>
+  /// <returns>Returns the length in characters of the converted string, without terminating character.</returns>
+  /// <remarks>LF characters that are already preceded by a CR character are not converted.</remarks>
+  size_t get_crlf_length(const char * str, size_t length);
+  size_t get_crlf_length(const wchar_t * str, size_t length);
+
+  /// <summary>
+  /// Convert the LF line endings of a string to CRLF.
+  /// </summary>
+  /// <param name="src">The string to convert.</param>
+  /// <param name="length">The length of the string in characters.</param>
+  /// <param name="dst">The output buffer. Must be at least get_crlf_length() characters and must not overlap with src.</param>
+  /// <returns>Returns the number of characters written to dst. No terminating character is written.</returns>
+  size_t lf_to_crlf(const char * src, size_t length, char * dst);
+  size_t lf_to_crlf(const wchar_t * src, size_t length, wchar_t * dst);
+
+  /// <summary>
+  /// Convert the CRLF line endings of a string to LF.
+  /// </summary>
+  /// <param name="src">The string to convert.</param>
+  /// <param name="length">The length of the string in characters.</param>
+  /// <param name="dst">The output buffer. Must be at least length characters. Can be the same as src for an in-place conversion.</param>
+  /// <returns>Returns the number of characters written to dst. No terminating character is written.</returns>
+  /// <remarks>CR characters that are not followed by a LF character are kept.</remarks>
+  size_t crlf_to_lf(const char * src, size_t length, char * dst);
+  size_t crlf_to_lf(const wchar_t * src, size_t length, wchar_t * dst);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_NEWLINE_H
@@ -0,0 +1,68 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_NORMALIZE_H
+#define WIN32CLIPBOARD_NORMALIZE_H
+
+#include <stddef.h>
+#include <string>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Unicode normalization forms of canonical equivalence.
+  /// </summary>
+  enum NormalizationForm
+  {
+    NormalizationNFC, //canonical decomposition followed by canonical composition, used by Windows
+    NormalizationNFD, //canonical decomposition, used by macOS file systems
+  };
+
+  /// <summary>
+  /// Query an UTF-8 string to know if it is in the given normalization form.
+  /// </summary>
+  /// <param name="str">The string to query.</param>
+  /// <param name="length">The length of the string in bytes.</param>
+  /// <param name="form">The normalization form.</param>
+  /// <returns>Returns true if the string is valid UTF-8 and is in the given normalization form. Returns false otherwise.</returns>
+  bool is_normalized_utf8(const char * str, size_t length, NormalizationForm form);
+
+  /// <summary>
+  /// Convert an UTF-8 string to the given normalization form.
+  /// </summary>
+  /// <param name="src">The string to convert.</param>
+  /// <param name="length">The length of the string in bytes.</param>
+  /// <param name="form">The normalization form.</param>
+  /// <param name="dst">The output normalized string.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the string is not valid UTF-8.</returns>
+  /// <remarks>
+  /// Runs of ASCII characters are skipped 16 bytes at a time and the other characters are checked with the quick check
+  /// property of the Unicode Standard Annex #15. Only the segments that fail the quick check are decomposed,
+  /// reordered and recomposed. A string that is already normalized is copied once.
+  /// </remarks>
+  bool normalize_utf8(const char * src, size_t length, NormalizationForm form, std::string & dst);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_NORMALIZE_H
@@ -0,0 +1,61 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_PNG_H
+#define WIN32CLIPBOARD_PNG_H
+
+#include <stddef.h>
+#include <string>
+
+#include "win32clipboard/image.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Encode an image as a PNG file.
+  /// </summary>
+  /// <param name="image">The image to encode.</param>
+  /// <param name="png">The output PNG file.</param>
+  /// <param name="num_threads">The maximum number of threads used for encoding. Use 0 to use one thread per hardware thread.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the image is empty.</returns>
+  /// <remarks>
+  /// The image is encoded as 8 bit RGB if all pixels are opaque and as 8 bit RGBA otherwise.
+  /// Rows are split in blocks which are filtered and compressed in parallel. Each block is compressed
+  /// with the end of the previous block as dictionary so that the compression ratio stays close to a single-threaded encoder.
+  /// </remarks>
+  bool encode_png(const Image & image, std::string & png, size_t num_threads = 0);
+
+  /// <summary>
+  /// Decode a PNG file into an image.
+  /// </summary>
+  /// <param name="buffer">The PNG file.</param>
+  /// <param name="size">The size in bytes of the PNG file.</param>
+  /// <param name="image">The output image.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the file is malformed or uses an unsupported feature.</returns>
+  /// <remarks>All color types and bit depths are supported. Interlaced images are not supported.</remarks>
+  bool decode_png(const void * buffer, size_t size, Image & image);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_PNG_H
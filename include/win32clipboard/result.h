@@ -0,0 +1,77 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_RESULT_H
+#define WIN32CLIPBOARD_RESULT_H
+
+#include <stdint.h>
+#include <string>
+
+#include "win32clipboard/stats.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// The result of a clipboard operation.
+  /// </summary>
+  /// <remarks>
+  /// The result is a small value recorded without allocations when the operation ends.
+  /// The message describing the result is only formatted when GetDescription() is called.
+  /// </remarks>
+  struct ClipboardResult
+  {
+    enum Code
+    {
+      CodeSuccess,
+      CodeFailed,               //the operation failed for an other reason, for instance invalid data
+      CodeOpenFailed,           //the clipboard could not be opened
+      CodeEmptyFailed,          //the clipboard could not be emptied
+      CodeFormatNotAvailable,   //the clipboard does not contain the format
+      CodeOutOfMemory,          //the clipboard memory could not be allocated
+      CodeLockFailed,           //the clipboard memory could not be locked
+      CodeSetDataFailed,        //the data could not be placed on the clipboard
+    };
+
+    Code code;
+    uint32_t system_code;                   //error code of the failed system call. 0 if the failure is not caused by a system call.
+    ClipboardStats::Operation operation;
+    ClipboardStats::Kind kind;
+
+    /// <summary>
+    /// Returns true if the operation was successful.
+    /// </summary>
+    /// <returns>Returns true if the operation was successful. Returns false otherwise.</returns>
+    bool IsSuccess() const;
+
+    /// <summary>
+    /// Format a message that describes the result.
+    /// </summary>
+    /// <returns>Returns a message such as "Get unicode text failed: the clipboard could not be opened (error 5, Access is denied.)".</returns>
+    /// <remarks>The message of the system code is provided by the system on Windows.</remarks>
+    std::string GetDescription() const;
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_RESULT_H
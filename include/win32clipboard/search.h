@@ -0,0 +1,162 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#ifndef WIN32CLIPBOARD_SEARCH_H
+#define WIN32CLIPBOARD_SEARCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Value returned by find_bytes() when the pattern is not found.
+  /// </summary>
+  static const size_t SEARCH_NOT_FOUND = (size_t)-1;
+
+  /// <summary>
+  /// Find the first occurrence of a pattern in a buffer.
+  /// </summary>
+  /// <param name="data">The buffer to search.</param>
+  /// <param name="size">The size of the buffer in bytes.</param>
+  /// <param name="pattern">The pattern to find.</param>
+  /// <param name="pattern_size">The size of the pattern in bytes.</param>
+  /// <param name="alignment">Occurrences whose offset is not a multiple of alignment are ignored. Use 2 to search utf16 text.</param>
+  /// <returns>Returns the offset in bytes of the first occurrence. Returns SEARCH_NOT_FOUND if the pattern is not found.</returns>
+  /// <remarks>Candidate positions are filtered on the first and the last byte of the pattern, 16 positions at a time.</remarks>
+  size_t find_bytes(const char * data, size_t size, const char * pattern, size_t pattern_size, size_t alignment = 1);
+
+  /// <summary>
+  /// Query a buffer to know if it starts with the given pattern.
+  /// </summary>
+  /// <param name="data">The buffer to query.</param>
+  /// <param name="size">The size of the buffer in bytes.</param>
+  /// <param name="pattern">The pattern to compare.</param>
+  /// <param name="pattern_size">The size of the pattern in bytes.</param>
+  /// <returns>Returns true if the buffer starts with the pattern. Returns false otherwise.</returns>
+  bool starts_with(const char * data, size_t size, const char * pattern, size_t pattern_size);
+
+  /// <summary>
+  /// Query a buffer to know if it ends with the given pattern.
+  /// </summary>
+  /// <param name="data">The buffer to query.</param>
+  /// <param name="size">The size of the buffer in bytes.</param>
+  /// <param name="pattern">The pattern to compare.</param>
+  /// <param name="pattern_size">The size of the pattern in bytes.</param>
+  /// <returns>Returns true if the buffer ends with the pattern. Returns false otherwise.</returns>
+  bool ends_with(const char * data, size_t size, const char * pattern, size_t pattern_size);
+
+  /// <summary>
+  /// An occurrence of a pattern of a PatternSet.
+  /// </summary>
+  struct SearchMatch
+  {
+    size_t pattern;   //index of the pattern in the set
+    size_t offset;    //offset of the occurrence
+    size_t size;      //size of the occurrence
+  };
+
+  /// <summary>
+  /// A set of patterns searched in a single pass over a buffer.
+  /// </summary>
+  /// <remarks>
+  /// The patterns are compiled to an Aho-Corasick automaton with a complete transition table:
+  /// the search reads each byte of the buffer once, whatever the number of patterns.
+  /// Bytes that cannot start a pattern are skipped with a vectorized scan when the patterns start with at most 3 distinct bytes.
+  /// The set is immutable once created and can be shared between threads.
+  /// </remarks>
+  class PatternSet
+  {
+  public:
+    /// <summary>
+    /// Encoding of the patterns and of the searched buffers.
+    /// </summary>
+    enum Encoding
+    {
+      EncodingBytes,  //patterns are searched as is
+      EncodingUtf16,  //utf8 patterns are converted to utf16 and only searched at even offsets
+    };
+
+    /// <summary>
+    /// Compile a set of patterns.
+    /// </summary>
+    /// <param name="iPatterns">The patterns of the set. Empty patterns never match.</param>
+    /// <param name="iEncoding">The encoding of the searched buffers.</param>
+    PatternSet(const std::vector<std::string> & iPatterns, Encoding iEncoding = EncodingBytes);
+    virtual ~PatternSet();
+
+    /// <summary>
+    /// Returns the number of patterns in the set.
+    /// </summary>
+    /// <returns>Returns the number of patterns in the set.</returns>
+    size_t GetCount() const;
+
+    /// <summary>
+    /// Returns the encoding of the searched buffers.
+    /// </summary>
+    /// <returns>Returns the encoding of the searched buffers.</returns>
+    Encoding GetEncoding() const;
+
+    /// <summary>
+    /// Find the first occurrence of any pattern of the set.
+    /// </summary>
+    /// <param name="iData">The buffer to search.</param>
+    /// <param name="iSize">The size of the buffer in bytes.</param>
+    /// <param name="oMatch">The output occurrence. The offset and the size are in bytes.</param>
+    /// <returns>Returns true if a pattern is found. Returns false otherwise.</returns>
+    /// <remarks>The first occurrence is the one that ends first. If multiple patterns end at the same offset, the longest one is returned.</remarks>
+    bool Find(const char * iData, size_t iSize, SearchMatch & oMatch) const;
+
+    /// <summary>
+    /// Find all occurrences of the patterns of the set, including overlapping occurrences.
+    /// </summary>
+    /// <param name="iData">The buffer to search.</param>
+    /// <param name="iSize">The size of the buffer in bytes.</param>
+    /// <param name="oMatches">The output occurrences, sorted by end offset. The offsets and the sizes are in bytes.</param>
+    /// <returns>Returns the number of occurrences found.</returns>
+    size_t FindAll(const char * iData, size_t iSize, std::vector<SearchMatch> & oMatches) const;
+
+  private:
+    //non-copyable
+    PatternSet(const PatternSet &);
+    PatternSet & operator=(const PatternSet &);
+
+    template <typename Visitor> void scan(const char * iData, size_t iSize, Visitor & iVisitor) const;
+    size_t skipToStart(const unsigned char * iData, size_t iOffset, size_t iSize) const;
+
+  private:
+    Encoding mEncoding;
+    size_t mAlignment;
+    std::vector<size_t> mSizes;         //size in bytes of each pattern
+    std::vector<int32_t> mTransitions;  //256 transitions per state
+    std::vector<int32_t> mOutputs;      //index of the pattern ending at each state, or -1
+    std::vector<int32_t> mLinks;        //next state of the failure chain with an output, or -1
+    size_t mNumStartBytes;              //number of distinct first bytes of the patterns
+    unsigned char mStartBytes[3];       //first bytes of the patterns, if there are at most 3
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_SEARCH_H
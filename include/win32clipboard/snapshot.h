@@ -0,0 +1,201 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_SNAPSHOT_H
+#define WIN32CLIPBOARD_SNAPSHOT_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/backend.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/image.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Immutable capture of the clipboard content that can be shared between consumers and threads without copying.
+  /// </summary>
+  /// <remarks>
+  /// The payload of each format is stored in its own reference-counted buffer. Copying a snapshot only increments a
+  /// reference count and any number of threads can read copies of the same snapshot concurrently.
+  /// A buffer is released when the last snapshot or reader referencing it is destroyed.
+  /// The image is stored as a device independent bitmap and the list of drag and drop files as a CF_HDROP buffer:
+  /// they are decoded by GetAsImage() and GetAsDragDropFiles().
+  /// Capture() replaces the content of an instance: it must not run concurrently with the readers of the same instance.
+  /// </remarks>
+  class ClipboardSnapshot
+  {
+  public:
+    /// <summary>
+    /// A read-only, reference-counted payload.
+    /// </summary>
+    typedef std::shared_ptr<const std::string> Buffer;
+
+    /// <summary>
+    /// A read-only, reference-counted unicode text payload.
+    /// </summary>
+    typedef std::shared_ptr<const std::wstring> UnicodeBuffer;
+
+    /// <summary>
+    /// Create an empty snapshot.
+    /// </summary>
+    ClipboardSnapshot();
+
+#ifdef _WIN32
+    /// <summary>
+    /// Capture the text, unicode text, image, binary, HTML and drag and drop files formats of the given clipboard.
+    /// </summary>
+    /// <param name="iClipboard">The clipboard to capture.</param>
+    /// <returns>Returns true if at least one format was captured. Returns false if the clipboard is empty.</returns>
+    /// <remarks>
+    /// Each format is read once from the clipboard. The buffers of the previous content stay valid for their other readers.
+    /// </remarks>
+    bool Capture(Clipboard & iClipboard);
+#endif
+
+    /// <summary>
+    /// Capture the text, unicode text, image, binary, HTML and drag and drop files formats of the given backend.
+    /// </summary>
+    /// <param name="iBackend">The backend to capture. The formats are read as stored by the Clipboard.</param>
+    /// <returns>Returns true if at least one format was captured. Returns false if the backend is empty.</returns>
+    /// <remarks>
+    /// Each format is read once from the backend. The buffers of the previous content stay valid for their other readers.
+    /// Backends do not provide a fingerprint.
+    /// </remarks>
+    bool Capture(Backend & iBackend);
+
+    /// <summary>
+    /// Release the content of the snapshot.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Returns true if the snapshot does not contain any format.
+    /// </summary>
+    /// <returns>Returns true if the snapshot does not contain any format. Returns false otherwise.</returns>
+    bool IsEmpty() const;
+
+    /// <summary>
+    /// Provides the fingerprint of the clipboard at the time of the capture.
+    /// </summary>
+    /// <param name="oFingerprint">The output fingerprint. See Clipboard::GetFingerprint().</param>
+    /// <returns>Returns true if the fingerprint is known. Returns false otherwise.</returns>
+    bool GetFingerprint(uint64_t & oFingerprint) const;
+
+    /// <summary>
+    /// Returns the number of bytes used by the payloads of all formats.
+    /// </summary>
+    /// <returns>Returns the number of bytes used by the payloads of all formats.</returns>
+    size_t GetMemoryUsage() const;
+
+    /// <summary>
+    /// Query the snapshot to know if it contains the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to query.</param>
+    /// <returns>Returns true if the snapshot contains the given format. Returns false otherwise.</returns>
+    bool Contains(Clipboard::Format iClipboardFormat) const;
+
+    /// <summary>
+    /// Returns the shared buffer of the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to query.</param>
+    /// <returns>Returns the buffer of the format. Returns an empty pointer if the snapshot does not contain the format.</returns>
+    /// <remarks>
+    /// The buffer remains valid for as long as the returned pointer is kept, even if the snapshot is captured again or destroyed.
+    /// The unicode text is stored as a wide string: FormatUnicode always returns an empty pointer. See GetUnicodeBuffer().
+    /// </remarks>
+    Buffer GetBuffer(Clipboard::Format iClipboardFormat) const;
+
+    /// <summary>
+    /// Returns the shared buffer of the unicode text format.
+    /// </summary>
+    /// <returns>Returns the buffer of the unicode text. Returns an empty pointer if the snapshot does not contain an unicode text value.</returns>
+    /// <remarks>The buffer remains valid for as long as the returned pointer is kept, even if the snapshot is captured again or destroyed.</remarks>
+    UnicodeBuffer GetUnicodeBuffer() const;
+
+    /// <summary>
+    /// Provides a read-only view of the payload of the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to query.</param>
+    /// <param name="oData">The address of the payload. The view is valid until the snapshot is captured again, cleared or destroyed.</param>
+    /// <param name="oSize">The size in bytes of the payload.</param>
+    /// <returns>Returns true if the snapshot contains the given format. Returns false otherwise.</returns>
+    /// <remarks>The payload of FormatImage is a device independent bitmap (see parse_dib()).</remarks>
+    bool GetData(Clipboard::Format iClipboardFormat, const char *& oData, size_t & oSize) const;
+
+    /// <summary>
+    /// Provides a copy of the text value of the snapshot.
+    /// </summary>
+    /// <param name="oText">The output text value of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains a text value. Returns false otherwise.</returns>
+    bool GetAsText(std::string & oText) const;
+
+    /// <summary>
+    /// Provides a copy of the unicode text value of the snapshot.
+    /// </summary>
+    /// <param name="oText">The output unicode text value of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains an unicode text value. Returns false otherwise.</returns>
+    bool GetAsTextUnicode(std::wstring & oText) const;
+
+    /// <summary>
+    /// Provides a copy of the binary data of the snapshot.
+    /// </summary>
+    /// <param name="oMemoryBuffer">The output binary data of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains binary data. Returns false otherwise.</returns>
+    bool GetAsBinary(Clipboard::MemoryBuffer & oMemoryBuffer) const;
+
+    /// <summary>
+    /// Provides a copy of the image of the snapshot.
+    /// </summary>
+    /// <param name="oImage">The output image of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains an image. Returns false otherwise.</returns>
+    bool GetAsImage(Image & oImage) const;
+
+    /// <summary>
+    /// Provides a copy of the HTML fragment of the snapshot.
+    /// </summary>
+    /// <param name="oFragment">The output utf8-encoded HTML fragment of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains an HTML fragment. Returns false otherwise.</returns>
+    bool GetAsHtml(std::string & oFragment) const;
+
+    /// <summary>
+    /// Provides the file operation and list of files of the snapshot.
+    /// </summary>
+    /// <param name="oDragDropType">The output file operation of the snapshot.</param>
+    /// <param name="oFiles">The output list of utf8-encoded files of the snapshot.</param>
+    /// <returns>Returns true if the snapshot contains a list of files. Returns false otherwise.</returns>
+    bool GetAsDragDropFiles(Clipboard::DragDropType & oDragDropType, DropFileList & oFiles) const;
+
+  private:
+    struct Contents;
+
+    std::shared_ptr<const Contents> mContents; //shared by all copies of the snapshot
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_SNAPSHOT_H
@@ -0,0 +1,288 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_STATS_H
+#define WIN32CLIPBOARD_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "win32clipboard/config.h"
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Histogram of durations with logarithmic buckets.
+  /// </summary>
+  /// <remarks>
+  /// Bucket 0 counts durations of 0 ns. Bucket i counts durations in the range [2^(i-1), 2^i) nanoseconds.
+  /// The last bucket also counts all longer durations.
+  /// </remarks>
+  struct LatencyHistogram
+  {
+    static const size_t NUM_BUCKETS = 40;
+
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[NUM_BUCKETS];
+
+    /// <summary>
+    /// Returns the index of the bucket that counts the given duration.
+    /// </summary>
+    /// <param name="iDuration">The duration in nanoseconds.</param>
+    /// <returns>Returns the index of the bucket that counts the given duration.</returns>
+    static size_t GetBucket(uint64_t iDuration);
+
+    /// <summary>
+    /// Returns an upper bound of the given percentile of the durations.
+    /// </summary>
+    /// <param name="iPercentile">The percentile, between 0 and 100.</param>
+    /// <returns>Returns the upper bound, in nanoseconds, of the bucket that contains the given percentile. Returns 0 if the histogram is empty.</returns>
+    uint64_t GetPercentile(double iPercentile) const;
+  };
+
+  /// <summary>
+  /// Counters of a single operation.
+  /// </summary>
+  struct OperationStats
+  {
+    uint64_t calls;
+    uint64_t failures;
+    uint64_t bytes;             //bytes copied to or from the clipboard memory, or produced by a conversion
+    LatencyHistogram latency;
+  };
+
+  /// <summary>
+  /// A snapshot of the statistics of the clipboard operations.
+  /// </summary>
+  struct ClipboardStats
+  {
+    enum Operation { OperationEmpty, OperationContains, OperationHash, OperationSet, OperationGet, OperationConvert, OperationFind, OperationUnknown };
+    enum Kind { KindText, KindUnicode, KindImage, KindBinary, KindHtml, KindDragDropFiles, KindAll };
+
+    static const size_t NUM_OPERATIONS = 7; //OperationUnknown is not counted: it identifies results that are not bound to an operation
+    static const size_t NUM_KINDS = 7;
+
+    /// <summary>
+    /// Returns the counters of the given operation on the given kind of value.
+    /// </summary>
+    /// <param name="iOperation">The operation. Must not be OperationUnknown.</param>
+    /// <param name="iKind">The kind of value. The first kinds match the values of Clipboard::Format.</param>
+    /// <returns>Returns the counters of the given operation on the given kind of value.</returns>
+    const OperationStats & Get(Operation iOperation, Kind iKind) const;
+
+    OperationStats operations[NUM_OPERATIONS][NUM_KINDS];
+
+    uint64_t opens;                 //number of times the clipboard was opened
+    uint64_t open_retries;          //number of failed attempts that were retried
+    uint64_t open_failures;         //number of times the clipboard could not be opened
+    LatencyHistogram open_latency;  //time spent waiting for the clipboard, including the retries
+  };
+
+  /// <summary>
+  /// Event sent to the trace callback at the beginning and at the end of each operation.
+  /// </summary>
+  struct TraceEvent
+  {
+    enum Type { TypeBegin, TypeEnd };
+
+    Type type;
+    ClipboardStats::Operation operation;
+    ClipboardStats::Kind kind;
+    bool success;                   //end events only
+    uint64_t bytes;                 //end events only
+    uint64_t duration_ns;           //end events only
+  };
+
+  typedef void (*TraceCallback)(const TraceEvent & iEvent, void * iUserData);
+
+  /// <summary>
+  /// Thread-safe collector of clipboard statistics.
+  /// </summary>
+  /// <remarks>
+  /// Counters are updated with relaxed atomic operations: recording never blocks and a snapshot
+  /// taken while other threads record may mix counters of concurrent operations.
+  /// If the library is built without WIN32CLIPBOARD_ENABLE_STATS, the operations of the library are not measured.
+  /// </remarks>
+  class StatsRecorder
+  {
+  public:
+    StatsRecorder();
+
+  private:
+    //non-copyable
+    StatsRecorder(const StatsRecorder &);
+    StatsRecorder & operator=(const StatsRecorder &);
+
+  public:
+    /// <summary>
+    /// Returns true if the library measures its operations.
+    /// </summary>
+    /// <returns>Returns true if the library was built with WIN32CLIPBOARD_ENABLE_STATS. Returns false otherwise.</returns>
+    static bool IsEnabled();
+
+    /// <summary>
+    /// Returns the current time of a monotonic clock.
+    /// </summary>
+    /// <returns>Returns the current time in nanoseconds.</returns>
+    static uint64_t GetTimestamp();
+
+    /// <summary>
+    /// Record an attempt to open the clipboard.
+    /// </summary>
+    /// <param name="iSuccess">True if the clipboard was opened.</param>
+    /// <param name="iRetries">The number of failed attempts before the last one.</param>
+    /// <param name="iDuration">The time spent opening the clipboard, in nanoseconds.</param>
+    void RecordOpen(bool iSuccess, size_t iRetries, uint64_t iDuration);
+
+    /// <summary>
+    /// Record a completed operation and send the end event to the trace callback.
+    /// </summary>
+    /// <param name="iOperation">The operation.</param>
+    /// <param name="iKind">The kind of value.</param>
+    /// <param name="iSuccess">True if the operation was successful.</param>
+    /// <param name="iBytes">The number of bytes copied or converted.</param>
+    /// <param name="iDuration">The duration of the operation, in nanoseconds.</param>
+    void Record(ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind, bool iSuccess, uint64_t iBytes, uint64_t iDuration);
+
+    /// <summary>
+    /// Send the begin event of an operation to the trace callback.
+    /// </summary>
+    /// <param name="iOperation">The operation.</param>
+    /// <param name="iKind">The kind of value.</param>
+    void TraceBegin(ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind);
+
+    /// <summary>
+    /// Set the function called at the beginning and at the end of each operation.
+    /// </summary>
+    /// <param name="iCallback">The callback function. Use NULL to disable tracing.</param>
+    /// <param name="iUserData">The value given to the callback function.</param>
+    /// <remarks>The callback is called from the thread that runs the operation. Set the callback before sharing the recorder between threads.</remarks>
+    void SetTraceCallback(TraceCallback iCallback, void * iUserData);
+
+    /// <summary>
+    /// Provides a snapshot of all counters.
+    /// </summary>
+    /// <param name="oStats">The output statistics.</param>
+    void GetStats(ClipboardStats & oStats) const;
+
+    /// <summary>
+    /// Reset all counters to zero.
+    /// </summary>
+    void Reset();
+
+  private:
+    struct AtomicHistogram
+    {
+      std::atomic<uint64_t> count;
+      std::atomic<uint64_t> total_ns;
+      std::atomic<uint64_t> max_ns;
+      std::atomic<uint64_t> buckets[LatencyHistogram::NUM_BUCKETS];
+    };
+
+    struct AtomicOperation
+    {
+      std::atomic<uint64_t> calls;
+      std::atomic<uint64_t> failures;
+      std::atomic<uint64_t> bytes;
+      AtomicHistogram latency;
+    };
+
+    static void record(AtomicHistogram & iHistogram, uint64_t iDuration);
+    static void load(const AtomicHistogram & iHistogram, LatencyHistogram & oHistogram);
+    static void reset(AtomicHistogram & iHistogram);
+
+  private:
+    AtomicOperation mOperations[ClipboardStats::NUM_OPERATIONS][ClipboardStats::NUM_KINDS];
+    std::atomic<uint64_t> mOpens;
+    std::atomic<uint64_t> mOpenRetries;
+    std::atomic<uint64_t> mOpenFailures;
+    AtomicHistogram mOpenLatency;
+    std::atomic<TraceCallback> mTraceCallback;
+    std::atomic<void *> mTraceUserData;
+  };
+
+  /// <summary>
+  /// Measure a single operation.
+  /// </summary>
+  /// <remarks>
+  /// The operation starts when the scope is created. Call End() to record the result of the operation.
+  /// An operation that was not ended when the scope is destroyed is recorded as a failure.
+  /// All functions compile to nothing if the library is built without WIN32CLIPBOARD_ENABLE_STATS.
+  /// </remarks>
+  class StatsScope
+  {
+  public:
+#ifdef WIN32CLIPBOARD_STATS_ENABLED
+    inline StatsScope(StatsRecorder & iRecorder, ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind) :
+      mRecorder(iRecorder),
+      mOperation(iOperation),
+      mKind(iKind),
+      mEnded(false)
+    {
+      mRecorder.TraceBegin(mOperation, mKind);
+      mStart = StatsRecorder::GetTimestamp();
+    }
+
+    inline ~StatsScope()
+    {
+      if (!mEnded)
+        End(false, 0);
+    }
+
+    /// <summary>
+    /// Record the result of the operation.
+    /// </summary>
+    /// <param name="iSuccess">True if the operation was successful.</param>
+    /// <param name="iBytes">The number of bytes copied or converted.</param>
+    /// <returns>Returns iSuccess.</returns>
+    inline bool End(bool iSuccess, uint64_t iBytes)
+    {
+      mEnded = true;
+      mRecorder.Record(mOperation, mKind, iSuccess, iBytes, StatsRecorder::GetTimestamp() - mStart);
+      return iSuccess;
+    }
+
+  private:
+    StatsRecorder & mRecorder;
+    ClipboardStats::Operation mOperation;
+    ClipboardStats::Kind mKind;
+    bool mEnded;
+    uint64_t mStart;
+#else
+    inline StatsScope(StatsRecorder &, ClipboardStats::Operation, ClipboardStats::Kind) {}
+    inline bool End(bool iSuccess, uint64_t) { return iSuccess; }
+#endif
+
+  private:
+    //non-copyable
+    StatsScope(const StatsScope &);
+    StatsScope & operator=(const StatsScope &);
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_STATS_H
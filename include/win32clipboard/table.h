@@ -0,0 +1,141 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_TABLE_H
+#define WIN32CLIPBOARD_TABLE_H
+
+#include <stddef.h>
+#include <vector>
+#include <string>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// A read-only tabular view over delimited text, as copied from spreadsheets (TSV) or CSV files.
+  /// </summary>
+  /// <remarks>
+  /// Rows are separated by LF or CRLF line endings and cells by a delimiter character.
+  /// A cell starting with a double quote is quoted: it can contain delimiters and line endings, and double quotes are escaped by doubling them.
+  /// Parsing only records the position of each cell. Cells are returned as spans over the text and unquoted on demand.
+  /// </remarks>
+  class Table
+  {
+  public:
+    Table();
+
+    /// <summary>
+    /// Parse the given text without copying it.
+    /// </summary>
+    /// <param name="text">The text to parse. The text must stay valid while the table is used.</param>
+    /// <param name="size">The size in bytes of the text.</param>
+    /// <param name="delimiter">The cell delimiter. Use '\t' for spreadsheets and ',' for CSV.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the delimiter is a double quote, a line ending or a \0 character.</returns>
+    bool Parse(const char * text, size_t size, char delimiter = '\t');
+
+    /// <summary>
+    /// Take ownership of the given text and parse it.
+    /// </summary>
+    /// <param name="text">The text to parse. The content is moved to the table and the string is left empty.</param>
+    /// <param name="delimiter">The cell delimiter. Use '\t' for spreadsheets and ',' for CSV.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the delimiter is a double quote, a line ending or a \0 character.</returns>
+    bool Assign(std::string & text, char delimiter = '\t');
+
+    /// <summary>
+    /// Remove all rows from the table.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Returns the number of rows of the table.
+    /// </summary>
+    /// <returns>Returns the number of rows of the table. A line ending at the end of the text does not start a new row.</returns>
+    size_t GetRowCount() const;
+
+    /// <summary>
+    /// Returns the number of cells of the given row.
+    /// </summary>
+    /// <param name="row">The index of the row.</param>
+    /// <returns>Returns the number of cells of the given row. Returns 0 if the row does not exist.</returns>
+    size_t GetCellCount(size_t row) const;
+
+    /// <summary>
+    /// Provides a view over the raw content of a cell.
+    /// </summary>
+    /// <param name="row">The index of the row.</param>
+    /// <param name="column">The index of the cell in the row.</param>
+    /// <param name="data">The output address of the content of the cell. The surrounding quotes of quoted cells are excluded, escaped quotes are not unescaped.</param>
+    /// <param name="size">The output size in bytes of the content of the cell.</param>
+    /// <returns>Returns true if the cell exists. Returns false otherwise.</returns>
+    bool GetCell(size_t row, size_t column, const char *& data, size_t & size) const;
+
+    /// <summary>
+    /// Returns true if the given cell is quoted.
+    /// </summary>
+    /// <param name="row">The index of the row.</param>
+    /// <param name="column">The index of the cell in the row.</param>
+    /// <returns>Returns true if the given cell exists and is quoted. Returns false otherwise.</returns>
+    bool IsQuoted(size_t row, size_t column) const;
+
+    /// <summary>
+    /// Provides the unquoted value of a cell.
+    /// </summary>
+    /// <param name="row">The index of the row.</param>
+    /// <param name="column">The index of the cell in the row.</param>
+    /// <param name="value">The output value of the cell.</param>
+    /// <returns>Returns true if the cell exists. Returns false otherwise.</returns>
+    bool GetCellValue(size_t row, size_t column, std::string & value) const;
+
+    /// <summary>
+    /// Parse all cells of a column as numbers.
+    /// </summary>
+    /// <param name="column">The index of the column.</param>
+    /// <param name="values">The output values of the column, one value per row. Missing and non-numeric cells are set to NaN.</param>
+    /// <returns>Returns the number of cells that were parsed as numbers.</returns>
+    /// <remarks>Numbers use the C locale format: an optional sign, digits, an optional '.' fraction and an optional exponent.</remarks>
+    size_t GetColumnAsNumbers(size_t column, std::vector<double> & values) const;
+
+  private:
+    //non-copyable: the spans may point into the owned text
+    Table(const Table &);
+    Table & operator=(const Table &);
+
+    // Position of a cell in the text. The end excludes the delimiter and the line ending.
+    struct Span
+    {
+      size_t begin;
+      size_t end;
+    };
+
+    const Span * getSpan(size_t row, size_t column) const;
+
+    std::string mBuffer;        //owned text, if any
+    const char * mText;
+    size_t mSize;
+    std::vector<Span> mCells;   //cells of all rows
+    std::vector<size_t> mRows;  //index of the first cell of each row, followed by the total number of cells
+  };
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_TABLE_H
@@ -0,0 +1,100 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_TEXTCODEC_H
+#define WIN32CLIPBOARD_TEXTCODEC_H
+
+#include <stddef.h>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Returns the length of the base64 encoding of the given number of bytes, padding included.
+  /// </summary>
+  /// <param name="size">The size in bytes of the data to encode.</param>
+  /// <returns>Returns the number of characters written by encode_base64().</returns>
+  size_t get_base64_encoded_size(size_t size);
+
+  /// <summary>
+  /// Encode binary data with the standard base64 alphabet of RFC 4648, with padding.
+  /// </summary>
+  /// <param name="src">The data to encode.</param>
+  /// <param name="size">The size in bytes of the data.</param>
+  /// <param name="dst">The output buffer of get_base64_encoded_size() characters. No \0 character is written.</param>
+  void encode_base64(const void * src, size_t size, char * dst);
+
+  /// <summary>
+  /// Returns the maximum size of the data decoded from the given number of base64 characters.
+  /// </summary>
+  /// <param name="length">The number of characters to decode.</param>
+  /// <returns>Returns the size of the buffer required by decode_base64().</returns>
+  size_t get_base64_decoded_size(size_t length);
+
+  /// <summary>
+  /// Decode base64 text encoded with the standard alphabet of RFC 4648.
+  /// </summary>
+  /// <param name="src">The text to decode.</param>
+  /// <param name="length">The length of the text in bytes.</param>
+  /// <param name="dst">The output buffer of get_base64_decoded_size() bytes.</param>
+  /// <param name="decoded_size">The output size in bytes of the decoded data.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the text is not valid base64.</returns>
+  /// <remarks>White spaces and line breaks are ignored. The padding is optional.</remarks>
+  bool decode_base64(const char * src, size_t length, void * dst, size_t & decoded_size);
+
+  /// <summary>
+  /// Returns the length of the hexadecimal encoding of the given number of bytes.
+  /// </summary>
+  /// <param name="size">The size in bytes of the data to encode.</param>
+  /// <returns>Returns the number of characters written by encode_hex().</returns>
+  size_t get_hex_encoded_size(size_t size);
+
+  /// <summary>
+  /// Encode binary data as lowercase hexadecimal digits, two per byte.
+  /// </summary>
+  /// <param name="src">The data to encode.</param>
+  /// <param name="size">The size in bytes of the data.</param>
+  /// <param name="dst">The output buffer of get_hex_encoded_size() characters. No \0 character is written.</param>
+  void encode_hex(const void * src, size_t size, char * dst);
+
+  /// <summary>
+  /// Returns the maximum size of the data decoded from the given number of hexadecimal digits.
+  /// </summary>
+  /// <param name="length">The number of characters to decode.</param>
+  /// <returns>Returns the size of the buffer required by decode_hex().</returns>
+  size_t get_hex_decoded_size(size_t length);
+
+  /// <summary>
+  /// Decode hexadecimal text.
+  /// </summary>
+  /// <param name="src">The text to decode.</param>
+  /// <param name="length">The length of the text in bytes.</param>
+  /// <param name="dst">The output buffer of get_hex_decoded_size() bytes.</param>
+  /// <param name="decoded_size">The output size in bytes of the decoded data.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the text is not valid hexadecimal.</returns>
+  /// <remarks>Lowercase and uppercase digits are accepted. White spaces and line breaks between bytes are ignored.</remarks>
+  bool decode_hex(const char * src, size_t length, void * dst, size_t & decoded_size);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_TEXTCODEC_H
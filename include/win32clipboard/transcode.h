@@ -0,0 +1,307 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_TRANSCODE_H
+#define WIN32CLIPBOARD_TRANSCODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Decoder and encoder of the unicode encoding of a code unit type.
+  /// </summary>
+  /// <remarks>
+  /// The encoding is selected at compile time from the size of the type: UTF-8 for 1 byte, UTF-16 for 2 bytes and UTF-32 for 4 bytes.
+  /// Therefore wchar_t is UTF-16 on Windows and UTF-32 on other platforms.
+  /// Decoders reject overlong sequences, unpaired surrogates and code points above U+10FFFF.
+  /// </remarks>
+  template <typename T, size_t N = sizeof(T)> struct utf_codec;
+
+  template <typename T> struct utf_codec<T, 1>
+  {
+    static const size_t MAX_UNITS = 4; //maximum number of code units of a code point
+
+    static inline bool decode(const T *& src, const T * end, uint32_t & code_point)
+    {
+      const uint32_t c = (unsigned char)src[0];
+      if (c < 0x80)
+      {
+        code_point = c;
+        src++;
+        return true;
+      }
+
+      //See http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf, Table 3-7. Well-Formed UTF-8 Byte Sequences
+      size_t length = 0;
+      if (0xC2 <= c && c <= 0xDF)       { code_point = c & 0x1F; length = 2; }
+      else if ((c & 0xF0) == 0xE0)      { code_point = c & 0x0F; length = 3; }
+      else if (0xF0 <= c && c <= 0xF4)  { code_point = c & 0x07; length = 4; }
+      else
+        return false;
+      if ((size_t)(end - src) < length)
+        return false;
+      for(size_t i=1; i<length; i++)
+      {
+        const uint32_t b = (unsigned char)src[i];
+        if ((b & 0xC0) != 0x80)
+          return false;
+        code_point = (code_point << 6) | (b & 0x3F);
+      }
+
+      //reject overlong sequences, surrogates and out of range code points
+      if ((length == 3 && code_point < 0x800) ||
+          (length == 4 && (code_point < 0x10000 || code_point > 0x10FFFF)) ||
+          (0xD800 <= code_point && code_point <= 0xDFFF))
+        return false;
+      src += length;
+      return true;
+    }
+
+    static inline T * encode(uint32_t code_point, T * dst)
+    {
+      if (code_point < 0x80)
+      {
+        *dst++ = (T)code_point;
+      }
+      else if (code_point < 0x800)
+      {
+        *dst++ = (T)(0xC0 | (code_point >> 6));
+        *dst++ = (T)(0x80 | (code_point & 0x3F));
+      }
+      else if (code_point < 0x10000)
+      {
+        *dst++ = (T)(0xE0 | (code_point >> 12));
+        *dst++ = (T)(0x80 | ((code_point >> 6) & 0x3F));
+        *dst++ = (T)(0x80 | (code_point & 0x3F));
+      }
+      else
+      {
+        *dst++ = (T)(0xF0 | (code_point >> 18));
+        *dst++ = (T)(0x80 | ((code_point >> 12) & 0x3F));
+        *dst++ = (T)(0x80 | ((code_point >> 6) & 0x3F));
+        *dst++ = (T)(0x80 | (code_point & 0x3F));
+      }
+      return dst;
+    }
+  };
+
+  template <typename T> struct utf_codec<T, 2>
+  {
+    static const size_t MAX_UNITS = 2;
+
+    static inline bool decode(const T *& src, const T * end, uint32_t & code_point)
+    {
+      const uint32_t high = (uint16_t)src[0];
+      if (high < 0xD800 || high > 0xDFFF)
+      {
+        code_point = high;
+        src++;
+        return true;
+      }
+      if (high > 0xDBFF || end - src < 2)
+        return false;
+      const uint32_t low = (uint16_t)src[1];
+      if (low < 0xDC00 || low > 0xDFFF)
+        return false;
+      code_point = 0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00);
+      src += 2;
+      return true;
+    }
+
+    static inline T * encode(uint32_t code_point, T * dst)
+    {
+      if (code_point < 0x10000)
+      {
+        *dst++ = (T)code_point;
+      }
+      else
+      {
+        code_point -= 0x10000;
+        *dst++ = (T)(0xD800 + (code_point >> 10));
+        *dst++ = (T)(0xDC00 + (code_point & 0x3FF));
+      }
+      return dst;
+    }
+  };
+
+  template <typename T> struct utf_codec<T, 4>
+  {
+    static const size_t MAX_UNITS = 1;
+
+    static inline bool decode(const T *& src, const T * /*end*/, uint32_t & code_point)
+    {
+      code_point = (uint32_t)src[0];
+      if (code_point > 0x10FFFF || (0xD800 <= code_point && code_point <= 0xDFFF))
+        return false;
+      src++;
+      return true;
+    }
+
+    static inline T * encode(uint32_t code_point, T * dst)
+    {
+      *dst++ = (T)code_point;
+      return dst;
+    }
+  };
+
+  /// <summary>
+  /// Maximum number of code units written by transcode() for each code unit read.
+  /// </summary>
+  template <typename From, typename To> struct utf_transcode_ratio
+  {
+    //a code point of n bytes in UTF-8 is 1 UTF-16 code unit if n < 4, 2 UTF-16 code units otherwise, and 1 UTF-32 code unit
+    static const size_t VALUE =
+      sizeof(To) == 1 ? (sizeof(From) == 1 ? 1 : sizeof(From) == 2 ? 3 : 4) :
+      sizeof(To) == 2 ? (sizeof(From) == 4 ? 2 : 1) :
+      1;
+  };
+
+  /// <summary>
+  /// Convert a unicode string from the encoding of a code unit type to the encoding of another.
+  /// </summary>
+  /// <param name="src">The string to convert.</param>
+  /// <param name="length">The length of the string in code units.</param>
+  /// <param name="dst">The output converted string.</param>
+  /// <returns>Returns true if the function is successful. Returns false if the string is not valid in the encoding of From.</returns>
+  /// <remarks>
+  /// The encodings are selected at compile time (see utf_codec): each pair of types has its own conversion loop, without runtime dispatch.
+  /// The output is allocated once for the worst case and shrunk at the end.
+  /// </remarks>
+  template <typename From, typename To>
+  inline bool transcode(const From * src, size_t length, std::basic_string<To> & dst)
+  {
+    typedef utf_codec<From> Decoder;
+    typedef utf_codec<To> Encoder;
+
+    dst.resize(length * utf_transcode_ratio<From, To>::VALUE);
+    if (length == 0)
+      return true;
+
+    const From * end = src + length;
+    To * const begin = &dst[0];
+    To * out = begin;
+    while (src < end)
+    {
+      //copy runs of ASCII characters without decoding
+      while (src < end && (uint32_t)src[0] < 0x80)
+        *out++ = (To)*src++;
+      if (src == end)
+        break;
+
+      uint32_t code_point = 0;
+      if (!Decoder::decode(src, end, code_point))
+      {
+        dst.clear();
+        return false;
+      }
+      out = Encoder::encode(code_point, out);
+    }
+    dst.resize(out - begin);
+    return true;
+  }
+
+  template <typename From, typename To>
+  inline bool transcode(const std::basic_string<From> & src, std::basic_string<To> & dst)
+  {
+    return transcode(src.data(), src.size(), dst);
+  }
+
+  /// <summary>
+  /// Convert an utf8-encoded string to an utf16-encoded string.
+  /// </summary>
+  /// <param name="str">The utf8-encoded string to convert.</param>
+  /// <returns>Returns an utf16-encoded string. Returns an empty string on failure.</returns>
+  inline std::u16string utf8_to_utf16(const std::string & str)
+  {
+    std::u16string output;
+    transcode(str, output);
+    return output;
+  }
+
+  /// <summary>
+  /// Convert an utf16-encoded string to an utf8-encoded string.
+  /// </summary>
+  /// <param name="str">The utf16-encoded string to convert.</param>
+  /// <returns>Returns an utf8-encoded string. Returns an empty string on failure.</returns>
+  inline std::string utf16_to_utf8(const std::u16string & str)
+  {
+    std::string output;
+    transcode(str, output);
+    return output;
+  }
+
+  /// <summary>
+  /// Convert an utf8-encoded string to an utf32-encoded string.
+  /// </summary>
+  /// <param name="str">The utf8-encoded string to convert.</param>
+  /// <returns>Returns an utf32-encoded string. Returns an empty string on failure.</returns>
+  inline std::u32string utf8_to_utf32(const std::string & str)
+  {
+    std::u32string output;
+    transcode(str, output);
+    return output;
+  }
+
+  /// <summary>
+  /// Convert an utf32-encoded string to an utf8-encoded string.
+  /// </summary>
+  /// <param name="str">The utf32-encoded string to convert.</param>
+  /// <returns>Returns an utf8-encoded string. Returns an empty string on failure.</returns>
+  inline std::string utf32_to_utf8(const std::u32string & str)
+  {
+    std::string output;
+    transcode(str, output);
+    return output;
+  }
+
+  /// <summary>
+  /// Convert an utf16-encoded string to an utf32-encoded string.
+  /// </summary>
+  /// <param name="str">The utf16-encoded string to convert.</param>
+  /// <returns>Returns an utf32-encoded string. Returns an empty string on failure.</returns>
+  inline std::u32string utf16_to_utf32(const std::u16string & str)
+  {
+    std::u32string output;
+    transcode(str, output);
+    return output;
+  }
+
+  /// <summary>
+  /// Convert an utf32-encoded string to an utf16-encoded string.
+  /// </summary>
+  /// <param name="str">The utf32-encoded string to convert.</param>
+  /// <returns>Returns an utf16-encoded string. Returns an empty string on failure.</returns>
+  inline std::u16string utf32_to_utf16(const std::u32string & str)
+  {
+    std::u16string output;
+    transcode(str, output);
+    return output;
+  }
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_TRANSCODE_H
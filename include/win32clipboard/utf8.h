@@ -0,0 +1,79 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_UTF8_H
+#define WIN32CLIPBOARD_UTF8_H
+
+#include <stddef.h>
+#include <string>
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Errors found by validate_utf8() and sanitize_utf8().
+  /// </summary>
+  struct Utf8Report
+  {
+    size_t num_errors;    //number of ill-formed sequences
+    size_t first_error;   //offset in bytes of the first ill-formed sequence. Equals the length of the input if there is no error.
+  };
+
+  /// <summary>
+  /// Validate an utf8-encoded string.
+  /// </summary>
+  /// <param name="str">The string to validate.</param>
+  /// <param name="length">The length of the string in bytes.</param>
+  /// <param name="report">The output count and position of the ill-formed sequences.</param>
+  /// <returns>Returns true if the string is valid UTF-8. Returns false otherwise.</returns>
+  /// <remarks>Overlong sequences, surrogates and code points above U+10FFFF are ill-formed. \0 characters are valid.</remarks>
+  bool validate_utf8(const char * str, size_t length, Utf8Report & report);
+
+  /// <summary>
+  /// Copy an utf8-encoded string, replacing its ill-formed sequences with U+FFFD.
+  /// </summary>
+  /// <param name="src">The string to copy.</param>
+  /// <param name="length">The length of the string in bytes.</param>
+  /// <param name="dst">The output valid utf8-encoded string.</param>
+  /// <param name="report">The output count and position of the ill-formed sequences.</param>
+  /// <param name="convert_line_endings">True to also convert the CRLF line endings to LF, like crlf_to_lf().</param>
+  /// <returns>Returns true if the string is valid UTF-8. Returns false if ill-formed sequences were replaced.</returns>
+  /// <remarks>
+  /// The string is validated, copied and optionally converted in a single pass.
+  /// Each maximal subpart of an ill-formed sequence is replaced by one U+FFFD character, as recommended by the Unicode standard.
+  /// </remarks>
+  bool sanitize_utf8(const char * src, size_t length, std::string & dst, Utf8Report & report, bool convert_line_endings = false);
+
+  /// <summary>
+  /// Convert an utf8-encoded string to utf16, replacing its ill-formed sequences with U+FFFD.
+  /// </summary>
+  /// <param name="src">The string to convert.</param>
+  /// <param name="length">The length of the string in bytes.</param>
+  /// <param name="dst">The output utf16-encoded string.</param>
+  /// <param name="report">The output count and position of the ill-formed sequences.</param>
+  /// <returns>Returns true if the string is valid UTF-8. Returns false if ill-formed sequences were replaced.</returns>
+  bool sanitize_utf8(const char * src, size_t length, std::u16string & dst, Utf8Report & report);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_UTF8_H
@@ -25,10 +25,18 @@
 #ifndef WIN32CLIPBOARD_H
 #define WIN32CLIPBOARD_H
 
+#include <stdint.h>
 #include <vector>
 #include <string>
 
 #include "win32clipboard/config.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/image.h"
+#include "win32clipboard/stats.h"
+#include "win32clipboard/table.h"
+#include "win32clipboard/utf8.h"
+#include "win32clipboard/search.h"
+#include "win32clipboard/result.h"
 
 namespace win32clipboard
 {
@@ -119,7 +127,7 @@ namespace win32clipboard
  
   class Clipboard
   {
-  private:
+  protected:
     Clipboard();
     virtual ~Clipboard();
 
@@ -129,6 +137,7 @@ namespace win32clipboard
     //enums
     enum Format { FormatText, FormatUnicode, FormatImage, FormatBinary };
     enum DragDropType {DragDropCopy, DragDropCut};
+    enum TextEncoding { TextEncodingBase64, TextEncodingHex };
 
     //typedefs
     typedef std::vector<std::string> StringVector;
@@ -137,6 +146,56 @@ namespace win32clipboard
     //constants
     static const size_t NUM_FORMATS = 4;
 
+    /// <summary>
+    /// Enable or disable the conversion of line endings of text values.
+    /// </summary>
+    /// <param name="iEnabled">True to enable the conversion. The conversion is disabled by default.</param>
+    /// <remarks>
+    /// When enabled, SetText() and SetTextUnicode() convert LF line endings to CRLF, the line separator of the clipboard,
+    /// and GetAsText() and GetAsTextUnicode() convert CRLF line endings to LF.
+    /// The conversion is done while copying the text to or from the clipboard memory.
+    /// </remarks>
+    virtual void SetLineEndingConversion(bool iEnabled);
+
+    /// <summary>
+    /// Returns true if the conversion of line endings of text values is enabled.
+    /// </summary>
+    /// <returns>Returns true if the conversion of line endings of text values is enabled. Returns false otherwise.</returns>
+    virtual bool IsLineEndingConversionEnabled() const;
+
+    /// <summary>
+    /// Provides the statistics of the clipboard operations.
+    /// </summary>
+    /// <param name="oStats">The output statistics.</param>
+    /// <remarks>
+    /// Each Set*(), GetAs*(), Contains(), Hash(), Find*(), StartsWith(), EndsWith() and Empty() call is counted per kind of value with its latency and the number of bytes copied.
+    /// Opening the clipboard and converting values (line endings, images, HTML, list of files) are measured separately.
+    /// All counters are zero if the library is built without WIN32CLIPBOARD_ENABLE_STATS.
+    /// </remarks>
+    virtual void GetStats(ClipboardStats & oStats) const;
+
+    /// <summary>
+    /// Reset the statistics of the clipboard operations.
+    /// </summary>
+    virtual void ResetStats();
+
+    /// <summary>
+    /// Set the function called at the beginning and at the end of each clipboard operation.
+    /// </summary>
+    /// <param name="iCallback">The callback function. Use NULL to disable tracing.</param>
+    /// <param name="iUserData">The value given to the callback function.</param>
+    virtual void SetTraceCallback(TraceCallback iCallback, void * iUserData);
+
+    /// <summary>
+    /// Provides the result of the last clipboard operation of the calling thread.
+    /// </summary>
+    /// <returns>Returns the error code, the system error code, the operation and the kind of value of the last operation.</returns>
+    /// <remarks>
+    /// The result is recorded for each Set*(), GetAs*(), Contains(), Hash(), Find*(), StartsWith(), EndsWith() and Empty() call, without allocations.
+    /// Call ClipboardResult::GetDescription() to format a message when the cause of a failure is required.
+    /// </remarks>
+    virtual ClipboardResult GetLastResult() const;
+
     /// <summary>
     /// Clear the clipboard.
     /// </summary>
@@ -170,6 +229,31 @@ namespace win32clipboard
     /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
     virtual bool GetAsText(std::string & oText);
 
+    /// <summary>
+    /// Provides the current text value of the clipboard as a valid utf8-encoded string.
+    /// </summary>
+    /// <param name="oText">The output utf8-encoded text value of the clipboard.</param>
+    /// <param name="oReport">The output count and position of the ill-formed sequences of the clipboard text.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The text is validated while it is copied out of the clipboard memory. Ill-formed sequences are replaced with U+FFFD.
+    /// When the conversion of line endings is enabled, CRLF line endings are converted to LF in the same pass.
+    /// The offsets of the report are positions in the clipboard text, before the conversion.
+    /// </remarks>
+    virtual bool GetAsText(std::string & oText, Utf8Report & oReport);
+
+    /// <summary>
+    /// Provides the current text value of the clipboard as an utf8-encoded string, reading the text format that is the cheapest to convert.
+    /// </summary>
+    /// <param name="oText">The output utf8-encoded text value of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard does not contain text.</returns>
+    /// <remarks>
+    /// The formats are selected by order of preference: CF_UNICODETEXT when it was placed on the clipboard,
+    /// utf8 custom formats such as "UTF8_STRING", CF_UNICODETEXT synthesized by the system, then CF_TEXT and CF_OEMTEXT.
+    /// The selected format is converted to utf8 once. Ill-formed sequences are replaced with U+FFFD.
+    /// </remarks>
+    virtual bool GetText(std::string & oText);
+
     /// <summary>
     /// Assign the given unicode text value to the clipboard.
     /// </summary>
@@ -184,6 +268,34 @@ namespace win32clipboard
     /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
     virtual bool GetAsTextUnicode(std::wstring & oText);
 
+    /// <summary>
+    /// Assign the given utf16-encoded text value to the clipboard.
+    /// </summary>
+    /// <param name="iText">The utf16-encoded text value to set to the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool SetTextUnicode(const std::u16string & iText);
+
+    /// <summary>
+    /// Provides the current unicode text value of the clipboard as an utf16-encoded string.
+    /// </summary>
+    /// <param name="oText">The output utf16-encoded text value of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool GetAsTextUnicode(std::u16string & oText);
+
+    /// <summary>
+    /// Assign the given utf32-encoded text value to the clipboard.
+    /// </summary>
+    /// <param name="iText">The utf32-encoded text value to set to the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise. The function fails if the text is not valid utf32.</returns>
+    virtual bool SetTextUnicode(const std::u32string & iText);
+
+    /// <summary>
+    /// Provides the current unicode text value of the clipboard as an utf32-encoded string.
+    /// </summary>
+    /// <param name="oText">The output utf32-encoded text value of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise. The function fails if the clipboard text is not valid utf16.</returns>
+    virtual bool GetAsTextUnicode(std::u32string & oText);
+
     /// <summary>
     /// Assign the given binary data to the clipboard.
     /// </summary>
@@ -199,19 +311,167 @@ namespace win32clipboard
     virtual bool GetAsBinary(MemoryBuffer & oMemoryBuffer);
 
     /// <summary>
-    /// Assign the given file operation and list of files to the clipboard.
+    /// Assign the given binary data to the clipboard as text, for applications that only accept text.
+    /// </summary>
+    /// <param name="iMemoryBuffer">The binary data to set to the clipboard.</param>
+    /// <param name="iEncoding">The encoding of the binary data: base64 or hexadecimal.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>The data is encoded directly into the clipboard memory, which is sized exactly for the text.</remarks>
+    virtual bool SetBinaryAsText(const MemoryBuffer & iMemoryBuffer, TextEncoding iEncoding);
+
+    /// <summary>
+    /// Provides the binary data encoded in the current text value of the clipboard.
+    /// </summary>
+    /// <param name="oMemoryBuffer">The output binary data.</param>
+    /// <param name="iEncoding">The encoding of the binary data: base64 or hexadecimal.</param>
+    /// <returns>Returns true if the function is successful. Returns false if the clipboard does not contain text or if the text is not valid in the given encoding.</returns>
+    /// <remarks>The data is decoded directly from the clipboard memory. White spaces and line breaks of the text are ignored.</remarks>
+    virtual bool GetAsBinaryFromText(MemoryBuffer & oMemoryBuffer, TextEncoding iEncoding);
+
+    /// <summary>
+    /// Assign the given image to the clipboard.
     /// </summary>
-    /// <param name="iMemoryBuffer">The file operation and list of files to set to the clipboard.</param>
+    /// <param name="iImage">The image to set to the clipboard.</param>
     /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The image is published as a CF_DIBV5 bitmap with an alpha channel and as a "PNG" file.
+    /// Windows synthesizes the CF_DIB and CF_BITMAP formats.
+    /// Both formats are encoded before the clipboard is modified. The function succeeds once the bitmap is published,
+    /// even if the "PNG" format cannot be placed on the clipboard.
+    /// </remarks>
+    virtual bool SetImage(const Image & iImage);
+
+    /// <summary>
+    /// Provides the current image of the clipboard.
+    /// </summary>
+    /// <param name="oImage">The output image of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The pixels are converted directly from the clipboard memory into the output image.
+    /// Only uncompressed 24 and 32 bits per pixel bitmaps are supported.
+    /// If no supported bitmap is available, the "PNG" format is decoded.
+    /// </remarks>
+    virtual bool GetAsImage(Image & oImage);
+
+    /// <summary>
+    /// Assign the given HTML fragment to the clipboard.
+    /// </summary>
+    /// <param name="iFragment">The utf8-encoded HTML fragment to set to the clipboard.</param>
+    /// <param name="iText">The plain text alternative of the fragment, published as a text value. Ignored if empty.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>The fragment is published in the CF_HTML ("HTML Format") format.</remarks>
+    virtual bool SetHtml(const std::string & iFragment, const std::string & iText);
+
+    /// <summary>
+    /// Provides the current HTML fragment of the clipboard.
+    /// </summary>
+    /// <param name="oFragment">The output utf8-encoded HTML fragment of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>The fragment is located with the offsets of the CF_HTML header. Only the fragment is copied.</remarks>
+    virtual bool GetAsHtml(std::string & oFragment);
+
+    /// <summary>
+    /// Provides the current text value of the clipboard as a table.
+    /// </summary>
+    /// <param name="oTable">The output table. The table takes ownership of the text value of the clipboard.</param>
+    /// <param name="iDelimiter">The cell delimiter. Spreadsheets copy cells as tab-separated values.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    virtual bool GetAsTable(Table & oTable, char iDelimiter);
+
+    /// <summary>
+    /// Assign the given file operation and list of files to the clipboard.
+    /// </summary>
+    /// <param name="iMemoryBuffer">The file operation and list of utf8-encoded files to set to the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise. The function fails if a file path is not a valid utf8-encoded string.</returns>
     virtual bool SetDragDropFiles(const DragDropType & iDragDropType, const StringVector & iFiles);
 
     /// <summary>
     /// Provides the current file operation and list of files set to the clipboard.
     /// </summary>
-    /// <param name="oText">The output file operation and list of files of the clipboard.</param>
+    /// <param name="oText">The output file operation and list of utf8-encoded files of the clipboard.</param>
     /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
     virtual bool GetAsDragDropFiles(DragDropType & oDragDropType, StringVector & oFiles);
 
+    /// <summary>
+    /// Provides the current file operation and list of files set to the clipboard.
+    /// </summary>
+    /// <param name="oDragDropType">The output file operation of the clipboard.</param>
+    /// <param name="oFiles">The output list of utf8-encoded files of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The list of files is decoded in linear time into a single string pool. The length of the file paths is not limited.
+    /// Prefer this overload for very large list of files.
+    /// The file paths are returned as stored by the source application: use DropFileList::Normalize() before comparing them.
+    /// </remarks>
+    virtual bool GetAsDragDropFiles(DragDropType & oDragDropType, DropFileList & oFiles);
+
+    /// <summary>
+    /// Compute a fast non-cryptographic hash of the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to hash.</param>
+    /// <param name="oHash">The output hash of the format.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The hash is computed directly over the clipboard data without copying it.
+    /// For the text, unicode text and binary formats, the hash matches hash64() of the value returned by the matching GetAs*()
+    /// method when the conversion of line endings is disabled.
+    /// FormatImage hashes the bytes of the CF_DIB format, not the converted Image returned by GetAsImage().
+    /// </remarks>
+    virtual bool Hash(Format iClipboardFormat, uint64_t & oHash);
+
+    /// <summary>
+    /// Compute a fingerprint of all known formats of the clipboard, including the list of files.
+    /// </summary>
+    /// <param name="oFingerprint">The output fingerprint of the clipboard.</param>
+    /// <returns>Returns true if the function is successful. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The fingerprint changes when the content of any known format changes.
+    /// Use it to detect changes without transferring the content of the clipboard.
+    /// </remarks>
+    virtual bool GetFingerprint(uint64_t & oFingerprint);
+
+    /// <summary>
+    /// Find the first occurrence of a pattern in the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to search.</param>
+    /// <param name="iPattern">The pattern to find. The pattern is utf8-encoded for FormatUnicode and is searched as is for the other formats.</param>
+    /// <param name="oOffset">The output offset of the occurrence, in characters for text formats and in bytes for the other formats.</param>
+    /// <returns>Returns true if the pattern is found. Returns false otherwise.</returns>
+    /// <remarks>
+    /// The search runs directly on the clipboard data, without copying it.
+    /// Text formats are searched up to their terminating character and line endings are not converted.
+    /// </remarks>
+    virtual bool Find(Format iClipboardFormat, const std::string & iPattern, size_t & oOffset);
+
+    /// <summary>
+    /// Find the first occurrence of any pattern of a set in the given format.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to search.</param>
+    /// <param name="iPatterns">The patterns to find. The set must be created with PatternSet::EncodingUtf16 to search FormatUnicode
+    /// and with PatternSet::EncodingBytes to search the other formats.</param>
+    /// <param name="oMatch">The output occurrence. The offset and the size are in characters for text formats and in bytes for the other formats.</param>
+    /// <returns>Returns true if a pattern is found. Returns false otherwise.</returns>
+    /// <remarks>The clipboard data is scanned once, directly in place, whatever the number of patterns.</remarks>
+    virtual bool FindAny(Format iClipboardFormat, const PatternSet & iPatterns, SearchMatch & oMatch);
+
+    /// <summary>
+    /// Query the given format to know if its value starts with a pattern.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to query.</param>
+    /// <param name="iPattern">The pattern to compare. The pattern is utf8-encoded for FormatUnicode and is compared as is for the other formats.</param>
+    /// <returns>Returns true if the value starts with the pattern. Returns false otherwise.</returns>
+    virtual bool StartsWith(Format iClipboardFormat, const std::string & iPattern);
+
+    /// <summary>
+    /// Query the given format to know if its value ends with a pattern.
+    /// </summary>
+    /// <param name="iClipboardFormat">The format to query.</param>
+    /// <param name="iPattern">The pattern to compare. The pattern is utf8-encoded for FormatUnicode and is compared as is for the other formats.</param>
+    /// <returns>Returns true if the value ends with the pattern. Returns false otherwise.</returns>
+    virtual bool EndsWith(Format iClipboardFormat, const std::string & iPattern);
+
+  private:
+    bool mConvertLineEndings;
   };
 
 } //namespace win32clipboard
@@ -0,0 +1,376 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#include "win32clipboard/backend.h"
+#include "serialize.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#undef min
+#undef max
+#endif
+
+namespace win32clipboard
+{
+  const char * const Backend::FORMAT_TEXT         = "CF_TEXT";
+  const char * const Backend::FORMAT_UNICODE      = "CF_UNICODETEXT";
+  const char * const Backend::FORMAT_DIB          = "CF_DIB";
+  const char * const Backend::FORMAT_DIBV5        = "CF_DIBV5";
+  const char * const Backend::FORMAT_HDROP        = "CF_HDROP";
+  const char * const Backend::FORMAT_BINARY       = "Binary";
+  const char * const Backend::FORMAT_DROP_EFFECT  = "Preferred DropEffect";
+  const char * const Backend::FORMAT_HTML         = "HTML Format";
+  const char * const Backend::FORMAT_PNG          = "PNG";
+
+  //File layout of FileBackend: the signature, the number of formats then, for each format,
+  //the size of the name, the name, the size of the payload and the payload. Sizes are little endian.
+  static const char FILE_SIGNATURE[8] = { 'W', '3', '2', 'C', 'L', 'I', 'P', '1' };
+
+  static bool readString(const std::string & buffer, size_t & offset, std::string & value)
+  {
+    uint64_t size = 0;
+    if (!readUint64(buffer, offset, size) || size > buffer.size() - offset)
+      return false;
+    value.assign(buffer, offset, (size_t)size);
+    offset += (size_t)size;
+    return true;
+  }
+
+  static bool readFile(const std::string & path, std::string & content)
+  {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+      return false;
+
+    content.clear();
+    char buffer[64*1024];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+      content.append(buffer, read);
+    bool success = (ferror(f) == 0);
+    fclose(f);
+    return success;
+  }
+
+  Backend::~Backend()
+  {
+  }
+
+  //Number of readers that can read a MemoryBackend at the same time without waiting for a free slot
+  static const size_t NUM_READER_SLOTS = 64;
+
+  // Immutable content of a MemoryBackend.
+  struct MemoryBackend::Snapshot
+  {
+    Snapshot() : sequence(0) {}
+
+    uint64_t sequence;
+    ItemList items;
+  };
+
+  // Slot in which a reader publishes the snapshot it is reading. Padded to its own cache line.
+  struct MemoryBackend::ReaderSlot
+  {
+    std::atomic<const Snapshot *> snapshot;
+    char padding[64 - sizeof(std::atomic<const Snapshot *>)];
+  };
+
+  static size_t getReaderSlotHint()
+  {
+    //spread the threads over the slots
+    return std::hash<std::thread::id>()(std::this_thread::get_id()) % NUM_READER_SLOTS;
+  }
+
+  MemoryBackend::MemoryBackend() :
+    mSnapshot(new Snapshot()),
+    mSlots(new ReaderSlot[NUM_READER_SLOTS])
+  {
+    for(size_t i=0; i<NUM_READER_SLOTS; i++)
+      mSlots[i].snapshot.store(NULL);
+  }
+
+  MemoryBackend::~MemoryBackend()
+  {
+    for(size_t i=0; i<mRetired.size(); i++)
+      delete mRetired[i];
+    delete mSnapshot.load();
+    delete[] mSlots;
+  }
+
+  bool MemoryBackend::Write(const ItemList & iItems)
+  {
+    //copy outside of the lock
+    Snapshot * snapshot = new Snapshot();
+    snapshot->items = iItems;
+    publish(snapshot);
+    return true;
+  }
+
+  bool MemoryBackend::Read(const std::string & iFormat, std::string & oData)
+  {
+    size_t slot = 0;
+    const Snapshot * snapshot = pin(slot);
+
+    bool found = false;
+    for(size_t i=0; i<snapshot->items.size() && !found; i++)
+    {
+      if (snapshot->items[i].format == iFormat)
+      {
+        oData = snapshot->items[i].data;
+        found = true;
+      }
+    }
+
+    unpin(slot);
+    return found;
+  }
+
+  bool MemoryBackend::GetFormats(StringVector & oFormats)
+  {
+    size_t slot = 0;
+    const Snapshot * snapshot = pin(slot);
+
+    oFormats.clear();
+    for(size_t i=0; i<snapshot->items.size(); i++)
+      oFormats.push_back(snapshot->items[i].format);
+
+    unpin(slot);
+    return true;
+  }
+
+  bool MemoryBackend::Empty()
+  {
+    publish(new Snapshot());
+    return true;
+  }
+
+  uint64_t MemoryBackend::GetSequence() const
+  {
+    size_t slot = 0;
+    const uint64_t sequence = pin(slot)->sequence;
+    unpin(slot);
+    return sequence;
+  }
+
+  const MemoryBackend::Snapshot * MemoryBackend::pin(size_t & oSlot) const
+  {
+    //claim a free slot with the current snapshot
+    const Snapshot * snapshot = mSnapshot.load();
+    const size_t hint = getReaderSlotHint();
+    for(size_t i=0; ; i++)
+    {
+      if (i > 0 && i % NUM_READER_SLOTS == 0)
+        std::this_thread::yield();
+
+      const Snapshot * expected = NULL;
+      oSlot = (hint + i) % NUM_READER_SLOTS;
+      if (mSlots[oSlot].snapshot.compare_exchange_strong(expected, snapshot))
+        break;
+    }
+
+    //the snapshot is protected once the slot is visible to the writers, unless a writer replaced it meanwhile
+    for(;;)
+    {
+      const Snapshot * current = mSnapshot.load();
+      if (current == snapshot)
+        return snapshot;
+      snapshot = current;
+      mSlots[oSlot].snapshot.store(snapshot);
+    }
+  }
+
+  void MemoryBackend::unpin(size_t iSlot) const
+  {
+    mSlots[iSlot].snapshot.store(NULL, std::memory_order_release);
+  }
+
+  void MemoryBackend::publish(Snapshot * iSnapshot)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    iSnapshot->sequence = mSnapshot.load()->sequence + 1;
+    mRetired.push_back(mSnapshot.exchange(iSnapshot));
+    reclaim();
+  }
+
+  void MemoryBackend::reclaim()
+  {
+    std::vector<const Snapshot *> pinned;
+    for(size_t i=0; i<NUM_READER_SLOTS; i++)
+    {
+      const Snapshot * snapshot = mSlots[i].snapshot.load();
+      if (snapshot != NULL)
+        pinned.push_back(snapshot);
+    }
+
+    size_t count = 0;
+    for(size_t i=0; i<mRetired.size(); i++)
+    {
+      if (std::find(pinned.begin(), pinned.end(), mRetired[i]) == pinned.end())
+        delete mRetired[i];
+      else
+        mRetired[count++] = mRetired[i];
+    }
+    mRetired.resize(count);
+  }
+
+  FileBackend::FileBackend(const std::string & iPath) :
+    mPath(iPath)
+  {
+  }
+
+  FileBackend::~FileBackend()
+  {
+  }
+
+  const std::string & FileBackend::GetPath() const
+  {
+    return mPath;
+  }
+
+  bool FileBackend::Write(const ItemList & iItems)
+  {
+    size_t size = sizeof(FILE_SIGNATURE) + 8;
+    for(size_t i=0; i<iItems.size(); i++)
+      size += 16 + iItems[i].format.size() + iItems[i].data.size();
+
+    std::string content;
+    content.reserve(size);
+    content.append(FILE_SIGNATURE, sizeof(FILE_SIGNATURE));
+    appendUint64(content, iItems.size());
+    for(size_t i=0; i<iItems.size(); i++)
+    {
+      appendUint64(content, iItems[i].format.size());
+      content += iItems[i].format;
+      appendUint64(content, iItems[i].data.size());
+      content += iItems[i].data;
+    }
+
+    //write to a temporary file unique to this call so that concurrent writers never share a file
+    char suffix[64];
+    const uint64_t ticks = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    sprintf(suffix, ".%llx.%llx.tmp", (unsigned long long)ticks, (unsigned long long)(size_t)&content);
+    const std::string temp_path = mPath + suffix;
+
+    FILE * f = fopen(temp_path.c_str(), "wb");
+    if (f == NULL)
+      return false;
+    bool success = (fwrite(content.data(), 1, content.size(), f) == content.size());
+    success = (fclose(f) == 0) && success;
+
+    //replace the file in a single step: readers see either the previous or the new content
+#ifdef _WIN32
+    //rename() does not replace an existing file on Windows
+    if (success)
+      success = (MoveFileExA(temp_path.c_str(), mPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+    if (success)
+      success = (rename(temp_path.c_str(), mPath.c_str()) == 0);
+#endif
+    if (!success)
+      remove(temp_path.c_str());
+    return success;
+  }
+
+  bool FileBackend::Read(const std::string & iFormat, std::string & oData)
+  {
+    ItemList items;
+    if (!load(items))
+      return false;
+    for(size_t i=0; i<items.size(); i++)
+    {
+      if (items[i].format == iFormat)
+      {
+        oData.swap(items[i].data);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool FileBackend::GetFormats(StringVector & oFormats)
+  {
+    oFormats.clear();
+    ItemList items;
+    if (!load(items))
+    {
+      //a missing file is an empty clipboard
+      FILE * f = fopen(mPath.c_str(), "rb");
+      if (f == NULL)
+        return true;
+      fclose(f);
+      return false;
+    }
+    for(size_t i=0; i<items.size(); i++)
+      oFormats.push_back(items[i].format);
+    return true;
+  }
+
+  bool FileBackend::Empty()
+  {
+    if (remove(mPath.c_str()) == 0)
+      return true;
+
+    //nothing to remove
+    FILE * f = fopen(mPath.c_str(), "rb");
+    if (f == NULL)
+      return true;
+    fclose(f);
+    return false;
+  }
+
+  bool FileBackend::load(ItemList & oItems)
+  {
+    std::string content;
+    if (!readFile(mPath, content))
+      return false;
+    if (content.size() < sizeof(FILE_SIGNATURE) || memcmp(content.data(), FILE_SIGNATURE, sizeof(FILE_SIGNATURE)) != 0)
+      return false;
+
+    size_t offset = sizeof(FILE_SIGNATURE);
+    uint64_t count = 0;
+    if (!readUint64(content, offset, count))
+      return false;
+
+    //each format uses at least 16 bytes
+    if (count > (content.size() - offset) / 16)
+      return false;
+
+    oItems.resize((size_t)count);
+    for(size_t i=0; i<oItems.size(); i++)
+    {
+      if (!readString(content, offset, oItems[i].format) || !readString(content, offset, oItems[i].data))
+        return false;
+    }
+    return true;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,125 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "capture.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/html.h"
+#include "win32clipboard/image.h"
+#include "win32clipboard/transcode.h"
+
+namespace win32clipboard
+{
+  // Values of the Preferred DropEffect format
+  static const unsigned char DROP_EFFECT_COPY = 1;
+  static const unsigned char DROP_EFFECT_MOVE = 2;
+
+  bool read_backend_text(Backend & backend, std::string & text)
+  {
+    if (!backend.Read(Backend::FORMAT_TEXT, text))
+      return false;
+
+    //the backend stores the terminating \0 character of the clipboard
+    const size_t length = text.find('\0');
+    if (length != std::string::npos)
+      text.resize(length);
+    return true;
+  }
+
+  bool read_backend_unicode(Backend & backend, std::wstring & text)
+  {
+    std::string data;
+    if (!backend.Read(Backend::FORMAT_UNICODE, data))
+      return false;
+
+    const char16_t * src = (const char16_t *)data.data();
+    const size_t count = data.size() / sizeof(char16_t);
+    size_t length = 0;
+    while (length < count && src[length] != 0)
+      length++;
+    return transcode(src, length, text);
+  }
+
+  bool read_backend_dib(Backend & backend, std::string & dib)
+  {
+    if (!backend.Read(Backend::FORMAT_DIBV5, dib) && !backend.Read(Backend::FORMAT_DIB, dib))
+      return false;
+
+    DibView view;
+    return parse_dib(dib.data(), dib.size(), view);
+  }
+
+  bool read_backend_html(Backend & backend, std::string & fragment)
+  {
+    std::string data;
+    HtmlView view;
+    if (!backend.Read(Backend::FORMAT_HTML, data) || !parse_cf_html(data.data(), data.size(), view))
+      return false;
+
+    fragment.assign(view.fragment, view.fragment_size);
+    return true;
+  }
+
+  bool read_backend_dropfiles(Backend & backend, Clipboard::DragDropType & type, std::string & dropfiles)
+  {
+    std::string effect;
+    if (!backend.Read(Backend::FORMAT_DROP_EFFECT, effect) || effect.size() < 4)
+      return false;
+
+    //the effect is a little-endian DWORD: its first byte holds the copy and move bits
+    const unsigned char bits = (unsigned char)effect[0];
+    if (bits & DROP_EFFECT_COPY)
+      type = Clipboard::DragDropCopy;
+    else if (bits & DROP_EFFECT_MOVE)
+      type = Clipboard::DragDropCut;
+    else
+      return false;
+
+    return backend.Read(Backend::FORMAT_HDROP, dropfiles);
+  }
+
+#ifdef _WIN32
+  bool read_clipboard_dib(Clipboard & clipboard, std::string & dib)
+  {
+    Image image;
+    if (!clipboard.GetAsImage(image))
+      return false;
+
+    dib.resize(get_dib_size(image));
+    return encode_dib(image, &dib[0], dib.size());
+  }
+
+  bool read_clipboard_dropfiles(Clipboard & clipboard, Clipboard::DragDropType & type, std::string & dropfiles)
+  {
+    DropFileList list;
+    if (!clipboard.GetAsDragDropFiles(type, list))
+      return false;
+
+    std::vector<std::string> files;
+    list.ToVector(files);
+    dropfiles.resize(get_dropfiles_size(files));
+    return encode_dropfiles(files, &dropfiles[0], dropfiles.size());
+  }
+#endif //_WIN32
+
+} //namespace win32clipboard
@@ -0,0 +1,100 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_CAPTURE_H
+#define WIN32CLIPBOARD_CAPTURE_H
+
+#include <string>
+
+#include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/backend.h"
+
+// Helpers for reading the formats of a clipboard or a backend, shared by ClipboardHistory and ClipboardSnapshot.
+// This header is private to the library.
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Read the CF_TEXT format of a backend.
+  /// </summary>
+  /// <param name="backend">The backend to read.</param>
+  /// <param name="text">The output text, without its terminating \0 character.</param>
+  /// <returns>Returns true if the backend contains a text value. Returns false otherwise.</returns>
+  bool read_backend_text(Backend & backend, std::string & text);
+
+  /// <summary>
+  /// Read the CF_UNICODETEXT format of a backend.
+  /// </summary>
+  /// <param name="backend">The backend to read.</param>
+  /// <param name="text">The output unicode text, without its terminating \0 character.</param>
+  /// <returns>Returns true if the backend contains a valid UTF-16 text value. Returns false otherwise.</returns>
+  bool read_backend_unicode(Backend & backend, std::wstring & text);
+
+  /// <summary>
+  /// Read the CF_DIBV5 or CF_DIB format of a backend.
+  /// </summary>
+  /// <param name="backend">The backend to read.</param>
+  /// <param name="dib">The output device-independent bitmap. CF_DIBV5 is preferred.</param>
+  /// <returns>Returns true if the backend contains a valid bitmap (see parse_dib()). Returns false otherwise.</returns>
+  bool read_backend_dib(Backend & backend, std::string & dib);
+
+  /// <summary>
+  /// Read the fragment of the CF_HTML format of a backend.
+  /// </summary>
+  /// <param name="backend">The backend to read.</param>
+  /// <param name="fragment">The output utf8-encoded HTML fragment.</param>
+  /// <returns>Returns true if the backend contains a valid CF_HTML buffer. Returns false otherwise.</returns>
+  bool read_backend_html(Backend & backend, std::string & fragment);
+
+  /// <summary>
+  /// Read the CF_HDROP and Preferred DropEffect formats of a backend.
+  /// </summary>
+  /// <param name="backend">The backend to read.</param>
+  /// <param name="type">The output file operation.</param>
+  /// <param name="dropfiles">The output CF_HDROP buffer (see decode_dropfiles()).</param>
+  /// <returns>Returns true if the backend contains a list of files to copy or move. Returns false otherwise.</returns>
+  bool read_backend_dropfiles(Backend & backend, Clipboard::DragDropType & type, std::string & dropfiles);
+
+#ifdef _WIN32
+  /// <summary>
+  /// Read the image of a clipboard as a device-independent bitmap.
+  /// </summary>
+  /// <param name="clipboard">The clipboard to read.</param>
+  /// <param name="dib">The output device-independent bitmap (see encode_dib()).</param>
+  /// <returns>Returns true if the clipboard contains an image. Returns false otherwise.</returns>
+  bool read_clipboard_dib(Clipboard & clipboard, std::string & dib);
+
+  /// <summary>
+  /// Read the list of drag and drop files of a clipboard as a CF_HDROP buffer.
+  /// </summary>
+  /// <param name="clipboard">The clipboard to read.</param>
+  /// <param name="type">The output file operation.</param>
+  /// <param name="dropfiles">The output CF_HDROP buffer (see encode_dropfiles()).</param>
+  /// <returns>Returns true if the clipboard contains a list of files. Returns false otherwise.</returns>
+  bool read_clipboard_dropfiles(Clipboard & clipboard, Clipboard::DragDropType & type, std::string & dropfiles);
+#endif //_WIN32
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_CAPTURE_H
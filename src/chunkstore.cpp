@@ -0,0 +1,582 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "win32clipboard/chunkstore.h"
+#include "win32clipboard/hash.h"
+#include "serialize.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#undef min
+#undef max
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace win32clipboard
+{
+  //Files of a store. Integers are 64 bit little endian.
+  //chunks.idx is a list of 32 bytes records: the identifier of a chunk, its offset in chunks.pack and its size.
+  //payloads.idx is a list of records: the identifier of a payload, its size, the number of chunks and their identifiers.
+  static const char * const PACK_FILE = "chunks.pack";
+  static const char * const CHUNK_INDEX_FILE = "chunks.idx";
+  static const char * const PAYLOAD_INDEX_FILE = "payloads.idx";
+
+  //Layout of a snapshot: the signature, the number of formats then, for each format,
+  //the size of the name, the name and the identifier of the payload.
+  static const char SNAPSHOT_SIGNATURE[8] = { 'W', '3', '2', 'C', 'S', 'N', 'P', '1' };
+
+  //Seed of the second half of the identifiers
+  static const uint64_t ID_SEED = 0x9E3779B97F4A7C15ull;
+
+  //Random values of the gear hash, one per byte value
+  struct GearTable
+  {
+    uint64_t values[256];
+
+    GearTable()
+    {
+      //splitmix64
+      uint64_t state = 0;
+      for(size_t i=0; i<256; i++)
+      {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        values[i] = z ^ (z >> 31);
+      }
+    }
+  };
+
+  //Returns a mask of the given number of most significant bits.
+  static uint64_t getHighMask(unsigned bits)
+  {
+    if (bits == 0)
+      return 0;
+    if (bits >= 64)
+      return ~0ull;
+    return ~0ull << (64 - bits);
+  }
+
+  static void appendId(std::string & buffer, const ChunkStore::Id & id)
+  {
+    appendUint64(buffer, id.low);
+    appendUint64(buffer, id.high);
+  }
+
+  static bool readId(const std::string & buffer, size_t & offset, ChunkStore::Id & id)
+  {
+    return readUint64(buffer, offset, id.low) && readUint64(buffer, offset, id.high);
+  }
+
+  static ChunkStore::Id getId(const char * data, size_t size)
+  {
+    ChunkStore::Id id;
+    id.low = hash64(data, size);
+    id.high = hash64(data, size, ID_SEED);
+    return id;
+  }
+
+  static bool readFile(const std::string & path, std::string & content)
+  {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+      return false;
+
+    content.clear();
+    char buffer[64*1024];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+      content.append(buffer, read);
+    bool success = (ferror(f) == 0);
+    fclose(f);
+    return success;
+  }
+
+  //Write a buffer at the given offset of a file, overwriting the incomplete records left by an interrupted write.
+  static bool writeFile(const std::string & path, uint64_t offset, const char * data, size_t size)
+  {
+    if (size == 0)
+      return true;
+
+    FILE * f = fopen(path.c_str(), "r+b");
+    if (f == NULL)
+      return false;
+#ifdef _WIN32
+    bool success = (_fseeki64(f, (__int64)offset, SEEK_SET) == 0);
+#else
+    bool success = (fseeko(f, (off_t)offset, SEEK_SET) == 0);
+#endif
+    success = success && fwrite(data, 1, size, f) == size;
+    success = (fclose(f) == 0) && success;
+    return success;
+  }
+
+  size_t find_chunk_boundary(const char * data, size_t size, size_t min_size, size_t avg_size, size_t max_size)
+  {
+    static const GearTable gear;
+
+    if (size <= min_size)
+      return size;
+    if (size > max_size)
+      size = max_size;
+    size_t normal_size = (avg_size < size ? avg_size : size);
+
+    //a boundary is found every avg_size bytes on average: use one more bit before avg_size and one less bit after it
+    unsigned bits = 0;
+    while (((size_t)1 << (bits + 1)) <= avg_size)
+      bits++;
+    const uint64_t strict_mask = getHighMask(bits + 1);
+    const uint64_t loose_mask = getHighMask(bits > 1 ? bits - 1 : 1);
+
+    const unsigned char * bytes = (const unsigned char *)data;
+    uint64_t hash = 0;
+    size_t i = min_size;
+    for(; i < normal_size; i++)
+    {
+      hash = (hash << 1) + gear.values[bytes[i]];
+      if ((hash & strict_mask) == 0)
+        return i + 1;
+    }
+    for(; i < size; i++)
+    {
+      hash = (hash << 1) + gear.values[bytes[i]];
+      if ((hash & loose_mask) == 0)
+        return i + 1;
+    }
+    return size;
+  }
+
+  ChunkStore::ChunkStore(const std::string & iDirectory, size_t iMinChunkSize, size_t iAvgChunkSize, size_t iMaxChunkSize) :
+    mDirectory(iDirectory),
+    mMinChunkSize(iMinChunkSize),
+    mAvgChunkSize(iAvgChunkSize > 0 ? iAvgChunkSize : DEFAULT_AVG_CHUNK_SIZE),
+    mMaxChunkSize(iMaxChunkSize > 0 ? iMaxChunkSize : DEFAULT_MAX_CHUNK_SIZE),
+    mValid(false),
+    mPackSize(0),
+    mChunkIndexSize(0),
+    mPayloadIndexSize(0),
+    mPayloadBytes(0),
+    mMapping(NULL),
+    mMappingSize(0)
+  {
+    mValid = load();
+  }
+
+  ChunkStore::~ChunkStore()
+  {
+    unmap();
+  }
+
+  bool ChunkStore::IsValid() const
+  {
+    return mValid;
+  }
+
+  std::string ChunkStore::getPath(const char * iName) const
+  {
+    if (mDirectory.empty())
+      return iName;
+    const char last = mDirectory[mDirectory.size() - 1];
+    if (last == '/' || last == '\\')
+      return mDirectory + iName;
+    return mDirectory + "/" + iName;
+  }
+
+  bool ChunkStore::load()
+  {
+    //create the directory and the files if they do not exist
+#ifdef _WIN32
+    _mkdir(mDirectory.c_str());
+#else
+    mkdir(mDirectory.c_str(), 0755);
+#endif
+    const char * files[] = { PACK_FILE, CHUNK_INDEX_FILE, PAYLOAD_INDEX_FILE };
+    for(size_t i=0; i<sizeof(files)/sizeof(files[0]); i++)
+    {
+      FILE * f = fopen(getPath(files[i]).c_str(), "ab");
+      if (f == NULL)
+        return false;
+      fclose(f);
+    }
+
+    std::string pack_index;
+    std::string payload_index;
+    if (!readFile(getPath(CHUNK_INDEX_FILE), pack_index) || !readFile(getPath(PAYLOAD_INDEX_FILE), payload_index))
+      return false;
+
+    FILE * f = fopen(getPath(PACK_FILE).c_str(), "rb");
+    if (f == NULL)
+      return false;
+#ifdef _WIN32
+    bool success = (_fseeki64(f, 0, SEEK_END) == 0);
+    const int64_t pack_size = _ftelli64(f);
+#else
+    bool success = (fseeko(f, 0, SEEK_END) == 0);
+    const int64_t pack_size = (int64_t)ftello(f);
+#endif
+    fclose(f);
+    if (!success || pack_size < 0)
+      return false;
+
+    //load the records up to the first incomplete or invalid one
+    size_t offset = 0;
+    for(;;)
+    {
+      Id id;
+      Chunk chunk;
+      if (!readId(pack_index, offset, id) || !readUint64(pack_index, offset, chunk.offset) || !readUint64(pack_index, offset, chunk.size))
+        break;
+      if (chunk.offset > (uint64_t)pack_size || chunk.size > (uint64_t)pack_size - chunk.offset)
+        break;
+      mChunks[id] = chunk;
+      mChunkIndexSize = offset;
+      if (chunk.offset + chunk.size > mPackSize)
+        mPackSize = chunk.offset + chunk.size;
+    }
+
+    offset = 0;
+    for(;;)
+    {
+      Id id;
+      Payload payload;
+      uint64_t count = 0;
+      if (!readId(payload_index, offset, id) || !readUint64(payload_index, offset, payload.size) || !readUint64(payload_index, offset, count))
+        break;
+      if (count > (payload_index.size() - offset) / 16)
+        break;
+
+      bool valid = true;
+      uint64_t size = 0;
+      payload.chunks.resize((size_t)count);
+      for(size_t i=0; i<payload.chunks.size() && valid; i++)
+      {
+        ChunkMap::const_iterator chunk;
+        valid = readId(payload_index, offset, payload.chunks[i]) && (chunk = mChunks.find(payload.chunks[i])) != mChunks.end();
+        if (valid)
+          size += chunk->second.size;
+      }
+      if (!valid || size != payload.size)
+        break;
+
+      if (mPayloads.find(id) == mPayloads.end())
+        mPayloadBytes += payload.size;
+      Payload & stored = mPayloads[id];
+      stored.size = payload.size;
+      stored.chunks.swap(payload.chunks);
+      mPayloadIndexSize = offset;
+    }
+
+    return true;
+  }
+
+  bool ChunkStore::Put(const char * iData, size_t iSize, Id & oId)
+  {
+    if (!mValid)
+      return false;
+
+    //the identifiers are not collision resistant: a stored content is only reused if its bytes are the same
+    oId = getId(iData, iSize);
+    PayloadMap::const_iterator existing = mPayloads.find(oId);
+    if (existing != mPayloads.end())
+      return isStored(existing->second, iData, iSize);
+
+    //split the payload and write the new chunks at the end of the chunks file
+    Payload payload;
+    payload.size = iSize;
+    ChunkMap new_chunks;
+    std::map<Id, size_t> new_offsets; //offset of the new chunks in the payload
+    std::string chunk_records;
+    std::string pack;
+    uint64_t pack_size = mPackSize;
+    const std::string pack_path = getPath(PACK_FILE);
+    for(size_t offset=0; offset<iSize; )
+    {
+      const size_t size = find_chunk_boundary(iData + offset, iSize - offset, mMinChunkSize, mAvgChunkSize, mMaxChunkSize);
+      const Id id = getId(iData + offset, size);
+      payload.chunks.push_back(id);
+
+      ChunkMap::const_iterator stored = mChunks.find(id);
+      std::map<Id, size_t>::const_iterator pending = new_offsets.find(id);
+      if (stored != mChunks.end())
+      {
+        if (!isStored(stored->second, iData + offset, size))
+          return false;
+      }
+      else if (pending != new_offsets.end())
+      {
+        if (new_chunks[id].size != size || memcmp(iData + pending->second, iData + offset, size) != 0)
+          return false;
+      }
+      else
+      {
+        new_offsets[id] = offset;
+        Chunk & chunk = new_chunks[id];
+        chunk.offset = pack_size + pack.size();
+        chunk.size = size;
+        appendId(chunk_records, id);
+        appendUint64(chunk_records, chunk.offset);
+        appendUint64(chunk_records, chunk.size);
+
+        //write the chunks by batches of about 1 MiB
+        pack.append(iData + offset, size);
+        if (pack.size() >= 1024 * 1024)
+        {
+          if (!writeFile(pack_path, pack_size, pack.data(), pack.size()))
+            return false;
+          pack_size += pack.size();
+          pack.clear();
+        }
+      }
+      offset += size;
+    }
+    if (!writeFile(pack_path, pack_size, pack.data(), pack.size()))
+      return false;
+    pack_size += pack.size();
+
+    std::string payload_record;
+    appendId(payload_record, oId);
+    appendUint64(payload_record, payload.size);
+    appendUint64(payload_record, payload.chunks.size());
+    for(size_t i=0; i<payload.chunks.size(); i++)
+      appendId(payload_record, payload.chunks[i]);
+
+    //the chunks are written before their index, which is written before the payloads that use them
+    if (!writeFile(getPath(CHUNK_INDEX_FILE), mChunkIndexSize, chunk_records.data(), chunk_records.size()))
+      return false;
+    mChunks.insert(new_chunks.begin(), new_chunks.end());
+    mChunkIndexSize += chunk_records.size();
+    mPackSize = pack_size;
+
+    if (!writeFile(getPath(PAYLOAD_INDEX_FILE), mPayloadIndexSize, payload_record.data(), payload_record.size()))
+      return false;
+    mPayloadIndexSize += payload_record.size();
+    mPayloadBytes += payload.size;
+    Payload & stored = mPayloads[oId];
+    stored.size = payload.size;
+    stored.chunks.swap(payload.chunks);
+
+    return true;
+  }
+
+  bool ChunkStore::Put(const std::string & iPayload, Id & oId)
+  {
+    return Put(iPayload.data(), iPayload.size(), oId);
+  }
+
+  bool ChunkStore::Get(const Id & iId, std::string & oPayload)
+  {
+    PayloadMap::const_iterator it = mPayloads.find(iId);
+    if (it == mPayloads.end())
+      return false;
+    const Payload & payload = it->second;
+
+    //remap the chunks file if it grew since it was mapped
+    if (payload.size > 0 && mMappingSize < mPackSize && !map())
+      return false;
+
+    oPayload.resize((size_t)payload.size);
+    char * output = (payload.size > 0 ? &oPayload[0] : NULL);
+    for(size_t i=0; i<payload.chunks.size(); i++)
+    {
+      const Chunk & chunk = mChunks.find(payload.chunks[i])->second;
+      if (chunk.offset + chunk.size > mMappingSize)
+        return false;
+      memcpy(output, mMapping + chunk.offset, (size_t)chunk.size);
+      output += chunk.size;
+    }
+    return true;
+  }
+
+  bool ChunkStore::Contains(const Id & iId) const
+  {
+    return (mPayloads.find(iId) != mPayloads.end());
+  }
+
+  bool ChunkStore::SaveSnapshot(Backend & iBackend, Id & oId)
+  {
+    Backend::StringVector formats;
+    if (!iBackend.GetFormats(formats))
+      return false;
+
+    std::string snapshot(SNAPSHOT_SIGNATURE, sizeof(SNAPSHOT_SIGNATURE));
+    std::string items;
+    size_t count = 0;
+    std::string data;
+    for(size_t i=0; i<formats.size(); i++)
+    {
+      if (!iBackend.Read(formats[i], data))
+        continue;
+
+      Id id;
+      if (!Put(data, id))
+        return false;
+      appendUint64(items, formats[i].size());
+      items += formats[i];
+      appendId(items, id);
+      count++;
+    }
+    appendUint64(snapshot, count);
+    snapshot += items;
+
+    return Put(snapshot, oId);
+  }
+
+  bool ChunkStore::RestoreSnapshot(const Id & iId, Backend & iBackend)
+  {
+    std::string snapshot;
+    if (!Get(iId, snapshot))
+      return false;
+    if (snapshot.size() < sizeof(SNAPSHOT_SIGNATURE) || memcmp(snapshot.data(), SNAPSHOT_SIGNATURE, sizeof(SNAPSHOT_SIGNATURE)) != 0)
+      return false;
+
+    size_t offset = sizeof(SNAPSHOT_SIGNATURE);
+    uint64_t count = 0;
+    if (!readUint64(snapshot, offset, count) || count > snapshot.size())
+      return false;
+
+    Backend::ItemList items((size_t)count);
+    for(size_t i=0; i<items.size(); i++)
+    {
+      uint64_t size = 0;
+      Id id;
+      if (!readUint64(snapshot, offset, size) || size > snapshot.size() - offset)
+        return false;
+      items[i].format.assign(snapshot, offset, (size_t)size);
+      offset += (size_t)size;
+      if (!readId(snapshot, offset, id) || !Get(id, items[i].data))
+        return false;
+    }
+
+    if (items.empty())
+      return iBackend.Empty();
+    return iBackend.Write(items);
+  }
+
+  size_t ChunkStore::GetPayloadCount() const
+  {
+    return mPayloads.size();
+  }
+
+  size_t ChunkStore::GetChunkCount() const
+  {
+    return mChunks.size();
+  }
+
+  uint64_t ChunkStore::GetPayloadBytes() const
+  {
+    return mPayloadBytes;
+  }
+
+  uint64_t ChunkStore::GetChunkBytes() const
+  {
+    return mPackSize;
+  }
+
+  bool ChunkStore::isStored(const Chunk & iChunk, const char * iData, size_t iSize)
+  {
+    if (iChunk.size != iSize)
+      return false;
+    if (iSize == 0)
+      return true;
+
+    //remap the chunks file if it grew since it was mapped
+    if (iChunk.offset + iChunk.size > mMappingSize && !map())
+      return false;
+    if (iChunk.offset + iChunk.size > mMappingSize)
+      return false;
+    return memcmp(mMapping + iChunk.offset, iData, iSize) == 0;
+  }
+
+  bool ChunkStore::isStored(const Payload & iPayload, const char * iData, size_t iSize)
+  {
+    if (iPayload.size != iSize)
+      return false;
+
+    size_t offset = 0;
+    for(size_t i=0; i<iPayload.chunks.size(); i++)
+    {
+      const Chunk & chunk = mChunks.find(iPayload.chunks[i])->second;
+      if (chunk.size > iSize - offset || !isStored(chunk, iData + offset, (size_t)chunk.size))
+        return false;
+      offset += (size_t)chunk.size;
+    }
+    return true;
+  }
+
+  bool ChunkStore::map()
+  {
+    unmap();
+    if (mPackSize == 0)
+      return true;
+
+    const std::string path = getPath(PACK_FILE);
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+      return false;
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, (DWORD)(mPackSize >> 32), (DWORD)mPackSize, NULL);
+    CloseHandle(hFile);
+    if (hMapping == NULL)
+      return false;
+    //the view keeps the mapping alive
+    void * view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, (SIZE_T)mPackSize);
+    CloseHandle(hMapping);
+    if (view == NULL)
+      return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    void * view = mmap(NULL, (size_t)mPackSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+      return false;
+#endif
+
+    mMapping = (const char *)view;
+    mMappingSize = mPackSize;
+    return true;
+  }
+
+  void ChunkStore::unmap()
+  {
+    if (mMapping == NULL)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile(mMapping);
+#else
+    munmap((void *)mMapping, (size_t)mMappingSize);
+#endif
+    mMapping = NULL;
+    mMappingSize = 0;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,1051 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "deflate.h"
+
+namespace win32clipboard
+{
+  //------------------------------------------------------------------------------------------------
+  // Checksums
+  //------------------------------------------------------------------------------------------------
+
+  struct Crc32Table
+  {
+    uint32_t values[8][256];
+
+    Crc32Table()
+    {
+      for(uint32_t i=0; i<256; i++)
+      {
+        uint32_t c = i;
+        for(int k=0; k<8; k++)
+          c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        values[0][i] = c;
+      }
+      for(uint32_t i=0; i<256; i++)
+      {
+        for(int t=1; t<8; t++)
+          values[t][i] = (values[t-1][i] >> 8) ^ values[0][values[t-1][i] & 0xFF];
+      }
+    }
+  };
+
+  uint32_t crc32(uint32_t crc, const void * data, size_t size)
+  {
+    static const Crc32Table table;
+    const uint32_t (&t)[8][256] = table.values;
+
+    const unsigned char * p = (const unsigned char *)data;
+    crc = ~crc;
+
+    //slicing-by-8
+    while (size >= 8)
+    {
+      uint32_t lo = crc ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+      uint32_t hi =        (uint32_t)p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+      crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+      p += 8;
+      size -= 8;
+    }
+    while (size > 0)
+    {
+      crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+      p++;
+      size--;
+    }
+
+    return ~crc;
+  }
+
+  static const uint32_t ADLER_BASE = 65521;
+  static const size_t ADLER_NMAX = 5552; //largest n such that 255n(n+1)/2 + (n+1)(BASE-1) fits in 32 bits
+
+  uint32_t adler32(uint32_t adler, const void * data, size_t size)
+  {
+    const unsigned char * p = (const unsigned char *)data;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size > 0)
+    {
+      size_t n = (size < ADLER_NMAX ? size : ADLER_NMAX);
+      size -= n;
+      while (n >= 8)
+      {
+        a += p[0]; b += a;
+        a += p[1]; b += a;
+        a += p[2]; b += a;
+        a += p[3]; b += a;
+        a += p[4]; b += a;
+        a += p[5]; b += a;
+        a += p[6]; b += a;
+        a += p[7]; b += a;
+        p += 8;
+        n -= 8;
+      }
+      while (n > 0)
+      {
+        a += *p++;
+        b += a;
+        n--;
+      }
+      a %= ADLER_BASE;
+      b %= ADLER_BASE;
+    }
+    return (b << 16) | a;
+  }
+
+  uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2)
+  {
+    //See adler32_combine() in zlib
+    const uint32_t rem = (uint32_t)(size2 % ADLER_BASE);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_BASE);
+    sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + ADLER_BASE - rem;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+    if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+    if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+    return sum1 | (sum2 << 16);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Deflate tables
+  //------------------------------------------------------------------------------------------------
+
+  static const size_t NUM_LITLEN_SYMBOLS = 288;
+  static const size_t NUM_DIST_SYMBOLS = 32;
+  static const size_t NUM_CODELEN_SYMBOLS = 19;
+  static const unsigned MAX_CODE_BITS = 15;
+  static const unsigned MAX_CODELEN_BITS = 7;
+  static const unsigned END_OF_BLOCK = 256;
+
+  static const size_t MIN_MATCH = 3;
+  static const size_t MAX_MATCH = 258;
+  static const size_t WINDOW_SIZE = 32768;
+
+  static const unsigned short LENGTH_BASE[29] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+  static const unsigned char LENGTH_EXTRA[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+  static const unsigned short DIST_BASE[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+  static const unsigned char DIST_EXTRA[30] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+  static const unsigned char CODELEN_ORDER[NUM_CODELEN_SYMBOLS] = {16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+
+  // Maps a match length to its length code index (0-28)
+  struct LengthCodeTable
+  {
+    unsigned char values[MAX_MATCH + 1];
+
+    LengthCodeTable()
+    {
+      memset(values, 0, sizeof(values));
+      for(size_t code=0; code<29; code++)
+      {
+        size_t last = (code + 1 < 29 ? LENGTH_BASE[code + 1] - 1 : MAX_MATCH);
+        if (code == 27)
+          last = 257; //258 has its own code
+        for(size_t length=LENGTH_BASE[code]; length<=last; length++)
+          values[length] = (unsigned char)code;
+      }
+    }
+  };
+
+  static inline unsigned getDistanceCode(unsigned distance)
+  {
+    unsigned d = distance - 1;
+    if (d < 4)
+      return d;
+    unsigned msb = 0;
+    while ((d >> (msb + 1)) != 0)
+      msb++;
+    return 2 * msb + ((d >> (msb - 1)) & 1);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Huffman codes
+  //------------------------------------------------------------------------------------------------
+
+  static inline uint32_t reverseBits(uint32_t code, unsigned length)
+  {
+    uint32_t reversed = 0;
+    for(unsigned i=0; i<length; i++)
+    {
+      reversed = (reversed << 1) | (code & 1);
+      code >>= 1;
+    }
+    return reversed;
+  }
+
+  // Compute length-limited Huffman code lengths for the given symbol frequencies.
+  static void buildCodeLengths(const uint32_t * freqs, size_t num_symbols, unsigned max_bits, unsigned char * lengths)
+  {
+    memset(lengths, 0, num_symbols);
+
+    //symbols sorted by increasing frequency
+    std::vector<std::pair<uint32_t, unsigned> > leaves;
+    for(size_t i=0; i<num_symbols; i++)
+    {
+      if (freqs[i] > 0)
+        leaves.push_back(std::make_pair(freqs[i], (unsigned)i));
+    }
+    if (leaves.empty())
+      return;
+    if (leaves.size() == 1)
+    {
+      lengths[leaves[0].second] = 1;
+      return;
+    }
+    std::sort(leaves.begin(), leaves.end());
+
+    //build the tree with two queues: sorted leaves and internal nodes created in increasing weight order
+    const size_t n = leaves.size();
+    std::vector<uint64_t> weights(2 * n - 1);
+    std::vector<size_t> parents(2 * n - 1, 0);
+    for(size_t i=0; i<n; i++)
+      weights[i] = leaves[i].first;
+
+    size_t next_leaf = 0;
+    size_t next_node = n;
+    for(size_t node=n; node<2*n-1; node++)
+    {
+      size_t children[2];
+      for(int k=0; k<2; k++)
+      {
+        if (next_leaf < n && (next_node >= node || weights[next_leaf] <= weights[next_node]))
+          children[k] = next_leaf++;
+        else
+          children[k] = next_node++;
+      }
+      weights[node] = weights[children[0]] + weights[children[1]];
+      parents[children[0]] = node;
+      parents[children[1]] = node;
+    }
+
+    //depth of each leaf, counted per length
+    std::vector<unsigned> depths(2 * n - 1, 0);
+    unsigned num_codes[64] = {0};
+    for(size_t node=2*n-2; node-- > 0; )
+      depths[node] = depths[parents[node]] + 1;
+    for(size_t i=0; i<n; i++)
+      num_codes[std::min(depths[i], 63u)]++;
+
+    //limit the code lengths to max_bits while keeping a complete code.
+    //See tdefl_huffman_enforce_max_code_size() in miniz.
+    for(unsigned i=max_bits+1; i<64; i++)
+    {
+      num_codes[max_bits] += num_codes[i];
+      num_codes[i] = 0;
+    }
+    uint32_t total = 0;
+    for(unsigned i=max_bits; i>0; i--)
+      total += num_codes[i] << (max_bits - i);
+    while (total != (1u << max_bits))
+    {
+      num_codes[max_bits]--;
+      for(unsigned i=max_bits-1; i>0; i--)
+      {
+        if (num_codes[i])
+        {
+          num_codes[i]--;
+          num_codes[i + 1] += 2;
+          break;
+        }
+      }
+      total--;
+    }
+
+    //the least frequent symbols get the longest codes
+    size_t leaf = 0;
+    for(unsigned length=max_bits; length>0; length--)
+    {
+      for(unsigned k=0; k<num_codes[length]; k++)
+        lengths[leaves[leaf++].second] = (unsigned char)length;
+    }
+  }
+
+  // Compute the canonical codes (bit-reversed, ready to be written LSB first) for the given code lengths.
+  static void buildCodes(const unsigned char * lengths, size_t num_symbols, uint16_t * codes)
+  {
+    unsigned bl_count[MAX_CODE_BITS + 1] = {0};
+    for(size_t i=0; i<num_symbols; i++)
+      bl_count[lengths[i]]++;
+    bl_count[0] = 0;
+
+    uint32_t next_code[MAX_CODE_BITS + 2] = {0};
+    uint32_t code = 0;
+    for(unsigned bits=1; bits<=MAX_CODE_BITS; bits++)
+    {
+      code = (code + bl_count[bits - 1]) << 1;
+      next_code[bits] = code;
+    }
+
+    for(size_t i=0; i<num_symbols; i++)
+    {
+      codes[i] = 0;
+      if (lengths[i] != 0)
+        codes[i] = (uint16_t)reverseBits(next_code[lengths[i]]++, lengths[i]);
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Compressor
+  //------------------------------------------------------------------------------------------------
+
+  class BitWriter
+  {
+  public:
+    BitWriter(std::string & out) : mOut(out), mBits(0), mCount(0)
+    {
+    }
+
+    inline void put(uint32_t bits, unsigned count)
+    {
+      mBits |= (uint64_t)bits << mCount;
+      mCount += count;
+      if (mCount >= 32)
+      {
+        char bytes[4] = { (char)mBits, (char)(mBits >> 8), (char)(mBits >> 16), (char)(mBits >> 24) };
+        mOut.append(bytes, 4);
+        mBits >>= 32;
+        mCount -= 32;
+      }
+    }
+
+    //copy raw bytes. The writer must be aligned.
+    void append(const unsigned char * data, size_t size)
+    {
+      mOut.append((const char *)data, size);
+    }
+
+    //flush the pending bits, padding the last byte with zeros
+    void align()
+    {
+      while (mCount > 0)
+      {
+        mOut.push_back((char)mBits);
+        mBits >>= 8;
+        mCount = (mCount > 8 ? mCount - 8 : 0);
+      }
+      mBits = 0;
+    }
+
+  private:
+    std::string & mOut;
+    uint64_t mBits;
+    unsigned mCount;
+  };
+
+  // A literal (distance == 0) or a match
+  struct Token
+  {
+    uint16_t value; //literal byte or match length
+    uint16_t distance;
+  };
+
+  class Compressor
+  {
+  public:
+    Compressor(const unsigned char * data, size_t size, size_t dictionary_size, std::string & out) :
+      mWriter(out)
+    {
+      if (dictionary_size > WINDOW_SIZE)
+        dictionary_size = WINDOW_SIZE;
+      mBase = data - dictionary_size;
+      mBegin = dictionary_size;
+      mEnd = dictionary_size + size;
+      mHead.assign(HASH_SIZE, -1);
+      mPrev.assign(mEnd, -1);
+    }
+
+    void compress(bool final)
+    {
+      //prime the window with the dictionary
+      for(size_t pos=0; pos<mBegin; pos++)
+        insert(pos);
+
+      std::vector<Token> tokens;
+      tokens.reserve(MAX_BLOCK_TOKENS);
+      size_t block_begin = mBegin;
+
+      size_t pos = mBegin;
+      while (pos < mEnd)
+      {
+        size_t distance = 0;
+        size_t length = findMatch(pos, distance);
+        Token token;
+        if (length >= MIN_MATCH)
+        {
+          token.value = (uint16_t)length;
+          token.distance = (uint16_t)distance;
+          for(size_t i=0; i<length; i++)
+            insert(pos + i);
+          pos += length;
+        }
+        else
+        {
+          token.value = mBase[pos];
+          token.distance = 0;
+          insert(pos);
+          pos++;
+        }
+        tokens.push_back(token);
+
+        if (tokens.size() >= MAX_BLOCK_TOKENS)
+        {
+          writeBlock(tokens, block_begin, pos, final && pos == mEnd);
+          tokens.clear();
+          block_begin = pos;
+        }
+      }
+      if (!tokens.empty() || final)
+        writeBlock(tokens, block_begin, pos, final);
+
+      if (!final)
+      {
+        //empty stored block: aligns the output to a byte boundary
+        mWriter.put(0, 3);
+        mWriter.align();
+        mWriter.put(0x0000, 16);
+        mWriter.put(0xFFFF, 16);
+      }
+      mWriter.align();
+    }
+
+  private:
+    static const size_t HASH_BITS = 15;
+    static const size_t HASH_SIZE = (size_t)1 << HASH_BITS;
+    static const size_t MAX_CHAIN = 48;
+    static const size_t NICE_LENGTH = 128;
+    static const size_t MAX_BLOCK_TOKENS = 32768;
+
+    inline uint32_t hashAt(size_t pos) const
+    {
+      const unsigned char * p = mBase + pos;
+      uint32_t value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+      return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    inline void insert(size_t pos)
+    {
+      if (pos + MIN_MATCH > mEnd)
+        return;
+      uint32_t h = hashAt(pos);
+      mPrev[pos] = mHead[h];
+      mHead[h] = (int32_t)pos;
+    }
+
+    size_t findMatch(size_t pos, size_t & distance) const
+    {
+      if (pos + MIN_MATCH > mEnd)
+        return 0;
+
+      const size_t max_length = std::min(MAX_MATCH, mEnd - pos);
+      const unsigned char * current = mBase + pos;
+      size_t best_length = MIN_MATCH - 1;
+      int32_t candidate = mHead[hashAt(pos)];
+      for(size_t chain=0; chain<MAX_CHAIN && candidate >= 0; chain++)
+      {
+        const size_t match_pos = (size_t)candidate;
+        if (pos - match_pos > WINDOW_SIZE)
+          break;
+
+        const unsigned char * match = mBase + match_pos;
+        if (match[best_length] == current[best_length] && match[0] == current[0] && match[1] == current[1])
+        {
+          size_t length = 2;
+          while (length < max_length && match[length] == current[length])
+            length++;
+          if (length > best_length)
+          {
+            best_length = length;
+            distance = pos - match_pos;
+            if (length >= NICE_LENGTH || length == max_length)
+              break;
+          }
+        }
+        candidate = mPrev[match_pos];
+      }
+
+      return (best_length >= MIN_MATCH ? best_length : 0);
+    }
+
+    void writeBlock(const std::vector<Token> & tokens, size_t raw_begin, size_t raw_end, bool final)
+    {
+      static const LengthCodeTable length_codes;
+
+      //symbol frequencies
+      uint32_t litlen_freqs[NUM_LITLEN_SYMBOLS] = {0};
+      uint32_t dist_freqs[NUM_DIST_SYMBOLS] = {0};
+      uint64_t extra_bits = 0;
+      for(size_t i=0; i<tokens.size(); i++)
+      {
+        const Token & t = tokens[i];
+        if (t.distance == 0)
+        {
+          litlen_freqs[t.value]++;
+        }
+        else
+        {
+          unsigned lcode = length_codes.values[t.value];
+          unsigned dcode = getDistanceCode(t.distance);
+          litlen_freqs[257 + lcode]++;
+          dist_freqs[dcode]++;
+          extra_bits += LENGTH_EXTRA[lcode] + DIST_EXTRA[dcode];
+        }
+      }
+      litlen_freqs[END_OF_BLOCK] = 1;
+
+      //dynamic codes
+      unsigned char litlen_lengths[NUM_LITLEN_SYMBOLS];
+      unsigned char dist_lengths[NUM_DIST_SYMBOLS];
+      buildCodeLengths(litlen_freqs, 286, MAX_CODE_BITS, litlen_lengths);
+      buildCodeLengths(dist_freqs, 30, MAX_CODE_BITS, dist_lengths);
+      litlen_lengths[286] = litlen_lengths[287] = 0;
+      dist_lengths[30] = dist_lengths[31] = 0;
+      if (dist_lengths[0] == 0 && std::count(dist_lengths, dist_lengths + 30, 0) == 30)
+        dist_lengths[0] = 1; //at least one distance code
+
+      size_t num_litlen = 286;
+      while (num_litlen > 257 && litlen_lengths[num_litlen - 1] == 0)
+        num_litlen--;
+      size_t num_dist = 30;
+      while (num_dist > 1 && dist_lengths[num_dist - 1] == 0)
+        num_dist--;
+
+      //run-length encoding of the code lengths
+      std::vector<unsigned char> all_lengths(litlen_lengths, litlen_lengths + num_litlen);
+      all_lengths.insert(all_lengths.end(), dist_lengths, dist_lengths + num_dist);
+      std::vector<std::pair<unsigned char, unsigned char> > rle; //symbol, extra value
+      for(size_t i=0; i<all_lengths.size(); )
+      {
+        const unsigned char value = all_lengths[i];
+        size_t run = 1;
+        while (i + run < all_lengths.size() && all_lengths[i + run] == value)
+          run++;
+
+        if (value == 0 && run >= 3)
+        {
+          size_t n = std::min(run, (size_t)138);
+          if (n >= 11)
+            rle.push_back(std::make_pair((unsigned char)18, (unsigned char)(n - 11)));
+          else
+            rle.push_back(std::make_pair((unsigned char)17, (unsigned char)(n - 3)));
+          i += n;
+        }
+        else if (value != 0 && run >= 4)
+        {
+          rle.push_back(std::make_pair(value, (unsigned char)0));
+          size_t n = std::min(run - 1, (size_t)6);
+          rle.push_back(std::make_pair((unsigned char)16, (unsigned char)(n - 3)));
+          i += 1 + n;
+        }
+        else
+        {
+          rle.push_back(std::make_pair(value, (unsigned char)0));
+          i++;
+        }
+      }
+
+      uint32_t codelen_freqs[NUM_CODELEN_SYMBOLS] = {0};
+      for(size_t i=0; i<rle.size(); i++)
+        codelen_freqs[rle[i].first]++;
+      unsigned char codelen_lengths[NUM_CODELEN_SYMBOLS];
+      buildCodeLengths(codelen_freqs, NUM_CODELEN_SYMBOLS, MAX_CODELEN_BITS, codelen_lengths);
+      size_t num_codelen = NUM_CODELEN_SYMBOLS;
+      while (num_codelen > 4 && codelen_lengths[CODELEN_ORDER[num_codelen - 1]] == 0)
+        num_codelen--;
+
+      //size of each block type, in bits
+      uint64_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * num_codelen + extra_bits;
+      for(size_t i=0; i<rle.size(); i++)
+      {
+        const unsigned char symbol = rle[i].first;
+        dynamic_bits += codelen_lengths[symbol] + (symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0);
+      }
+      uint64_t fixed_bits = 3 + extra_bits;
+      for(size_t i=0; i<NUM_LITLEN_SYMBOLS; i++)
+      {
+        dynamic_bits += (uint64_t)litlen_freqs[i] * litlen_lengths[i];
+        fixed_bits += (uint64_t)litlen_freqs[i] * (i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+      }
+      for(size_t i=0; i<NUM_DIST_SYMBOLS; i++)
+      {
+        dynamic_bits += (uint64_t)dist_freqs[i] * dist_lengths[i];
+        fixed_bits += (uint64_t)dist_freqs[i] * 5;
+      }
+      const size_t raw_size = raw_end - raw_begin;
+      const uint64_t stored_bits = (raw_size / 65535 + 1) * (5 * 8 + 7) + (uint64_t)raw_size * 8;
+
+      if (stored_bits < dynamic_bits && stored_bits < fixed_bits)
+      {
+        writeStored(raw_begin, raw_end, final);
+        return;
+      }
+
+      if (fixed_bits <= dynamic_bits)
+      {
+        for(size_t i=0; i<NUM_LITLEN_SYMBOLS; i++)
+          litlen_lengths[i] = (unsigned char)(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+        for(size_t i=0; i<NUM_DIST_SYMBOLS; i++)
+          dist_lengths[i] = 5;
+        mWriter.put(final ? 1 : 0, 1);
+        mWriter.put(1, 2);
+      }
+      else
+      {
+        mWriter.put(final ? 1 : 0, 1);
+        mWriter.put(2, 2);
+        mWriter.put((uint32_t)(num_litlen - 257), 5);
+        mWriter.put((uint32_t)(num_dist - 1), 5);
+        mWriter.put((uint32_t)(num_codelen - 4), 4);
+        for(size_t i=0; i<num_codelen; i++)
+          mWriter.put(codelen_lengths[CODELEN_ORDER[i]], 3);
+
+        uint16_t codelen_codes[NUM_CODELEN_SYMBOLS];
+        buildCodes(codelen_lengths, NUM_CODELEN_SYMBOLS, codelen_codes);
+        for(size_t i=0; i<rle.size(); i++)
+        {
+          const unsigned char symbol = rle[i].first;
+          mWriter.put(codelen_codes[symbol], codelen_lengths[symbol]);
+          if (symbol == 16)
+            mWriter.put(rle[i].second, 2);
+          else if (symbol == 17)
+            mWriter.put(rle[i].second, 3);
+          else if (symbol == 18)
+            mWriter.put(rle[i].second, 7);
+        }
+      }
+
+      uint16_t litlen_codes[NUM_LITLEN_SYMBOLS];
+      uint16_t dist_codes[NUM_DIST_SYMBOLS];
+      buildCodes(litlen_lengths, NUM_LITLEN_SYMBOLS, litlen_codes);
+      buildCodes(dist_lengths, NUM_DIST_SYMBOLS, dist_codes);
+
+      for(size_t i=0; i<tokens.size(); i++)
+      {
+        const Token & t = tokens[i];
+        if (t.distance == 0)
+        {
+          mWriter.put(litlen_codes[t.value], litlen_lengths[t.value]);
+        }
+        else
+        {
+          const unsigned lcode = length_codes.values[t.value];
+          const unsigned dcode = getDistanceCode(t.distance);
+          mWriter.put(litlen_codes[257 + lcode], litlen_lengths[257 + lcode]);
+          mWriter.put(t.value - LENGTH_BASE[lcode], LENGTH_EXTRA[lcode]);
+          mWriter.put(dist_codes[dcode], dist_lengths[dcode]);
+          mWriter.put(t.distance - DIST_BASE[dcode], DIST_EXTRA[dcode]);
+        }
+      }
+      mWriter.put(litlen_codes[END_OF_BLOCK], litlen_lengths[END_OF_BLOCK]);
+    }
+
+    void writeStored(size_t raw_begin, size_t raw_end, bool final)
+    {
+      do
+      {
+        const size_t length = std::min(raw_end - raw_begin, (size_t)65535);
+        const bool last = (raw_begin + length == raw_end);
+        mWriter.put((final && last) ? 1 : 0, 1);
+        mWriter.put(0, 2);
+        mWriter.align();
+        mWriter.put((uint32_t)length, 16);
+        mWriter.put((uint32_t)(~length & 0xFFFF), 16);
+        mWriter.align();
+        mWriter.append(mBase + raw_begin, length);
+        raw_begin += length;
+      } while (raw_begin < raw_end);
+    }
+
+  private:
+    BitWriter mWriter;
+    const unsigned char * mBase; //start of the dictionary
+    size_t mBegin;               //position of the data to compress, relative to mBase
+    size_t mEnd;
+    std::vector<int32_t> mHead;
+    std::vector<int32_t> mPrev;
+  };
+
+  void deflate_raw(const unsigned char * data, size_t size, size_t dictionary_size, bool final, std::string & out)
+  {
+    Compressor compressor(data, size, dictionary_size, out);
+    compressor.compress(final);
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Decompressor
+  //------------------------------------------------------------------------------------------------
+
+  // Table-driven Huffman decoder. Each entry of the table is indexed by the next
+  // max_bits bits of the stream and holds the symbol and the length of its code.
+  class HuffmanDecoder
+  {
+  public:
+    bool init(const unsigned char * lengths, size_t num_symbols)
+    {
+      unsigned bl_count[MAX_CODE_BITS + 1] = {0};
+      mMaxBits = 0;
+      for(size_t i=0; i<num_symbols; i++)
+      {
+        bl_count[lengths[i]]++;
+        if (lengths[i] > mMaxBits)
+          mMaxBits = lengths[i];
+      }
+      bl_count[0] = 0;
+      if (mMaxBits == 0)
+      {
+        mTable.clear();
+        return true; //no symbols, any attempt to decode fails
+      }
+
+      //reject over-subscribed codes
+      int left = 1;
+      for(unsigned bits=1; bits<=MAX_CODE_BITS; bits++)
+      {
+        left <<= 1;
+        left -= (int)bl_count[bits];
+        if (left < 0)
+          return false;
+      }
+
+      uint16_t codes[NUM_LITLEN_SYMBOLS];
+      buildCodes(lengths, num_symbols, codes);
+
+      //unused entries keep a length of 0 and are detected as invalid codes
+      mTable.assign((size_t)1 << mMaxBits, 0);
+      for(size_t i=0; i<num_symbols; i++)
+      {
+        const unsigned length = lengths[i];
+        if (length == 0)
+          continue;
+        const uint32_t entry = ((uint32_t)i << 4) | length;
+        for(size_t index=codes[i]; index<mTable.size(); index += ((size_t)1 << length))
+          mTable[index] = entry;
+      }
+      return true;
+    }
+
+    inline unsigned getMaxBits() const { return mMaxBits; }
+    inline uint32_t lookup(uint32_t bits) const { return mTable.empty() ? 0 : mTable[bits & ((1u << mMaxBits) - 1)]; }
+
+  private:
+    std::vector<uint32_t> mTable;
+    unsigned mMaxBits;
+  };
+
+  class Decompressor
+  {
+  public:
+    Decompressor(const unsigned char * data, size_t size, unsigned char * out, size_t out_size) :
+      mData(data), mSize(size), mPos(0), mBits(0), mCount(0),
+      mOut(out), mOutSize(out_size), mOutPos(0)
+    {
+    }
+
+    bool decompress()
+    {
+      bool final = false;
+      while (!final)
+      {
+        uint32_t header = 0;
+        if (!getBits(3, header))
+          return false;
+        final = (header & 1) != 0;
+        const uint32_t type = header >> 1;
+
+        bool success = false;
+        if (type == 0)
+          success = readStored();
+        else if (type == 1)
+          success = readFixed();
+        else if (type == 2)
+          success = readDynamic();
+        if (!success)
+          return false;
+      }
+      return true;
+    }
+
+    //number of input bytes consumed, including partially consumed bytes
+    size_t getConsumed() const { return mPos - mCount / 8; }
+    size_t getProduced() const { return mOutPos; }
+
+  private:
+    inline void refill()
+    {
+      while (mCount <= 56 && mPos < mSize)
+      {
+        mBits |= (uint64_t)mData[mPos++] << mCount;
+        mCount += 8;
+      }
+    }
+
+    inline bool getBits(unsigned count, uint32_t & value)
+    {
+      if (count == 0)
+      {
+        value = 0;
+        return true;
+      }
+      if (mCount < count)
+      {
+        refill();
+        if (mCount < count)
+          return false;
+      }
+      value = (uint32_t)(mBits & ((1ull << count) - 1));
+      mBits >>= count;
+      mCount -= count;
+      return true;
+    }
+
+    inline bool decodeSymbol(const HuffmanDecoder & decoder, unsigned & symbol)
+    {
+      if (mCount < decoder.getMaxBits())
+        refill();
+      const uint32_t entry = decoder.lookup((uint32_t)mBits);
+      const unsigned length = entry & 0xF;
+      if (length == 0 || length > mCount)
+        return false;
+      mBits >>= length;
+      mCount -= length;
+      symbol = entry >> 4;
+      return true;
+    }
+
+    bool readStored()
+    {
+      //skip to the next byte boundary
+      const unsigned padding = mCount % 8;
+      mBits >>= padding;
+      mCount -= padding;
+
+      uint32_t length = 0;
+      uint32_t complement = 0;
+      if (!getBits(16, length) || !getBits(16, complement))
+        return false;
+      if ((length ^ 0xFFFF) != complement)
+        return false;
+
+      //give back the bytes that were read ahead
+      mPos -= mCount / 8;
+      mBits = 0;
+      mCount = 0;
+
+      if (length > mSize - mPos || length > mOutSize - mOutPos)
+        return false;
+      memcpy(mOut + mOutPos, mData + mPos, length);
+      mPos += length;
+      mOutPos += length;
+      return true;
+    }
+
+    bool readFixed()
+    {
+      static const FixedDecoders fixed;
+      return readCompressed(fixed.litlen, fixed.dist);
+    }
+
+    bool readDynamic()
+    {
+      uint32_t hlit = 0, hdist = 0, hclen = 0;
+      if (!getBits(5, hlit) || !getBits(5, hdist) || !getBits(4, hclen))
+        return false;
+      const size_t num_litlen = hlit + 257;
+      const size_t num_dist = hdist + 1;
+      const size_t num_codelen = hclen + 4;
+      if (num_litlen > 286 || num_dist > 30)
+        return false;
+
+      unsigned char codelen_lengths[NUM_CODELEN_SYMBOLS] = {0};
+      for(size_t i=0; i<num_codelen; i++)
+      {
+        uint32_t length = 0;
+        if (!getBits(3, length))
+          return false;
+        codelen_lengths[CODELEN_ORDER[i]] = (unsigned char)length;
+      }
+      HuffmanDecoder codelen_decoder;
+      if (!codelen_decoder.init(codelen_lengths, NUM_CODELEN_SYMBOLS))
+        return false;
+
+      unsigned char lengths[286 + 30] = {0};
+      const size_t total = num_litlen + num_dist;
+      size_t index = 0;
+      while (index < total)
+      {
+        unsigned symbol = 0;
+        if (!decodeSymbol(codelen_decoder, symbol))
+          return false;
+
+        if (symbol < 16)
+        {
+          lengths[index++] = (unsigned char)symbol;
+          continue;
+        }
+
+        unsigned char value = 0;
+        uint32_t repeat = 0;
+        if (symbol == 16)
+        {
+          if (index == 0 || !getBits(2, repeat))
+            return false;
+          value = lengths[index - 1];
+          repeat += 3;
+        }
+        else if (symbol == 17)
+        {
+          if (!getBits(3, repeat))
+            return false;
+          repeat += 3;
+        }
+        else
+        {
+          if (!getBits(7, repeat))
+            return false;
+          repeat += 11;
+        }
+        if (index + repeat > total)
+          return false;
+        memset(lengths + index, value, repeat);
+        index += repeat;
+      }
+      if (lengths[END_OF_BLOCK] == 0)
+        return false;
+
+      HuffmanDecoder litlen_decoder;
+      HuffmanDecoder dist_decoder;
+      if (!litlen_decoder.init(lengths, num_litlen) || !dist_decoder.init(lengths + num_litlen, num_dist))
+        return false;
+      return readCompressed(litlen_decoder, dist_decoder);
+    }
+
+    bool readCompressed(const HuffmanDecoder & litlen_decoder, const HuffmanDecoder & dist_decoder)
+    {
+      for(;;)
+      {
+        unsigned symbol = 0;
+        if (!decodeSymbol(litlen_decoder, symbol))
+          return false;
+
+        if (symbol < 256)
+        {
+          if (mOutPos >= mOutSize)
+            return false;
+          mOut[mOutPos++] = (unsigned char)symbol;
+          continue;
+        }
+        if (symbol == END_OF_BLOCK)
+          return true;
+
+        const unsigned lcode = symbol - 257;
+        if (lcode >= 29)
+          return false;
+        uint32_t extra = 0;
+        if (!getBits(LENGTH_EXTRA[lcode], extra))
+          return false;
+        const size_t length = LENGTH_BASE[lcode] + extra;
+
+        unsigned dcode = 0;
+        if (!decodeSymbol(dist_decoder, dcode) || dcode >= 30)
+          return false;
+        if (!getBits(DIST_EXTRA[dcode], extra))
+          return false;
+        const size_t distance = DIST_BASE[dcode] + extra;
+
+        if (distance > mOutPos || length > mOutSize - mOutPos)
+          return false;
+
+        //the source and destination overlap when the match repeats its own output
+        unsigned char * dst = mOut + mOutPos;
+        const unsigned char * src = dst - distance;
+        if (distance >= length)
+        {
+          memcpy(dst, src, length);
+        }
+        else
+        {
+          for(size_t i=0; i<length; i++)
+            dst[i] = src[i];
+        }
+        mOutPos += length;
+      }
+    }
+
+    struct FixedDecoders
+    {
+      HuffmanDecoder litlen;
+      HuffmanDecoder dist;
+
+      FixedDecoders()
+      {
+        unsigned char lengths[NUM_LITLEN_SYMBOLS];
+        for(size_t i=0; i<NUM_LITLEN_SYMBOLS; i++)
+          lengths[i] = (unsigned char)(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+        litlen.init(lengths, NUM_LITLEN_SYMBOLS);
+        memset(lengths, 5, NUM_DIST_SYMBOLS);
+        dist.init(lengths, NUM_DIST_SYMBOLS);
+      }
+    };
+
+  private:
+    const unsigned char * mData;
+    size_t mSize;
+    size_t mPos;
+    uint64_t mBits;
+    unsigned mCount;
+    unsigned char * mOut;
+    size_t mOutSize;
+    size_t mOutPos;
+  };
+
+  bool inflate_zlib(const void * data, size_t size, unsigned char * out, size_t out_size)
+  {
+    const unsigned char * bytes = (const unsigned char *)data;
+    if (size < 2 + 4)
+      return false;
+
+    //zlib header: deflate method, window size up to 32K, no preset dictionary
+    const unsigned cmf = bytes[0];
+    const unsigned flg = bytes[1];
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20) != 0)
+      return false;
+
+    Decompressor decompressor(bytes + 2, size - 2, out, out_size);
+    if (!decompressor.decompress() || decompressor.getProduced() != out_size)
+      return false;
+
+    const size_t trailer = 2 + decompressor.getConsumed();
+    if (size - trailer < 4)
+      return false;
+    const uint32_t expected = ((uint32_t)bytes[trailer] << 24) | ((uint32_t)bytes[trailer + 1] << 16) | ((uint32_t)bytes[trailer + 2] << 8) | bytes[trailer + 3];
+    return adler32(1, out, out_size) == expected;
+  }
+
+} //namespace win32clipboard
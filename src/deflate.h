@@ -0,0 +1,90 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_DEFLATE_H
+#define WIN32CLIPBOARD_DEFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Minimal deflate (RFC 1951) and zlib (RFC 1950) implementation used by the PNG codec.
+// This header is private to the library.
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Update a CRC-32 (ISO 3309) checksum with the given buffer.
+  /// </summary>
+  /// <param name="crc">The current checksum. Use 0 for the first buffer.</param>
+  /// <param name="data">The buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <returns>Returns the updated checksum.</returns>
+  uint32_t crc32(uint32_t crc, const void * data, size_t size);
+
+  /// <summary>
+  /// Update an Adler-32 checksum with the given buffer.
+  /// </summary>
+  /// <param name="adler">The current checksum. Use 1 for the first buffer.</param>
+  /// <param name="data">The buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <returns>Returns the updated checksum.</returns>
+  uint32_t adler32(uint32_t adler, const void * data, size_t size);
+
+  /// <summary>
+  /// Combine the Adler-32 checksums of two consecutive buffers.
+  /// </summary>
+  /// <param name="adler1">The checksum of the first buffer.</param>
+  /// <param name="adler2">The checksum of the second buffer.</param>
+  /// <param name="size2">The size in bytes of the second buffer.</param>
+  /// <returns>Returns the checksum of the two buffers.</returns>
+  uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2);
+
+  /// <summary>
+  /// Compress a buffer as a sequence of raw deflate blocks.
+  /// </summary>
+  /// <param name="data">The buffer to compress.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="dictionary_size">Number of bytes before data that can be referenced by matches. At most 32768 bytes are used.</param>
+  /// <param name="final">True if the output ends the deflate stream.</param>
+  /// <param name="out">The string where the compressed blocks are appended.</param>
+  /// <remarks>
+  /// If final is false, the output ends with an empty stored block which aligns the output to a byte boundary.
+  /// Independently compressed outputs can then be concatenated into a single deflate stream.
+  /// </remarks>
+  void deflate_raw(const unsigned char * data, size_t size, size_t dictionary_size, bool final, std::string & out);
+
+  /// <summary>
+  /// Decompress a zlib stream into a buffer of known size.
+  /// </summary>
+  /// <param name="data">The zlib stream.</param>
+  /// <param name="size">The size in bytes of the zlib stream.</param>
+  /// <param name="out">The output buffer.</param>
+  /// <param name="out_size">The expected size in bytes of the decompressed data.</param>
+  /// <returns>Returns true if the stream is valid and decompresses to exactly out_size bytes. Returns false otherwise.</returns>
+  bool inflate_zlib(const void * data, size_t size, unsigned char * out, size_t out_size);
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_DEFLATE_H
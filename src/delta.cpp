@@ -0,0 +1,294 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <string.h>
+#include <algorithm>
+
+#include "win32clipboard/delta.h"
+#include "win32clipboard/hash.h"
+#include "serialize.h"
+
+namespace win32clipboard
+{
+  //Layout of a delta: the hash of the base version (8 bytes, little endian), the block size, the size of the new version
+  //then a list of operations. An operation is either OP_LITERAL, a size and the literal bytes,
+  //or OP_COPY, the index of the first block and the number of consecutive blocks to copy from the base version.
+  //Integers other than the hash are encoded as variable length integers, 7 bits per byte.
+  static const char OP_LITERAL = 'L';
+  static const char OP_COPY = 'C';
+
+  //The rolling checksum of rsync: the sum of the bytes and the sum of the partial sums, both modulo 2^16.
+  struct RollingChecksum
+  {
+    uint32_t a;
+    uint32_t b;
+
+    void init(const unsigned char * data, size_t size)
+    {
+      a = 0;
+      b = 0;
+      for(size_t i=0; i<size; i++)
+      {
+        a += data[i];
+        b += a;
+      }
+    }
+
+    //Move the window of the given size by one byte
+    void roll(unsigned char out, unsigned char in, size_t size)
+    {
+      a += (uint32_t)in - (uint32_t)out;
+      b += a - (uint32_t)size * out;
+    }
+
+    uint32_t get() const
+    {
+      return (a & 0xFFFF) | (b << 16);
+    }
+  };
+
+  //Blocks of the base version sorted by weak checksum, with a bitmap of the 16 bit tags of the checksums for fast rejection.
+  class BlockIndex
+  {
+  public:
+    BlockIndex(const DeltaSignature & iSignature) :
+      mSignature(iSignature),
+      mTags(65536 / 8, 0)
+    {
+      mBlocks.reserve(iSignature.weak_sums.size());
+      for(size_t i=0; i<iSignature.weak_sums.size(); i++)
+      {
+        const uint32_t weak = iSignature.weak_sums[i];
+        mBlocks.push_back(Block(weak, i));
+        const uint32_t tag = getTag(weak);
+        mTags[tag / 8] |= (unsigned char)(1 << (tag % 8));
+      }
+      std::sort(mBlocks.begin(), mBlocks.end());
+    }
+
+    //Returns the index of a block matching the given data, preferring the expected block. Returns -1 if no block matches.
+    int64_t find(uint32_t iWeak, const char * iData, size_t iExpected) const
+    {
+      const uint32_t tag = getTag(iWeak);
+      if ((mTags[tag / 8] & (1 << (tag % 8))) == 0)
+        return -1;
+
+      std::vector<Block>::const_iterator it = std::lower_bound(mBlocks.begin(), mBlocks.end(), Block(iWeak, 0));
+      if (it == mBlocks.end() || it->first != iWeak)
+        return -1;
+
+      const uint64_t strong = hash64(iData, mSignature.block_size);
+      int64_t found = -1;
+      for(; it != mBlocks.end() && it->first == iWeak; ++it)
+      {
+        if (mSignature.strong_sums[it->second] != strong)
+          continue;
+        if (it->second == iExpected)
+          return (int64_t)iExpected;
+        if (found < 0)
+          found = (int64_t)it->second;
+      }
+      return found;
+    }
+
+  private:
+    typedef std::pair<uint32_t, size_t> Block;
+
+    static uint32_t getTag(uint32_t iWeak)
+    {
+      return (iWeak ^ (iWeak >> 16)) & 0xFFFF;
+    }
+
+    const DeltaSignature & mSignature;
+    std::vector<Block> mBlocks;
+    std::vector<unsigned char> mTags;
+  };
+
+  //Builds the list of operations of a delta, merging consecutive copies.
+  class DeltaWriter
+  {
+  public:
+    DeltaWriter(std::string & oDelta) :
+      mDelta(oDelta),
+      mCopyBlock(0),
+      mCopyCount(0)
+    {
+    }
+
+    void literal(const char * iData, size_t iSize)
+    {
+      if (iSize == 0)
+        return;
+      flush();
+      mDelta += OP_LITERAL;
+      appendVarint(mDelta, iSize);
+      mDelta.append(iData, iSize);
+    }
+
+    void copy(size_t iBlock)
+    {
+      if (mCopyCount > 0 && mCopyBlock + mCopyCount == iBlock)
+      {
+        mCopyCount++;
+        return;
+      }
+      flush();
+      mCopyBlock = iBlock;
+      mCopyCount = 1;
+    }
+
+    //Returns the block expected after the current copy.
+    size_t getNextBlock() const
+    {
+      return mCopyBlock + mCopyCount;
+    }
+
+    void flush()
+    {
+      if (mCopyCount == 0)
+        return;
+      mDelta += OP_COPY;
+      appendVarint(mDelta, mCopyBlock);
+      appendVarint(mDelta, mCopyCount);
+      mCopyCount = 0;
+    }
+
+  private:
+    std::string & mDelta;
+    size_t mCopyBlock;
+    size_t mCopyCount;
+  };
+
+  void compute_signature(const char * base, size_t base_size, size_t block_size, DeltaSignature & signature)
+  {
+    if (block_size == 0)
+      block_size = 1;
+
+    const size_t num_blocks = base_size / block_size;
+    signature.block_size = block_size;
+    signature.base_size = base_size;
+    signature.base_hash = hash64(base, base_size);
+    signature.weak_sums.resize(num_blocks);
+    signature.strong_sums.resize(num_blocks);
+
+    RollingChecksum checksum;
+    for(size_t i=0; i<num_blocks; i++)
+    {
+      const char * block = base + i * block_size;
+      checksum.init((const unsigned char *)block, block_size);
+      signature.weak_sums[i] = checksum.get();
+      signature.strong_sums[i] = hash64(block, block_size);
+    }
+  }
+
+  void compute_delta(const DeltaSignature & signature, const char * target, size_t target_size, std::string & delta)
+  {
+    const size_t block_size = signature.block_size;
+
+    delta.clear();
+    appendUint64(delta, signature.base_hash);
+    appendVarint(delta, block_size);
+    appendVarint(delta, target_size);
+
+    DeltaWriter writer(delta);
+    size_t literal_start = 0;
+
+    if (!signature.weak_sums.empty() && block_size > 0 && target_size >= block_size)
+    {
+      const unsigned char * data = (const unsigned char *)target;
+      const BlockIndex index(signature);
+
+      RollingChecksum checksum;
+      checksum.init(data, block_size);
+      size_t offset = 0;
+      while (offset + block_size <= target_size)
+      {
+        const int64_t block = index.find(checksum.get(), target + offset, writer.getNextBlock());
+        if (block >= 0)
+        {
+          writer.literal(target + literal_start, offset - literal_start);
+          writer.copy((size_t)block);
+          offset += block_size;
+          literal_start = offset;
+          if (offset + block_size <= target_size)
+            checksum.init(data + offset, block_size);
+          continue;
+        }
+
+        if (offset + block_size < target_size)
+          checksum.roll(data[offset], data[offset + block_size], block_size);
+        offset++;
+      }
+    }
+
+    writer.literal(target + literal_start, target_size - literal_start);
+    writer.flush();
+  }
+
+  bool apply_delta(const char * base, size_t base_size, const char * delta, size_t delta_size, std::string & target)
+  {
+    size_t offset = 0;
+    uint64_t base_hash = 0;
+    if (!readUint64(delta, delta_size, offset, base_hash) || base_hash != hash64(base, base_size))
+      return false;
+
+    uint64_t block_size = 0;
+    uint64_t target_size = 0;
+    if (!readVarint(delta, delta_size, offset, block_size) || !readVarint(delta, delta_size, offset, target_size))
+      return false;
+
+    target.clear();
+    target.reserve((size_t)target_size);
+    while (offset < delta_size)
+    {
+      const char op = delta[offset++];
+      if (op == OP_LITERAL)
+      {
+        uint64_t size = 0;
+        if (!readVarint(delta, delta_size, offset, size) || size > delta_size - offset)
+          return false;
+        target.append(delta + offset, (size_t)size);
+        offset += (size_t)size;
+      }
+      else if (op == OP_COPY)
+      {
+        uint64_t block = 0;
+        uint64_t count = 0;
+        if (!readVarint(delta, delta_size, offset, block) || !readVarint(delta, delta_size, offset, count))
+          return false;
+        const uint64_t num_blocks = (block_size > 0 ? base_size / block_size : 0);
+        if (block > num_blocks || count > num_blocks - block)
+          return false;
+        target.append(base + block * block_size, (size_t)(count * block_size));
+      }
+      else
+        return false;
+
+      if (target.size() > target_size)
+        return false;
+    }
+
+    return (target.size() == target_size);
+  }
+
+} //namespace win32clipboard
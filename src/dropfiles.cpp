@@ -0,0 +1,444 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "win32clipboard/dropfiles.h"
+
+namespace win32clipboard
+{
+  // Layout of the DROPFILES structure, all fields are 32 bit little-endian integers:
+  //   DWORD pFiles;  offset of the file list from the beginning of the structure
+  //   POINT pt;      drop point (x, y)
+  //   BOOL  fNC;     nonclient area flag
+  //   BOOL  fWide;   file list contains wide characters
+  static const size_t DROPFILES_OFFSET_PFILES = 0;
+  static const size_t DROPFILES_OFFSET_FWIDE  = 16;
+
+  static inline void write32le(unsigned char * p, uint32_t value)
+  {
+    p[0] = (unsigned char)(value      );
+    p[1] = (unsigned char)(value >>  8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+  }
+
+  static inline uint32_t read32le(const unsigned char * p)
+  {
+    return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  static inline unsigned char * write16le(unsigned char * p, uint32_t value)
+  {
+    p[0] = (unsigned char)(value      );
+    p[1] = (unsigned char)(value >>  8);
+    return p + 2;
+  }
+
+  static inline uint32_t read16le(const unsigned char * p)
+  {
+    return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8);
+  }
+
+  // Returns the number of UTF-16 code units required for the given UTF-8 string.
+  // Each code point is counted once by its leading byte. 4 bytes sequences requires a surrogate pair.
+  static inline size_t count_utf16_units(const std::string & str)
+  {
+    size_t count = 0;
+    const unsigned char * p = (const unsigned char *)str.data();
+    const size_t length = str.size();
+    for(size_t i=0; i<length; i++)
+    {
+      const unsigned char c = p[i];
+      count += ((c & 0xC0) != 0x80);
+      count += (c >= 0xF0);
+    }
+    return count;
+  }
+
+  // Transcode an UTF-8 string to UTF-16LE into the given output buffer.
+  // Returns the end of the written data. Returns NULL if the string is not valid UTF-8 or if the output buffer is too small.
+  static unsigned char * transcode_utf8_to_utf16le(const std::string & str, unsigned char * dst, const unsigned char * dst_end)
+  {
+    const unsigned char * p = (const unsigned char *)str.data();
+    const unsigned char * const end = p + str.size();
+
+    while (p < end)
+    {
+      //fast path for runs of ASCII characters, 8 bytes at a time
+      while (p + 8 <= end && dst + 16 <= dst_end)
+      {
+        uint64_t chunk;
+        memcpy(&chunk, p, sizeof(chunk));
+        if (chunk & 0x8080808080808080ULL)
+          break;
+        for(size_t i=0; i<8; i++)
+          dst = write16le(dst, p[i]);
+        p += 8;
+      }
+      if (p >= end)
+        break;
+
+      //See http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf, Table 3-7. Well-Formed UTF-8 Byte Sequences
+      const unsigned char c1 = p[0];
+      const size_t available = (size_t)(end - p);
+      uint32_t code_point = 0;
+      size_t n = 0;
+      if (c1 <= 0x7F)
+      {
+        code_point = c1;
+        n = 1;
+      }
+      else if (0xC2 <= c1 && c1 <= 0xDF)
+      {
+        if (available < 2 || (p[1] & 0xC0) != 0x80)
+          return NULL;
+        code_point = ((c1 & 0x1F) << 6) | (p[1] & 0x3F);
+        n = 2;
+      }
+      else if (0xE0 <= c1 && c1 <= 0xEF)
+      {
+        if (available < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80)
+          return NULL;
+        if (c1 == 0xE0 && p[1] < 0xA0) //overlong
+          return NULL;
+        if (c1 == 0xED && p[1] > 0x9F) //surrogates
+          return NULL;
+        code_point = ((c1 & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        n = 3;
+      }
+      else if (0xF0 <= c1 && c1 <= 0xF4)
+      {
+        if (available < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80)
+          return NULL;
+        if (c1 == 0xF0 && p[1] < 0x90) //overlong
+          return NULL;
+        if (c1 == 0xF4 && p[1] > 0x8F) //above U+10FFFF
+          return NULL;
+        code_point = ((c1 & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        n = 4;
+      }
+      else
+        return NULL; // invalid UTF-8 sequence
+
+      if (code_point >= 0x10000)
+      {
+        if (dst + 4 > dst_end)
+          return NULL;
+        code_point -= 0x10000;
+        dst = write16le(dst, 0xD800 + (code_point >> 10));
+        dst = write16le(dst, 0xDC00 + (code_point & 0x3FF));
+      }
+      else
+      {
+        if (dst + 2 > dst_end)
+          return NULL;
+        dst = write16le(dst, code_point);
+      }
+
+      //next code point
+      p += n;
+    }
+
+    return dst;
+  }
+
+  // Write the given code point as UTF-8. If dst is NULL, only the number of bytes is returned.
+  static inline size_t write_utf8(char * dst, uint32_t code_point)
+  {
+    if (code_point < 0x80)
+    {
+      if (dst)
+      {
+        dst[0] = (char)code_point;
+      }
+      return 1;
+    }
+    else if (code_point < 0x800)
+    {
+      if (dst)
+      {
+        dst[0] = (char)(0xC0 | (code_point >> 6));
+        dst[1] = (char)(0x80 | (code_point & 0x3F));
+      }
+      return 2;
+    }
+    else if (code_point < 0x10000)
+    {
+      if (dst)
+      {
+        dst[0] = (char)(0xE0 | (code_point >> 12));
+        dst[1] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (code_point & 0x3F));
+      }
+      return 3;
+    }
+    if (dst)
+    {
+      dst[0] = (char)(0xF0 | (code_point >> 18));
+      dst[1] = (char)(0x80 | ((code_point >> 12) & 0x3F));
+      dst[2] = (char)(0x80 | ((code_point >> 6) & 0x3F));
+      dst[3] = (char)(0x80 | (code_point & 0x3F));
+    }
+    return 4;
+  }
+
+  // Walk a list of NULL terminated UTF-16LE file paths that ends with an empty file path or at the end of the buffer.
+  // If pool is NULL, only computes the size of the UTF-8 pool and the number of file paths.
+  // Otherwise, writes each file path as a NULL terminated UTF-8 string into the pool and its offset into offsets.
+  // Returns false if a file path is not terminated.
+  static bool walk_wide_file_list(const unsigned char * p, const unsigned char * end, char * pool, size_t * offsets, size_t & pool_size, size_t & count)
+  {
+    pool_size = 0;
+    count = 0;
+
+    while (p + 2 <= end && read16le(p) != 0)
+    {
+      if (offsets)
+        offsets[count] = pool_size;
+
+      bool terminated = false;
+      while (p + 2 <= end)
+      {
+        uint32_t unit = read16le(p);
+        p += 2;
+
+        if (unit == 0)
+        {
+          terminated = true;
+          break;
+        }
+
+        uint32_t code_point = unit;
+        if (0xD800 <= unit && unit <= 0xDFFF)
+        {
+          uint32_t low = (p + 2 <= end ? read16le(p) : 0);
+          if (unit <= 0xDBFF && 0xDC00 <= low && low <= 0xDFFF)
+          {
+            code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+            p += 2;
+          }
+          else
+            code_point = 0xFFFD; //unpaired surrogate
+        }
+
+        pool_size += write_utf8(pool ? pool + pool_size : NULL, code_point);
+      }
+      if (!terminated)
+        return false;
+
+      if (pool)
+        pool[pool_size] = '\0';
+      pool_size++;
+      count++;
+    }
+
+    return true;
+  }
+
+  DropFileList::DropFileList()
+  {
+  }
+
+  size_t DropFileList::GetCount() const
+  {
+    return mOffsets.size();
+  }
+
+  const char * DropFileList::GetPath(size_t index) const
+  {
+    if (index >= mOffsets.size())
+      return NULL;
+    return mPool.c_str() + mOffsets[index];
+  }
+
+  size_t DropFileList::GetLength(size_t index) const
+  {
+    if (index >= mOffsets.size())
+      return 0;
+    const size_t next = (index + 1 < mOffsets.size() ? mOffsets[index + 1] : mPool.size());
+    return next - mOffsets[index] - 1; // -1 for the NULL terminating character
+  }
+
+  void DropFileList::Append(const char * path, size_t length)
+  {
+    mOffsets.push_back(mPool.size());
+    mPool.append(path, length);
+    mPool.append(1, '\0');
+  }
+
+  void DropFileList::Clear()
+  {
+    mPool.clear();
+    mOffsets.clear();
+  }
+
+  void DropFileList::ToVector(std::vector<std::string> & files) const
+  {
+    files.clear();
+    files.reserve(mOffsets.size());
+    for(size_t i=0; i<mOffsets.size(); i++)
+    {
+      files.push_back(std::string(GetPath(i), GetLength(i)));
+    }
+  }
+
+  bool DropFileList::Normalize(NormalizationForm form)
+  {
+    //most file paths are already normalized: the pool is rebuilt only from the first one that is not
+    size_t index = 0;
+    while (index < mOffsets.size() && is_normalized_utf8(GetPath(index), GetLength(index), form))
+      index++;
+    if (index == mOffsets.size())
+      return true;
+
+    bool success = true;
+    std::string pool(mPool, 0, mOffsets[index]);
+    std::string path;
+    for(; index<mOffsets.size(); index++)
+    {
+      const char * src = GetPath(index);
+      const size_t length = GetLength(index);
+      mOffsets[index] = pool.size();
+      if (normalize_utf8(src, length, form, path))
+        pool.append(path);
+      else
+      {
+        pool.append(src, length);
+        success = false;
+      }
+      pool.append(1, '\0');
+    }
+    mPool.swap(pool);
+    return success;
+  }
+
+  size_t get_dropfiles_size(const std::vector<std::string> & files)
+  {
+    size_t size = DROPFILES_HEADER_SIZE;
+    for(size_t i=0; i<files.size(); i++)
+    {
+      size += (count_utf16_units(files[i]) + 1) * 2; // +1 for including the NULL terminating character
+    }
+    size += 2; //final empty file path
+    return size;
+  }
+
+  bool encode_dropfiles(const std::vector<std::string> & files, void * buffer, size_t size)
+  {
+    if (buffer == NULL || size < DROPFILES_HEADER_SIZE + 2)
+      return false;
+
+    unsigned char * const begin = (unsigned char *)buffer;
+    const unsigned char * const end = begin + size;
+
+    //DROPFILES structure
+    memset(begin, 0, DROPFILES_HEADER_SIZE);
+    write32le(begin + DROPFILES_OFFSET_PFILES, (uint32_t)DROPFILES_HEADER_SIZE);
+    write32le(begin + DROPFILES_OFFSET_FWIDE, 1); //we will use WIDE CHAR for storing the file paths
+
+    //append each files
+    unsigned char * dst = begin + DROPFILES_HEADER_SIZE;
+    for(size_t i=0; i<files.size(); i++)
+    {
+      dst = transcode_utf8_to_utf16le(files[i], dst, end);
+      if (dst == NULL || dst + 2 > end)
+        return false;
+      dst = write16le(dst, 0);
+    }
+
+    //append final empty file path
+    if (dst + 2 > end)
+      return false;
+    write16le(dst, 0);
+
+    return true;
+  }
+
+  bool decode_dropfiles(const void * buffer, size_t size, DropFileList & files, bool & is_wide)
+  {
+    files.Clear();
+    is_wide = false;
+
+    if (buffer == NULL || size < DROPFILES_HEADER_SIZE)
+      return false;
+
+    const unsigned char * const begin = (const unsigned char *)buffer;
+    const unsigned char * const end = begin + size;
+    const size_t offset = read32le(begin + DROPFILES_OFFSET_PFILES);
+    is_wide = (read32le(begin + DROPFILES_OFFSET_FWIDE) != 0);
+    if (offset > size)
+      return false;
+
+    const unsigned char * p = begin + offset;
+    if (is_wide)
+    {
+      //compute the exact size of the pool, then decode the file paths directly into it
+      size_t pool_size = 0;
+      size_t count = 0;
+      if (!walk_wide_file_list(p, end, NULL, NULL, pool_size, count))
+        return false;
+      if (count == 0)
+        return true;
+
+      files.mPool.resize(pool_size);
+      files.mOffsets.resize(count);
+      walk_wide_file_list(p, end, &files.mPool[0], &files.mOffsets[0], pool_size, count);
+    }
+    else
+    {
+      //ansi file paths are already NULL terminated: the list is copied as is
+      const unsigned char * list_begin = p;
+      size_t count = 0;
+      while (p < end && (*p) != '\0')
+      {
+        const unsigned char * terminator = (const unsigned char *)memchr(p, '\0', (size_t)(end - p));
+        if (terminator == NULL)
+          return false;
+        p = terminator + 1;
+        count++;
+      }
+      files.mPool.assign((const char *)list_begin, (size_t)(p - list_begin));
+      files.mOffsets.reserve(count);
+      size_t position = 0;
+      for(size_t i=0; i<count; i++)
+      {
+        files.mOffsets.push_back(position);
+        position += strlen(files.mPool.c_str() + position) + 1;
+      }
+    }
+
+    return true;
+  }
+
+  bool decode_dropfiles(const void * buffer, size_t size, std::vector<std::string> & files, bool & is_wide)
+  {
+    DropFileList list;
+    bool decoded = decode_dropfiles(buffer, size, list, is_wide);
+    list.ToVector(files);
+    return decoded;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,248 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+#include "win32clipboard/faultbackend.h"
+
+namespace win32clipboard
+{
+  //Defaults of ClipboardObject, which opens the Windows clipboard
+  static const size_t DEFAULT_OPEN_ATTEMPTS = 5;
+  static const uint32_t DEFAULT_OPEN_RETRY_DELAY_US = 50*1000;
+
+  static void sleepMicroseconds(uint64_t iDuration)
+  {
+    if (iDuration > 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(iDuration));
+  }
+
+  //splitmix64: the n-th value of the sequence only depends on the seed and n
+  static inline uint64_t splitmix64(uint64_t iSeed, uint64_t iIndex)
+  {
+    uint64_t z = iSeed + (iIndex + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  //Random decisions of the operations of a thread on a backend
+  struct OperationStream
+  {
+    uint64_t operations;  //number of operations started by the thread
+    uint64_t seed;        //seed of the decisions of the current operation
+    uint64_t decisions;   //number of decisions taken by the current operation
+
+    OperationStream() : operations(0), seed(0), decisions(0) {}
+  };
+
+  //Random streams of the calling thread: its index and its operations on each backend
+  struct ThreadStream
+  {
+    uint64_t index;
+    std::map<uint64_t, OperationStream> backends;
+
+    ThreadStream() : index(0) {}
+  };
+  static thread_local ThreadStream gThreadStream;
+  static std::atomic<uint64_t> gNextInstance(0);
+
+  FaultOptions::FaultOptions() :
+    seed(0),
+    open_failure_rate(0.0),
+    open_attempts(DEFAULT_OPEN_ATTEMPTS),
+    open_retry_delay_us(DEFAULT_OPEN_RETRY_DELAY_US),
+    max_hold_time_us(0),
+    slow_alloc_rate(0.0),
+    slow_alloc_time_us(0),
+    partial_write_rate(0.0)
+  {
+  }
+
+  FaultBackend::FaultBackend(Backend & iBackend, const FaultOptions & iOptions) :
+    mBackend(iBackend),
+    mOptions(iOptions),
+    mInstance(gNextInstance++),
+    mOperations(0),
+    mOpenRetries(0),
+    mOpenFailures(0),
+    mInjectedFailures(0),
+    mContendedOpens(0),
+    mSlowAllocations(0),
+    mPartialWrites(0)
+  {
+  }
+
+  FaultBackend::~FaultBackend()
+  {
+    gThreadStream.backends.erase(mInstance);
+  }
+
+  bool FaultBackend::Write(const ItemList & iItems)
+  {
+    if (!open())
+      return false;
+    std::lock_guard<std::mutex> lock(mMutex, std::adopt_lock);
+
+    //allocate the memory of each format
+    for(size_t i=0; i<iItems.size(); i++)
+    {
+      if (decide(mOptions.slow_alloc_rate))
+      {
+        mSlowAllocations++;
+        sleepMicroseconds(mOptions.slow_alloc_time_us);
+      }
+    }
+
+    if (iItems.empty() || !decide(mOptions.partial_write_rate))
+      return mBackend.Write(iItems);
+
+    //the write fails after storing the first half of the formats and part of the next one
+    mPartialWrites++;
+    ItemList partial(iItems.begin(), iItems.begin() + iItems.size() / 2 + 1);
+    Item & last = partial.back();
+    last.data.resize(last.data.size() / 2);
+    mBackend.Write(partial);
+    return false;
+  }
+
+  bool FaultBackend::Read(const std::string & iFormat, std::string & oData)
+  {
+    if (!open())
+      return false;
+    std::lock_guard<std::mutex> lock(mMutex, std::adopt_lock);
+    return mBackend.Read(iFormat, oData);
+  }
+
+  bool FaultBackend::GetFormats(StringVector & oFormats)
+  {
+    if (!open())
+      return false;
+    std::lock_guard<std::mutex> lock(mMutex, std::adopt_lock);
+    return mBackend.GetFormats(oFormats);
+  }
+
+  bool FaultBackend::Empty()
+  {
+    if (!open())
+      return false;
+    std::lock_guard<std::mutex> lock(mMutex, std::adopt_lock);
+    return mBackend.Empty();
+  }
+
+  const FaultOptions & FaultBackend::GetOptions() const
+  {
+    return mOptions;
+  }
+
+  void FaultBackend::GetStats(FaultStats & oStats) const
+  {
+    oStats.operations = mOperations.load();
+    oStats.open_retries = mOpenRetries.load();
+    oStats.open_failures = mOpenFailures.load();
+    oStats.injected_failures = mInjectedFailures.load();
+    oStats.contended_opens = mContendedOpens.load();
+    oStats.slow_allocations = mSlowAllocations.load();
+    oStats.partial_writes = mPartialWrites.load();
+  }
+
+  void FaultBackend::SetThreadIndex(uint64_t iIndex)
+  {
+    gThreadStream.index = iIndex;
+  }
+
+  void FaultBackend::beginOperation()
+  {
+    //the decisions of the n-th operation of a thread only depend on the seed, the index of the thread and n:
+    //retries caused by the other threads do not shift the decisions of the next operations
+    ThreadStream & thread = gThreadStream;
+    OperationStream & stream = thread.backends[mInstance];
+    stream.seed = splitmix64(splitmix64(mOptions.seed, thread.index), stream.operations++);
+    stream.decisions = 0;
+  }
+
+  void FaultBackend::seekDecision(uint64_t iDecision)
+  {
+    gThreadStream.backends[mInstance].decisions = iDecision;
+  }
+
+  uint64_t FaultBackend::nextRandom()
+  {
+    OperationStream & stream = gThreadStream.backends[mInstance];
+    return splitmix64(stream.seed, stream.decisions++);
+  }
+
+  bool FaultBackend::decide(double iProbability)
+  {
+    if (iProbability <= 0.0)
+      return false;
+    if (iProbability >= 1.0)
+      return true;
+    //the 53 high bits are converted exactly to a double in [0, 1)
+    const double value = (double)(nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+    return value < iProbability;
+  }
+
+  //Lock the mutex for the current operation, like OpenClipboard() retried by ClipboardObject.
+  bool FaultBackend::open()
+  {
+    mOperations++;
+    beginOperation();
+
+    const size_t attempts = (mOptions.open_attempts > 0 ? mOptions.open_attempts : 1);
+    for(size_t i=0; i<attempts; i++)
+    {
+      if (i > 0)
+      {
+        mOpenRetries++;
+        sleepMicroseconds(mOptions.open_retry_delay_us);
+      }
+
+      if (decide(mOptions.open_failure_rate))
+      {
+        mInjectedFailures++;
+        continue;
+      }
+      if (!mMutex.try_lock())
+      {
+        mContendedOpens++;
+        continue;
+      }
+
+      //the decisions taken once opened do not depend on the number of attempts
+      seekDecision(attempts);
+
+      //the clipboard is held opened by the application for a while
+      if (mOptions.max_hold_time_us > 0)
+        sleepMicroseconds(nextRandom() % ((uint64_t)mOptions.max_hold_time_us + 1));
+      return true;
+    }
+
+    mOpenFailures++;
+    return false;
+  }
+
+} //namespace win32clipboard
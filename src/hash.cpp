@@ -0,0 +1,141 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+
+#include "win32clipboard/hash.h"
+
+namespace win32clipboard
+{
+  static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+  static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+  static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+  static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+  static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+  static inline uint64_t rotl64(uint64_t x, int r)
+  {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  // Unaligned little-endian reads. memcpy() is optimized into a single load by the compiler.
+  static inline uint64_t read64(const unsigned char * p)
+  {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static inline uint32_t read32(const unsigned char * p)
+  {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static inline uint64_t round64(uint64_t acc, uint64_t input)
+  {
+    acc += input * PRIME64_2;
+    acc  = rotl64(acc, 31);
+    acc *= PRIME64_1;
+    return acc;
+  }
+
+  static inline uint64_t mergeRound64(uint64_t acc, uint64_t value)
+  {
+    value = round64(0, value);
+    acc ^= value;
+    acc  = acc * PRIME64_1 + PRIME64_4;
+    return acc;
+  }
+
+  uint64_t hash64(const void * data, size_t size, uint64_t seed)
+  {
+    const unsigned char * p = (const unsigned char *)data;
+    const unsigned char * const end = p + size;
+    uint64_t h;
+
+    if (size >= 32)
+    {
+      const unsigned char * const limit = end - 32;
+
+      //4 independent accumulators
+      uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+      uint64_t v2 = seed + PRIME64_2;
+      uint64_t v3 = seed + 0;
+      uint64_t v4 = seed - PRIME64_1;
+
+      do
+      {
+        v1 = round64(v1, read64(p +  0));
+        v2 = round64(v2, read64(p +  8));
+        v3 = round64(v3, read64(p + 16));
+        v4 = round64(v4, read64(p + 24));
+        p += 32;
+      } while (p <= limit);
+
+      h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+      h = mergeRound64(h, v1);
+      h = mergeRound64(h, v2);
+      h = mergeRound64(h, v3);
+      h = mergeRound64(h, v4);
+    }
+    else
+    {
+      h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t)size;
+
+    //remaining bytes
+    while (p + 8 <= end)
+    {
+      h ^= round64(0, read64(p));
+      h  = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+      p += 8;
+    }
+    if (p + 4 <= end)
+    {
+      h ^= (uint64_t)read32(p) * PRIME64_1;
+      h  = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+      p += 4;
+    }
+    while (p < end)
+    {
+      h ^= (*p) * PRIME64_5;
+      h  = rotl64(h, 11) * PRIME64_1;
+      p++;
+    }
+
+    //avalanche
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+
+    return h;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,566 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "win32clipboard/history.h"
+#include "win32clipboard/hash.h"
+
+#include "capture.h"
+
+namespace win32clipboard
+{
+  // Each format of Clipboard::Format has a slot, followed by the slot of the list of drag and drop files.
+  // The payload of the list of files is a 32 bit little-endian drop effect followed by a CF_HDROP buffer.
+  static const size_t NUM_FORMATS = Clipboard::NUM_FORMATS;
+  static const size_t SLOT_FILES = NUM_FORMATS;
+  static const size_t NUM_SLOTS = NUM_FORMATS + 1;
+
+  // Values of the drop effect
+  static const uint32_t DROP_EFFECT_COPY = 1;
+  static const uint32_t DROP_EFFECT_MOVE = 2;
+
+  // Size of the chunks of the arena. Bigger blocks are allocated in their own chunk.
+  static const size_t CHUNK_SIZE = 64 * 1024;
+  static const size_t ALIGNMENT = 16;
+
+  static inline size_t alignSize(size_t size)
+  {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  }
+
+  // Storage for the payloads of all formats of an entry.
+  // The payloads are stored right after the structure, in the same allocation.
+  struct ClipboardHistory::Block
+  {
+    size_t refs;                      //number of entries referencing this block
+    uint64_t hash;
+    size_t size;                      //size of all payloads, in bytes
+    Chunk * chunk;                    //chunk of the arena that holds the block
+    bool present[NUM_SLOTS];
+    size_t offsets[NUM_SLOTS + 1];    //offset of each payload. The last offset is the end of the last payload.
+
+    const char * getData() const { return (const char *)(this + 1); }
+    char * getData() { return (char *)(this + 1); }
+  };
+
+  // A chunk of the arena. Blocks are allocated right after the structure by bumping an offset.
+  struct ClipboardHistory::Chunk
+  {
+    size_t capacity;                  //number of bytes available for blocks
+    size_t used;                      //number of bytes allocated to blocks
+    size_t live;                      //number of blocks allocated and not released
+    size_t padding;
+
+    char * getData() { return (char *)this + alignSize(sizeof(Chunk)); }
+  };
+
+  static inline uint32_t read32le(const char * p)
+  {
+    const unsigned char * u = (const unsigned char *)p;
+    return ((uint32_t)u[0]) | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+  }
+
+  static inline void write32le(std::string & str, uint32_t value)
+  {
+    str += (char)(value      );
+    str += (char)(value >>  8);
+    str += (char)(value >> 16);
+    str += (char)(value >> 24);
+  }
+
+  static uint64_t hashPayloads(const std::string * iPayloads, const bool * iPresent)
+  {
+    //hash the format, the size and the hash of each payload so that moving bytes between formats changes the hash
+    uint64_t records[3 * NUM_SLOTS] = {0};
+    for(size_t i=0; i<NUM_SLOTS; i++)
+    {
+      if (!iPresent[i])
+        continue;
+
+      records[3*i + 0] = (uint64_t)i + 1;
+      records[3*i + 1] = (uint64_t)iPayloads[i].size();
+      records[3*i + 2] = hash64(iPayloads[i].data(), iPayloads[i].size());
+    }
+    return hash64(records, sizeof(records));
+  }
+
+  static inline void assignUnicode(std::string & oPayload, const std::wstring & iText)
+  {
+    oPayload.assign((const char *)iText.data(), iText.size() * sizeof(wchar_t));
+  }
+
+  static inline void assignDropFiles(std::string & oPayload, Clipboard::DragDropType iDragDropType, const std::string & iDropFiles)
+  {
+    write32le(oPayload, iDragDropType == Clipboard::DragDropCut ? DROP_EFFECT_MOVE : DROP_EFFECT_COPY);
+    oPayload += iDropFiles;
+  }
+
+  // Read the text, unicode text, image, binary data and list of files of a backend.
+  // The payloads are encoded like the values returned by the Clipboard.
+  static void captureBackend(Backend & iBackend, std::string * oPayloads, bool * oPresent)
+  {
+    oPresent[Clipboard::FormatText] = read_backend_text(iBackend, oPayloads[Clipboard::FormatText]);
+
+    std::wstring unicode;
+    oPresent[Clipboard::FormatUnicode] = read_backend_unicode(iBackend, unicode);
+    if (oPresent[Clipboard::FormatUnicode])
+      assignUnicode(oPayloads[Clipboard::FormatUnicode], unicode);
+
+    oPresent[Clipboard::FormatImage] = read_backend_dib(iBackend, oPayloads[Clipboard::FormatImage]);
+    oPresent[Clipboard::FormatBinary] = iBackend.Read(Backend::FORMAT_BINARY, oPayloads[Clipboard::FormatBinary]);
+
+    Clipboard::DragDropType type = Clipboard::DragDropCopy;
+    std::string dropfiles;
+    oPresent[SLOT_FILES] = read_backend_dropfiles(iBackend, type, dropfiles);
+    if (oPresent[SLOT_FILES])
+      assignDropFiles(oPayloads[SLOT_FILES], type, dropfiles);
+  }
+
+#ifdef _WIN32
+  // Read every known format of a clipboard with the GetAs*() methods.
+  static void captureClipboard(Clipboard & iClipboard, std::string * oPayloads, bool * oPresent)
+  {
+    oPresent[Clipboard::FormatText] = iClipboard.GetAsText(oPayloads[Clipboard::FormatText]);
+
+    std::wstring unicode;
+    oPresent[Clipboard::FormatUnicode] = iClipboard.GetAsTextUnicode(unicode);
+    if (oPresent[Clipboard::FormatUnicode])
+      assignUnicode(oPayloads[Clipboard::FormatUnicode], unicode);
+
+    oPresent[Clipboard::FormatImage] = read_clipboard_dib(iClipboard, oPayloads[Clipboard::FormatImage]);
+    oPresent[Clipboard::FormatBinary] = iClipboard.GetAsBinary(oPayloads[Clipboard::FormatBinary]);
+
+    Clipboard::DragDropType type = Clipboard::DragDropCopy;
+    std::string dropfiles;
+    oPresent[SLOT_FILES] = read_clipboard_dropfiles(iClipboard, type, dropfiles);
+    if (oPresent[SLOT_FILES])
+      assignDropFiles(oPayloads[SLOT_FILES], type, dropfiles);
+  }
+#endif //_WIN32
+
+  bool ClipboardHistory::isSameContent(const Entry & iEntry, const std::string * iPayloads, const bool * iPresent)
+  {
+    for(size_t i=0; i<NUM_SLOTS; i++)
+    {
+      const char * data = NULL;
+      size_t size = 0;
+      if (iEntry.getSlot(i, data, size) != iPresent[i])
+        return false;
+      if (!iPresent[i])
+        continue;
+
+      if (size != iPayloads[i].size() || memcmp(data, iPayloads[i].data(), size) != 0)
+        return false;
+    }
+    return true;
+  }
+
+  ClipboardHistory::Entry::Entry() :
+    mSequence(0),
+    mBlock(NULL)
+  {
+  }
+
+  uint64_t ClipboardHistory::Entry::GetSequence() const
+  {
+    return mSequence;
+  }
+
+  uint64_t ClipboardHistory::Entry::GetHash() const
+  {
+    if (mBlock == NULL)
+      return 0;
+    return mBlock->hash;
+  }
+
+  bool ClipboardHistory::Entry::Contains(Clipboard::Format iClipboardFormat) const
+  {
+    if (mBlock == NULL || (size_t)iClipboardFormat >= NUM_FORMATS)
+      return false;
+    return mBlock->present[iClipboardFormat];
+  }
+
+  bool ClipboardHistory::Entry::GetData(Clipboard::Format iClipboardFormat, const char *& oData, size_t & oSize) const
+  {
+    if ((size_t)iClipboardFormat >= NUM_FORMATS)
+      return false;
+    return getSlot(iClipboardFormat, oData, oSize);
+  }
+
+  bool ClipboardHistory::Entry::getSlot(size_t iSlot, const char *& oData, size_t & oSize) const
+  {
+    if (mBlock == NULL || iSlot >= NUM_SLOTS || !mBlock->present[iSlot])
+      return false;
+
+    const size_t begin = mBlock->offsets[iSlot + 0];
+    const size_t end   = mBlock->offsets[iSlot + 1];
+    oData = mBlock->getData() + begin;
+    oSize = end - begin;
+    return true;
+  }
+
+  bool ClipboardHistory::Entry::GetAsText(std::string & oText) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    if (!GetData(Clipboard::FormatText, data, size))
+      return false;
+    oText.assign(data, size);
+    return true;
+  }
+
+  bool ClipboardHistory::Entry::GetAsTextUnicode(std::wstring & oText) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    if (!GetData(Clipboard::FormatUnicode, data, size))
+      return false;
+    oText.assign((const wchar_t *)data, size / sizeof(wchar_t));
+    return true;
+  }
+
+  bool ClipboardHistory::Entry::GetAsBinary(Clipboard::MemoryBuffer & oMemoryBuffer) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    if (!GetData(Clipboard::FormatBinary, data, size))
+      return false;
+    oMemoryBuffer.assign(data, size);
+    return true;
+  }
+
+  bool ClipboardHistory::Entry::GetAsImage(Image & oImage) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    DibView view;
+    if (!GetData(Clipboard::FormatImage, data, size) || !parse_dib(data, size, view))
+      return false;
+    decode_dib(view, oImage);
+    return true;
+  }
+
+  bool ClipboardHistory::Entry::GetAsDragDropFiles(Clipboard::DragDropType & oDragDropType, DropFileList & oFiles) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    bool is_wide = false;
+    if (!getSlot(SLOT_FILES, data, size) || size < 4)
+      return false;
+    oDragDropType = (read32le(data) == DROP_EFFECT_MOVE ? Clipboard::DragDropCut : Clipboard::DragDropCopy);
+    return decode_dropfiles(data + 4, size - 4, oFiles, is_wide);
+  }
+
+#ifdef _WIN32
+  ClipboardHistory::ClipboardHistory(Clipboard & iClipboard, size_t iCapacity, size_t iMaxBytes) :
+    mClipboard(&iClipboard),
+    mBackend(NULL),
+    mEntries(iCapacity > 0 ? iCapacity : 1),
+    mHead(0),
+    mCount(0),
+    mMaxBytes(iMaxBytes),
+    mUsedBytes(0),
+    mNextSequence(1),
+    mLastFingerprint(0),
+    mHasLastFingerprint(false),
+    mChunk(NULL)
+  {
+  }
+#endif //_WIN32
+
+  ClipboardHistory::ClipboardHistory(Backend & iBackend, size_t iCapacity, size_t iMaxBytes) :
+    mClipboard(NULL),
+    mBackend(&iBackend),
+    mEntries(iCapacity > 0 ? iCapacity : 1),
+    mHead(0),
+    mCount(0),
+    mMaxBytes(iMaxBytes),
+    mUsedBytes(0),
+    mNextSequence(1),
+    mLastFingerprint(0),
+    mHasLastFingerprint(false),
+    mChunk(NULL)
+  {
+  }
+
+  ClipboardHistory::~ClipboardHistory()
+  {
+    Clear();
+    free(mChunk); //the current chunk is kept when its last block is released
+  }
+
+  bool ClipboardHistory::Update()
+  {
+    //skip the capture if the clipboard did not change since the last update.
+    //Backends do not provide a fingerprint: their content is compared with the last entry instead.
+#ifdef _WIN32
+    if (mClipboard != NULL)
+    {
+      uint64_t fingerprint = 0;
+      bool has_fingerprint = mClipboard->GetFingerprint(fingerprint);
+      if (has_fingerprint && mHasLastFingerprint && fingerprint == mLastFingerprint)
+        return false;
+      mLastFingerprint = fingerprint;
+      mHasLastFingerprint = has_fingerprint;
+    }
+#endif
+
+    //capture every known format
+    std::string payloads[NUM_SLOTS];
+    bool present[NUM_SLOTS] = {0};
+    capture(payloads, present);
+
+    bool empty = true;
+    for(size_t i=0; i<NUM_SLOTS; i++)
+    {
+      if (present[i])
+        empty = false;
+    }
+    if (empty)
+      return false;
+
+    //ignore the capture if the content did not change since the last entry
+    const Entry * last = Find(GetLastSequence());
+    if (last != NULL && isSameContent(*last, payloads, present))
+      return false;
+
+    Block * block = acquireBlock(payloads, present);
+    if (block == NULL)
+      return false;
+
+    //make room for the new entry
+    if (mCount == mEntries.size())
+      evictOldest();
+
+    Entry & entry = mEntries[(mHead + mCount) % mEntries.size()];
+    entry.mSequence = mNextSequence++;
+    entry.mBlock = block;
+    mCount++;
+
+    return true;
+  }
+
+  void ClipboardHistory::Clear()
+  {
+    while(mCount > 0)
+      evictOldest();
+    mHead = 0;
+    mHasLastFingerprint = false;
+  }
+
+  size_t ClipboardHistory::GetCount() const
+  {
+    return mCount;
+  }
+
+  size_t ClipboardHistory::GetCapacity() const
+  {
+    return mEntries.size();
+  }
+
+  size_t ClipboardHistory::GetMemoryUsage() const
+  {
+    return mUsedBytes;
+  }
+
+  uint64_t ClipboardHistory::GetFirstSequence() const
+  {
+    if (mCount == 0)
+      return 0;
+    return mEntries[mHead].mSequence;
+  }
+
+  uint64_t ClipboardHistory::GetLastSequence() const
+  {
+    if (mCount == 0)
+      return 0;
+    return mEntries[(mHead + mCount - 1) % mEntries.size()].mSequence;
+  }
+
+  const ClipboardHistory::Entry * ClipboardHistory::Find(uint64_t iSequence) const
+  {
+    //sequence numbers of the entries in the ring are contiguous
+    const uint64_t first = GetFirstSequence();
+    if (mCount == 0 || iSequence < first || iSequence - first >= mCount)
+      return NULL;
+
+    const size_t index = (mHead + (size_t)(iSequence - first)) % mEntries.size();
+    return &mEntries[index];
+  }
+
+  ClipboardHistory::Block * ClipboardHistory::acquireBlock(const std::string * iPayloads, const bool * iPresent)
+  {
+    const uint64_t hash = hashPayloads(iPayloads, iPresent);
+
+    //reuse an existing block with the same content
+    std::pair<BlockMap::iterator, BlockMap::iterator> range = mBlocks.equal_range(hash);
+    for(BlockMap::iterator it = range.first; it != range.second; ++it)
+    {
+      Entry candidate;
+      candidate.mBlock = it->second;
+      if (isSameContent(candidate, iPayloads, iPresent))
+      {
+        it->second->refs++;
+        return it->second;
+      }
+    }
+
+    size_t size = 0;
+    for(size_t i=0; i<NUM_SLOTS; i++)
+    {
+      if (iPresent[i])
+        size += iPayloads[i].size();
+    }
+    if (size > mMaxBytes)
+      return NULL;
+
+    //evict the oldest entries until the new block fits in the memory budget
+    while(mCount > 0 && mUsedBytes + size > mMaxBytes)
+      evictOldest();
+
+    Chunk * chunk = NULL;
+    Block * block = (Block *)allocate(sizeof(Block) + size, chunk);
+    if (block == NULL)
+      return NULL;
+    block->refs = 1;
+    block->hash = hash;
+    block->size = size;
+    block->chunk = chunk;
+
+    char * data = block->getData();
+    size_t offset = 0;
+    for(size_t i=0; i<NUM_SLOTS; i++)
+    {
+      block->present[i] = iPresent[i];
+      block->offsets[i] = offset;
+      if (iPresent[i])
+      {
+        memcpy(data + offset, iPayloads[i].data(), iPayloads[i].size());
+        offset += iPayloads[i].size();
+      }
+    }
+    block->offsets[NUM_SLOTS] = offset;
+
+    mBlocks.insert(BlockMap::value_type(hash, block));
+    mUsedBytes += size;
+
+    return block;
+  }
+
+  void ClipboardHistory::releaseBlock(Block * iBlock)
+  {
+    if (iBlock == NULL)
+      return;
+
+    iBlock->refs--;
+    if (iBlock->refs > 0)
+      return;
+
+    std::pair<BlockMap::iterator, BlockMap::iterator> range = mBlocks.equal_range(iBlock->hash);
+    for(BlockMap::iterator it = range.first; it != range.second; ++it)
+    {
+      if (it->second == iBlock)
+      {
+        mBlocks.erase(it);
+        break;
+      }
+    }
+    mUsedBytes -= iBlock->size;
+
+    //the memory of a chunk is reclaimed when its last block is released
+    Chunk * chunk = iBlock->chunk;
+    chunk->live--;
+    if (chunk->live > 0)
+      return;
+    if (chunk == mChunk)
+      chunk->used = 0;
+    else
+      free(chunk);
+  }
+
+  void * ClipboardHistory::allocate(size_t iSize, Chunk *& oChunk)
+  {
+    const size_t size = alignSize(iSize);
+
+    if (mChunk == NULL || mChunk->capacity - mChunk->used < size)
+    {
+      if (mChunk != NULL && mChunk->live == 0 && mChunk->capacity >= size)
+      {
+        //the current chunk is empty and big enough
+        mChunk->used = 0;
+      }
+      else
+      {
+        //start a new chunk. The previous chunk is released with its last block.
+        const size_t capacity = (size > CHUNK_SIZE ? size : CHUNK_SIZE);
+        Chunk * chunk = (Chunk *)malloc(alignSize(sizeof(Chunk)) + capacity);
+        if (chunk == NULL)
+          return NULL;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        chunk->live = 0;
+        chunk->padding = 0;
+
+        if (mChunk != NULL && mChunk->live == 0)
+          free(mChunk);
+        mChunk = chunk;
+      }
+    }
+
+    void * ptr = mChunk->getData() + mChunk->used;
+    mChunk->used += size;
+    mChunk->live++;
+    oChunk = mChunk;
+    return ptr;
+  }
+
+  void ClipboardHistory::capture(std::string * oPayloads, bool * oPresent)
+  {
+#ifdef _WIN32
+    if (mClipboard != NULL)
+    {
+      captureClipboard(*mClipboard, oPayloads, oPresent);
+      return;
+    }
+#endif
+    captureBackend(*mBackend, oPayloads, oPresent);
+  }
+
+  void ClipboardHistory::evictOldest()
+  {
+    if (mCount == 0)
+      return;
+
+    Entry & entry = mEntries[mHead];
+    releaseBlock(entry.mBlock);
+    entry.mBlock = NULL;
+    entry.mSequence = 0;
+
+    mHead = (mHead + 1) % mEntries.size();
+    mCount--;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,202 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <stdint.h>
+
+#include "win32clipboard/html.h"
+
+namespace win32clipboard
+{
+  // See https://docs.microsoft.com/en-us/windows/win32/dataxchg/html-clipboard-format
+  static const char HTML_VERSION[] = "Version:0.9\r\n";
+  static const char HTML_PREFIX[]  = "<html><body>\r\n<!--StartFragment-->";
+  static const char HTML_SUFFIX[]  = "<!--EndFragment-->\r\n</body></html>";
+  static const char HTML_EOL[]     = "\r\n";
+
+  // Offsets of the header, in the order they are written
+  enum HtmlOffset { START_HTML, END_HTML, START_FRAGMENT, END_FRAGMENT, NUM_OFFSETS };
+  static const char * const OFFSET_NAMES[NUM_OFFSETS] = { "StartHTML", "EndHTML", "StartFragment", "EndFragment" };
+
+  // Offsets are written with a fixed number of digits so that the size of the header does not depend on their values
+  static const size_t OFFSET_DIGITS = 10;
+  static const uint64_t MAX_OFFSET = 9999999999ull;
+
+  // Largest number of digits of a parsed offset
+  static const size_t MAX_PARSED_DIGITS = 18;
+
+  static size_t getHeaderSize()
+  {
+    size_t size = sizeof(HTML_VERSION) - 1;
+    for(size_t i=0; i<NUM_OFFSETS; i++)
+      size += strlen(OFFSET_NAMES[i]) + 1 + OFFSET_DIGITS + sizeof(HTML_EOL) - 1; // name:0000000000\r\n
+    return size;
+  }
+
+  static inline char * writeText(char * p, const char * text, size_t length)
+  {
+    memcpy(p, text, length);
+    return p + length;
+  }
+
+  static inline char * writeOffset(char * p, size_t value)
+  {
+    for(size_t i=OFFSET_DIGITS; i-- > 0; )
+    {
+      p[i] = (char)('0' + value % 10);
+      value /= 10;
+    }
+    return p + OFFSET_DIGITS;
+  }
+
+  size_t get_cf_html_size(size_t fragment_size)
+  {
+    return getHeaderSize() + (sizeof(HTML_PREFIX) - 1) + fragment_size + (sizeof(HTML_SUFFIX) - 1) + 1;
+  }
+
+  bool encode_cf_html(const char * fragment, size_t fragment_size, void * buffer, size_t size)
+  {
+    const size_t required_size = get_cf_html_size(fragment_size);
+    if (buffer == NULL || size < required_size || (uint64_t)required_size > MAX_OFFSET)
+      return false;
+
+    //all offsets are known before writing anything
+    size_t offsets[NUM_OFFSETS];
+    offsets[START_HTML]     = getHeaderSize();
+    offsets[START_FRAGMENT] = offsets[START_HTML] + sizeof(HTML_PREFIX) - 1;
+    offsets[END_FRAGMENT]   = offsets[START_FRAGMENT] + fragment_size;
+    offsets[END_HTML]       = offsets[END_FRAGMENT] + sizeof(HTML_SUFFIX) - 1;
+
+    char * p = (char *)buffer;
+    p = writeText(p, HTML_VERSION, sizeof(HTML_VERSION) - 1);
+    for(size_t i=0; i<NUM_OFFSETS; i++)
+    {
+      p = writeText(p, OFFSET_NAMES[i], strlen(OFFSET_NAMES[i]));
+      *p++ = ':';
+      p = writeOffset(p, offsets[i]);
+      p = writeText(p, HTML_EOL, sizeof(HTML_EOL) - 1);
+    }
+    p = writeText(p, HTML_PREFIX, sizeof(HTML_PREFIX) - 1);
+    if (fragment_size > 0)
+      p = writeText(p, fragment, fragment_size);
+    p = writeText(p, HTML_SUFFIX, sizeof(HTML_SUFFIX) - 1);
+    *p = '\0';
+
+    return true;
+  }
+
+  // Parse a decimal value, -1 included. Leading and trailing spaces are ignored.
+  static bool parseValue(const char * begin, const char * end, int64_t & value)
+  {
+    while (begin < end && *begin == ' ')
+      begin++;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\r'))
+      end--;
+
+    bool negative = false;
+    if (begin < end && *begin == '-')
+    {
+      negative = true;
+      begin++;
+    }
+    if (begin == end || (size_t)(end - begin) > MAX_PARSED_DIGITS)
+      return false;
+
+    value = 0;
+    for(; begin < end; begin++)
+    {
+      if (*begin < '0' || *begin > '9')
+        return false;
+      value = value * 10 + (*begin - '0');
+    }
+    if (negative)
+      value = -value;
+    return true;
+  }
+
+  static inline bool isValidRange(int64_t begin, int64_t end, size_t size)
+  {
+    return 0 <= begin && begin <= end && (uint64_t)end <= (uint64_t)size;
+  }
+
+  bool parse_cf_html(const void * buffer, size_t size, HtmlView & view)
+  {
+    const char * data = (const char *)buffer;
+    if (data == NULL)
+      return false;
+
+    int64_t offsets[NUM_OFFSETS] = { -1, -1, -1, -1 };
+
+    //read the "name:value" lines of the header. The header ends where the document starts:
+    //at the StartHTML offset once known, or at the first line which is not a description.
+    size_t header_end = size;
+    size_t pos = 0;
+    while (pos < header_end && data[pos] != '<')
+    {
+      const char * line = data + pos;
+      const char * eol = (const char *)memchr(line, '\n', header_end - pos);
+      if (eol == NULL)
+        eol = data + header_end;
+      const char * colon = (const char *)memchr(line, ':', eol - line);
+      if (colon == NULL)
+        break;
+
+      const size_t name_length = colon - line;
+      for(size_t i=0; i<NUM_OFFSETS; i++)
+      {
+        if (name_length == strlen(OFFSET_NAMES[i]) && memcmp(line, OFFSET_NAMES[i], name_length) == 0)
+        {
+          if (!parseValue(colon + 1, eol, offsets[i]))
+            return false;
+          if (i == START_HTML && offsets[i] >= 0 && (uint64_t)offsets[i] < (uint64_t)header_end)
+            header_end = (size_t)offsets[i];
+          break;
+        }
+      }
+
+      pos = (eol - data) + 1;
+    }
+
+    //the fragment offsets are mandatory
+    if (!isValidRange(offsets[START_FRAGMENT], offsets[END_FRAGMENT], size))
+      return false;
+    view.fragment = data + offsets[START_FRAGMENT];
+    view.fragment_size = (size_t)(offsets[END_FRAGMENT] - offsets[START_FRAGMENT]);
+
+    //the document offsets are -1 when the fragment has no context
+    if (isValidRange(offsets[START_HTML], offsets[END_HTML], size))
+    {
+      view.html = data + offsets[START_HTML];
+      view.html_size = (size_t)(offsets[END_HTML] - offsets[START_HTML]);
+    }
+    else
+    {
+      view.html = view.fragment;
+      view.html_size = view.fragment_size;
+    }
+
+    return true;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,339 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+
+#include "win32clipboard/image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define WIN32CLIPBOARD_HAVE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace win32clipboard
+{
+  // Compression values of the BITMAPINFOHEADER structure
+  static const uint32_t BI_RGB_VALUE       = 0;
+  static const uint32_t BI_BITFIELDS_VALUE = 3;
+
+  // Size of the supported bitmap header structures
+  static const size_t BITMAPINFOHEADER_SIZE = 40;
+  static const size_t BITMAPV4HEADER_SIZE   = 108;
+  static const size_t BITMAPV5HEADER_SIZE   = 124;
+
+  // Channel masks of BGRA pixels
+  static const uint32_t MASK_RED   = 0x00FF0000;
+  static const uint32_t MASK_GREEN = 0x0000FF00;
+  static const uint32_t MASK_BLUE  = 0x000000FF;
+  static const uint32_t MASK_ALPHA = 0xFF000000;
+
+  static const uint32_t LCS_SRGB      = 0x73524742; // 'sRGB'
+  static const uint32_t LCS_GM_IMAGES = 4;
+
+  static inline uint32_t read32le(const unsigned char * p)
+  {
+    return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  static inline uint32_t read16le(const unsigned char * p)
+  {
+    return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8);
+  }
+
+  static inline void write32le(unsigned char * p, uint32_t value)
+  {
+    p[0] = (unsigned char)(value      );
+    p[1] = (unsigned char)(value >>  8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+  }
+
+  static inline void write16le(unsigned char * p, uint32_t value)
+  {
+    p[0] = (unsigned char)(value      );
+    p[1] = (unsigned char)(value >>  8);
+  }
+
+  Image::Image() :
+    mWidth(0),
+    mHeight(0)
+  {
+  }
+
+  void Image::Create(size_t iWidth, size_t iHeight)
+  {
+    mWidth = iWidth;
+    mHeight = iHeight;
+    mPixels.resize(iWidth * iHeight * 4);
+  }
+
+  size_t Image::GetWidth() const
+  {
+    return mWidth;
+  }
+
+  size_t Image::GetHeight() const
+  {
+    return mHeight;
+  }
+
+  size_t Image::GetStride() const
+  {
+    return mWidth * 4;
+  }
+
+  unsigned char * Image::GetPixels()
+  {
+    if (mPixels.empty())
+      return NULL;
+    return &mPixels[0];
+  }
+
+  const unsigned char * Image::GetPixels() const
+  {
+    if (mPixels.empty())
+      return NULL;
+    return &mPixels[0];
+  }
+
+  void swap_red_blue(const unsigned char * src, unsigned char * dst, size_t count, unsigned char alpha)
+  {
+    const uint32_t alpha_bits = ((uint32_t)alpha) << 24;
+    size_t i = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    //4 pixels at a time: keep green and alpha, move red and blue to the other side of the pixel
+    const __m128i mask_ga = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i mask_rb = _mm_set1_epi32(0x00FF00FF);
+    const __m128i alpha_or = _mm_set1_epi32((int)alpha_bits);
+    for(; i + 4 <= count; i += 4)
+    {
+      __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 4*i));
+      __m128i ga = _mm_and_si128(pixels, mask_ga);
+      __m128i rb = _mm_and_si128(pixels, mask_rb);
+      rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+      pixels = _mm_or_si128(_mm_or_si128(ga, rb), alpha_or);
+      _mm_storeu_si128((__m128i *)(dst + 4*i), pixels);
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+      const unsigned char * s = src + 4*i;
+      unsigned char * d = dst + 4*i;
+      const unsigned char c0 = s[0];
+      const unsigned char c2 = s[2];
+      d[0] = c2;
+      d[1] = s[1];
+      d[2] = c0;
+      d[3] = s[3] | alpha;
+    }
+  }
+
+  void expand_bgr_to_rgba(const unsigned char * src, unsigned char * dst, size_t count)
+  {
+    size_t i = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSSE3
+    //4 pixels at a time. Each iteration loads 16 bytes but only uses the first 12.
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i opaque = _mm_set1_epi32((int)MASK_ALPHA);
+    for(; i + 6 <= count; i += 4) // 3*(i+6) >= 3*i + 16: never reads past the end of src
+    {
+      __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 3*i));
+      pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), opaque);
+      _mm_storeu_si128((__m128i *)(dst + 4*i), pixels);
+    }
+#elif defined(WIN32CLIPBOARD_HAVE_SSE2)
+    //4 pixels at a time. The 3 bytes pixels are moved to 32 bit lanes with byte shifts, then red and blue are swapped like in swap_red_blue().
+    const __m128i mask_g = _mm_set1_epi32(0x0000FF00);
+    const __m128i mask_rb = _mm_set1_epi32(0x00FF00FF);
+    const __m128i opaque = _mm_set1_epi32((int)MASK_ALPHA);
+    for(; i + 6 <= count; i += 4) // 3*(i+6) >= 3*i + 16: never reads past the end of src
+    {
+      const __m128i bytes = _mm_loadu_si128((const __m128i *)(src + 3*i));
+      const __m128i p01 = _mm_unpacklo_epi32(bytes, _mm_srli_si128(bytes, 3));
+      const __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(bytes, 6), _mm_srli_si128(bytes, 9));
+      const __m128i pixels = _mm_unpacklo_epi64(p01, p23); // B G R x in each lane
+      __m128i rb = _mm_and_si128(pixels, mask_rb);
+      rb = _mm_and_si128(_mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16)), mask_rb);
+      const __m128i rgba = _mm_or_si128(_mm_or_si128(rb, _mm_and_si128(pixels, mask_g)), opaque);
+      _mm_storeu_si128((__m128i *)(dst + 4*i), rgba);
+    }
+#else
+    //4 pixels at a time with 3 unaligned 32 bit loads
+    for(; i + 4 <= count; i += 4)
+    {
+      uint32_t w0, w1, w2;
+      memcpy(&w0, src + 3*i + 0, 4); // B0 G0 R0 B1
+      memcpy(&w1, src + 3*i + 4, 4); // G1 R1 B2 G2
+      memcpy(&w2, src + 3*i + 8, 4); // R2 B3 G3 R3
+      unsigned char * d = dst + 4*i;
+      d[ 0] = (unsigned char)(w0 >> 16); d[ 1] = (unsigned char)(w0 >>  8); d[ 2] = (unsigned char)(w0      ); d[ 3] = 0xFF;
+      d[ 4] = (unsigned char)(w1 >>  8); d[ 5] = (unsigned char)(w1      ); d[ 6] = (unsigned char)(w0 >> 24); d[ 7] = 0xFF;
+      d[ 8] = (unsigned char)(w2      ); d[ 9] = (unsigned char)(w1 >> 24); d[10] = (unsigned char)(w1 >> 16); d[11] = 0xFF;
+      d[12] = (unsigned char)(w2 >> 24); d[13] = (unsigned char)(w2 >> 16); d[14] = (unsigned char)(w2 >>  8); d[15] = 0xFF;
+    }
+#endif
+
+    for(; i < count; i++)
+    {
+      const unsigned char * s = src + 3*i;
+      unsigned char * d = dst + 4*i;
+      d[0] = s[2];
+      d[1] = s[1];
+      d[2] = s[0];
+      d[3] = 0xFF;
+    }
+  }
+
+  bool parse_dib(const void * buffer, size_t size, DibView & view)
+  {
+    memset(&view, 0, sizeof(view));
+
+    const unsigned char * p = (const unsigned char *)buffer;
+    if (p == NULL || size < BITMAPINFOHEADER_SIZE)
+      return false;
+
+    const size_t header_size = read32le(p + 0);
+    if (header_size < BITMAPINFOHEADER_SIZE || header_size > size)
+      return false;
+
+    const int32_t width  = (int32_t)read32le(p + 4);
+    const int32_t height = (int32_t)read32le(p + 8);
+    const uint32_t bit_count   = read16le(p + 14);
+    const uint32_t compression = read32le(p + 16);
+    const uint32_t colors_used = read32le(p + 32);
+    if (width <= 0 || height == 0 || height == INT32_MIN)
+      return false;
+    if (bit_count != 24 && bit_count != 32)
+      return false;
+
+    size_t pixels_offset = header_size + (size_t)colors_used * 4;
+
+    //channel masks
+    bool has_alpha = false;
+    if (compression == BI_BITFIELDS_VALUE)
+    {
+      if (bit_count != 32)
+        return false;
+
+      //masks follow a BITMAPINFOHEADER structure but are part of the newer structures
+      const unsigned char * masks = p + BITMAPINFOHEADER_SIZE;
+      if (size < BITMAPINFOHEADER_SIZE + 12)
+        return false;
+      if (header_size == BITMAPINFOHEADER_SIZE)
+        pixels_offset += 12;
+      else if (header_size < BITMAPINFOHEADER_SIZE + 12)
+        return false; //the header ends in the middle of the masks
+      if (read32le(masks + 0) != MASK_RED || read32le(masks + 4) != MASK_GREEN || read32le(masks + 8) != MASK_BLUE)
+        return false;
+      has_alpha = (header_size >= BITMAPV4HEADER_SIZE && read32le(masks + 12) == MASK_ALPHA);
+    }
+    else if (compression != BI_RGB_VALUE)
+      return false;
+
+    view.width = (size_t)width;
+    view.height = (size_t)(height < 0 ? -height : height);
+    view.bit_count = bit_count;
+    view.stride = ((view.width * bit_count + 31) / 32) * 4;
+    view.bottom_up = (height > 0);
+    view.has_alpha = has_alpha;
+
+    //validate the pixels are inside the buffer
+    if (pixels_offset > size || view.stride > (size - pixels_offset) / view.height)
+      return false;
+    view.pixels = p + pixels_offset;
+
+    return true;
+  }
+
+  void decode_dib(const DibView & view, Image & image)
+  {
+    image.Create(view.width, view.height);
+    unsigned char * dst = image.GetPixels();
+    if (dst == NULL || view.pixels == NULL)
+      return;
+
+    const unsigned char alpha = (view.has_alpha ? 0x00 : 0xFF);
+    for(size_t y=0; y<view.height; y++)
+    {
+      const size_t src_row = (view.bottom_up ? view.height - 1 - y : y);
+      const unsigned char * src = view.pixels + src_row * view.stride;
+      unsigned char * row = dst + y * image.GetStride();
+      if (view.bit_count == 32)
+        swap_red_blue(src, row, view.width, alpha);
+      else
+        expand_bgr_to_rgba(src, row, view.width);
+    }
+  }
+
+  size_t get_dib_size(const Image & image)
+  {
+    return BITMAPV5HEADER_SIZE + image.GetStride() * image.GetHeight();
+  }
+
+  bool encode_dib(const Image & image, void * buffer, size_t size)
+  {
+    if (buffer == NULL || size < get_dib_size(image))
+      return false;
+
+    const size_t width = image.GetWidth();
+    const size_t height = image.GetHeight();
+    const size_t stride = image.GetStride();
+
+    //BITMAPV5HEADER structure
+    unsigned char * p = (unsigned char *)buffer;
+    memset(p, 0, BITMAPV5HEADER_SIZE);
+    write32le(p +   0, (uint32_t)BITMAPV5HEADER_SIZE);
+    write32le(p +   4, (uint32_t)width);
+    write32le(p +   8, (uint32_t)height); //positive height: bottom-up rows, as expected by most applications
+    write16le(p +  12, 1);                //planes
+    write16le(p +  14, 32);               //bit count
+    write32le(p +  16, BI_BITFIELDS_VALUE);
+    write32le(p +  20, (uint32_t)(stride * height));
+    write32le(p +  40, MASK_RED);
+    write32le(p +  44, MASK_GREEN);
+    write32le(p +  48, MASK_BLUE);
+    write32le(p +  52, MASK_ALPHA);
+    write32le(p +  56, LCS_SRGB);
+    write32le(p + 108, LCS_GM_IMAGES);
+
+    //pixels, flipped and converted to BGRA in a single pass
+    const unsigned char * src = image.GetPixels();
+    unsigned char * dst = p + BITMAPV5HEADER_SIZE;
+    for(size_t y=0; y<height; y++)
+    {
+      swap_red_blue(src + y * stride, dst + (height - 1 - y) * stride, width, 0);
+    }
+
+    return true;
+  }
+
+} //namespace win32clipboard
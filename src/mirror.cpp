@@ -0,0 +1,350 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include "win32clipboard/mirror.h"
+#include "win32clipboard/hash.h"
+#include "serialize.h"
+
+namespace win32clipboard
+{
+  //Layout of a content message: MESSAGE_CONTENT, the flags, the number of formats then, for each format, the size of the name,
+  //the name, the mode, the hash of the payload (8 bytes, little endian) and, unless the format is unchanged, the size of the
+  //payload or of the delta followed by its bytes. Sizes are encoded as variable length integers, 7 bits per byte.
+  //A resynchronization request is a single MESSAGE_RESYNC byte.
+  static const char MESSAGE_CONTENT = 'M';
+  static const char MESSAGE_RESYNC = 'R';
+  static const char FLAG_RESET = 1;       //the message does not refer to previous versions
+  static const char MODE_UNCHANGED = '=';
+  static const char MODE_FULL = 'F';
+  static const char MODE_DELTA = 'D';
+
+  //Payloads smaller than this number of blocks are always sent in full
+  static const size_t MIN_DELTA_BLOCKS = 4;
+
+
+  //Append the size of a string followed by its bytes.
+  static void appendString(std::string & buffer, const char * data, size_t size)
+  {
+    appendVarint(buffer, size);
+    buffer.append(data, size);
+  }
+
+  static bool readString(const std::string & buffer, size_t & offset, std::string & value)
+  {
+    uint64_t size = 0;
+    if (!readVarint(buffer, offset, size) || size > buffer.size() - offset)
+      return false;
+    value.assign(buffer, offset, (size_t)size);
+    offset += (size_t)size;
+    return true;
+  }
+
+  static bool isResetMessage(const std::string & iMessage)
+  {
+    return (iMessage.size() >= 2 && iMessage[0] == MESSAGE_CONTENT && (iMessage[1] & FLAG_RESET) != 0);
+  }
+
+  Transport::~Transport()
+  {
+  }
+
+  LocalTransport::LocalTransport() :
+    mPeer(NULL),
+    mBytesSent(0)
+  {
+  }
+
+  LocalTransport::~LocalTransport()
+  {
+  }
+
+  void LocalTransport::Connect(LocalTransport & iFirst, LocalTransport & iSecond)
+  {
+    iFirst.mPeer = &iSecond;
+    iSecond.mPeer = &iFirst;
+  }
+
+  bool LocalTransport::Send(const std::string & iMessage)
+  {
+    if (mPeer == NULL)
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock(mPeer->mMutex);
+      mPeer->mMessages.push_back(iMessage);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBytesSent += iMessage.size();
+    return true;
+  }
+
+  bool LocalTransport::Receive(std::string & oMessage)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mMessages.empty())
+      return false;
+    oMessage.swap(mMessages.front());
+    mMessages.pop_front();
+    return true;
+  }
+
+  uint64_t LocalTransport::GetBytesSent() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mBytesSent;
+  }
+
+  MirrorSender::MirrorSender(Backend & iSource, Transport & iTransport, size_t iBlockSize) :
+    mSource(iSource),
+    mTransport(iTransport),
+    mBlockSize(iBlockSize > 0 ? iBlockSize : DEFAULT_BLOCK_SIZE),
+    mReset(true)
+  {
+    mStats = MirrorStats();
+  }
+
+  MirrorSender::~MirrorSender()
+  {
+  }
+
+  bool MirrorSender::Update()
+  {
+    //the receiver lost track of the previous versions
+    std::string request;
+    while (mTransport.Receive(request))
+    {
+      if (!request.empty() && request[0] == MESSAGE_RESYNC)
+      {
+        mStats.resyncs++;
+        Reset();
+      }
+    }
+
+    Backend::StringVector names;
+    if (!mSource.GetFormats(names))
+      return false;
+
+    bool changed = mReset;
+    FormatStateMap formats;
+    std::string records;
+    std::string payload;
+    std::string delta;
+    size_t count = 0;
+    uint64_t payload_bytes = 0;
+    uint64_t full_formats = 0;
+    uint64_t delta_formats = 0;
+    for(size_t i=0; i<names.size(); i++)
+    {
+      const std::string & name = names[i];
+      if (!mSource.Read(name, payload))
+        continue;
+      count++;
+
+      const uint64_t hash = hash64(payload.data(), payload.size());
+      FormatStateMap::const_iterator previous = (mReset ? mFormats.end() : mFormats.find(name));
+      appendString(records, name.data(), name.size());
+
+      if (previous != mFormats.end() && previous->second.hash == hash)
+      {
+        records += MODE_UNCHANGED;
+        appendUint64(records, hash);
+        formats[name] = previous->second;
+        continue;
+      }
+
+      //send the smallest of the delta and the payload
+      changed = true;
+      payload_bytes += payload.size();
+      bool use_delta = false;
+      if (previous != mFormats.end() && !previous->second.signature.weak_sums.empty())
+      {
+        compute_delta(previous->second.signature, payload.data(), payload.size(), delta);
+        use_delta = (delta.size() < payload.size());
+      }
+
+      if (use_delta)
+      {
+        records += MODE_DELTA;
+        appendUint64(records, hash);
+        appendString(records, delta.data(), delta.size());
+        delta_formats++;
+      }
+      else
+      {
+        records += MODE_FULL;
+        appendUint64(records, hash);
+        appendString(records, payload.data(), payload.size());
+        full_formats++;
+      }
+
+      FormatState & state = formats[name];
+      state.hash = hash;
+      if (payload.size() >= MIN_DELTA_BLOCKS * mBlockSize)
+        compute_signature(payload.data(), payload.size(), mBlockSize, state.signature);
+    }
+
+    //formats were removed
+    if (count != mFormats.size())
+      changed = true;
+    if (!changed)
+      return false;
+
+    std::string message;
+    message.reserve(records.size() + 16);
+    message += MESSAGE_CONTENT;
+    message += (char)(mReset ? FLAG_RESET : 0);
+    appendVarint(message, count);
+    message += records;
+    if (!mTransport.Send(message))
+      return false;
+
+    mFormats.swap(formats);
+    mReset = false;
+
+    mStats.updates++;
+    mStats.full_formats += full_formats;
+    mStats.delta_formats += delta_formats;
+    mStats.payload_bytes += payload_bytes;
+    mStats.sent_bytes += message.size();
+    return true;
+  }
+
+  void MirrorSender::Reset()
+  {
+    mFormats.clear();
+    mReset = true;
+  }
+
+  void MirrorSender::GetStats(MirrorStats & oStats) const
+  {
+    oStats = mStats;
+  }
+
+  MirrorReceiver::MirrorReceiver(Backend & iDestination, Transport & iTransport) :
+    mDestination(iDestination),
+    mTransport(iTransport),
+    mWaitingReset(false),
+    mErrors(0)
+  {
+  }
+
+  MirrorReceiver::~MirrorReceiver()
+  {
+  }
+
+  bool MirrorReceiver::Update()
+  {
+    bool applied = false;
+    std::string message;
+    while (mTransport.Receive(message))
+    {
+      //messages sent before the sender handled the resynchronization request refer to versions that are lost
+      if (mWaitingReset && !isResetMessage(message))
+        continue;
+
+      if (apply(message))
+      {
+        mWaitingReset = false;
+        applied = true;
+        continue;
+      }
+
+      mErrors++;
+      mFormats.clear();
+      mWaitingReset = true;
+      mTransport.Send(std::string(1, MESSAGE_RESYNC));
+    }
+    return applied;
+  }
+
+  uint64_t MirrorReceiver::GetErrorCount() const
+  {
+    return mErrors;
+  }
+
+  bool MirrorReceiver::apply(const std::string & iMessage)
+  {
+    if (iMessage.size() < 2 || iMessage[0] != MESSAGE_CONTENT)
+      return false;
+
+    size_t offset = 2;
+    uint64_t count = 0;
+    if (!readVarint(iMessage, offset, count) || count > iMessage.size())
+      return false;
+
+    //rebuild every format. On failure, the previous versions are discarded anyway.
+    FormatVersionMap formats;
+    Backend::ItemList items((size_t)count);
+    std::string buffer;
+    for(size_t i=0; i<items.size(); i++)
+    {
+      Backend::Item & item = items[i];
+      uint64_t hash = 0;
+      if (!readString(iMessage, offset, item.format) || offset >= iMessage.size())
+        return false;
+      const char mode = iMessage[offset++];
+      if (!readUint64(iMessage, offset, hash))
+        return false;
+
+      FormatVersion & version = formats[item.format];
+      version.hash = hash;
+      FormatVersionMap::iterator previous = mFormats.find(item.format);
+      if (mode == MODE_UNCHANGED)
+      {
+        if (previous == mFormats.end() || previous->second.hash != hash)
+          return false;
+        version.data.swap(previous->second.data);
+      }
+      else if (mode == MODE_FULL)
+      {
+        if (!readString(iMessage, offset, version.data))
+          return false;
+      }
+      else if (mode == MODE_DELTA)
+      {
+        if (previous == mFormats.end() || !readString(iMessage, offset, buffer))
+          return false;
+        const std::string & base = previous->second.data;
+        if (!apply_delta(base.data(), base.size(), buffer.data(), buffer.size(), version.data))
+          return false;
+      }
+      else
+        return false;
+
+      if (mode != MODE_UNCHANGED && hash64(version.data.data(), version.data.size()) != hash)
+        return false;
+      item.data = version.data;
+    }
+    if (offset != iMessage.size())
+      return false;
+
+    const bool success = (items.empty() ? mDestination.Empty() : mDestination.Write(items));
+    if (!success)
+      return false;
+
+    mFormats.swap(formats);
+    return true;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,270 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+
+#include "win32clipboard/newline.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static const unsigned CR = '\r';
+  static const unsigned LF = '\n';
+
+  static inline unsigned countBits(unsigned mask)
+  {
+    //line endings are sparse: loop once per set bit
+    unsigned count = 0;
+    while (mask)
+    {
+      mask &= mask - 1;
+      count++;
+    }
+    return count;
+  }
+
+  static inline unsigned lowestBit(unsigned mask)
+  {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    unsigned index = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      index++;
+    }
+    return index;
+#endif
+  }
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+  // Scan a block of 16 bytes for CR and LF characters.
+  // The output masks have one bit per character: bit i is set if character i matches.
+  template <size_t CHAR_SIZE> struct Block;
+
+  template <> struct Block<1>
+  {
+    static const size_t LENGTH = 16;
+    static inline void scan(const void * p, unsigned & cr, unsigned & lf)
+    {
+      const __m128i chars = _mm_loadu_si128((const __m128i *)p);
+      cr = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8((char)CR)));
+      lf = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8((char)LF)));
+    }
+  };
+
+  template <> struct Block<2>
+  {
+    static const size_t LENGTH = 8;
+    static inline void scan(const void * p, unsigned & cr, unsigned & lf)
+    {
+      //pack the 16 bit comparison results to bytes to get one bit per character
+      const __m128i chars = _mm_loadu_si128((const __m128i *)p);
+      const __m128i zero = _mm_setzero_si128();
+      cr = (unsigned)_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(chars, _mm_set1_epi16((short)CR)), zero));
+      lf = (unsigned)_mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(chars, _mm_set1_epi16((short)LF)), zero));
+    }
+  };
+
+  template <> struct Block<4>
+  {
+    static const size_t LENGTH = 4;
+    static inline void scan(const void * p, unsigned & cr, unsigned & lf)
+    {
+      const __m128i chars = _mm_loadu_si128((const __m128i *)p);
+      cr = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chars, _mm_set1_epi32((int)CR))));
+      lf = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chars, _mm_set1_epi32((int)LF))));
+    }
+  };
+#endif
+
+  // Copy the characters [begin, end) of src at the end of the output. The buffers may overlap if dst <= src.
+  template <typename T>
+  static inline void copyRun(const T * src, size_t begin, size_t end, T * dst, size_t & out)
+  {
+    const size_t count = end - begin;
+    if (count > 0 && dst + out != src + begin)
+      memmove(dst + out, src + begin, count * sizeof(T));
+    out += count;
+  }
+
+  template <typename T>
+  static size_t getCrlfLengthT(const T * str, size_t length)
+  {
+    size_t lone_lf = 0;
+    size_t i = 0;
+    unsigned prev_cr = 0; //1 if the character before i is a CR
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    typedef Block<sizeof(T)> B;
+    for(; i + B::LENGTH <= length; i += B::LENGTH)
+    {
+      unsigned cr, lf;
+      B::scan(str + i, cr, lf);
+      lone_lf += countBits(lf & ~((cr << 1) | prev_cr));
+      prev_cr = (cr >> (B::LENGTH - 1)) & 1;
+    }
+#endif
+
+    for(; i < length; i++)
+    {
+      if (str[i] == (T)LF && !prev_cr)
+        lone_lf++;
+      prev_cr = (str[i] == (T)CR);
+    }
+
+    return length + lone_lf;
+  }
+
+  template <typename T>
+  static size_t lfToCrlfT(const T * src, size_t length, T * dst)
+  {
+    size_t out = 0;
+    size_t run = 0; //first character not copied yet
+    size_t i = 0;
+    unsigned prev_cr = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    typedef Block<sizeof(T)> B;
+    for(; i + B::LENGTH <= length; i += B::LENGTH)
+    {
+      unsigned cr, lf;
+      B::scan(src + i, cr, lf);
+      unsigned lone_lf = lf & ~((cr << 1) | prev_cr);
+      prev_cr = (cr >> (B::LENGTH - 1)) & 1;
+
+      //copy everything up to each lone LF, then insert a CR. The LF is copied with the next run.
+      while (lone_lf)
+      {
+        const size_t pos = i + lowestBit(lone_lf);
+        copyRun(src, run, pos, dst, out);
+        dst[out++] = (T)CR;
+        run = pos;
+        lone_lf &= lone_lf - 1;
+      }
+    }
+#endif
+
+    for(; i < length; i++)
+    {
+      if (src[i] == (T)LF && !prev_cr)
+      {
+        copyRun(src, run, i, dst, out);
+        dst[out++] = (T)CR;
+        run = i;
+      }
+      prev_cr = (src[i] == (T)CR);
+    }
+    copyRun(src, run, length, dst, out);
+
+    return out;
+  }
+
+  template <typename T>
+  static size_t crlfToLfT(const T * src, size_t length, T * dst)
+  {
+    size_t out = 0;
+    size_t run = 0;
+    size_t i = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    typedef Block<sizeof(T)> B;
+    for(; i + B::LENGTH <= length; i += B::LENGTH)
+    {
+      unsigned cr, lf;
+      B::scan(src + i, cr, lf);
+
+      //a CR in the last position of the block is followed by the first character of the next block
+      unsigned next_lf = 0;
+      if (i + B::LENGTH < length && src[i + B::LENGTH] == (T)LF)
+        next_lf = 1u << (B::LENGTH - 1);
+      unsigned dropped_cr = cr & ((lf >> 1) | next_lf);
+
+      while (dropped_cr)
+      {
+        const size_t pos = i + lowestBit(dropped_cr);
+        copyRun(src, run, pos, dst, out);
+        run = pos + 1;
+        dropped_cr &= dropped_cr - 1;
+      }
+    }
+#endif
+
+    for(; i < length; i++)
+    {
+      if (src[i] == (T)CR && i + 1 < length && src[i + 1] == (T)LF)
+      {
+        copyRun(src, run, i, dst, out);
+        run = i + 1;
+      }
+    }
+    copyRun(src, run, length, dst, out);
+
+    return out;
+  }
+
+  size_t get_crlf_length(const char * str, size_t length)
+  {
+    return getCrlfLengthT(str, length);
+  }
+
+  size_t get_crlf_length(const wchar_t * str, size_t length)
+  {
+    return getCrlfLengthT(str, length);
+  }
+
+  size_t lf_to_crlf(const char * src, size_t length, char * dst)
+  {
+    return lfToCrlfT(src, length, dst);
+  }
+
+  size_t lf_to_crlf(const wchar_t * src, size_t length, wchar_t * dst)
+  {
+    return lfToCrlfT(src, length, dst);
+  }
+
+  size_t crlf_to_lf(const char * src, size_t length, char * dst)
+  {
+    return crlfToLfT(src, length, dst);
+  }
+
+  size_t crlf_to_lf(const wchar_t * src, size_t length, wchar_t * dst)
+  {
+    return crlfToLfT(src, length, dst);
+  }
+
+} //namespace win32clipboard
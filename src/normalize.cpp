@@ -0,0 +1,392 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdint.h>
+#include <vector>
+
+#include "win32clipboard/normalize.h"
+#include "win32clipboard/transcode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace win32clipboard
+{
+  struct CodePointProperties
+  {
+    uint8_t ccc;   //canonical combining class
+    uint8_t flags; //quick check flags
+  };
+
+  struct CompositionPair
+  {
+    uint32_t first;
+    uint32_t second;
+    uint32_t composite;
+  };
+
+  //Quick check flags
+  static const uint8_t NFC_QC_NO    = 1;
+  static const uint8_t NFC_QC_MAYBE = 2; //the code point may compose with a previous code point
+  static const uint8_t NFD_QC_NO    = 4;
+} //namespace win32clipboard
+
+#include "normalize_tables.h"
+
+namespace win32clipboard
+{
+  typedef utf_codec<char> Utf8Codec;
+
+  //Hangul syllables are decomposed and composed algorithmically.
+  //See http://www.unicode.org/versions/Unicode14.0.0/ch03.pdf, 3.12 Conjoining Jamo Behavior
+  static const uint32_t HANGUL_SBASE = 0xAC00;
+  static const uint32_t HANGUL_LBASE = 0x1100;
+  static const uint32_t HANGUL_VBASE = 0x1161;
+  static const uint32_t HANGUL_TBASE = 0x11A7;
+  static const uint32_t HANGUL_LCOUNT = 19;
+  static const uint32_t HANGUL_VCOUNT = 21;
+  static const uint32_t HANGUL_TCOUNT = 28;
+  static const uint32_t HANGUL_NCOUNT = HANGUL_VCOUNT * HANGUL_TCOUNT;
+  static const uint32_t HANGUL_SCOUNT = HANGUL_LCOUNT * HANGUL_NCOUNT;
+
+  //A code point of a segment being normalized
+  struct NormalizedChar
+  {
+    uint32_t code_point;
+    uint8_t ccc;
+  };
+  typedef std::vector<NormalizedChar> NormalizedCharList;
+
+  static inline const CodePointProperties & getProperties(uint32_t code_point)
+  {
+    if (code_point >= PROPERTIES_LIMIT)
+      return PROPERTIES[0];
+    const uint32_t block = PROPERTIES_STAGE1[code_point >> PROPERTIES_BLOCK_BITS];
+    const uint32_t mask = (1u << PROPERTIES_BLOCK_BITS) - 1;
+    return PROPERTIES[PROPERTIES_STAGE2[(block << PROPERTIES_BLOCK_BITS) | (code_point & mask)]];
+  }
+
+  static inline uint8_t getQuickCheckMask(NormalizationForm form)
+  {
+    return (form == NormalizationNFC ? (NFC_QC_NO | NFC_QC_MAYBE) : NFD_QC_NO);
+  }
+
+  static inline void appendChar(NormalizedCharList & chars, uint32_t code_point)
+  {
+    NormalizedChar c;
+    c.code_point = code_point;
+    c.ccc = getProperties(code_point).ccc;
+    chars.push_back(c);
+  }
+
+  //Append the full canonical decomposition of the given code point.
+  static void decompose(uint32_t code_point, NormalizedCharList & chars)
+  {
+    if (code_point - HANGUL_SBASE < HANGUL_SCOUNT)
+    {
+      const uint32_t index = code_point - HANGUL_SBASE;
+      appendChar(chars, HANGUL_LBASE + index / HANGUL_NCOUNT);
+      appendChar(chars, HANGUL_VBASE + (index % HANGUL_NCOUNT) / HANGUL_TCOUNT);
+      if (index % HANGUL_TCOUNT != 0)
+        appendChar(chars, HANGUL_TBASE + index % HANGUL_TCOUNT);
+      return;
+    }
+
+    //binary search of the decomposition
+    size_t first = 0;
+    size_t last = sizeof(DECOMPOSITION_KEYS) / sizeof(DECOMPOSITION_KEYS[0]);
+    while (first < last)
+    {
+      const size_t middle = first + (last - first) / 2;
+      if (DECOMPOSITION_KEYS[middle] < code_point)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+    if (first < sizeof(DECOMPOSITION_KEYS) / sizeof(DECOMPOSITION_KEYS[0]) && DECOMPOSITION_KEYS[first] == code_point)
+    {
+      for(size_t i=DECOMPOSITION_OFFSETS[first]; i<DECOMPOSITION_OFFSETS[first + 1]; i++)
+        appendChar(chars, DECOMPOSITION_DATA[i]);
+      return;
+    }
+
+    appendChar(chars, code_point);
+  }
+
+  //Sort each sequence of combining characters by combining class. The sort is stable.
+  static void reorder(NormalizedCharList & chars)
+  {
+    for(size_t i=1; i<chars.size(); i++)
+    {
+      const NormalizedChar c = chars[i];
+      if (c.ccc == 0)
+        continue;
+      size_t j = i;
+      while (j > 0 && chars[j - 1].ccc > c.ccc)
+      {
+        chars[j] = chars[j - 1];
+        j--;
+      }
+      chars[j] = c;
+    }
+  }
+
+  //Returns the primary composite of the given pair of code points. Returns 0 if the pair does not compose.
+  static uint32_t compose(uint32_t first, uint32_t second)
+  {
+    if (first - HANGUL_LBASE < HANGUL_LCOUNT && second - HANGUL_VBASE < HANGUL_VCOUNT)
+      return HANGUL_SBASE + ((first - HANGUL_LBASE) * HANGUL_VCOUNT + (second - HANGUL_VBASE)) * HANGUL_TCOUNT;
+    if (first - HANGUL_SBASE < HANGUL_SCOUNT && (first - HANGUL_SBASE) % HANGUL_TCOUNT == 0 && second - HANGUL_TBASE - 1 < HANGUL_TCOUNT - 1)
+      return first + (second - HANGUL_TBASE);
+
+    size_t lower = 0;
+    size_t upper = sizeof(COMPOSITIONS) / sizeof(COMPOSITIONS[0]);
+    while (lower < upper)
+    {
+      const size_t middle = lower + (upper - lower) / 2;
+      const CompositionPair & pair = COMPOSITIONS[middle];
+      if (pair.first < first || (pair.first == first && pair.second < second))
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+    if (lower < sizeof(COMPOSITIONS) / sizeof(COMPOSITIONS[0]) && COMPOSITIONS[lower].first == first && COMPOSITIONS[lower].second == second)
+      return COMPOSITIONS[lower].composite;
+    return 0;
+  }
+
+  //Canonical composition of a decomposed and reordered segment.
+  static void recompose(NormalizedCharList & chars)
+  {
+    if (chars.empty())
+      return;
+
+    size_t starter = 0;
+    uint32_t last_ccc = (chars[0].ccc == 0 ? 0 : 256); //a segment that does not start with a starter does not compose
+    size_t count = 1;
+    for(size_t i=1; i<chars.size(); i++)
+    {
+      const NormalizedChar c = chars[i];
+      const bool blocked = (last_ccc != 0 && last_ccc >= c.ccc);
+      if (!blocked && last_ccc != 256)
+      {
+        const uint32_t composite = compose(chars[starter].code_point, c.code_point);
+        if (composite != 0)
+        {
+          chars[starter].code_point = composite;
+          continue;
+        }
+      }
+      if (c.ccc == 0)
+      {
+        starter = count;
+        last_ccc = 0;
+      }
+      else if (last_ccc != 256)
+        last_ccc = c.ccc;
+      chars[count++] = c;
+    }
+    chars.resize(count);
+  }
+
+  //Returns true if the given code point starts a segment: nothing before it can reorder or compose with it.
+  static inline bool isBoundary(const CodePointProperties & properties, uint8_t mask)
+  {
+    return properties.ccc == 0 && (properties.flags & mask) == 0;
+  }
+
+  //Returns the end of the segment that starts before p: the next boundary or the end of the string.
+  //Returns NULL if the string is not valid UTF-8.
+  static const char * findSegmentEnd(const char * p, const char * end, uint8_t mask)
+  {
+    while (p < end)
+    {
+      if ((unsigned char)(*p) < 0x80)
+        return p;
+      const char * next = p;
+      uint32_t code_point = 0;
+      if (!Utf8Codec::decode(next, end, code_point))
+        return NULL;
+      if (isBoundary(getProperties(code_point), mask))
+        return p;
+      p = next;
+    }
+    return end;
+  }
+
+  //Decompose, reorder and, for NFC, recompose the segment [begin, end) and append it to dst.
+  static bool normalizeSegment(const char * begin, const char * end, NormalizationForm form, NormalizedCharList & chars, std::string & dst)
+  {
+    chars.clear();
+    const char * p = begin;
+    while (p < end)
+    {
+      uint32_t code_point = 0;
+      if (!Utf8Codec::decode(p, end, code_point))
+        return false;
+      decompose(code_point, chars);
+    }
+    reorder(chars);
+    if (form == NormalizationNFC)
+      recompose(chars);
+
+    char buffer[Utf8Codec::MAX_UNITS];
+    for(size_t i=0; i<chars.size(); i++)
+    {
+      const char * buffer_end = Utf8Codec::encode(chars[i].code_point, buffer);
+      dst.append(buffer, buffer_end - buffer);
+    }
+    return true;
+  }
+
+  //Skip a run of ASCII characters. Returns the first non-ASCII character or end.
+  static inline const char * skipAscii(const char * p, const char * end)
+  {
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    while (end - p >= 16)
+    {
+      const int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)p));
+      if (mask != 0)
+      {
+        //index of the first byte with the high bit set
+        int index = 0;
+        while ((mask & (1 << index)) == 0)
+          index++;
+        return p + index;
+      }
+      p += 16;
+    }
+#endif
+    while (p < end && (unsigned char)(*p) < 0x80)
+      p++;
+    return p;
+  }
+
+  //Quick check of the string: returns the start of the first segment that must be normalized, or end if the string is normalized.
+  //Returns NULL if the string is not valid UTF-8.
+  //A segment that fails the quick check is reported even if it is already normalized (NFC_QC_MAYBE).
+  static const char * quickCheck(const char * p, const char * end, uint8_t mask, const char *& segment_end)
+  {
+    const char * boundary = p;
+    uint8_t last_ccc = 0;
+    while (p < end)
+    {
+      const char * ascii_end = skipAscii(p, end);
+      if (ascii_end != p)
+      {
+        boundary = ascii_end - 1;
+        last_ccc = 0;
+        p = ascii_end;
+        continue;
+      }
+
+      const char * next = p;
+      uint32_t code_point = 0;
+      if (!Utf8Codec::decode(next, end, code_point))
+        return NULL;
+      const CodePointProperties & properties = getProperties(code_point);
+      if ((properties.flags & mask) != 0 || (properties.ccc != 0 && last_ccc > properties.ccc))
+      {
+        segment_end = findSegmentEnd(next, end, mask);
+        if (segment_end == NULL)
+          return NULL;
+        return boundary;
+      }
+      if (properties.ccc == 0)
+        boundary = p;
+      last_ccc = properties.ccc;
+      p = next;
+    }
+    segment_end = end;
+    return end;
+  }
+
+  bool is_normalized_utf8(const char * str, size_t length, NormalizationForm form)
+  {
+    const uint8_t mask = getQuickCheckMask(form);
+    const char * p = str;
+    const char * const end = str + length;
+    NormalizedCharList chars;
+    std::string segment;
+    while (p < end)
+    {
+      const char * segment_end = NULL;
+      const char * segment_begin = quickCheck(p, end, mask, segment_end);
+      if (segment_begin == NULL)
+        return false;
+      if (segment_begin == end)
+        return true;
+
+      //the segment may already be normalized if it contains only NFC_QC_MAYBE characters
+      segment.clear();
+      if (!normalizeSegment(segment_begin, segment_end, form, chars, segment))
+        return false;
+      if (segment.size() != (size_t)(segment_end - segment_begin) || segment.compare(0, segment.size(), segment_begin, segment.size()) != 0)
+        return false;
+      p = segment_end;
+    }
+    return true;
+  }
+
+  bool normalize_utf8(const char * src, size_t length, NormalizationForm form, std::string & dst)
+  {
+    dst.clear();
+
+    const uint8_t mask = getQuickCheckMask(form);
+    const char * p = src;
+    const char * const end = src + length;
+    const char * copied = src; //end of the input already appended to dst
+    NormalizedCharList chars;
+    while (p < end)
+    {
+      const char * segment_end = NULL;
+      const char * segment_begin = quickCheck(p, end, mask, segment_end);
+      if (segment_begin == NULL)
+      {
+        dst.clear();
+        return false;
+      }
+      if (segment_begin == end)
+        break;
+
+      if (dst.empty())
+        dst.reserve(length + length / 2);
+      dst.append(copied, segment_begin - copied);
+      if (!normalizeSegment(segment_begin, segment_end, form, chars, dst))
+      {
+        dst.clear();
+        return false;
+      }
+      copied = segment_end;
+      p = segment_end;
+    }
+
+    //copy the normalized remaining of the string, or the whole string if it is already normalized
+    dst.append(copied, end - copied);
+    return true;
+  }
+
+} //namespace win32clipboard
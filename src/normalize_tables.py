@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# Generate normalize_tables.h, the Unicode data used by normalize.cpp.
+# The data is read from the unicodedata module of the Python interpreter.
+#
+# Usage: python3 normalize_tables.py > normalize_tables.h
+#
+
+import unicodedata
+
+# Code points above this limit have no decomposition, combine with nothing and have a combining class of 0
+LIMIT = 0x30000
+BLOCK_BITS = 6
+BLOCK_SIZE = 1 << BLOCK_BITS
+
+# Hangul syllables are decomposed and composed algorithmically
+SBASE, SCOUNT = 0xAC00, 11172
+VBASE, VCOUNT = 0x1161, 21
+TBASE, TCOUNT = 0x11A7, 28
+
+# Flags of the properties
+NFC_NO = 1
+NFC_MAYBE = 2
+NFD_NO = 4
+
+
+def canonical_decomposition(cp):
+    d = unicodedata.decomposition(chr(cp))
+    if not d or d.startswith('<'):
+        return None
+    return [int(x, 16) for x in d.split()]
+
+
+def full_decomposition(cp):
+    d = canonical_decomposition(cp)
+    if d is None:
+        return [cp]
+    out = []
+    for c in d:
+        out += full_decomposition(c)
+    return out
+
+
+def main():
+    decompositions = {}
+    compositions = {}
+    for cp in range(LIMIT):
+        d = canonical_decomposition(cp)
+        if d is None:
+            continue
+        decompositions[cp] = full_decomposition(cp)
+        # primary composites: pairs that are not excluded from the composition
+        if len(d) == 2 and unicodedata.normalize('NFC', chr(cp)) == chr(cp):
+            compositions[(d[0], d[1])] = cp
+
+    seconds = set(second for (first, second) in compositions)
+    seconds.update(range(VBASE, VBASE + VCOUNT))
+    seconds.update(range(TBASE + 1, TBASE + TCOUNT))
+
+    # properties of each code point: combining class and quick check flags
+    properties = [(0, 0)]
+    property_index = {(0, 0): 0}
+    values = []
+    for cp in range(LIMIT):
+        c = chr(cp)
+        flags = 0
+        if unicodedata.normalize('NFC', c) != c:
+            flags |= NFC_NO
+        elif cp in seconds:
+            flags |= NFC_MAYBE
+        if unicodedata.normalize('NFD', c) != c:
+            flags |= NFD_NO
+        key = (unicodedata.combining(c), flags)
+        if key not in property_index:
+            property_index[key] = len(properties)
+            properties.append(key)
+        values.append(property_index[key])
+
+    # two-stage table: the blocks of code points with the same properties are stored once
+    blocks = []
+    block_index = {}
+    stage1 = []
+    for start in range(0, LIMIT, BLOCK_SIZE):
+        block = tuple(values[start:start + BLOCK_SIZE])
+        if block not in block_index:
+            block_index[block] = len(blocks)
+            blocks.append(block)
+        stage1.append(block_index[block])
+
+    assert len(properties) <= 256 and len(blocks) <= 256
+
+    decomposition_keys = sorted(decompositions)
+    decomposition_offsets = [0]
+    decomposition_data = []
+    for cp in decomposition_keys:
+        decomposition_data += decompositions[cp]
+        decomposition_offsets.append(len(decomposition_data))
+    assert decomposition_offsets[-1] < 65536
+
+    def emit(name, ctype, items, per_line, fmt):
+        print('  static const %s %s[%d] = {' % (ctype, name, len(items)))
+        for i in range(0, len(items), per_line):
+            print('    ' + ', '.join(fmt(x) for x in items[i:i + per_line]) + ',')
+        print('  };')
+        print('')
+
+    print('// Generated by normalize_tables.py from the data of Unicode %s. Do not edit.' % unicodedata.unidata_version)
+    print('')
+    print('#ifndef WIN32CLIPBOARD_NORMALIZE_TABLES_H')
+    print('#define WIN32CLIPBOARD_NORMALIZE_TABLES_H')
+    print('')
+    print('#include <stdint.h>')
+    print('')
+    print('namespace win32clipboard')
+    print('{')
+    print('  static const uint32_t PROPERTIES_LIMIT = 0x%X;' % LIMIT)
+    print('  static const uint32_t PROPERTIES_BLOCK_BITS = %d;' % BLOCK_BITS)
+    print('')
+    print('  //combining class and quick check flags')
+    emit('PROPERTIES', 'CodePointProperties', properties, 8, lambda p: '{%d,%d}' % p)
+    print('  //index of the block of properties of each block of %d code points' % BLOCK_SIZE)
+    emit('PROPERTIES_STAGE1', 'uint8_t', stage1, 32, str)
+    print('  //index of the properties of each code point of each block')
+    emit('PROPERTIES_STAGE2', 'uint8_t', [v for b in blocks for v in b], 32, str)
+    print('  //code points that have a canonical decomposition, except the hangul syllables')
+    emit('DECOMPOSITION_KEYS', 'uint32_t', decomposition_keys, 12, lambda x: '0x%X' % x)
+    print('  //offset of the full canonical decomposition of each code point in DECOMPOSITION_DATA')
+    emit('DECOMPOSITION_OFFSETS', 'uint16_t', decomposition_offsets, 16, str)
+    emit('DECOMPOSITION_DATA', 'uint32_t', decomposition_data, 12, lambda x: '0x%X' % x)
+    print('  //primary composites, sorted by pair of code points')
+    pairs = sorted(compositions.items())
+    emit('COMPOSITIONS', 'CompositionPair', pairs, 4, lambda p: '{0x%X,0x%X,0x%X}' % (p[0][0], p[0][1], p[1]))
+    print('} //namespace win32clipboard')
+    print('')
+    print('#endif //WIN32CLIPBOARD_NORMALIZE_TABLES_H')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,826 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include "win32clipboard/png.h"
+#include "deflate.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static const unsigned char PNG_SIGNATURE[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+
+  // Color types of the IHDR chunk
+  static const unsigned COLOR_GRAY       = 0;
+  static const unsigned COLOR_RGB        = 2;
+  static const unsigned COLOR_PALETTE    = 3;
+  static const unsigned COLOR_GRAY_ALPHA = 4;
+  static const unsigned COLOR_RGBA       = 6;
+
+  // Row filter types
+  static const unsigned FILTER_NONE    = 0;
+  static const unsigned FILTER_SUB     = 1;
+  static const unsigned FILTER_UP      = 2;
+  static const unsigned FILTER_AVERAGE = 3;
+  static const unsigned FILTER_PAETH   = 4;
+  static const unsigned NUM_FILTERS    = 5;
+
+  static const uint32_t MAX_DIMENSION = 0x7FFFFFFF;
+
+  // Amount of filtered data compressed by each thread
+  static const size_t MIN_BLOCK_SIZE = 256 * 1024;
+  static const size_t MAX_BLOCK_SIZE = 64 * 1024 * 1024; //keeps each IDAT chunk far below the 2^31 bytes limit
+  static const size_t DICTIONARY_SIZE = 32768;
+
+  // Largest expansion ratio of deflate: 258 bytes for a match of ~2 bits
+  static const size_t MAX_INFLATE_RATIO = 1032;
+
+  static inline uint32_t read32be(const unsigned char * p)
+  {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+  }
+
+  static inline void write32be(unsigned char * p, uint32_t value)
+  {
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >>  8);
+    p[3] = (unsigned char)(value      );
+  }
+
+  static void appendChunk(std::string & png, const char * type, const unsigned char * data, size_t size)
+  {
+    unsigned char header[8];
+    write32be(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+    png.append((const char *)header, 8);
+    if (size > 0)
+      png.append((const char *)data, size);
+
+    unsigned char crc[4];
+    write32be(crc, crc32(crc32(0, type, 4), data, size));
+    png.append((const char *)crc, 4);
+  }
+
+  // Call func(index) for each index in [0, count) using up to num_threads threads.
+  template <typename Func>
+  static void runParallel(size_t num_threads, size_t count, Func func)
+  {
+    if (num_threads > count)
+      num_threads = count;
+    if (num_threads <= 1)
+    {
+      for(size_t i=0; i<count; i++)
+        func(i);
+      return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+      for(size_t i = next++; i < count; i = next++)
+        func(i);
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+      for(size_t i=1; i<num_threads; i++)
+        threads.push_back(std::thread(worker));
+    }
+    catch(const std::exception &)
+    {
+      //not enough resources for more threads: the remaining work is done by the current thread
+    }
+    worker();
+    for(size_t i=0; i<threads.size(); i++)
+      threads[i].join();
+  }
+
+  static inline unsigned char paethPredictor(int a, int b, int c)
+  {
+    const int pa = abs(b - c);
+    const int pb = abs(a - c);
+    const int pc = abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc)
+      return (unsigned char)a;
+    if (pb <= pc)
+      return (unsigned char)b;
+    return (unsigned char)c;
+  }
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+  static inline __m128i abs16(__m128i x)
+  {
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+  }
+
+  static inline __m128i select128(__m128i mask, __m128i a, __m128i b)
+  {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+
+  // Paeth predictor of 8 samples stored in 16 bit lanes
+  static inline __m128i paethPredictor16(__m128i a, __m128i b, __m128i c)
+  {
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = abs16(_mm_add_epi16(pa, pb));
+    pa = abs16(pa);
+    pb = abs16(pb);
+    const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    const __m128i predictor = select128(_mm_cmpeq_epi16(smallest, pb), b, c);
+    return select128(_mm_cmpeq_epi16(smallest, pa), a, predictor);
+  }
+
+  // Paeth predictor of 16 samples
+  static inline __m128i paethPredictor8(__m128i a, __m128i b, __m128i c)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = paethPredictor16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+    const __m128i hi = paethPredictor16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+    return _mm_packus_epi16(lo, hi);
+  }
+
+  // Rounded down average of 16 samples
+  static inline __m128i average8(__m128i a, __m128i b)
+  {
+    const __m128i odd = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1));
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), odd);
+  }
+#endif
+
+  //------------------------------------------------------------------------------------------------
+  // Encoder
+  //------------------------------------------------------------------------------------------------
+
+  // Apply a filter to a row. The samples before the row (i < bpp) are considered zero.
+  static void filterRow(unsigned filter, const unsigned char * raw, const unsigned char * prior, size_t size, size_t bpp, unsigned char * out)
+  {
+    size_t i = 0;
+
+    //first pixel: the left neighbours are zero
+    for(; i < bpp && i < size; i++)
+    {
+      switch(filter)
+      {
+      case FILTER_SUB:     out[i] = raw[i]; break;
+      case FILTER_AVERAGE: out[i] = (unsigned char)(raw[i] - (prior[i] >> 1)); break;
+      case FILTER_UP:
+      case FILTER_PAETH:   out[i] = (unsigned char)(raw[i] - prior[i]); break;
+      default:             out[i] = raw[i]; break;
+      };
+    }
+
+    //the other pixels only depend on unfiltered samples: no dependency between iterations
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m128i x = _mm_loadu_si128((const __m128i *)(raw + i));
+      const __m128i a = _mm_loadu_si128((const __m128i *)(raw + i - bpp));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(prior + i));
+      __m128i result;
+      switch(filter)
+      {
+      case FILTER_SUB:     result = _mm_sub_epi8(x, a); break;
+      case FILTER_UP:      result = _mm_sub_epi8(x, b); break;
+      case FILTER_AVERAGE: result = _mm_sub_epi8(x, average8(a, b)); break;
+      case FILTER_PAETH:
+        {
+          const __m128i c = _mm_loadu_si128((const __m128i *)(prior + i - bpp));
+          result = _mm_sub_epi8(x, paethPredictor8(a, b, c));
+        }
+        break;
+      default:             result = x; break;
+      };
+      _mm_storeu_si128((__m128i *)(out + i), result);
+    }
+#endif
+
+    for(; i < size; i++)
+    {
+      switch(filter)
+      {
+      case FILTER_SUB:     out[i] = (unsigned char)(raw[i] - raw[i - bpp]); break;
+      case FILTER_UP:      out[i] = (unsigned char)(raw[i] - prior[i]); break;
+      case FILTER_AVERAGE: out[i] = (unsigned char)(raw[i] - ((raw[i - bpp] + prior[i]) >> 1)); break;
+      case FILTER_PAETH:   out[i] = (unsigned char)(raw[i] - paethPredictor(raw[i - bpp], prior[i], prior[i - bpp])); break;
+      default:             out[i] = raw[i]; break;
+      };
+    }
+  }
+
+  // Score of a filtered row: sum of the absolute values of the samples, interpreted as signed bytes.
+  // The filter with the smallest score usually compresses best.
+  static uint64_t scoreRow(const unsigned char * row, size_t size)
+  {
+    uint64_t score = 0;
+    size_t i = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for(; i + 16 <= size; i += 16)
+    {
+      const __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+      const __m128i magnitude = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(magnitude, zero));
+    }
+    score = (uint64_t)_mm_cvtsi128_si32(sum) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#endif
+
+    for(; i < size; i++)
+      score += (row[i] < 128 ? row[i] : 256 - row[i]);
+    return score;
+  }
+
+  static bool isOpaque(const Image & image)
+  {
+    const unsigned char * pixels = image.GetPixels();
+    const size_t count = image.GetWidth() * image.GetHeight();
+    unsigned char alpha = 0xFF;
+    for(size_t i=0; i<count; i++)
+      alpha &= pixels[4*i + 3];
+    return alpha == 0xFF;
+  }
+
+  struct EncoderBlock
+  {
+    size_t first_row;
+    size_t num_rows;
+    size_t offset;        //offset of the block in the filtered data
+    size_t size;          //size of the block in the filtered data
+    uint32_t adler;       //Adler-32 checksum of the filtered data of the block
+    std::string chunk;    //compressed data of the block, as a complete IDAT chunk
+  };
+
+  bool encode_png(const Image & image, std::string & png, size_t num_threads)
+  {
+    const size_t width = image.GetWidth();
+    const size_t height = image.GetHeight();
+    if (image.GetPixels() == NULL || width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION)
+      return false;
+
+    if (num_threads == 0)
+      num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0)
+      num_threads = 1;
+
+    //drop the alpha channel when it does not carry information
+    const bool opaque = isOpaque(image);
+    const size_t bpp = (opaque ? 3 : 4);
+    const size_t row_size = width * bpp;
+    const size_t filtered_row_size = row_size + 1;
+    const size_t filtered_size = filtered_row_size * height;
+
+    //split the rows in blocks, one block per thread for big images
+    size_t block_size = (filtered_size + num_threads - 1) / num_threads;
+    if (block_size < MIN_BLOCK_SIZE)
+      block_size = MIN_BLOCK_SIZE;
+    if (block_size > MAX_BLOCK_SIZE)
+      block_size = MAX_BLOCK_SIZE;
+    const size_t rows_per_block = (block_size + filtered_row_size - 1) / filtered_row_size;
+    const size_t num_blocks = (height + rows_per_block - 1) / rows_per_block;
+
+    std::vector<EncoderBlock> blocks(num_blocks);
+    for(size_t i=0; i<num_blocks; i++)
+    {
+      EncoderBlock & block = blocks[i];
+      block.first_row = i * rows_per_block;
+      block.num_rows = std::min(rows_per_block, height - block.first_row);
+      block.offset = block.first_row * filtered_row_size;
+      block.size = block.num_rows * filtered_row_size;
+      block.adler = 1;
+    }
+
+    //filter the rows of each block
+    std::vector<unsigned char> filtered(filtered_size);
+    const std::vector<unsigned char> zero_row(row_size, 0);
+    runParallel(num_threads, num_blocks, [&](size_t index)
+    {
+      const EncoderBlock & block = blocks[index];
+      const size_t stride = image.GetStride();
+      const unsigned char * pixels = image.GetPixels();
+
+      //RGB rows of the block, preceded by the last row of the previous block
+      std::vector<unsigned char> rgb;
+      const size_t first_rgb_row = (block.first_row > 0 ? block.first_row - 1 : 0);
+      if (opaque)
+      {
+        const size_t num_rgb_rows = block.first_row + block.num_rows - first_rgb_row;
+        rgb.resize(num_rgb_rows * row_size);
+        for(size_t y=0; y<num_rgb_rows; y++)
+        {
+          const unsigned char * src = pixels + (first_rgb_row + y) * stride;
+          unsigned char * dst = &rgb[y * row_size];
+          for(size_t x=0; x<width; x++)
+          {
+            dst[3*x + 0] = src[4*x + 0];
+            dst[3*x + 1] = src[4*x + 1];
+            dst[3*x + 2] = src[4*x + 2];
+          }
+        }
+      }
+
+      std::vector<unsigned char> candidates(NUM_FILTERS * row_size);
+      for(size_t y=block.first_row; y<block.first_row + block.num_rows; y++)
+      {
+        const unsigned char * raw   = (opaque ? &rgb[(y - first_rgb_row) * row_size] : pixels + y * stride);
+        const unsigned char * prior = &zero_row[0];
+        if (y > 0)
+          prior = (opaque ? raw - row_size : raw - stride);
+
+        //try all filters and keep the one with the smallest score
+        unsigned best_filter = FILTER_NONE;
+        uint64_t best_score = 0;
+        for(unsigned filter=FILTER_NONE; filter<NUM_FILTERS; filter++)
+        {
+          unsigned char * candidate = &candidates[filter * row_size];
+          filterRow(filter, raw, prior, row_size, bpp, candidate);
+          const uint64_t score = scoreRow(candidate, row_size);
+          if (filter == FILTER_NONE || score < best_score)
+          {
+            best_filter = filter;
+            best_score = score;
+          }
+        }
+
+        unsigned char * out = &filtered[y * filtered_row_size];
+        out[0] = (unsigned char)best_filter;
+        memcpy(out + 1, &candidates[best_filter * row_size], row_size);
+      }
+    });
+
+    //compress each block. Each block uses the end of the previous block as dictionary
+    //and ends on a byte boundary so that the compressed blocks can be concatenated.
+    runParallel(num_threads, num_blocks, [&](size_t index)
+    {
+      EncoderBlock & block = blocks[index];
+      const bool last = (index + 1 == num_blocks);
+      const size_t dictionary_size = std::min(block.offset, DICTIONARY_SIZE);
+
+      std::string & chunk = block.chunk;
+      chunk.assign(8, '\0'); //chunk length and type
+      if (index == 0)
+      {
+        //zlib header: deflate with a 32K window, default compression
+        chunk.push_back((char)0x78);
+        chunk.push_back((char)0x9C);
+      }
+      deflate_raw(&filtered[block.offset], block.size, dictionary_size, last, chunk);
+      block.adler = adler32(1, &filtered[block.offset], block.size);
+
+      unsigned char * header = (unsigned char *)&chunk[0];
+      write32be(header, (uint32_t)(chunk.size() - 8));
+      memcpy(header + 4, "IDAT", 4);
+      unsigned char crc[4];
+      write32be(crc, crc32(0, &chunk[4], chunk.size() - 4));
+      chunk.append((const char *)crc, 4);
+    });
+
+    //assemble the file
+    png.assign((const char *)PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+
+    unsigned char ihdr[13];
+    write32be(ihdr + 0, (uint32_t)width);
+    write32be(ihdr + 4, (uint32_t)height);
+    ihdr[8] = 8; //bit depth
+    ihdr[9] = (unsigned char)(opaque ? COLOR_RGB : COLOR_RGBA);
+    ihdr[10] = 0; //deflate
+    ihdr[11] = 0; //adaptive filtering
+    ihdr[12] = 0; //no interlace
+    appendChunk(png, "IHDR", ihdr, sizeof(ihdr));
+
+    uint32_t adler = 1;
+    for(size_t i=0; i<num_blocks; i++)
+    {
+      png.append(blocks[i].chunk);
+      adler = adler32_combine(adler, blocks[i].adler, blocks[i].size);
+    }
+
+    //the zlib checksum is only known once all blocks are compressed: it is stored in its own IDAT chunk
+    unsigned char trailer[4];
+    write32be(trailer, adler);
+    appendChunk(png, "IDAT", trailer, sizeof(trailer));
+
+    appendChunk(png, "IEND", NULL, 0);
+
+    return true;
+  }
+
+  //------------------------------------------------------------------------------------------------
+  // Decoder
+  //------------------------------------------------------------------------------------------------
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+  template <size_t BPP>
+  static inline __m128i loadPixel(const unsigned char * p)
+  {
+    uint32_t value = 0;
+    memcpy(&value, p, BPP);
+    return _mm_cvtsi32_si128((int)value);
+  }
+
+  template <size_t BPP>
+  static inline void storePixel(unsigned char * p, __m128i pixel)
+  {
+    const uint32_t value = (uint32_t)_mm_cvtsi128_si32(pixel);
+    memcpy(p, &value, BPP);
+  }
+
+  // Reconstruction of 3 or 4 bytes per pixel rows, one pixel at a time.
+  // Each pixel depends on the previous one: the samples of a pixel are processed in parallel instead.
+  template <size_t BPP>
+  static void unfilterSub(unsigned char * row, size_t size)
+  {
+    __m128i a = _mm_setzero_si128();
+    for(size_t i=0; i + BPP <= size; i += BPP)
+    {
+      a = _mm_add_epi8(a, loadPixel<BPP>(row + i));
+      storePixel<BPP>(row + i, a);
+    }
+  }
+
+  template <size_t BPP>
+  static void unfilterAverage(unsigned char * row, const unsigned char * prior, size_t size)
+  {
+    __m128i a = _mm_setzero_si128();
+    for(size_t i=0; i + BPP <= size; i += BPP)
+    {
+      const __m128i b = loadPixel<BPP>(prior + i);
+      a = _mm_add_epi8(loadPixel<BPP>(row + i), average8(a, b));
+      storePixel<BPP>(row + i, a);
+    }
+  }
+
+  template <size_t BPP>
+  static void unfilterPaeth(unsigned char * row, const unsigned char * prior, size_t size)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero;
+    __m128i c = zero;
+    for(size_t i=0; i + BPP <= size; i += BPP)
+    {
+      const __m128i b = _mm_unpacklo_epi8(loadPixel<BPP>(prior + i), zero);
+      const __m128i predictor = _mm_packus_epi16(paethPredictor16(a, b, c), zero);
+      const __m128i x = _mm_add_epi8(loadPixel<BPP>(row + i), predictor);
+      storePixel<BPP>(row + i, x);
+      a = _mm_unpacklo_epi8(x, zero);
+      c = b;
+    }
+  }
+#endif
+
+  // Reconstruct a filtered row in place. The size of the row is a multiple of bpp.
+  static bool unfilterRow(unsigned filter, unsigned char * row, const unsigned char * prior, size_t size, size_t bpp)
+  {
+    switch(filter)
+    {
+    case FILTER_NONE:
+      return true;
+    case FILTER_UP:
+      {
+        size_t i = 0;
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+        for(; i + 16 <= size; i += 16)
+        {
+          const __m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+          const __m128i b = _mm_loadu_si128((const __m128i *)(prior + i));
+          _mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+        }
+#endif
+        for(; i < size; i++)
+          row[i] = (unsigned char)(row[i] + prior[i]);
+      }
+      return true;
+    case FILTER_SUB:
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      if (bpp == 3) { unfilterSub<3>(row, size); return true; }
+      if (bpp == 4) { unfilterSub<4>(row, size); return true; }
+#endif
+      for(size_t i=bpp; i<size; i++)
+        row[i] = (unsigned char)(row[i] + row[i - bpp]);
+      return true;
+    case FILTER_AVERAGE:
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      if (bpp == 3) { unfilterAverage<3>(row, prior, size); return true; }
+      if (bpp == 4) { unfilterAverage<4>(row, prior, size); return true; }
+#endif
+      for(size_t i=0; i<bpp && i<size; i++)
+        row[i] = (unsigned char)(row[i] + (prior[i] >> 1));
+      for(size_t i=bpp; i<size; i++)
+        row[i] = (unsigned char)(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+      return true;
+    case FILTER_PAETH:
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      if (bpp == 3) { unfilterPaeth<3>(row, prior, size); return true; }
+      if (bpp == 4) { unfilterPaeth<4>(row, prior, size); return true; }
+#endif
+      for(size_t i=0; i<bpp && i<size; i++)
+        row[i] = (unsigned char)(row[i] + prior[i]);
+      for(size_t i=bpp; i<size; i++)
+        row[i] = (unsigned char)(row[i] + paethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+      return true;
+    default:
+      return false;
+    };
+  }
+
+  struct PngInfo
+  {
+    uint32_t width;
+    uint32_t height;
+    unsigned bit_depth;
+    unsigned color_type;
+    unsigned channels;
+    unsigned char palette[256][4];  //RGBA
+    size_t palette_size;
+    bool has_key;                   //true if a transparent color is defined for gray or RGB images
+    uint32_t key[3];
+  };
+
+  // Returns the sample at the given index of a row
+  static inline uint32_t getSample(const unsigned char * row, size_t index, unsigned bit_depth)
+  {
+    if (bit_depth == 8)
+      return row[index];
+    if (bit_depth == 16)
+      return ((uint32_t)row[2*index] << 8) | row[2*index + 1];
+
+    //samples smaller than a byte are packed from the most significant bit
+    const size_t bit = index * bit_depth;
+    const unsigned shift = (unsigned)(8 - bit_depth - (bit & 7));
+    return (row[bit >> 3] >> shift) & ((1u << bit_depth) - 1);
+  }
+
+  // Scale a sample to 8 bits
+  static inline unsigned char toByte(uint32_t sample, unsigned bit_depth)
+  {
+    if (bit_depth == 8)
+      return (unsigned char)sample;
+    if (bit_depth == 16)
+      return (unsigned char)(sample >> 8);
+    return (unsigned char)(sample * 255 / ((1u << bit_depth) - 1));
+  }
+
+  // Convert a reconstructed row to RGBA pixels
+  static bool convertRow(const PngInfo & info, const unsigned char * row, unsigned char * dst)
+  {
+    const size_t width = info.width;
+    const unsigned depth = info.bit_depth;
+
+    //fast paths for the common formats
+    if (depth == 8 && info.color_type == COLOR_RGBA)
+    {
+      memcpy(dst, row, width * 4);
+      return true;
+    }
+    if (depth == 8 && info.color_type == COLOR_RGB && !info.has_key)
+    {
+      //expanding as BGR and swapping the channels keeps both passes vectorized
+      expand_bgr_to_rgba(row, dst, width);
+      swap_red_blue(dst, dst, width, 0);
+      return true;
+    }
+
+    for(size_t x=0; x<width; x++)
+    {
+      unsigned char * d = dst + 4*x;
+      switch(info.color_type)
+      {
+      case COLOR_GRAY:
+        {
+          const uint32_t gray = getSample(row, x, depth);
+          d[0] = d[1] = d[2] = toByte(gray, depth);
+          d[3] = (info.has_key && gray == info.key[0]) ? 0 : 0xFF;
+        }
+        break;
+      case COLOR_RGB:
+        {
+          const uint32_t r = getSample(row, 3*x + 0, depth);
+          const uint32_t g = getSample(row, 3*x + 1, depth);
+          const uint32_t b = getSample(row, 3*x + 2, depth);
+          d[0] = toByte(r, depth);
+          d[1] = toByte(g, depth);
+          d[2] = toByte(b, depth);
+          d[3] = (info.has_key && r == info.key[0] && g == info.key[1] && b == info.key[2]) ? 0 : 0xFF;
+        }
+        break;
+      case COLOR_PALETTE:
+        {
+          const uint32_t index = getSample(row, x, depth);
+          if (index >= info.palette_size)
+            return false;
+          memcpy(d, info.palette[index], 4);
+        }
+        break;
+      case COLOR_GRAY_ALPHA:
+        d[0] = d[1] = d[2] = toByte(getSample(row, 2*x + 0, depth), depth);
+        d[3] = toByte(getSample(row, 2*x + 1, depth), depth);
+        break;
+      default: //COLOR_RGBA
+        d[0] = toByte(getSample(row, 4*x + 0, depth), depth);
+        d[1] = toByte(getSample(row, 4*x + 1, depth), depth);
+        d[2] = toByte(getSample(row, 4*x + 2, depth), depth);
+        d[3] = toByte(getSample(row, 4*x + 3, depth), depth);
+        break;
+      };
+    }
+    return true;
+  }
+
+  static bool parseHeader(const unsigned char * data, size_t size, PngInfo & info)
+  {
+    if (size != 13)
+      return false;
+
+    info.width = read32be(data);
+    info.height = read32be(data + 4);
+    info.bit_depth = data[8];
+    info.color_type = data[9];
+    if (info.width == 0 || info.height == 0 || info.width > MAX_DIMENSION || info.height > MAX_DIMENSION)
+      return false;
+    if (data[10] != 0 || data[11] != 0) //compression and filter methods
+      return false;
+    if (data[12] != 0) //interlaced images are not supported
+      return false;
+
+    //allowed bit depths for each color type
+    const unsigned depth = info.bit_depth;
+    switch(info.color_type)
+    {
+    case COLOR_GRAY:
+      info.channels = 1;
+      return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+    case COLOR_PALETTE:
+      info.channels = 1;
+      return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case COLOR_RGB:
+      info.channels = 3;
+      return depth == 8 || depth == 16;
+    case COLOR_GRAY_ALPHA:
+      info.channels = 2;
+      return depth == 8 || depth == 16;
+    case COLOR_RGBA:
+      info.channels = 4;
+      return depth == 8 || depth == 16;
+    default:
+      return false;
+    };
+  }
+
+  bool decode_png(const void * buffer, size_t size, Image & image)
+  {
+    const unsigned char * bytes = (const unsigned char *)buffer;
+    if (bytes == NULL || size < sizeof(PNG_SIGNATURE) || memcmp(bytes, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+      return false;
+
+    PngInfo info;
+    memset(&info, 0, sizeof(info));
+    bool has_header = false;
+    bool has_end = false;
+    std::string idat;
+
+    //read the chunks
+    size_t pos = sizeof(PNG_SIGNATURE);
+    while (!has_end)
+    {
+      if (size - pos < 12)
+        return false;
+      const size_t length = read32be(bytes + pos);
+      if (length > size - pos - 12)
+        return false;
+      const unsigned char * type = bytes + pos + 4;
+      const unsigned char * data = bytes + pos + 8;
+      if (crc32(0, type, length + 4) != read32be(data + length))
+        return false;
+      pos += length + 12;
+
+      //IHDR must be the first chunk
+      const bool is_header = (memcmp(type, "IHDR", 4) == 0);
+      if (is_header != !has_header)
+        return false;
+
+      if (is_header)
+      {
+        if (!parseHeader(data, length, info))
+          return false;
+        has_header = true;
+      }
+      else if (memcmp(type, "PLTE", 4) == 0)
+      {
+        if (length % 3 != 0 || length / 3 > 256 || length == 0)
+          return false;
+        info.palette_size = length / 3;
+        for(size_t i=0; i<info.palette_size; i++)
+        {
+          memcpy(info.palette[i], data + 3*i, 3);
+          info.palette[i][3] = 0xFF;
+        }
+      }
+      else if (memcmp(type, "tRNS", 4) == 0)
+      {
+        if (info.color_type == COLOR_PALETTE)
+        {
+          if (length > info.palette_size)
+            return false;
+          for(size_t i=0; i<length; i++)
+            info.palette[i][3] = data[i];
+        }
+        else if (info.color_type == COLOR_GRAY && length == 2)
+        {
+          info.has_key = true;
+          info.key[0] = (data[0] << 8) | data[1];
+        }
+        else if (info.color_type == COLOR_RGB && length == 6)
+        {
+          info.has_key = true;
+          for(size_t i=0; i<3; i++)
+            info.key[i] = (data[2*i] << 8) | data[2*i + 1];
+        }
+      }
+      else if (memcmp(type, "IDAT", 4) == 0)
+      {
+        idat.append((const char *)data, length);
+      }
+      else if (memcmp(type, "IEND", 4) == 0)
+      {
+        has_end = true;
+      }
+      else if ((type[0] & 0x20) == 0)
+      {
+        //unknown critical chunk
+        return false;
+      }
+    }
+    if (info.color_type == COLOR_PALETTE && info.palette_size == 0)
+      return false;
+
+    //size of the reconstructed data
+    const uint64_t row_bits = (uint64_t)info.width * info.channels * info.bit_depth;
+    const uint64_t row_size = (row_bits + 7) / 8;
+    const uint64_t filtered_row_size = row_size + 1;
+    const uint64_t filtered_size = filtered_row_size * info.height;
+    const uint64_t image_size = (uint64_t)info.width * info.height * 4;
+    if (filtered_size / info.height != filtered_row_size || filtered_size > (size_t)-1 || image_size > (size_t)-1)
+      return false;
+
+    //reject files which would not decompress to the expected size before allocating the buffers
+    if (filtered_size / MAX_INFLATE_RATIO > idat.size())
+      return false;
+
+    std::vector<unsigned char> filtered((size_t)filtered_size);
+    if (!inflate_zlib(idat.data(), idat.size(), &filtered[0], filtered.size()))
+      return false;
+
+    //reconstruct each row in place and convert it to the output image
+    const size_t bpp = (info.channels * info.bit_depth + 7) / 8;
+    const std::vector<unsigned char> zero_row((size_t)row_size, 0);
+    image.Create(info.width, info.height);
+    unsigned char * pixels = image.GetPixels();
+    const unsigned char * prior = &zero_row[0];
+    for(size_t y=0; y<info.height; y++)
+    {
+      unsigned char * row = &filtered[y * (size_t)filtered_row_size];
+      if (!unfilterRow(row[0], row + 1, prior, (size_t)row_size, bpp))
+        return false;
+      if (!convertRow(info, row + 1, pixels + y * image.GetStride()))
+        return false;
+      prior = row + 1;
+    }
+
+    return true;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,132 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "win32clipboard/result.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace win32clipboard
+{
+  static const char * OPERATION_NAMES[ClipboardStats::NUM_OPERATIONS] = {
+    "Empty",
+    "Contains",
+    "Hash",
+    "Set",
+    "Get",
+    "Convert",
+    "Find",
+  };
+
+  static const char * KIND_NAMES[ClipboardStats::NUM_KINDS] = {
+    "text",
+    "unicode text",
+    "image",
+    "binary",
+    "HTML",
+    "drag and drop files",
+    "all formats",
+  };
+
+  static const char * getCodeDescription(ClipboardResult::Code iCode)
+  {
+    switch(iCode)
+    {
+    case ClipboardResult::CodeSuccess:
+      return "the operation was successful";
+    case ClipboardResult::CodeFailed:
+      return "the operation failed";
+    case ClipboardResult::CodeOpenFailed:
+      return "the clipboard could not be opened";
+    case ClipboardResult::CodeEmptyFailed:
+      return "the clipboard could not be emptied";
+    case ClipboardResult::CodeFormatNotAvailable:
+      return "the clipboard does not contain the format";
+    case ClipboardResult::CodeOutOfMemory:
+      return "the clipboard memory could not be allocated";
+    case ClipboardResult::CodeLockFailed:
+      return "the clipboard memory could not be locked";
+    case ClipboardResult::CodeSetDataFailed:
+      return "the data could not be placed on the clipboard";
+    };
+    return "unknown error";
+  }
+
+  //Append the message of the system to the description of a system error code.
+  static void appendSystemMessage(uint32_t iSystemCode, std::string & oDescription)
+  {
+    char buffer[64];
+    sprintf(buffer, " (error %u", (unsigned int)iSystemCode);
+    oDescription += buffer;
+
+#ifdef _WIN32
+    char message[1024] = {0};
+    DWORD length = ::FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+                                    NULL,
+                                    (DWORD)iSystemCode,
+                                    MAKELANGID(LANG_NEUTRAL,SUBLANG_DEFAULT),
+                                    message,
+                                    sizeof(message) - 1,
+                                    NULL);
+    //remove the line break at the end of the system messages
+    while (length > 0 && (message[length-1] == '\r' || message[length-1] == '\n'))
+      length--;
+    if (length > 0)
+    {
+      oDescription += ", ";
+      oDescription.append(message, length);
+    }
+#endif
+
+    oDescription += ")";
+  }
+
+  bool ClipboardResult::IsSuccess() const
+  {
+    return (code == CodeSuccess);
+  }
+
+  std::string ClipboardResult::GetDescription() const
+  {
+    std::string description;
+    if ((size_t)operation < ClipboardStats::NUM_OPERATIONS && (size_t)kind < ClipboardStats::NUM_KINDS)
+    {
+      description += OPERATION_NAMES[operation];
+      description += " ";
+      description += KIND_NAMES[kind];
+      if (IsSuccess())
+        return description + " succeeded";
+      description += " failed: ";
+    }
+    description += getCodeDescription(code);
+    if (system_code != 0)
+      appendSystemMessage(system_code, description);
+    return description;
+  }
+
+} //namespace win32clipboard
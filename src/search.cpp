@@ -0,0 +1,342 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <string.h>
+
+#include "win32clipboard/search.h"
+#include "win32clipboard/transcode.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static const size_t NUM_BYTES = 256;
+
+  static inline unsigned lowestBit(unsigned mask)
+  {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    unsigned index = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      index++;
+    }
+    return index;
+#endif
+  }
+
+  size_t find_bytes(const char * data, size_t size, const char * pattern, size_t pattern_size, size_t alignment)
+  {
+    if (alignment == 0)
+      alignment = 1;
+    if (pattern_size == 0)
+      return 0;
+    if (pattern_size > size)
+      return SEARCH_NOT_FOUND;
+
+    const size_t last = size - pattern_size; //last candidate position
+    size_t i = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    //keep the positions where both the first and the last byte of the pattern match
+    if (pattern_size > 1)
+    {
+      const __m128i first_byte = _mm_set1_epi8(pattern[0]);
+      const __m128i last_byte = _mm_set1_epi8(pattern[pattern_size - 1]);
+      for(; i + 16 <= last + 1; i += 16)
+      {
+        const __m128i first_block = _mm_loadu_si128((const __m128i *)(data + i));
+        const __m128i last_block = _mm_loadu_si128((const __m128i *)(data + i + pattern_size - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_byte), _mm_cmpeq_epi8(last_block, last_byte)));
+        while (mask != 0)
+        {
+          const size_t position = i + lowestBit(mask);
+          if (position % alignment == 0 && memcmp(data + position + 1, pattern + 1, pattern_size - 2) == 0)
+            return position;
+          mask &= mask - 1;
+        }
+      }
+    }
+#endif
+
+    //remaining positions
+    while (i <= last)
+    {
+      const char * found = (const char *)memchr(data + i, pattern[0], last - i + 1);
+      if (found == NULL)
+        return SEARCH_NOT_FOUND;
+      const size_t position = (size_t)(found - data);
+      if (position % alignment == 0 && memcmp(found, pattern, pattern_size) == 0)
+        return position;
+      i = position + 1;
+    }
+    return SEARCH_NOT_FOUND;
+  }
+
+  bool starts_with(const char * data, size_t size, const char * pattern, size_t pattern_size)
+  {
+    return (pattern_size <= size && memcmp(data, pattern, pattern_size) == 0);
+  }
+
+  bool ends_with(const char * data, size_t size, const char * pattern, size_t pattern_size)
+  {
+    return (pattern_size <= size && memcmp(data + size - pattern_size, pattern, pattern_size) == 0);
+  }
+
+  PatternSet::PatternSet(const std::vector<std::string> & iPatterns, Encoding iEncoding) :
+    mEncoding(iEncoding),
+    mAlignment(iEncoding == EncodingUtf16 ? sizeof(char16_t) : 1),
+    mSizes(iPatterns.size(), 0),
+    mTransitions(NUM_BYTES, 0),
+    mOutputs(1, -1),
+    mNumStartBytes(0)
+  {
+    memset(mStartBytes, 0, sizeof(mStartBytes));
+
+    //build the trie of the patterns. A transition to the root means that there is no transition yet.
+    for(size_t i=0; i<iPatterns.size(); i++)
+    {
+      std::string pattern = iPatterns[i];
+      if (mEncoding == EncodingUtf16)
+      {
+        const std::u16string utf16 = utf8_to_utf16(iPatterns[i]);
+        pattern.assign((const char *)utf16.data(), utf16.size() * sizeof(char16_t));
+      }
+      mSizes[i] = pattern.size();
+      if (pattern.empty())
+        continue;
+
+      int32_t state = 0;
+      for(size_t j=0; j<pattern.size(); j++)
+      {
+        const size_t index = (size_t)state * NUM_BYTES + (unsigned char)pattern[j];
+        if (mTransitions[index] == 0)
+        {
+          mTransitions[index] = (int32_t)mOutputs.size();
+          mTransitions.resize(mTransitions.size() + NUM_BYTES, 0);
+          mOutputs.push_back(-1);
+        }
+        state = mTransitions[index];
+      }
+
+      //duplicated patterns are reported with the index of the first one
+      if (mOutputs[state] < 0)
+        mOutputs[state] = (int32_t)i;
+    }
+
+    //compute the failure function in breadth-first order and complete the transition table with it
+    const size_t num_states = mOutputs.size();
+    std::vector<int32_t> failures(num_states, 0);
+    std::vector<int32_t> queue;
+    queue.reserve(num_states);
+    mLinks.assign(num_states, -1);
+
+    for(size_t b=0; b<NUM_BYTES; b++)
+    {
+      const int32_t child = mTransitions[b];
+      if (child != 0)
+        queue.push_back(child);
+    }
+    for(size_t head=0; head<queue.size(); head++)
+    {
+      const int32_t state = queue[head];
+      const int32_t failure = failures[state];
+      mLinks[state] = (mOutputs[failure] >= 0 ? failure : mLinks[failure]);
+
+      int32_t * transitions = &mTransitions[(size_t)state * NUM_BYTES];
+      const int32_t * failure_transitions = &mTransitions[(size_t)failure * NUM_BYTES];
+      for(size_t b=0; b<NUM_BYTES; b++)
+      {
+        const int32_t child = transitions[b];
+        if (child != 0)
+        {
+          failures[child] = failure_transitions[b];
+          queue.push_back(child);
+        }
+        else
+          transitions[b] = failure_transitions[b];
+      }
+    }
+
+    //find the bytes that can leave the root
+    for(size_t b=0; b<NUM_BYTES; b++)
+    {
+      if (mTransitions[b] == 0)
+        continue;
+      if (mNumStartBytes < sizeof(mStartBytes))
+        mStartBytes[mNumStartBytes] = (unsigned char)b;
+      mNumStartBytes++;
+    }
+  }
+
+  PatternSet::~PatternSet()
+  {
+  }
+
+  size_t PatternSet::GetCount() const
+  {
+    return mSizes.size();
+  }
+
+  PatternSet::Encoding PatternSet::GetEncoding() const
+  {
+    return mEncoding;
+  }
+
+  size_t PatternSet::skipToStart(const unsigned char * iData, size_t iOffset, size_t iSize) const
+  {
+    if (mNumStartBytes == 0)
+      return iSize;
+    if (mNumStartBytes > sizeof(mStartBytes))
+      return iOffset;
+    if (mNumStartBytes == 1)
+    {
+      const unsigned char * found = (const unsigned char *)memchr(iData + iOffset, mStartBytes[0], iSize - iOffset);
+      return (found != NULL ? (size_t)(found - iData) : iSize);
+    }
+
+    //with 2 start bytes, the last one is compared twice
+    const unsigned char b0 = mStartBytes[0];
+    const unsigned char b1 = mStartBytes[1];
+    const unsigned char b2 = mStartBytes[mNumStartBytes - 1];
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    const __m128i v0 = _mm_set1_epi8((char)b0);
+    const __m128i v1 = _mm_set1_epi8((char)b1);
+    const __m128i v2 = _mm_set1_epi8((char)b2);
+    for(; iOffset + 16 <= iSize; iOffset += 16)
+    {
+      const __m128i block = _mm_loadu_si128((const __m128i *)(iData + iOffset));
+      const __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, v0), _mm_cmpeq_epi8(block, v1)), _mm_cmpeq_epi8(block, v2));
+      const unsigned mask = (unsigned)_mm_movemask_epi8(matches);
+      if (mask != 0)
+        return iOffset + lowestBit(mask);
+    }
+#endif
+
+    for(; iOffset < iSize; iOffset++)
+    {
+      const unsigned char c = iData[iOffset];
+      if (c == b0 || c == b1 || c == b2)
+        return iOffset;
+    }
+    return iSize;
+  }
+
+  //The visitor returns false to stop the search.
+  template <typename Visitor> void PatternSet::scan(const char * iData, size_t iSize, Visitor & iVisitor) const
+  {
+    const unsigned char * data = (const unsigned char *)iData;
+    const int32_t * transitions = &mTransitions[0];
+    int32_t state = 0;
+    size_t i = 0;
+    while (i < iSize)
+    {
+      //bytes that do not start a pattern keep the automaton in the root state
+      if (state == 0)
+      {
+        i = skipToStart(data, i, iSize);
+        if (i == iSize)
+          break;
+      }
+
+      state = transitions[(size_t)state * NUM_BYTES + data[i]];
+      i++;
+
+      //report the pattern ending at this state, then the shorter patterns ending at the same offset
+      int32_t output = (mOutputs[state] >= 0 ? state : mLinks[state]);
+      for(; output >= 0; output = mLinks[output])
+      {
+        const size_t pattern = (size_t)mOutputs[output];
+        const size_t size = mSizes[pattern];
+        const size_t offset = i - size;
+        if (offset % mAlignment != 0)
+          continue;
+        if (!iVisitor(pattern, offset, size))
+          return;
+      }
+    }
+  }
+
+  struct FirstMatchVisitor
+  {
+    SearchMatch * match;
+    bool found;
+
+    bool operator()(size_t pattern, size_t offset, size_t size)
+    {
+      match->pattern = pattern;
+      match->offset = offset;
+      match->size = size;
+      found = true;
+      return false;
+    }
+  };
+
+  struct AllMatchesVisitor
+  {
+    std::vector<SearchMatch> * matches;
+
+    bool operator()(size_t pattern, size_t offset, size_t size)
+    {
+      SearchMatch match;
+      match.pattern = pattern;
+      match.offset = offset;
+      match.size = size;
+      matches->push_back(match);
+      return true;
+    }
+  };
+
+  bool PatternSet::Find(const char * iData, size_t iSize, SearchMatch & oMatch) const
+  {
+    FirstMatchVisitor visitor;
+    visitor.match = &oMatch;
+    visitor.found = false;
+    scan(iData, iSize, visitor);
+    return visitor.found;
+  }
+
+  size_t PatternSet::FindAll(const char * iData, size_t iSize, std::vector<SearchMatch> & oMatches) const
+  {
+    oMatches.clear();
+    AllMatchesVisitor visitor;
+    visitor.matches = &oMatches;
+    scan(iData, iSize, visitor);
+    return oMatches.size();
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,120 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#ifndef WIN32CLIPBOARD_SERIALIZE_H
+#define WIN32CLIPBOARD_SERIALIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Integer encodings shared by the binary formats of the library (deltas, mirror messages, stores and files).
+// This header is private to the library.
+
+namespace win32clipboard
+{
+  /// <summary>
+  /// Append a variable length integer to a buffer: 7 bits per byte, least significant group first.
+  /// The most significant bit of a byte is set when more bytes follow.
+  /// </summary>
+  /// <param name="buffer">The buffer.</param>
+  /// <param name="value">The value to append.</param>
+  inline void appendVarint(std::string & buffer, uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      buffer += (char)(0x80 | (value & 0x7F));
+      value >>= 7;
+    }
+    buffer += (char)value;
+  }
+
+  /// <summary>
+  /// Read a variable length integer written by appendVarint().
+  /// </summary>
+  /// <param name="buffer">The buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="offset">The offset of the integer. Moved past the integer on success.</param>
+  /// <param name="value">The decoded value.</param>
+  /// <returns>Returns false if the integer is truncated or longer than 64 bits. Returns true otherwise.</returns>
+  inline bool readVarint(const char * buffer, size_t size, size_t & offset, uint64_t & value)
+  {
+    value = 0;
+    for(unsigned shift=0; shift<64; shift+=7)
+    {
+      if (offset >= size)
+        return false;
+      const unsigned char byte = (unsigned char)buffer[offset++];
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  inline bool readVarint(const std::string & buffer, size_t & offset, uint64_t & value)
+  {
+    return readVarint(buffer.data(), buffer.size(), offset, value);
+  }
+
+  /// <summary>
+  /// Append a 64 bit integer to a buffer as 8 bytes, little endian.
+  /// </summary>
+  /// <param name="buffer">The buffer.</param>
+  /// <param name="value">The value to append.</param>
+  inline void appendUint64(std::string & buffer, uint64_t value)
+  {
+    char bytes[8];
+    for(size_t i=0; i<8; i++)
+      bytes[i] = (char)(value >> (8*i));
+    buffer.append(bytes, sizeof(bytes));
+  }
+
+  /// <summary>
+  /// Read a 64 bit integer written by appendUint64().
+  /// </summary>
+  /// <param name="buffer">The buffer.</param>
+  /// <param name="size">The size in bytes of the buffer.</param>
+  /// <param name="offset">The offset of the integer. Moved past the integer on success.</param>
+  /// <param name="value">The decoded value.</param>
+  /// <returns>Returns false if fewer than 8 bytes remain. Returns true otherwise.</returns>
+  inline bool readUint64(const char * buffer, size_t size, size_t & offset, uint64_t & value)
+  {
+    if (offset > size || size - offset < 8)
+      return false;
+    value = 0;
+    for(size_t i=0; i<8; i++)
+      value |= (uint64_t)(unsigned char)buffer[offset + i] << (8*i);
+    offset += 8;
+    return true;
+  }
+
+  inline bool readUint64(const std::string & buffer, size_t & offset, uint64_t & value)
+  {
+    return readUint64(buffer.data(), buffer.size(), offset, value);
+  }
+
+} //namespace win32clipboard
+
+#endif //WIN32CLIPBOARD_SERIALIZE_H
@@ -0,0 +1,408 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+
+#include "win32clipboard/backend.h"
+
+namespace win32clipboard
+{
+  static const uint32_t SEGMENT_MAGIC = 0x50494C43; //"CLIP"
+  static const uint32_t SEGMENT_VERSION = 1;
+
+  //Payloads are aligned for the readers that parse them in place
+  static const size_t DATA_ALIGNMENT = 64;
+
+  //Same worst case as the retries of OpenClipboard() in ClipboardObject
+  static const long OPEN_TIMEOUT_MS = 250;
+
+  //Time given to the creator of a segment to initialize it
+  static const long ATTACH_TIMEOUT_MS = 1000;
+
+  static inline size_t alignUp(size_t value)
+  {
+    return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+  }
+
+  static std::string getSegmentName(const std::string & name)
+  {
+    if (!name.empty() && name[0] == '/')
+      return name;
+    return "/" + name;
+  }
+
+  static void sleepMilliseconds(long milliseconds)
+  {
+    struct timespec duration;
+    duration.tv_sec = milliseconds / 1000;
+    duration.tv_nsec = (milliseconds % 1000) * 1000000L;
+    nanosleep(&duration, NULL);
+  }
+
+  struct FormatEntry
+  {
+    char name[SharedMemoryBackend::MAX_FORMAT_NAME_LENGTH + 1];
+    uint64_t offset;      //offset of the payload in the data area
+    uint64_t size;
+  };
+
+  // Layout of the shared memory segment. The data area follows the structure.
+  struct SharedMemoryBackend::Segment
+  {
+    std::atomic<uint32_t> magic;    //set once the segment is initialized
+    uint32_t version;
+    uint64_t capacity;              //size of the data area
+    pthread_mutex_t mutex;          //process-shared and robust
+    uint64_t sequence;
+    uint64_t used;                  //bytes used in the data area
+    uint32_t num_formats;
+    FormatEntry formats[MAX_FORMATS];
+
+    char * getData() { return (char *)this + alignUp(sizeof(Segment)); }
+  };
+
+  static bool initMutex(pthread_mutex_t * mutex)
+  {
+    pthread_mutexattr_t attributes;
+    if (pthread_mutexattr_init(&attributes) != 0)
+      return false;
+    bool success =
+      pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED) == 0 &&
+      pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST) == 0 &&
+      pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_ERRORCHECK) == 0 &&
+      pthread_mutex_init(mutex, &attributes) == 0;
+    pthread_mutexattr_destroy(&attributes);
+    return success;
+  }
+
+  SharedMemoryBackend::SharedMemoryBackend(const std::string & iName, size_t iCapacity) :
+    mSegment(NULL),
+    mMappingSize(0),
+    mOpened(false)
+  {
+    const std::string name = getSegmentName(iName);
+
+    //the first process creates and initializes the segment
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+    {
+      const size_t size = alignUp(sizeof(Segment)) + iCapacity;
+      void * mapping = MAP_FAILED;
+      if (ftruncate(fd, (off_t)size) == 0)
+        mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (mapping == MAP_FAILED)
+      {
+        shm_unlink(name.c_str());
+        return;
+      }
+
+      //the new pages are zero-filled
+      Segment * segment = (Segment *)mapping;
+      segment->version = SEGMENT_VERSION;
+      segment->capacity = iCapacity;
+      if (!initMutex(&segment->mutex))
+      {
+        munmap(mapping, size);
+        shm_unlink(name.c_str());
+        return;
+      }
+      segment->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+      mSegment = segment;
+      mMappingSize = size;
+      return;
+    }
+    if (errno != EEXIST)
+      return;
+
+    //other processes wait until the segment is initialized
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+      return;
+    struct stat status;
+    for(long elapsed = 0; ; elapsed++)
+    {
+      if (fstat(fd, &status) != 0 || elapsed >= ATTACH_TIMEOUT_MS)
+      {
+        close(fd);
+        return;
+      }
+      if ((size_t)status.st_size >= alignUp(sizeof(Segment)))
+        break;
+      sleepMilliseconds(1);
+    }
+
+    const size_t size = (size_t)status.st_size;
+    void * mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+      return;
+
+    Segment * segment = (Segment *)mapping;
+    for(long elapsed = 0; segment->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC; elapsed++)
+    {
+      if (elapsed >= ATTACH_TIMEOUT_MS)
+      {
+        munmap(mapping, size);
+        return;
+      }
+      sleepMilliseconds(1);
+    }
+    if (segment->version != SEGMENT_VERSION || alignUp(sizeof(Segment)) + segment->capacity > size)
+    {
+      munmap(mapping, size);
+      return;
+    }
+
+    mSegment = segment;
+    mMappingSize = size;
+  }
+
+  SharedMemoryBackend::~SharedMemoryBackend()
+  {
+    if (mOpened)
+      Close();
+    if (mSegment != NULL)
+      munmap(mSegment, mMappingSize);
+  }
+
+  bool SharedMemoryBackend::IsValid() const
+  {
+    return mSegment != NULL;
+  }
+
+  size_t SharedMemoryBackend::GetCapacity() const
+  {
+    if (mSegment == NULL)
+      return 0;
+    return (size_t)mSegment->capacity;
+  }
+
+  bool SharedMemoryBackend::Remove(const std::string & iName)
+  {
+    return shm_unlink(getSegmentName(iName).c_str()) == 0;
+  }
+
+  bool SharedMemoryBackend::Open()
+  {
+    if (mOpened || !lock())
+      return false;
+    mOpened = true;
+    return true;
+  }
+
+  bool SharedMemoryBackend::Close()
+  {
+    if (!mOpened)
+      return false;
+    mOpened = false;
+    unlock();
+    return true;
+  }
+
+  bool SharedMemoryBackend::Clear()
+  {
+    if (!mOpened)
+      return false;
+    mSegment->num_formats = 0;
+    mSegment->used = 0;
+    mSegment->sequence++;
+    return true;
+  }
+
+  bool SharedMemoryBackend::SetData(const std::string & iFormat, const void * iData, size_t iSize)
+  {
+    if (!mOpened)
+      return false;
+    return setData(iFormat, iData, iSize);
+  }
+
+  bool SharedMemoryBackend::GetData(const std::string & iFormat, const char *& oData, size_t & oSize)
+  {
+    if (!mOpened)
+      return false;
+
+    for(uint32_t i=0; i<mSegment->num_formats; i++)
+    {
+      const FormatEntry & entry = mSegment->formats[i];
+      if (iFormat == entry.name)
+      {
+        oData = mSegment->getData() + entry.offset;
+        oSize = (size_t)entry.size;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint64_t SharedMemoryBackend::GetSequence() const
+  {
+    if (mSegment == NULL)
+      return 0;
+    return __atomic_load_n(&mSegment->sequence, __ATOMIC_RELAXED);
+  }
+
+  bool SharedMemoryBackend::Write(const ItemList & iItems)
+  {
+    //validate the items before modifying the clipboard
+    if (mSegment == NULL || iItems.size() > MAX_FORMATS)
+      return false;
+    size_t size = 0;
+    for(size_t i=0; i<iItems.size(); i++)
+    {
+      if (iItems[i].format.empty() || iItems[i].format.size() > MAX_FORMAT_NAME_LENGTH)
+        return false;
+      size += alignUp(iItems[i].data.size());
+    }
+    if (size > mSegment->capacity)
+      return false;
+
+    if (!lock())
+      return false;
+
+    mSegment->num_formats = 0;
+    mSegment->used = 0;
+    bool success = true;
+    for(size_t i=0; i<iItems.size() && success; i++)
+      success = setData(iItems[i].format, iItems[i].data.data(), iItems[i].data.size());
+    mSegment->sequence++;
+
+    unlock();
+    return success;
+  }
+
+  bool SharedMemoryBackend::Read(const std::string & iFormat, std::string & oData)
+  {
+    if (!lock())
+      return false;
+
+    bool found = false;
+    for(uint32_t i=0; i<mSegment->num_formats && !found; i++)
+    {
+      const FormatEntry & entry = mSegment->formats[i];
+      if (iFormat == entry.name)
+      {
+        oData.assign(mSegment->getData() + entry.offset, (size_t)entry.size);
+        found = true;
+      }
+    }
+
+    unlock();
+    return found;
+  }
+
+  bool SharedMemoryBackend::GetFormats(StringVector & oFormats)
+  {
+    oFormats.clear();
+    if (!lock())
+      return false;
+
+    for(uint32_t i=0; i<mSegment->num_formats; i++)
+      oFormats.push_back(mSegment->formats[i].name);
+
+    unlock();
+    return true;
+  }
+
+  bool SharedMemoryBackend::Empty()
+  {
+    if (!lock())
+      return false;
+
+    mSegment->num_formats = 0;
+    mSegment->used = 0;
+    mSegment->sequence++;
+
+    unlock();
+    return true;
+  }
+
+  bool SharedMemoryBackend::lock()
+  {
+    if (mSegment == NULL)
+      return false;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (OPEN_TIMEOUT_MS % 1000) * 1000000L;
+    deadline.tv_sec += OPEN_TIMEOUT_MS / 1000 + deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    int result = pthread_mutex_timedlock(&mSegment->mutex, &deadline);
+    if (result == EOWNERDEAD)
+    {
+      //the previous owner died while the clipboard was opened: its content may be partially written
+      mSegment->num_formats = 0;
+      mSegment->used = 0;
+      mSegment->sequence++;
+      pthread_mutex_consistent(&mSegment->mutex);
+      return true;
+    }
+    return result == 0;
+  }
+
+  void SharedMemoryBackend::unlock()
+  {
+    pthread_mutex_unlock(&mSegment->mutex);
+  }
+
+  bool SharedMemoryBackend::setData(const std::string & iFormat, const void * iData, size_t iSize)
+  {
+    if (iFormat.empty() || iFormat.size() > MAX_FORMAT_NAME_LENGTH)
+      return false;
+
+    //a format that is set again is replaced. Its previous payload is released by the next Clear().
+    uint32_t index = 0;
+    while (index < mSegment->num_formats && iFormat != mSegment->formats[index].name)
+      index++;
+    if (index == MAX_FORMATS)
+      return false;
+
+    const size_t offset = (size_t)mSegment->used;
+    if (iSize > mSegment->capacity - offset)
+      return false;
+    if (iSize > 0)
+      memcpy(mSegment->getData() + offset, iData, iSize);
+    mSegment->used = alignUp(offset + iSize) < mSegment->capacity ? alignUp(offset + iSize) : mSegment->capacity;
+
+    FormatEntry & entry = mSegment->formats[index];
+    memset(entry.name, 0, sizeof(entry.name));
+    memcpy(entry.name, iFormat.data(), iFormat.size());
+    entry.offset = offset;
+    entry.size = iSize;
+    if (index == mSegment->num_formats)
+      mSegment->num_formats++;
+    return true;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,269 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "win32clipboard/snapshot.h"
+
+#include "capture.h"
+
+namespace win32clipboard
+{
+  static const size_t NUM_FORMATS = Clipboard::NUM_FORMATS;
+
+  // Content of a snapshot. Never modified once published.
+  struct ClipboardSnapshot::Contents
+  {
+    Buffer buffers[NUM_FORMATS];  //the unicode text is stored in its own buffer
+    UnicodeBuffer unicode;
+    Buffer html;
+    Buffer dropfiles;             //CF_HDROP buffer
+    Clipboard::DragDropType drag_drop_type;
+    uint64_t fingerprint;
+    bool has_fingerprint;
+    size_t size; //size of all payloads, in bytes
+
+    Contents() :
+      drag_drop_type(Clipboard::DragDropCopy),
+      fingerprint(0),
+      has_fingerprint(false),
+      size(0)
+    {
+    }
+
+    void publish(Buffer & oBuffer, std::string & iPayload)
+    {
+      size += iPayload.size();
+      oBuffer = std::make_shared<const std::string>(std::move(iPayload));
+    }
+
+    void publish(UnicodeBuffer & oBuffer, std::wstring & iPayload)
+    {
+      size += iPayload.size() * sizeof(wchar_t);
+      oBuffer = std::make_shared<const std::wstring>(std::move(iPayload));
+    }
+  };
+
+  ClipboardSnapshot::ClipboardSnapshot()
+  {
+  }
+
+#ifdef _WIN32
+  bool ClipboardSnapshot::Capture(Clipboard & iClipboard)
+  {
+    std::shared_ptr<Contents> contents = std::make_shared<Contents>();
+    contents->has_fingerprint = iClipboard.GetFingerprint(contents->fingerprint);
+
+    //the payloads are moved into their buffers without copying
+    std::string text;
+    if (iClipboard.GetAsText(text))
+      contents->publish(contents->buffers[Clipboard::FormatText], text);
+
+    std::wstring unicode;
+    if (iClipboard.GetAsTextUnicode(unicode))
+      contents->publish(contents->unicode, unicode);
+
+    std::string dib;
+    if (read_clipboard_dib(iClipboard, dib))
+      contents->publish(contents->buffers[Clipboard::FormatImage], dib);
+
+    Clipboard::MemoryBuffer binary;
+    if (iClipboard.GetAsBinary(binary))
+      contents->publish(contents->buffers[Clipboard::FormatBinary], binary);
+
+    std::string html;
+    if (iClipboard.GetAsHtml(html))
+      contents->publish(contents->html, html);
+
+    std::string dropfiles;
+    if (read_clipboard_dropfiles(iClipboard, contents->drag_drop_type, dropfiles))
+      contents->publish(contents->dropfiles, dropfiles);
+
+    mContents = contents;
+    return !IsEmpty();
+  }
+#endif //_WIN32
+
+  bool ClipboardSnapshot::Capture(Backend & iBackend)
+  {
+    std::shared_ptr<Contents> contents = std::make_shared<Contents>();
+
+    //the payloads are moved into their buffers without copying
+    std::string text;
+    if (read_backend_text(iBackend, text))
+      contents->publish(contents->buffers[Clipboard::FormatText], text);
+
+    std::wstring unicode;
+    if (read_backend_unicode(iBackend, unicode))
+      contents->publish(contents->unicode, unicode);
+
+    std::string dib;
+    if (read_backend_dib(iBackend, dib))
+      contents->publish(contents->buffers[Clipboard::FormatImage], dib);
+
+    Clipboard::MemoryBuffer binary;
+    if (iBackend.Read(Backend::FORMAT_BINARY, binary))
+      contents->publish(contents->buffers[Clipboard::FormatBinary], binary);
+
+    std::string html;
+    if (read_backend_html(iBackend, html))
+      contents->publish(contents->html, html);
+
+    std::string dropfiles;
+    if (read_backend_dropfiles(iBackend, contents->drag_drop_type, dropfiles))
+      contents->publish(contents->dropfiles, dropfiles);
+
+    mContents = contents;
+    return !IsEmpty();
+  }
+
+  void ClipboardSnapshot::Clear()
+  {
+    mContents.reset();
+  }
+
+  bool ClipboardSnapshot::IsEmpty() const
+  {
+    for(size_t i=0; i<NUM_FORMATS; i++)
+    {
+      if (Contains((Clipboard::Format)i))
+        return false;
+    }
+    return (!mContents || (!mContents->html && !mContents->dropfiles));
+  }
+
+  bool ClipboardSnapshot::GetFingerprint(uint64_t & oFingerprint) const
+  {
+    if (!mContents || !mContents->has_fingerprint)
+      return false;
+    oFingerprint = mContents->fingerprint;
+    return true;
+  }
+
+  size_t ClipboardSnapshot::GetMemoryUsage() const
+  {
+    if (!mContents)
+      return 0;
+    return mContents->size;
+  }
+
+  bool ClipboardSnapshot::Contains(Clipboard::Format iClipboardFormat) const
+  {
+    if (!mContents || (size_t)iClipboardFormat >= NUM_FORMATS)
+      return false;
+    if (iClipboardFormat == Clipboard::FormatUnicode)
+      return (mContents->unicode != NULL);
+    return (mContents->buffers[iClipboardFormat] != NULL);
+  }
+
+  ClipboardSnapshot::Buffer ClipboardSnapshot::GetBuffer(Clipboard::Format iClipboardFormat) const
+  {
+    if (!mContents || (size_t)iClipboardFormat >= NUM_FORMATS)
+      return Buffer();
+    return mContents->buffers[iClipboardFormat];
+  }
+
+  ClipboardSnapshot::UnicodeBuffer ClipboardSnapshot::GetUnicodeBuffer() const
+  {
+    if (!mContents)
+      return UnicodeBuffer();
+    return mContents->unicode;
+  }
+
+  bool ClipboardSnapshot::GetData(Clipboard::Format iClipboardFormat, const char *& oData, size_t & oSize) const
+  {
+    if (!Contains(iClipboardFormat))
+      return false;
+
+    if (iClipboardFormat == Clipboard::FormatUnicode)
+    {
+      const std::wstring & unicode = *mContents->unicode;
+      oData = (const char *)unicode.data();
+      oSize = unicode.size() * sizeof(wchar_t);
+      return true;
+    }
+
+    const std::string & buffer = *mContents->buffers[iClipboardFormat];
+    oData = buffer.data();
+    oSize = buffer.size();
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsText(std::string & oText) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    if (!GetData(Clipboard::FormatText, data, size))
+      return false;
+    oText.assign(data, size);
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsTextUnicode(std::wstring & oText) const
+  {
+    if (!Contains(Clipboard::FormatUnicode))
+      return false;
+    oText = *mContents->unicode;
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsBinary(Clipboard::MemoryBuffer & oMemoryBuffer) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    if (!GetData(Clipboard::FormatBinary, data, size))
+      return false;
+    oMemoryBuffer.assign(data, size);
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsImage(Image & oImage) const
+  {
+    const char * data = NULL;
+    size_t size = 0;
+    DibView view;
+    if (!GetData(Clipboard::FormatImage, data, size) || !parse_dib(data, size, view))
+      return false;
+    decode_dib(view, oImage);
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsHtml(std::string & oFragment) const
+  {
+    if (!mContents || !mContents->html)
+      return false;
+    oFragment = *mContents->html;
+    return true;
+  }
+
+  bool ClipboardSnapshot::GetAsDragDropFiles(Clipboard::DragDropType & oDragDropType, DropFileList & oFiles) const
+  {
+    if (!mContents || !mContents->dropfiles)
+      return false;
+
+    const std::string & dropfiles = *mContents->dropfiles;
+    bool is_wide = false;
+    oDragDropType = mContents->drag_drop_type;
+    return decode_dropfiles(dropfiles.data(), dropfiles.size(), oFiles, is_wide);
+  }
+
+} //namespace win32clipboard
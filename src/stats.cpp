@@ -0,0 +1,238 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <chrono>
+
+#include "win32clipboard/stats.h"
+
+namespace win32clipboard
+{
+  static const std::memory_order RELAXED = std::memory_order_relaxed;
+
+  //Returns the number of bits required to represent the given value.
+  static inline size_t bitLength(uint64_t value)
+  {
+#if defined(__GNUC__)
+    return (value == 0 ? 0 : 64 - (size_t)__builtin_clzll(value));
+#else
+    size_t length = 0;
+    while (value)
+    {
+      value >>= 1;
+      length++;
+    }
+    return length;
+#endif
+  }
+
+  size_t LatencyHistogram::GetBucket(uint64_t iDuration)
+  {
+    const size_t bucket = bitLength(iDuration);
+    return (bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1);
+  }
+
+  uint64_t LatencyHistogram::GetPercentile(double iPercentile) const
+  {
+    if (count == 0)
+      return 0;
+    if (iPercentile < 0.0)
+      iPercentile = 0.0;
+    if (iPercentile > 100.0)
+      iPercentile = 100.0;
+
+    //rank of the requested duration, starting at 1
+    uint64_t rank = (uint64_t)(iPercentile / 100.0 * (double)count + 0.999999);
+    if (rank == 0)
+      rank = 1;
+
+    uint64_t cumulative = 0;
+    for(size_t i=0; i<NUM_BUCKETS; i++)
+    {
+      cumulative += buckets[i];
+      if (cumulative >= rank)
+      {
+        //the largest duration of the bucket, which can not exceed the largest recorded duration
+        const uint64_t upper = (i == 0 ? 0 : ((uint64_t)1 << i) - 1);
+        return (i == NUM_BUCKETS - 1 || upper > max_ns ? max_ns : upper);
+      }
+    }
+    return max_ns;
+  }
+
+  const OperationStats & ClipboardStats::Get(Operation iOperation, Kind iKind) const
+  {
+    return operations[iOperation][iKind];
+  }
+
+  StatsRecorder::StatsRecorder()
+  {
+    mTraceCallback.store(NULL);
+    mTraceUserData.store(NULL);
+    Reset();
+  }
+
+  bool StatsRecorder::IsEnabled()
+  {
+#ifdef WIN32CLIPBOARD_STATS_ENABLED
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  uint64_t StatsRecorder::GetTimestamp()
+  {
+    const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  }
+
+  void StatsRecorder::RecordOpen(bool iSuccess, size_t iRetries, uint64_t iDuration)
+  {
+    if (iSuccess)
+      mOpens.fetch_add(1, RELAXED);
+    else
+      mOpenFailures.fetch_add(1, RELAXED);
+    mOpenRetries.fetch_add(iRetries, RELAXED);
+    record(mOpenLatency, iDuration);
+  }
+
+  void StatsRecorder::Record(ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind, bool iSuccess, uint64_t iBytes, uint64_t iDuration)
+  {
+    if ((size_t)iOperation >= ClipboardStats::NUM_OPERATIONS || (size_t)iKind >= ClipboardStats::NUM_KINDS)
+      return;
+
+    AtomicOperation & operation = mOperations[iOperation][iKind];
+    operation.calls.fetch_add(1, RELAXED);
+    if (!iSuccess)
+      operation.failures.fetch_add(1, RELAXED);
+    operation.bytes.fetch_add(iBytes, RELAXED);
+    record(operation.latency, iDuration);
+
+    TraceCallback callback = mTraceCallback.load(std::memory_order_acquire);
+    if (callback != NULL)
+    {
+      TraceEvent event;
+      event.type = TraceEvent::TypeEnd;
+      event.operation = iOperation;
+      event.kind = iKind;
+      event.success = iSuccess;
+      event.bytes = iBytes;
+      event.duration_ns = iDuration;
+      callback(event, mTraceUserData.load(RELAXED));
+    }
+  }
+
+  void StatsRecorder::TraceBegin(ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind)
+  {
+    TraceCallback callback = mTraceCallback.load(std::memory_order_acquire);
+    if (callback == NULL)
+      return;
+
+    TraceEvent event;
+    event.type = TraceEvent::TypeBegin;
+    event.operation = iOperation;
+    event.kind = iKind;
+    event.success = false;
+    event.bytes = 0;
+    event.duration_ns = 0;
+    callback(event, mTraceUserData.load(RELAXED));
+  }
+
+  void StatsRecorder::SetTraceCallback(TraceCallback iCallback, void * iUserData)
+  {
+    //publish the user data before the callback that uses it
+    mTraceUserData.store(iUserData, RELAXED);
+    mTraceCallback.store(iCallback, std::memory_order_release);
+  }
+
+  void StatsRecorder::GetStats(ClipboardStats & oStats) const
+  {
+    for(size_t i=0; i<ClipboardStats::NUM_OPERATIONS; i++)
+    {
+      for(size_t j=0; j<ClipboardStats::NUM_KINDS; j++)
+      {
+        const AtomicOperation & operation = mOperations[i][j];
+        OperationStats & stats = oStats.operations[i][j];
+        stats.calls = operation.calls.load(RELAXED);
+        stats.failures = operation.failures.load(RELAXED);
+        stats.bytes = operation.bytes.load(RELAXED);
+        load(operation.latency, stats.latency);
+      }
+    }
+    oStats.opens = mOpens.load(RELAXED);
+    oStats.open_retries = mOpenRetries.load(RELAXED);
+    oStats.open_failures = mOpenFailures.load(RELAXED);
+    load(mOpenLatency, oStats.open_latency);
+  }
+
+  void StatsRecorder::Reset()
+  {
+    for(size_t i=0; i<ClipboardStats::NUM_OPERATIONS; i++)
+    {
+      for(size_t j=0; j<ClipboardStats::NUM_KINDS; j++)
+      {
+        AtomicOperation & operation = mOperations[i][j];
+        operation.calls.store(0, RELAXED);
+        operation.failures.store(0, RELAXED);
+        operation.bytes.store(0, RELAXED);
+        reset(operation.latency);
+      }
+    }
+    mOpens.store(0, RELAXED);
+    mOpenRetries.store(0, RELAXED);
+    mOpenFailures.store(0, RELAXED);
+    reset(mOpenLatency);
+  }
+
+  void StatsRecorder::record(AtomicHistogram & iHistogram, uint64_t iDuration)
+  {
+    iHistogram.count.fetch_add(1, RELAXED);
+    iHistogram.total_ns.fetch_add(iDuration, RELAXED);
+    iHistogram.buckets[LatencyHistogram::GetBucket(iDuration)].fetch_add(1, RELAXED);
+
+    uint64_t max = iHistogram.max_ns.load(RELAXED);
+    while (iDuration > max && !iHistogram.max_ns.compare_exchange_weak(max, iDuration, RELAXED))
+    {
+    }
+  }
+
+  void StatsRecorder::load(const AtomicHistogram & iHistogram, LatencyHistogram & oHistogram)
+  {
+    oHistogram.count = iHistogram.count.load(RELAXED);
+    oHistogram.total_ns = iHistogram.total_ns.load(RELAXED);
+    oHistogram.max_ns = iHistogram.max_ns.load(RELAXED);
+    for(size_t i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
+      oHistogram.buckets[i] = iHistogram.buckets[i].load(RELAXED);
+  }
+
+  void StatsRecorder::reset(AtomicHistogram & iHistogram)
+  {
+    iHistogram.count.store(0, RELAXED);
+    iHistogram.total_ns.store(0, RELAXED);
+    iHistogram.max_ns.store(0, RELAXED);
+    for(size_t i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
+      iHistogram.buckets[i].store(0, RELAXED);
+  }
+
+} //namespace win32clipboard
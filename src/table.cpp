@@ -0,0 +1,418 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <stdint.h>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+#include "win32clipboard/table.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static const size_t BLOCK_SIZE = 64;
+  static const char QUOTE = '"';
+
+  // Largest number of digits of a number that can be converted exactly with a single multiplication or division
+  static const size_t MAX_EXACT_DIGITS = 15;
+  // Largest power of ten that is exactly representable as a double
+  static const int MAX_EXACT_POWER = 22;
+  static const size_t MAX_NUMBER_LENGTH = 64;
+
+  static inline unsigned lowestBit64(uint64_t mask)
+  {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(mask);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return (unsigned)index;
+#else
+    unsigned index = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      index++;
+    }
+    return index;
+#endif
+  }
+
+  // Positions of the special characters of a block of 64 bytes. Bit i is set if byte i matches.
+  struct BlockMasks
+  {
+    uint64_t quote;
+    uint64_t delimiter;
+    uint64_t newline;
+  };
+
+  static inline void scanBlock(const char * block, char delimiter, BlockMasks & masks)
+  {
+    masks.quote = masks.delimiter = masks.newline = 0;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    const __m128i quote = _mm_set1_epi8(QUOTE);
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i newline = _mm_set1_epi8('\n');
+    for(size_t i=0; i<BLOCK_SIZE; i += 16)
+    {
+      const __m128i chars = _mm_loadu_si128((const __m128i *)(block + i));
+      masks.quote     |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, quote))   << i;
+      masks.delimiter |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, delim))   << i;
+      masks.newline   |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, newline)) << i;
+    }
+#else
+    for(size_t i=0; i<BLOCK_SIZE; i++)
+    {
+      const uint64_t bit = (uint64_t)1 << i;
+      if (block[i] == QUOTE)
+        masks.quote |= bit;
+      else if (block[i] == delimiter)
+        masks.delimiter |= bit;
+      else if (block[i] == '\n')
+        masks.newline |= bit;
+    }
+#endif
+  }
+
+  static inline bool isDigit(char c)
+  {
+    return '0' <= c && c <= '9';
+  }
+
+  // Parse a decimal number. Returns false if the text is not entirely a number.
+  static bool parseNumber(const char * text, size_t size, double & value)
+  {
+    while (size > 0 && *text == ' ')
+    {
+      text++;
+      size--;
+    }
+    while (size > 0 && text[size - 1] == ' ')
+      size--;
+    if (size == 0 || size > MAX_NUMBER_LENGTH)
+      return false;
+
+    //fast path: [sign]digits[.digits][e[sign]digits] with few enough digits and a small enough exponent to be converted exactly
+    static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    size_t i = 0;
+    const bool negative = (text[0] == '-');
+    if (text[0] == '-' || text[0] == '+')
+      i++;
+    uint64_t mantissa = 0;
+    size_t num_digits = 0;
+    size_t num_decimals = 0;
+    bool has_point = false;
+    for(; i < size; i++)
+    {
+      if (isDigit(text[i]))
+      {
+        mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+        num_digits++;
+        if (has_point)
+          num_decimals++;
+      }
+      else if (text[i] == '.' && !has_point)
+        has_point = true;
+      else
+        break;
+    }
+    int exponent = -(int)num_decimals;
+    if (i < size && num_digits > 0 && (text[i] == 'e' || text[i] == 'E'))
+    {
+      size_t j = i + 1;
+      const bool negative_exponent = (j < size && text[j] == '-');
+      if (j < size && (text[j] == '-' || text[j] == '+'))
+        j++;
+      int explicit_exponent = 0;
+      size_t num_exponent_digits = 0;
+      for(; j < size && isDigit(text[j]) && explicit_exponent <= 2 * MAX_EXACT_POWER; j++, num_exponent_digits++)
+        explicit_exponent = explicit_exponent * 10 + (text[j] - '0');
+      if (j == size && num_exponent_digits > 0)
+      {
+        exponent += (negative_exponent ? -explicit_exponent : explicit_exponent);
+        i = size;
+      }
+    }
+    if (i == size && num_digits > 0 && num_digits <= MAX_EXACT_DIGITS && exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER)
+    {
+      //both operands are exact: the multiplication or the division is correctly rounded
+      value = (exponent >= 0 ? (double)mantissa * POWERS_OF_TEN[exponent] : (double)mantissa / POWERS_OF_TEN[-exponent]);
+      if (negative)
+        value = -value;
+      return true;
+    }
+
+    //slow path for large exponents and long numbers. Only accept the characters of a decimal number.
+    for(i=0; i<size; i++)
+    {
+      const char c = text[i];
+      if (!isDigit(c) && c != '+' && c != '-' && c != '.' && c != 'e' && c != 'E')
+        return false;
+    }
+
+    //strtod() follows LC_NUMERIC: convert with the classic locale instead
+    std::istringstream stream(std::string(text, size));
+    stream.imbue(std::locale::classic());
+    stream >> value;
+    return !stream.fail() && stream.peek() == std::char_traits<char>::eof();
+  }
+
+  Table::Table() :
+    mText(NULL),
+    mSize(0)
+  {
+    mRows.push_back(0);
+  }
+
+  bool Table::Parse(const char * text, size_t size, char delimiter)
+  {
+    Clear();
+    if (delimiter == QUOTE || delimiter == '\n' || delimiter == '\r' || delimiter == '\0')
+      return false;
+    if (text == NULL || size == 0)
+      return true;
+
+    mText = text;
+    mSize = size;
+
+    size_t cell_begin = 0;
+    bool in_quotes = false;
+    size_t skip_until = 0; //position after an escaped quote
+    char tail[BLOCK_SIZE];
+
+    for(size_t base=0; base<size; base += BLOCK_SIZE)
+    {
+      //the last block is padded with zeros, which never match
+      const char * block = text + base;
+      if (size - base < BLOCK_SIZE)
+      {
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, block, size - base);
+        block = tail;
+      }
+
+      BlockMasks masks;
+      scanBlock(block, delimiter, masks);
+
+      //quotes only need to be looked at if the block contains some or starts inside a quoted cell
+      uint64_t positions = masks.delimiter | masks.newline;
+      if (in_quotes || masks.quote != 0)
+        positions |= masks.quote;
+
+      //visit the special characters only
+      while (positions)
+      {
+        const size_t pos = base + lowestBit64(positions);
+        positions &= positions - 1;
+        if (pos < skip_until)
+          continue;
+
+        const char c = text[pos];
+        if (in_quotes)
+        {
+          //a doubled quote is an escaped quote, a single quote ends the quoted section
+          if (c == QUOTE)
+          {
+            if (pos + 1 < size && text[pos + 1] == QUOTE)
+              skip_until = pos + 2;
+            else
+              in_quotes = false;
+          }
+          continue;
+        }
+
+        if (c == QUOTE)
+        {
+          //quotes are only special at the beginning of a cell
+          if (pos == cell_begin)
+            in_quotes = true;
+          continue;
+        }
+
+        //end of cell
+        Span span;
+        span.begin = cell_begin;
+        span.end = pos;
+        if (c == '\n' && span.end > span.begin && text[span.end - 1] == '\r')
+          span.end--;
+        mCells.push_back(span);
+        cell_begin = pos + 1;
+
+        //end of row
+        if (c == '\n')
+          mRows.push_back(mCells.size());
+      }
+    }
+
+    //last row, unless the text ends with a line ending
+    if (cell_begin < size || text[size - 1] != '\n')
+    {
+      Span span;
+      span.begin = cell_begin;
+      span.end = size;
+      if (span.end > span.begin && text[span.end - 1] == '\r' && !in_quotes)
+        span.end--;
+      mCells.push_back(span);
+      mRows.push_back(mCells.size());
+    }
+
+    return true;
+  }
+
+  bool Table::Assign(std::string & text, char delimiter)
+  {
+    mBuffer.swap(text);
+    text.clear();
+    return Parse(mBuffer.data(), mBuffer.size(), delimiter);
+  }
+
+  void Table::Clear()
+  {
+    //the owned text is kept: Assign() parses it after the call to Clear()
+    mText = NULL;
+    mSize = 0;
+    mCells.clear();
+    mRows.clear();
+    mRows.push_back(0);
+  }
+
+  size_t Table::GetRowCount() const
+  {
+    return mRows.size() - 1;
+  }
+
+  size_t Table::GetCellCount(size_t row) const
+  {
+    if (row >= GetRowCount())
+      return 0;
+    return mRows[row + 1] - mRows[row];
+  }
+
+  const Table::Span * Table::getSpan(size_t row, size_t column) const
+  {
+    if (column >= GetCellCount(row))
+      return NULL;
+    return &mCells[mRows[row] + column];
+  }
+
+  bool Table::IsQuoted(size_t row, size_t column) const
+  {
+    const Span * span = getSpan(row, column);
+    return span != NULL && span->end > span->begin && mText[span->begin] == QUOTE;
+  }
+
+  bool Table::GetCell(size_t row, size_t column, const char *& data, size_t & size) const
+  {
+    const Span * span = getSpan(row, column);
+    if (span == NULL)
+      return false;
+
+    size_t begin = span->begin;
+    size_t end = span->end;
+    if (IsQuoted(row, column))
+    {
+      begin++;
+      if (end > begin && mText[end - 1] == QUOTE)
+        end--;
+    }
+    data = mText + begin;
+    size = end - begin;
+    return true;
+  }
+
+  bool Table::GetCellValue(size_t row, size_t column, std::string & value) const
+  {
+    const Span * span = getSpan(row, column);
+    if (span == NULL)
+      return false;
+
+    const char * data = mText + span->begin;
+    const char * end = mText + span->end;
+    if (!IsQuoted(row, column))
+    {
+      value.assign(data, end);
+      return true;
+    }
+
+    //unescape the doubled quotes up to the closing quote. Characters after the closing quote are kept as is.
+    value.clear();
+    value.reserve(end - data);
+    data++;
+    while (data < end)
+    {
+      const char * quote = (const char *)memchr(data, QUOTE, end - data);
+      if (quote == NULL)
+      {
+        value.append(data, end);
+        break;
+      }
+      value.append(data, quote);
+      data = quote + 1;
+      if (data < end && *data == QUOTE)
+      {
+        value += QUOTE;
+        data++;
+      }
+      else
+      {
+        value.append(data, end);
+        break;
+      }
+    }
+    return true;
+  }
+
+  size_t Table::GetColumnAsNumbers(size_t column, std::vector<double> & values) const
+  {
+    const size_t num_rows = GetRowCount();
+    values.assign(num_rows, std::numeric_limits<double>::quiet_NaN());
+
+    size_t count = 0;
+    for(size_t row=0; row<num_rows; row++)
+    {
+      const char * data = NULL;
+      size_t size = 0;
+      if (!GetCell(row, column, data, size))
+        continue;
+      if (parseNumber(data, size, values[row]))
+        count++;
+      else
+        values[row] = std::numeric_limits<double>::quiet_NaN();
+    }
+    return count;
+  }
+
+} //namespace win32clipboard
@@ -0,0 +1,371 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <stdint.h>
+
+#include "win32clipboard/textcodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+
+  //Values of the decoding tables that are not digits
+  static const uint8_t INVALID = 0xFF;
+  static const uint8_t SPACE   = 0xFE;
+  static const uint8_t PADDING = 0xFD;
+
+  struct DecodingTables
+  {
+    uint8_t base64[256];
+    uint8_t hex[256];
+
+    DecodingTables()
+    {
+      for(size_t i=0; i<256; i++)
+      {
+        base64[i] = INVALID;
+        hex[i] = INVALID;
+      }
+      for(size_t i=0; i<64; i++)
+        base64[(uint8_t)BASE64_ALPHABET[i]] = (uint8_t)i;
+      for(size_t i=0; i<16; i++)
+      {
+        hex[(uint8_t)HEX_DIGITS[i]] = (uint8_t)i;
+        hex[(uint8_t)(i < 10 ? '0' + i : 'A' + i - 10)] = (uint8_t)i;
+      }
+      const char spaces[] = { ' ', '\t', '\r', '\n' };
+      for(size_t i=0; i<sizeof(spaces); i++)
+      {
+        base64[(uint8_t)spaces[i]] = SPACE;
+        hex[(uint8_t)spaces[i]] = SPACE;
+      }
+      base64[(uint8_t)'='] = PADDING;
+    }
+  };
+
+  static const DecodingTables gTables;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+  static inline __m128i inRange(__m128i chars, char first, char last)
+  {
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(first - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8(last + 1)));
+  }
+
+  //Encode 12 bytes to 16 characters. Reads 12 bytes.
+  static inline void encodeBase64Block(const uint8_t * src, char * dst)
+  {
+    //one group of 3 bytes per 32 bit lane
+    __m128i groups = _mm_setr_epi32(
+      (int)(src[0] << 16 | src[1] << 8 | src[2]),
+      (int)(src[3] << 16 | src[4] << 8 | src[5]),
+      (int)(src[6] << 16 | src[7] << 8 | src[8]),
+      (int)(src[9] << 16 | src[10] << 8 | src[11]));
+
+    //split each group in 4 values of 6 bits, in the order of the characters
+    const __m128i mask = _mm_set1_epi32(0x3F);
+    __m128i values =                  _mm_and_si128(_mm_srli_epi32(groups, 18), mask);
+    values = _mm_or_si128(values, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(groups, 12), mask), 8));
+    values = _mm_or_si128(values, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(groups, 6), mask), 16));
+    values = _mm_or_si128(values, _mm_slli_epi32(_mm_and_si128(groups, mask), 24));
+
+    //map the values to the alphabet: A-Z, a-z, 0-9, + and /
+    __m128i offsets = _mm_set1_epi8('A');
+    offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(25)), _mm_set1_epi8('a' - 'A' - 26)));
+    offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(51)), _mm_set1_epi8('0' - 'a' - 26)));
+    offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(62)), _mm_set1_epi8('+' - '0' - 10)));
+    offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(63)), _mm_set1_epi8('/' - '0' - 11)));
+    _mm_storeu_si128((__m128i *)dst, _mm_add_epi8(values, offsets));
+  }
+
+  //Decode 16 characters to 12 bytes. Returns false if a character is not in the alphabet.
+  static inline bool decodeBase64Block(const char * src, uint8_t * dst)
+  {
+    const __m128i chars = _mm_loadu_si128((const __m128i *)src);
+    const __m128i upper = inRange(chars, 'A', 'Z');
+    const __m128i lower = inRange(chars, 'a', 'z');
+    const __m128i digit = inRange(chars, '0', '9');
+    const __m128i plus  = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+      return false;
+
+    __m128i offsets =                   _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(plus,  _mm_set1_epi8(62 - '+')));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+    const __m128i values = _mm_add_epi8(chars, offsets);
+
+    //join the 4 values of 6 bits of each 32 bit lane in a group of 3 bytes
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i groups =                  _mm_slli_epi32(_mm_and_si128(values, mask), 18);
+    groups = _mm_or_si128(groups, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(values, 8), mask), 12));
+    groups = _mm_or_si128(groups, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(values, 16), mask), 6));
+    groups = _mm_or_si128(groups, _mm_srli_epi32(values, 24));
+
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, groups);
+    for(size_t i=0; i<4; i++)
+    {
+      dst[3*i + 0] = (uint8_t)(lanes[i] >> 16);
+      dst[3*i + 1] = (uint8_t)(lanes[i] >> 8);
+      dst[3*i + 2] = (uint8_t)(lanes[i]);
+    }
+    return true;
+  }
+
+  static inline __m128i toHexDigits(__m128i nibbles)
+  {
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+  }
+
+  //Encode 16 bytes to 32 characters.
+  static inline void encodeHexBlock(const uint8_t * src, char * dst)
+  {
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)src);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i high = toHexDigits(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+    const __m128i low  = toHexDigits(_mm_and_si128(bytes, mask));
+    _mm_storeu_si128((__m128i *)(dst +  0), _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi8(high, low));
+  }
+
+  //Convert 16 hexadecimal digits to 8 bytes in the low bytes of 16 bit lanes. Returns false if a character is not a digit.
+  static inline bool decodeHexDigits(const char * src, __m128i & oBytes)
+  {
+    const __m128i chars = _mm_loadu_si128((const __m128i *)src);
+    const __m128i digit = inRange(chars, '0', '9');
+    const __m128i lower = inRange(chars, 'a', 'f');
+    const __m128i upper = inRange(chars, 'A', 'F');
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(digit, lower), upper)) != 0xFFFF)
+      return false;
+
+    __m128i offsets =                   _mm_and_si128(digit, _mm_set1_epi8(-'0'));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(lower, _mm_set1_epi8(10 - 'a')));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(upper, _mm_set1_epi8(10 - 'A')));
+    const __m128i nibbles = _mm_add_epi8(chars, offsets);
+
+    //the first digit of each pair is the high nibble of the byte
+    oBytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x0F)), 4), _mm_srli_epi16(nibbles, 8));
+    return true;
+  }
+
+  //Decode 32 characters to 16 bytes. Returns false if a character is not a digit.
+  static inline bool decodeHexBlock(const char * src, uint8_t * dst)
+  {
+    __m128i first;
+    __m128i second;
+    if (!decodeHexDigits(src, first) || !decodeHexDigits(src + 16, second))
+      return false;
+    _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(first, second));
+    return true;
+  }
+#endif
+
+  size_t get_base64_encoded_size(size_t size)
+  {
+    return (size + 2) / 3 * 4;
+  }
+
+  void encode_base64(const void * src, size_t size, char * dst)
+  {
+    const uint8_t * bytes = (const uint8_t *)src;
+    const uint8_t * end = bytes + size;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    while (end - bytes >= 12)
+    {
+      encodeBase64Block(bytes, dst);
+      bytes += 12;
+      dst += 16;
+    }
+#endif
+
+    while (end - bytes >= 3)
+    {
+      const uint32_t group = (uint32_t)bytes[0] << 16 | (uint32_t)bytes[1] << 8 | bytes[2];
+      dst[0] = BASE64_ALPHABET[(group >> 18) & 0x3F];
+      dst[1] = BASE64_ALPHABET[(group >> 12) & 0x3F];
+      dst[2] = BASE64_ALPHABET[(group >>  6) & 0x3F];
+      dst[3] = BASE64_ALPHABET[group & 0x3F];
+      bytes += 3;
+      dst += 4;
+    }
+
+    //pad the last group
+    const size_t remaining = (size_t)(end - bytes);
+    if (remaining > 0)
+    {
+      const uint32_t group = (uint32_t)bytes[0] << 16 | (remaining > 1 ? (uint32_t)bytes[1] << 8 : 0);
+      dst[0] = BASE64_ALPHABET[(group >> 18) & 0x3F];
+      dst[1] = BASE64_ALPHABET[(group >> 12) & 0x3F];
+      dst[2] = (remaining > 1 ? BASE64_ALPHABET[(group >> 6) & 0x3F] : '=');
+      dst[3] = '=';
+    }
+  }
+
+  size_t get_base64_decoded_size(size_t length)
+  {
+    return (length + 3) / 4 * 3;
+  }
+
+  bool decode_base64(const char * src, size_t length, void * dst, size_t & decoded_size)
+  {
+    const char * end = src + length;
+    uint8_t * const begin = (uint8_t *)dst;
+    uint8_t * out = begin;
+    uint32_t group = 0;
+    size_t count = 0;     //number of values in the current group
+    size_t padding = 0;
+
+    while (src < end)
+    {
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      //decode blocks of characters that are aligned on groups, until a space, the padding or an invalid character
+      if (count == 0 && padding == 0)
+      {
+        while (end - src >= 16 && decodeBase64Block(src, out))
+        {
+          src += 16;
+          out += 12;
+        }
+        if (src == end)
+          break;
+      }
+#endif
+
+      const uint8_t value = gTables.base64[(uint8_t)*src++];
+      if (value == SPACE)
+        continue;
+      if (value == PADDING)
+      {
+        padding++;
+        continue;
+      }
+      if (value == INVALID || padding > 0)
+        return false;
+
+      group = group << 6 | value;
+      count++;
+      if (count == 4)
+      {
+        out[0] = (uint8_t)(group >> 16);
+        out[1] = (uint8_t)(group >> 8);
+        out[2] = (uint8_t)group;
+        out += 3;
+        group = 0;
+        count = 0;
+      }
+    }
+
+    //the last group has 2 or 3 values, completed by the same number of padding characters if any
+    if (count == 1 || (padding > 0 && count + padding != 4))
+      return false;
+    if (count == 2)
+      *out++ = (uint8_t)(group >> 4);
+    else if (count == 3)
+    {
+      *out++ = (uint8_t)(group >> 10);
+      *out++ = (uint8_t)(group >> 2);
+    }
+
+    decoded_size = (size_t)(out - begin);
+    return true;
+  }
+
+  size_t get_hex_encoded_size(size_t size)
+  {
+    return size * 2;
+  }
+
+  void encode_hex(const void * src, size_t size, char * dst)
+  {
+    const uint8_t * bytes = (const uint8_t *)src;
+    const uint8_t * end = bytes + size;
+
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    while (end - bytes >= 16)
+    {
+      encodeHexBlock(bytes, dst);
+      bytes += 16;
+      dst += 32;
+    }
+#endif
+
+    for(; bytes < end; bytes++)
+    {
+      dst[0] = HEX_DIGITS[*bytes >> 4];
+      dst[1] = HEX_DIGITS[*bytes & 0x0F];
+      dst += 2;
+    }
+  }
+
+  size_t get_hex_decoded_size(size_t length)
+  {
+    return length / 2;
+  }
+
+  bool decode_hex(const char * src, size_t length, void * dst, size_t & decoded_size)
+  {
+    const char * end = src + length;
+    uint8_t * const begin = (uint8_t *)dst;
+    uint8_t * out = begin;
+
+    while (src < end)
+    {
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      //decode blocks of digits until a space or an invalid character
+      while (end - src >= 32 && decodeHexBlock(src, out))
+      {
+        src += 32;
+        out += 16;
+      }
+      if (src == end)
+        break;
+#endif
+
+      const uint8_t high = gTables.hex[(uint8_t)*src++];
+      if (high == SPACE)
+        continue;
+      if (high == INVALID || src == end)
+        return false;
+      const uint8_t low = gTables.hex[(uint8_t)*src++];
+      if (low >= 16)
+        return false;
+      *out++ = (uint8_t)(high << 4 | low);
+    }
+
+    decoded_size = (size_t)(out - begin);
+    return true;
+  }
+
+} //namespace win32clipboard
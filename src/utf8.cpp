@@ -0,0 +1,319 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include <string.h>
+#include <stdint.h>
+
+#include "win32clipboard/utf8.h"
+#include "win32clipboard/newline.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WIN32CLIPBOARD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace win32clipboard
+{
+  static inline unsigned lowestBit(unsigned mask)
+  {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    unsigned index = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      index++;
+    }
+    return index;
+#endif
+  }
+
+  // Returns the number of ASCII characters at the beginning of the string.
+  static inline size_t getAsciiLength(const unsigned char * s, size_t length)
+  {
+    size_t i = 0;
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+    for(; i + 16 <= length; i += 16)
+    {
+      const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)));
+      if (mask != 0)
+        return i + lowestBit(mask);
+    }
+#else
+    for(; i + 8 <= length; i += 8)
+    {
+      uint64_t word = 0;
+      memcpy(&word, s + i, sizeof(word));
+      if (word & 0x8080808080808080ull)
+        break;
+    }
+#endif
+    while (i < length && s[i] < 0x80)
+      i++;
+    return i;
+  }
+
+  // Decode a sequence that starts with a non-ASCII byte.
+  // Returns the length of the sequence. Returns 0 if the sequence is ill-formed: invalid is then the length of its maximal subpart.
+  static inline size_t decodeSequence(const unsigned char * s, size_t available, uint32_t & code_point, size_t & invalid)
+  {
+    //See http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf, Table 3-7. Well-Formed UTF-8 Byte Sequences
+    const unsigned c = s[0];
+    size_t length = 0;
+    unsigned lower = 0x80;  //range of the second byte
+    unsigned upper = 0xBF;
+    if (0xC2 <= c && c <= 0xDF)
+    {
+      length = 2;
+      code_point = c & 0x1F;
+    }
+    else if (0xE0 <= c && c <= 0xEF)
+    {
+      length = 3;
+      code_point = c & 0x0F;
+      if (c == 0xE0)
+        lower = 0xA0; //overlong
+      else if (c == 0xED)
+        upper = 0x9F; //surrogates
+    }
+    else if (0xF0 <= c && c <= 0xF4)
+    {
+      length = 4;
+      code_point = c & 0x07;
+      if (c == 0xF0)
+        lower = 0x90; //overlong
+      else if (c == 0xF4)
+        upper = 0x8F; //above U+10FFFF
+    }
+    else
+    {
+      invalid = 1;
+      return 0;
+    }
+
+    for(size_t i=1; i<length; i++)
+    {
+      const unsigned b = (i < available ? s[i] : 0);
+      if (b < lower || b > upper)
+      {
+        invalid = i;
+        return 0;
+      }
+      lower = 0x80;
+      upper = 0xBF;
+      code_point = (code_point << 6) | (b & 0x3F);
+    }
+    return length;
+  }
+
+  // Outputs of the sanitizer. The input is validated once and each output decides what to write.
+  struct NullOutput
+  {
+    inline void ascii(const unsigned char *, size_t) {}
+    inline void sequence(const unsigned char *, size_t, uint32_t) {}
+    inline void replacement() {}
+  };
+
+  struct Utf8Output
+  {
+    Utf8Output(std::string & iDst, size_t iLength, bool iConvertLineEndings) : dst(iDst), pos(0), convert_line_endings(iConvertLineEndings)
+    {
+      //the output is only bigger than the input when ill-formed sequences of 1 or 2 bytes are replaced
+      dst.resize(iLength);
+    }
+
+    inline void reserve(size_t size)
+    {
+      if (pos + size > dst.size())
+        dst.resize(pos + size > 2 * dst.size() ? pos + size : 2 * dst.size());
+    }
+
+    inline void copy(const unsigned char * s, size_t n)
+    {
+      reserve(n);
+      memcpy(&dst[pos], s, n);
+      pos += n;
+    }
+
+    inline void ascii(const unsigned char * s, size_t n)
+    {
+      if (n == 0)
+        return;
+      if (!convert_line_endings)
+      {
+        copy(s, n);
+        return;
+      }
+
+      //runs of ASCII characters are maximal: a CR at the end of a run is not followed by a LF
+      reserve(n);
+      pos += crlf_to_lf((const char *)s, n, &dst[pos]);
+    }
+
+    inline void sequence(const unsigned char * s, size_t n, uint32_t /*code_point*/)
+    {
+      //valid sequences are copied as is
+      copy(s, n);
+    }
+
+    inline void replacement()
+    {
+      static const unsigned char REPLACEMENT[] = { 0xEF, 0xBF, 0xBD }; //U+FFFD
+      copy(REPLACEMENT, sizeof(REPLACEMENT));
+    }
+
+    inline void finish()
+    {
+      dst.resize(pos);
+    }
+
+    std::string & dst;
+    size_t pos;
+    bool convert_line_endings;
+  };
+
+  struct Utf16Output
+  {
+    Utf16Output(std::u16string & iDst, size_t iLength) : dst(iDst), pos(0)
+    {
+      //each byte of the input gives at most one code unit
+      dst.resize(iLength);
+    }
+
+    inline void ascii(const unsigned char * s, size_t n)
+    {
+      if (n == 0)
+        return;
+      char16_t * d = &dst[pos];
+      size_t i = 0;
+#ifdef WIN32CLIPBOARD_HAVE_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      for(; i + 16 <= n; i += 16)
+      {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i + 0), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128((__m128i *)(d + i + 8), _mm_unpackhi_epi8(bytes, zero));
+      }
+#endif
+      for(; i < n; i++)
+        d[i] = (char16_t)s[i];
+      pos += n;
+    }
+
+    inline void sequence(const unsigned char *, size_t, uint32_t code_point)
+    {
+      if (code_point < 0x10000)
+      {
+        dst[pos++] = (char16_t)code_point;
+      }
+      else
+      {
+        code_point -= 0x10000;
+        dst[pos++] = (char16_t)(0xD800 + (code_point >> 10));
+        dst[pos++] = (char16_t)(0xDC00 + (code_point & 0x3FF));
+      }
+    }
+
+    inline void replacement()
+    {
+      dst[pos++] = (char16_t)0xFFFD;
+    }
+
+    inline void finish()
+    {
+      dst.resize(pos);
+    }
+
+    std::u16string & dst;
+    size_t pos;
+  };
+
+  template <typename Output>
+  static inline bool sanitize(const char * str, size_t length, Output & output, Utf8Report & report)
+  {
+    const unsigned char * s = (const unsigned char *)str;
+    report.num_errors = 0;
+    report.first_error = length;
+
+    size_t i = 0;
+    while (i < length)
+    {
+      const size_t ascii = getAsciiLength(s + i, length - i);
+      output.ascii(s + i, ascii);
+      i += ascii;
+      if (i == length)
+        break;
+
+      uint32_t code_point = 0;
+      size_t invalid = 0;
+      const size_t sequence_length = decodeSequence(s + i, length - i, code_point, invalid);
+      if (sequence_length > 0)
+      {
+        output.sequence(s + i, sequence_length, code_point);
+        i += sequence_length;
+      }
+      else
+      {
+        if (report.num_errors == 0)
+          report.first_error = i;
+        report.num_errors++;
+        output.replacement();
+        i += invalid;
+      }
+    }
+    return report.num_errors == 0;
+  }
+
+  bool validate_utf8(const char * str, size_t length, Utf8Report & report)
+  {
+    NullOutput output;
+    return sanitize(str, length, output, report);
+  }
+
+  bool sanitize_utf8(const char * src, size_t length, std::string & dst, Utf8Report & report, bool convert_line_endings)
+  {
+    Utf8Output output(dst, length, convert_line_endings);
+    const bool valid = sanitize(src, length, output, report);
+    output.finish();
+    return valid;
+  }
+
+  bool sanitize_utf8(const char * src, size_t length, std::u16string & dst, Utf8Report & report)
+  {
+    Utf16Output output(dst, length);
+    const bool valid = sanitize(src, length, output, report);
+    output.finish();
+    return valid;
+  }
+
+} //namespace win32clipboard
@@ -30,9 +30,20 @@
 #include <shellApi.h>
 
 #include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/hash.h"
+#include "win32clipboard/dropfiles.h"
+#include "win32clipboard/png.h"
+#include "win32clipboard/newline.h"
+#include "win32clipboard/html.h"
+#include "win32clipboard/stats.h"
+#include "win32clipboard/backend.h"
+#include "win32clipboard/transcode.h"
+#include "win32clipboard/utf8.h"
+#include "win32clipboard/search.h"
+#include "win32clipboard/result.h"
+#include "win32clipboard/textcodec.h"
 
 #include "rapidassist/strings.h"
-#include "rapidassist/environment.h"
 #include "rapidassist/timing.h"
 
 namespace win32clipboard
@@ -40,8 +51,27 @@ namespace win32clipboard
   //Format descriptors for different types of object sent to the clipboard
   static const UINT gFormatDescriptorBinary     = RegisterClipboardFormat("Binary");
   static const UINT gFormatDescriptorDropEffect = RegisterClipboardFormat("Preferred DropEffect");
+  static const UINT gFormatDescriptorPng        = RegisterClipboardFormat("PNG");
+  static const UINT gFormatDescriptorHtml       = RegisterClipboardFormat("HTML Format");
+
+  //Custom formats of utf8-encoded text published by cross-platform applications
+  static const UINT gFormatDescriptorsUtf8[] = {
+    RegisterClipboardFormat("UTF8_STRING"),
+    RegisterClipboardFormat("text/plain;charset=utf-8"),
+  };
+
+  //Statistics of all clipboard operations
+  static StatsRecorder gStats;
+
+  //Result of the last clipboard operation of each thread, and the first failure of the current operation
+  struct Failure
+  {
+    ClipboardResult::Code code;
+    uint32_t system_code;
+  };
+  static thread_local ClipboardResult gLastResult;
+  static thread_local Failure gFailure;
 
-  static const std::string CRLF = ra::environment::GetLineSeparator();
   static const std::string  EMPTY_STRING;
   static const std::wstring EMPTY_WIDE_STRING;
 
@@ -101,80 +131,9 @@ namespace win32clipboard
 
   bool is_utf8_valid(const char * str)
   {
-    int offset = 0;
-    while (str[offset] != '\0')
-    {
-      const char & c1 = str[offset + 0];
-      char c2 = str[offset + 1];
-      char c3 = str[offset + 2];
-      char c4 = str[offset + 3];
-    
-      //prevent going outside of the string
-      if (c1 == '\0')
-        c2 = c3 = c4 = '\0';
-      else if (c2 == '\0')
-        c3 = c4 = '\0';
-      else if (c3 == '\0')
-        c4 = '\0';
-
-      //size in bytes of the code point
-      int n = 1;
-
-      //See http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf, Table 3-7. Well-Formed UTF-8 Byte Sequences
-      // ## | Code Points         | First Byte | Second Byte | Third Byte | Fourth Byte
-      // #1 | U+0000   - U+007F   | 00 - 7F    |             |            | 
-      // #2 | U+0080   - U+07FF   | C2 - DF    | 80 - BF     |            | 
-      // #3 | U+0800   - U+0FFF   | E0         | A0 - BF     | 80 - BF    | 
-      // #4 | U+1000   - U+CFFF   | E1 - EC    | 80 - BF     | 80 - BF    | 
-      // #5 | U+D000   - U+D7FF   | ED         | 80 - 9F     | 80 - BF    | 
-      // #6 | U+E000   - U+FFFF   | EE - EF    | 80 - BF     | 80 - BF    | 
-      // #7 | U+10000  - U+3FFFF  | F0         | 90 - BF     | 80 - BF    | 80 - BF
-      // #8 | U+40000  - U+FFFFF  | F1 - F3    | 80 - BF     | 80 - BF    | 80 - BF
-      // #9 | U+100000 - U+10FFFF | F4         | 80 - 8F     | 80 - BF    | 80 - BF
-
-      if (c1 <= 0x7F) // #1 | U+0000   - U+007F, (ASCII)
-        n = 1;
-      else if ( 0xC2 <= c1 && c1 <= 0xDF &&
-                0x80 <= c2 && c2 <= 0xBF)  // #2 | U+0080   - U+07FF
-        n = 2;
-      else if ( 0xE0 == c1 &&
-                0xA0 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF)  // #3 | U+0800   - U+0FFF
-        n = 3;
-      else if ( 0xE1 <= c1 && c1 <= 0xEC &&
-                0x80 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF)  // #4 | U+1000   - U+CFFF
-        n = 3;
-      else if ( 0xED == c1 &&
-                0x80 <= c2 && c2 <= 0x9F &&
-                0x80 <= c3 && c3 <= 0xBF)  // #5 | U+D000   - U+D7FF
-        n = 3;
-      else if ( 0xEE <= c1 && c1 <= 0xEF &&
-                0x80 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF)  // #6 | U+E000   - U+FFFF
-        n = 3;
-      else if ( 0xF0 == c1 &&
-                0x90 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF &&
-                0x80 <= c4 && c4 <= 0xBF)  // #7 | U+10000  - U+3FFFF
-        n = 4;
-      else if ( 0xF1 <= c1 && c1 <= 0xF3 &&
-                0x80 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF &&
-                0x80 <= c4 && c4 <= 0xBF)  // #8 | U+40000  - U+FFFFF
-        n = 4;
-      else if ( 0xF4 == c1 &&
-                0x80 <= c2 && c2 <= 0xBF &&
-                0x80 <= c3 && c3 <= 0xBF &&
-                0x80 <= c4 && c4 <= 0xBF)  // #7 | U+10000  - U+3FFFF
-        n = 4;
-      else
-        return false; // invalid UTF-8 sequence
-
-      //next code point
-      offset += n;
-    }
-    return true;
+    //the bytes must be compared as unsigned values: see validate_utf8()
+    Utf8Report report;
+    return validate_utf8(str, strlen(str), report);
   }
 
   // Convert a wide Unicode string to an UTF8 string
@@ -239,23 +198,65 @@ namespace win32clipboard
     return str_utf8;
   }
  
-  std::string getLastErrorDescription()
-  {
-    DWORD dwLastError = ::GetLastError();
-    char lpErrorBuffer[10240] = {0};
-    DWORD dwErrorBufferSize = sizeof(lpErrorBuffer);
-    ::FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM,
-                    NULL,
-                    dwLastError,
-                    MAKELANGID(LANG_NEUTRAL,SUBLANG_DEFAULT),
-                    lpErrorBuffer,
-                    dwErrorBufferSize-1,
-                    NULL);
-    char lpDescBuffer[10240] = {0};
-    sprintf(lpDescBuffer, "Error %d, %s", dwLastError, lpErrorBuffer);
-    return std::string(lpDescBuffer);
+  //Record the cause of the failure of the current operation. Only the first failure is kept.
+  static inline void setFailure(ClipboardResult::Code iCode, uint32_t iSystemCode)
+  {
+    if (gFailure.code != ClipboardResult::CodeSuccess)
+      return;
+    gFailure.code = iCode;
+    gFailure.system_code = iSystemCode;
   }
 
+  //Measure a public operation and record its result as the last result of the thread.
+  class OperationScope
+  {
+  public:
+    inline OperationScope(ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind) :
+      mStats(gStats, iOperation, iKind),
+      mOperation(iOperation),
+      mKind(iKind),
+      mEnded(false)
+    {
+      gFailure.code = ClipboardResult::CodeSuccess;
+      gFailure.system_code = 0;
+    }
+
+    inline ~OperationScope()
+    {
+      if (!mEnded)
+        End(false, 0);
+    }
+
+    inline bool End(bool iSuccess, uint64_t iBytes)
+    {
+      mEnded = true;
+      if (iSuccess)
+      {
+        gLastResult.code = ClipboardResult::CodeSuccess;
+        gLastResult.system_code = 0;
+      }
+      else
+      {
+        gLastResult.code = (gFailure.code != ClipboardResult::CodeSuccess ? gFailure.code : ClipboardResult::CodeFailed);
+        gLastResult.system_code = gFailure.system_code;
+      }
+      gLastResult.operation = mOperation;
+      gLastResult.kind = mKind;
+      return mStats.End(iSuccess, iBytes);
+    }
+
+  private:
+    //non-copyable
+    OperationScope(const OperationScope &);
+    OperationScope & operator=(const OperationScope &);
+
+  private:
+    StatsScope mStats;
+    ClipboardStats::Operation mOperation;
+    ClipboardStats::Kind mKind;
+    bool mEnded;
+  };
+
   class ClipboardObject
   {
   public:
@@ -265,19 +266,31 @@ namespace win32clipboard
       mOpenStatus = FALSE;
       mCloseStatus = FALSE;
 
+#ifdef WIN32CLIPBOARD_STATS_ENABLED
+      const uint64_t start = StatsRecorder::GetTimestamp();
+#endif
+
       //Calling OpenClipboard() following a CloseClipboard() may sometimes fails with "Error 0x00000005, Access is denied."
       //Retry a maximum of 5 times to open the clipboard
+      size_t attempts = 0;
+      DWORD last_error = 0;
       for(size_t i=0; i<5 && mOpenStatus == FALSE; i++)
       {
+        attempts++;
         mOpenStatus = OpenClipboard(mHwnd);
         if (mOpenStatus == FALSE)
         {
-          std::string error = getLastErrorDescription();
-
           //Failed opening the clipboard object. Will try again little bit later
+          last_error = ::GetLastError();
           ra::timing::Millisleep(50);
         }
       }
+      if (mOpenStatus == FALSE)
+        setFailure(ClipboardResult::CodeOpenFailed, last_error);
+
+#ifdef WIN32CLIPBOARD_STATS_ENABLED
+      gStats.RecordOpen(isOpened(), attempts - 1, StatsRecorder::GetTimestamp() - start);
+#endif
     }
 
     bool isOpened()
@@ -299,7 +312,246 @@ namespace win32clipboard
     BOOL mCloseStatus;
   };
 
-  Clipboard::Clipboard()
+  class LockedData
+  {
+  public:
+    LockedData(HANDLE hData)
+    {
+      mHandle = hData;
+      mData = NULL;
+      mSize = 0;
+      if (mHandle != NULL)
+      {
+        mData = GlobalLock(mHandle);
+        if (mData != NULL)
+          mSize = (size_t)GlobalSize(mHandle);
+        else
+          setFailure(ClipboardResult::CodeLockFailed, ::GetLastError());
+      }
+    }
+
+    bool isLocked()
+    {
+      return (mData != NULL);
+    }
+
+    const void * getData()
+    {
+      return mData;
+    }
+
+    size_t getSize()
+    {
+      return mSize;
+    }
+
+    ~LockedData()
+    {
+      if (isLocked())
+      {
+        GlobalUnlock(mHandle);
+      }
+    }
+
+  private:
+    HANDLE mHandle;
+    void * mData;
+    size_t mSize;
+  };
+
+  //The clipboard functions below record the cause of their failure. The clipboard must be opened.
+  static HANDLE getClipboardData(UINT uFormat)
+  {
+    HANDLE hData = GetClipboardData(uFormat);
+    if (hData == NULL)
+      setFailure(ClipboardResult::CodeFormatNotAvailable, 0);
+    return hData;
+  }
+
+  static HANDLE setClipboardData(UINT uFormat, HANDLE hMem)
+  {
+    HANDLE hData = SetClipboardData(uFormat, hMem);
+    if (hData == NULL)
+      setFailure(ClipboardResult::CodeSetDataFailed, ::GetLastError());
+    return hData;
+  }
+
+  static BOOL emptyClipboard()
+  {
+    BOOL empty = EmptyClipboard();
+    if (empty == FALSE)
+      setFailure(ClipboardResult::CodeEmptyFailed, ::GetLastError());
+    return empty;
+  }
+
+  static HGLOBAL globalAlloc(UINT uFlags, size_t iSize)
+  {
+    HGLOBAL hMem = GlobalAlloc(uFlags, iSize);
+    if (hMem == NULL)
+      setFailure(ClipboardResult::CodeOutOfMemory, ::GetLastError());
+    return hMem;
+  }
+
+  static UINT getFormatDescriptor(Clipboard::Format iClipboardFormat)
+  {
+    switch(iClipboardFormat)
+    {
+    case Clipboard::FormatText:
+      return CF_TEXT;
+    case Clipboard::FormatUnicode:
+      return CF_UNICODETEXT;
+    case Clipboard::FormatImage:
+      return CF_DIB;
+    case Clipboard::FormatBinary:
+      return gFormatDescriptorBinary;
+    };
+    return 0;
+  }
+
+  static bool isUtf8Format(UINT uFormat)
+  {
+    static const size_t num_formats = sizeof(gFormatDescriptorsUtf8) / sizeof(gFormatDescriptorsUtf8[0]);
+    for(size_t i=0; i<num_formats; i++)
+    {
+      if (uFormat == gFormatDescriptorsUtf8[i])
+        return true;
+    }
+    return false;
+  }
+
+  //Returns the number of bytes of the given clipboard data that matches the value returned by the GetAs*() methods.
+  static size_t getContentSize(UINT uFormat, size_t data_size)
+  {
+    //text formats are returned without the last \0 character
+    if (uFormat == CF_TEXT && data_size >= sizeof(char))
+      return data_size - sizeof(char);
+    if (uFormat == CF_UNICODETEXT && data_size >= sizeof(wchar_t))
+      return (data_size / sizeof(wchar_t) - 1) * sizeof(wchar_t);
+    return data_size;
+  }
+
+  //The clipboard must be opened.
+  static bool hashClipboardData(UINT uFormat, uint64_t & oHash)
+  {
+    HANDLE hData = getClipboardData(uFormat);
+    if (hData == NULL)
+      return false;
+
+    LockedData data(hData);
+    if (!data.isLocked())
+      return false;
+
+    oHash = hash64(data.getData(), getContentSize(uFormat, data.getSize()));
+    return true;
+  }
+
+  //Returns the number of bytes of the given clipboard data up to the terminating character of text formats.
+  static size_t getValueSize(UINT uFormat, const void * data, size_t data_size)
+  {
+    if (uFormat == CF_TEXT || uFormat == CF_OEMTEXT || isUtf8Format(uFormat))
+    {
+      const char * end = (const char *)memchr(data, '\0', data_size);
+      return (end != NULL ? (size_t)(end - (const char *)data) : data_size);
+    }
+    if (uFormat == CF_UNICODETEXT)
+    {
+      const wchar_t * str = (const wchar_t *)data;
+      const size_t count = data_size / sizeof(wchar_t);
+      size_t length = 0;
+      while (length < count && str[length] != 0)
+        length++;
+      return length * sizeof(wchar_t);
+    }
+    return data_size;
+  }
+
+  //Encode an utf8 pattern like the value of the given format.
+  static bool getSearchPattern(Clipboard::Format iClipboardFormat, const std::string & iPattern, std::string & oPattern)
+  {
+    if (iClipboardFormat != Clipboard::FormatUnicode)
+    {
+      oPattern = iPattern;
+      return true;
+    }
+
+    std::u16string utf16;
+    if (!transcode(iPattern, utf16))
+      return false;
+    oPattern.assign((const char *)utf16.data(), utf16.size() * sizeof(char16_t));
+    return true;
+  }
+
+  //Run a query directly on the clipboard data of the given format.
+  //The query is called with the value of the format, its size in bytes and the size of its characters.
+  template <typename Query> static bool queryClipboardData(Clipboard::Format iClipboardFormat, Query & iQuery)
+  {
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    UINT uFormat = getFormatDescriptor(iClipboardFormat);
+    if (uFormat == 0)
+      return false;
+
+    LockedData data(getClipboardData(uFormat));
+    if (!data.isLocked())
+      return false;
+
+    const char * value = (const char *)data.getData();
+    const size_t char_size = (uFormat == CF_UNICODETEXT ? sizeof(wchar_t) : sizeof(char));
+    iQuery(value, getValueSize(uFormat, value, data.getSize()), char_size);
+    return true;
+  }
+
+  struct FindQuery
+  {
+    const std::string * pattern;
+    size_t offset;
+    bool found;
+
+    void operator()(const char * value, size_t size, size_t char_size)
+    {
+      offset = find_bytes(value, size, pattern->data(), pattern->size(), char_size);
+      found = (offset != SEARCH_NOT_FOUND);
+      if (found)
+        offset /= char_size;
+    }
+  };
+
+  struct FindAnyQuery
+  {
+    const PatternSet * patterns;
+    SearchMatch match;
+    bool found;
+
+    void operator()(const char * value, size_t size, size_t char_size)
+    {
+      found = patterns->Find(value, size, match);
+      if (found)
+      {
+        match.offset /= char_size;
+        match.size /= char_size;
+      }
+    }
+  };
+
+  struct AffixQuery
+  {
+    const std::string * pattern;
+    bool suffix;
+    bool found;
+
+    void operator()(const char * value, size_t size, size_t /*char_size*/)
+    {
+      if (suffix)
+        found = ends_with(value, size, pattern->data(), pattern->size());
+      else
+        found = starts_with(value, size, pattern->data(), pattern->size());
+    }
+  };
+
+  Clipboard::Clipboard() :
+    mConvertLineEndings(false)
   {
   }
 
@@ -313,15 +565,47 @@ namespace win32clipboard
     return _instance;
   }
 
+  void Clipboard::SetLineEndingConversion(bool iEnabled)
+  {
+    mConvertLineEndings = iEnabled;
+  }
+
+  bool Clipboard::IsLineEndingConversionEnabled() const
+  {
+    return mConvertLineEndings;
+  }
+
+  void Clipboard::GetStats(ClipboardStats & oStats) const
+  {
+    gStats.GetStats(oStats);
+  }
+
+  void Clipboard::ResetStats()
+  {
+    gStats.Reset();
+  }
+
+  void Clipboard::SetTraceCallback(TraceCallback iCallback, void * iUserData)
+  {
+    gStats.SetTraceCallback(iCallback, iUserData);
+  }
+
+  ClipboardResult Clipboard::GetLastResult() const
+  {
+    return gLastResult;
+  }
+
   bool Clipboard::Empty()
   {
+    OperationScope scope(ClipboardStats::OperationEmpty, ClipboardStats::KindAll);
+
     ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
 
-    BOOL empty = EmptyClipboard();
+    BOOL empty = emptyClipboard();
     
-    return (empty == TRUE);
+    return scope.End(empty == TRUE, 0);
   }
 
   bool Clipboard::IsEmpty()
@@ -340,6 +624,8 @@ namespace win32clipboard
 
   bool Clipboard::Contains(Clipboard::Format iClipboardFormat)
   {
+    OperationScope scope(ClipboardStats::OperationContains, (ClipboardStats::Kind)iClipboardFormat);
+
     ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
@@ -349,229 +635,645 @@ namespace win32clipboard
     {
     case Clipboard::FormatText:
       {
-        HANDLE hData = GetClipboardData(CF_TEXT);
+        HANDLE hData = getClipboardData(CF_TEXT);
         containsFormat = (hData != NULL);
       }
       break;
     case Clipboard::FormatUnicode:
       {
-        HANDLE hData = GetClipboardData(CF_UNICODETEXT);
+        HANDLE hData = getClipboardData(CF_UNICODETEXT);
         containsFormat = (hData != NULL);
       }
       break;
     case Clipboard::FormatImage:
       {
-        HANDLE hData = GetClipboardData(CF_BITMAP);
+        HANDLE hData = getClipboardData(CF_DIB);
         containsFormat = (hData != NULL);
       }
       break;
     case Clipboard::FormatBinary:
       {
-        HANDLE hData = GetClipboardData(gFormatDescriptorBinary);
+        HANDLE hData = getClipboardData(gFormatDescriptorBinary);
         containsFormat = (hData != NULL);
       }
       break;
     };
 
-    return containsFormat;
+    return scope.End(containsFormat, 0);
   }
 
-  template <typename T> inline bool setTextT(UINT uFormat, const T* str, size_t length)
+  template <typename T> inline bool setTextT(UINT uFormat, ClipboardStats::Kind iKind, const T* str, size_t length, bool iConvertLineEndings)
   {
+    OperationScope scope(ClipboardStats::OperationSet, iKind);
+
     ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
 
     //flush existing content
-    if (!EmptyClipboard())
+    if (!emptyClipboard())
       return false;
 
-    size_t memory_size = (length+1)*sizeof(T); // +1 character to include the NULL terminating character
+    //size the memory exactly for the converted text
+    const size_t converted_length = (iConvertLineEndings ? get_crlf_length(str, length) : length);
+    size_t memory_size = (converted_length+1)*sizeof(T); // +1 character to include the NULL terminating character
 
-    //copy data to global allocated memory
-    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, memory_size);
+    //copy data to global allocated memory, converting the line endings on the fly
+    HGLOBAL hMem = globalAlloc(GMEM_MOVEABLE, memory_size);
     if (hMem == NULL)
       return false;
-    void * buffer = GlobalLock(hMem);
-    memcpy(buffer, str, memory_size);
+    T * buffer = (T *)GlobalLock(hMem);
+    if (iConvertLineEndings)
+    {
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, iKind);
+      lf_to_crlf(str, length, buffer);
+      conversion.End(true, converted_length*sizeof(T));
+    }
+    else
+      memcpy(buffer, str, length*sizeof(T));
+    buffer[converted_length] = 0;
     GlobalUnlock(hMem);
 
     //put it on the clipboard
-    HANDLE hData = SetClipboardData(uFormat, hMem);
+    HANDLE hData = setClipboardData(uFormat, hMem);
     if (hData != hMem)
       return false;
 
-    return true;
+    return scope.End(true, memory_size);
   }
  
-  bool Clipboard::SetText(const std::string & iText)
+  //C is the character type of the output string, of the same size as T. For instance, char16_t for wchar_t.
+  template <typename T, typename C> inline bool getTextT(UINT uFormat, ClipboardStats::Kind iKind, std::basic_string<C> & oText, bool iConvertLineEndings)
   {
-    return setTextT<char>(CF_TEXT, iText.data(), iText.length());
-  }
+    static_assert(sizeof(T) == sizeof(C), "Character types must be of the same size");
+
+    OperationScope scope(ClipboardStats::OperationGet, iKind);
 
-  bool Clipboard::GetAsText(std::string & oText)
-  {
     ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
 
-    HANDLE hData = GetClipboardData(CF_TEXT);
+    HANDLE hData = getClipboardData(uFormat);
     if (hData == NULL)
       return false;
 
     size_t data_size = (size_t)GlobalSize(hData);
-    size_t count = data_size / sizeof(char);
-    const char* text_buffer = (const char*)GlobalLock(hData);
-    oText.assign(text_buffer, count-1); //copy the data to output variable, minus the last \0 character
-    GlobalUnlock( hData );
+    size_t count = data_size / sizeof(T);
+    const T* text_buffer = (const T*)GlobalLock(hData);
+    if (iConvertLineEndings)
+    {
+      //convert while copying out of the clipboard memory so that the text is only scanned once
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, iKind);
+      oText.resize(count-1);
+      size_t length = crlf_to_lf(text_buffer, count-1, (T *)&oText[0]);
+      oText.resize(length);
+      conversion.End(true, length*sizeof(T));
+    }
+    else
+    {
+      oText.assign((const C *)text_buffer, count-1); //copy the data to output variable, minus the last \0 character
+    }
+    GlobalUnlock(hData);
 
-    return true;
+    return scope.End(true, data_size);
   }
 
-  bool Clipboard::SetTextUnicode(const std::wstring & iText)
+  bool Clipboard::SetText(const std::string & iText)
   {
-    return setTextT<wchar_t>(CF_UNICODETEXT, iText.data(), iText.length());
+    return setTextT<char>(CF_TEXT, ClipboardStats::KindText, iText.data(), iText.length(), mConvertLineEndings);
   }
 
-  bool Clipboard::GetAsTextUnicode(std::wstring & oText)
+  bool Clipboard::GetAsText(std::string & oText)
   {
-    ClipboardObject obj(DEFAULT_READ_CLIPBOARD_HANDLE);
+    return getTextT<char>(CF_TEXT, ClipboardStats::KindText, oText, mConvertLineEndings);
+  }
+
+  bool Clipboard::GetAsText(std::string & oText, Utf8Report & oReport)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindText);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
 
-    HANDLE hData = GetClipboardData(CF_UNICODETEXT);
+    HANDLE hData = getClipboardData(CF_TEXT);
     if (hData == NULL)
       return false;
 
+    //validate and convert the line endings while copying out of the clipboard memory, minus the last \0 character
     size_t data_size = (size_t)GlobalSize(hData);
-    size_t count = data_size / sizeof(wchar_t);
-    const wchar_t* text_buffer = (const wchar_t*)GlobalLock(hData);
-    oText.assign(text_buffer, count- 1); //copy the data to output variable, minus the last \0 character
+    const char * text_buffer = (const char *)GlobalLock(hData);
+    {
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindText);
+      sanitize_utf8(text_buffer, data_size > 0 ? data_size - 1 : 0, oText, oReport, mConvertLineEndings);
+      conversion.End(true, oText.size());
+    }
     GlobalUnlock(hData);
 
-    return true;
+    return scope.End(true, data_size);
   }
 
-  bool Clipboard::SetBinary(const MemoryBuffer & iMemoryBuffer)
+  bool Clipboard::SetTextUnicode(const std::wstring & iText)
   {
-    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
-    if (!obj.isOpened())
-      return false;
-
-    //flush existing content
-    if (!EmptyClipboard())
-      return false;
-
-    //copy data to global allocated memory
-    HGLOBAL hMem = GlobalAlloc(GMEM_DDESHARE, iMemoryBuffer.size());
-    if (hMem == NULL)
-      return false;
-    void * buffer = GlobalLock(hMem);
-    memcpy(buffer, iMemoryBuffer.c_str(), iMemoryBuffer.size());
-    GlobalUnlock(hMem);
+    return setTextT<wchar_t>(CF_UNICODETEXT, ClipboardStats::KindUnicode, iText.data(), iText.length(), mConvertLineEndings);
+  }
 
-    //put it on the clipboard
-    HANDLE hData = SetClipboardData(gFormatDescriptorBinary, hMem);
-    if (hData != hMem)
-      return false;
+  bool Clipboard::GetAsTextUnicode(std::wstring & oText)
+  {
+    return getTextT<wchar_t>(CF_UNICODETEXT, ClipboardStats::KindUnicode, oText, mConvertLineEndings);
+  }
 
-    return true;
+  bool Clipboard::SetTextUnicode(const std::u16string & iText)
+  {
+    //wchar_t is utf16 on Windows
+    return setTextT<wchar_t>(CF_UNICODETEXT, ClipboardStats::KindUnicode, (const wchar_t *)iText.data(), iText.length(), mConvertLineEndings);
   }
 
-  bool Clipboard::GetAsBinary(MemoryBuffer & oMemoryBuffer)
+  bool Clipboard::GetAsTextUnicode(std::u16string & oText)
   {
-    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
-    if (!obj.isOpened())
-      return false;
+    return getTextT<wchar_t>(CF_UNICODETEXT, ClipboardStats::KindUnicode, oText, mConvertLineEndings);
+  }
 
-    //get the buffer
-    HANDLE hData = GetClipboardData(gFormatDescriptorBinary);
-    if (hData == NULL)
+  bool Clipboard::SetTextUnicode(const std::u32string & iText)
+  {
+    std::u16string text;
+    if (!transcode(iText, text))
       return false;
-
-    size_t data_size = (size_t)GlobalSize(hData);
-    void * buffer = GlobalLock( hData );
-    oMemoryBuffer.assign((const char*)buffer, data_size); //copy the data to output variable
-    GlobalUnlock( hData );
-    
-    return true;
+    return SetTextUnicode(text);
   }
 
-  bool Clipboard::SetDragDropFiles(const Clipboard::DragDropType & iDragDropType, const Clipboard::StringVector & iFiles)
+  bool Clipboard::GetAsTextUnicode(std::u32string & oText)
   {
-    //http://support.microsoft.com/kb/231721/en-us
-    //http://aclacl.brinkster.net/MFC/ch19b.htm
-    //http://read.pudn.com/downloads22/sourcecode/windows/multimedia/73340/ShitClass3/%E7%B1%BB%E5%8C%85/SManageFile.cpp__.htm
-
-    //Validate drag drop type
-    if (iDragDropType != Clipboard::DragDropCopy && iDragDropType != Clipboard::DragDropCut)
+    std::u16string text;
+    if (!GetAsTextUnicode(text))
       return false;
+    return transcode(text, oText);
+  }
+
+  //Select the text format that is the cheapest to convert to utf8 without loss.
+  //The system enumerates the formats placed on the clipboard before the formats it synthesizes from them.
+  //The clipboard must be opened.
+  static UINT getCheapestTextFormat()
+  {
+    UINT ansi = 0;
+    UINT utf8 = 0;
+    bool unicode = false;
+    bool unicode_native = false;
+    UINT uFormat = 0;
+    while ((uFormat = EnumClipboardFormats(uFormat)) != 0)
+    {
+      if (uFormat == CF_UNICODETEXT)
+      {
+        //CF_UNICODETEXT is synthesized if it is enumerated after an ansi format
+        unicode = true;
+        unicode_native = (ansi == 0);
+      }
+      else if (uFormat == CF_TEXT || uFormat == CF_OEMTEXT)
+      {
+        if (ansi == 0)
+          ansi = uFormat;
+      }
+      else if (utf8 == 0 && isUtf8Format(uFormat))
+        utf8 = uFormat;
+    }
+
+    if (unicode_native)
+      return CF_UNICODETEXT;
+    if (utf8 != 0)
+      return utf8;
+    //the system converts the ansi text with the code page of CF_LOCALE, which is more accurate than the code page of the process
+    if (unicode)
+      return CF_UNICODETEXT;
+    return ansi;
+  }
+
+  static void utf16ToUtf8(const wchar_t * str, size_t length, std::string & oText)
+  {
+    //wchar_t is utf16 on Windows
+    if (transcode((const char16_t *)str, length, oText))
+      return;
+
+    //the text contains unpaired surrogates. WideCharToMultiByte() replaces them with U+FFFD.
+    oText = unicode_to_utf8(std::wstring(str, length));
+  }
+
+  static void ansiToUtf8(UINT uFormat, const char * str, size_t length, std::string & oText)
+  {
+    //ascii text is identical in all code pages
+    size_t ascii_length = 0;
+    while (ascii_length < length && (unsigned char)str[ascii_length] < 0x80)
+      ascii_length++;
+    if (ascii_length == length)
+    {
+      oText.assign(str, length);
+      return;
+    }
+
+    const UINT code_page = (uFormat == CF_OEMTEXT ? CP_OEMCP : CP_ACP);
+    int num_characters = MultiByteToWideChar(code_page, 0, str, (int)length, NULL, 0);
+    std::wstring unicode(num_characters, 0);
+    if (num_characters > 0)
+      MultiByteToWideChar(code_page, 0, str, (int)length, &unicode[0], num_characters);
+    utf16ToUtf8(unicode.data(), unicode.size(), oText);
+  }
+
+  bool Clipboard::GetText(std::string & oText)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindText);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    UINT uFormat = getCheapestTextFormat();
+    if (uFormat == 0)
+      return false;
+
+    LockedData data( getClipboardData(uFormat) );
+    if (!data.isLocked())
+      return false;
+
+    //convert the value of the format, without its \0 character, while copying it out of the clipboard memory
+    const char * value = (const char *)data.getData();
+    const size_t value_size = getValueSize(uFormat, value, data.getSize());
+    bool line_endings_converted = false;
+    {
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, uFormat == CF_UNICODETEXT ? ClipboardStats::KindUnicode : ClipboardStats::KindText);
+      if (uFormat == CF_UNICODETEXT)
+        utf16ToUtf8((const wchar_t *)value, value_size / sizeof(wchar_t), oText);
+      else if (isUtf8Format(uFormat))
+      {
+        //the line endings of UTF-8 formats are converted while validating
+        Utf8Report report;
+        sanitize_utf8(value, value_size, oText, report, mConvertLineEndings);
+        line_endings_converted = true;
+      }
+      else
+        ansiToUtf8(uFormat, value, value_size, oText);
+      conversion.End(true, oText.size());
+    }
+
+    //the transcoded formats are converted in a separate pass over the output
+    if (mConvertLineEndings && !line_endings_converted && !oText.empty())
+      oText.resize(crlf_to_lf(oText.data(), oText.size(), &oText[0]));
+
+    return scope.End(true, data.getSize());
+  }
+
+  bool Clipboard::SetBinary(const MemoryBuffer & iMemoryBuffer)
+  {
+    OperationScope scope(ClipboardStats::OperationSet, ClipboardStats::KindBinary);
 
     ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
       return false;
 
     //flush existing content
-    if (!EmptyClipboard())
+    if (!emptyClipboard())
       return false;
 
-    //Register iFiles
+    //copy data to global allocated memory
+    HGLOBAL hMem = globalAlloc(GMEM_DDESHARE, iMemoryBuffer.size());
+    if (hMem == NULL)
+      return false;
+    void * buffer = GlobalLock(hMem);
+    memcpy(buffer, iMemoryBuffer.c_str(), iMemoryBuffer.size());
+    GlobalUnlock(hMem);
+
+    //put it on the clipboard
+    HANDLE hData = setClipboardData(gFormatDescriptorBinary, hMem);
+    if (hData != hMem)
+      return false;
+
+    return scope.End(true, iMemoryBuffer.size());
+  }
+
+  bool Clipboard::GetAsBinary(MemoryBuffer & oMemoryBuffer)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindBinary);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //get the buffer
+    HANDLE hData = getClipboardData(gFormatDescriptorBinary);
+    if (hData == NULL)
+      return false;
+
+    size_t data_size = (size_t)GlobalSize(hData);
+    void * buffer = GlobalLock( hData );
+    oMemoryBuffer.assign((const char*)buffer, data_size); //copy the data to output variable
+    GlobalUnlock( hData );
+    
+    return scope.End(true, data_size);
+  }
+
+  bool Clipboard::SetBinaryAsText(const MemoryBuffer & iMemoryBuffer, TextEncoding iEncoding)
+  {
+    OperationScope scope(ClipboardStats::OperationSet, ClipboardStats::KindText);
+
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //flush existing content
+    if (!emptyClipboard())
+      return false;
+
+    //size the memory exactly for the encoded text and its NULL terminating character
+    const size_t length = (iEncoding == TextEncodingHex ? get_hex_encoded_size(iMemoryBuffer.size()) : get_base64_encoded_size(iMemoryBuffer.size()));
+    HGLOBAL hMem = globalAlloc(GMEM_MOVEABLE, length + 1);
+    if (hMem == NULL)
+      return false;
+    char * buffer = (char *)GlobalLock(hMem);
+    {
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindBinary);
+      if (iEncoding == TextEncodingHex)
+        encode_hex(iMemoryBuffer.data(), iMemoryBuffer.size(), buffer);
+      else
+        encode_base64(iMemoryBuffer.data(), iMemoryBuffer.size(), buffer);
+      conversion.End(true, length);
+    }
+    buffer[length] = 0;
+    GlobalUnlock(hMem);
+
+    //put it on the clipboard
+    HANDLE hData = setClipboardData(CF_TEXT, hMem);
+    if (hData != hMem)
+      return false;
+
+    return scope.End(true, length + 1);
+  }
+
+  bool Clipboard::GetAsBinaryFromText(MemoryBuffer & oMemoryBuffer, TextEncoding iEncoding)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindText);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    LockedData data( getClipboardData(CF_TEXT) );
+    if (!data.isLocked())
+      return false;
+
+    //decode the text, without its \0 character, while copying it out of the clipboard memory
+    const char * text = (const char *)data.getData();
+    const size_t length = getValueSize(CF_TEXT, text, data.getSize());
+    StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindBinary);
+    oMemoryBuffer.resize(iEncoding == TextEncodingHex ? get_hex_decoded_size(length) : get_base64_decoded_size(length));
+    size_t size = 0;
+    const bool decoded = (iEncoding == TextEncodingHex ?
+      decode_hex(text, length, &oMemoryBuffer[0], size) :
+      decode_base64(text, length, &oMemoryBuffer[0], size));
+    if (!decoded)
     {
-      DROPFILES df = {0};
-      df.pFiles = sizeof(DROPFILES);
-      df.pt.x = 0;
-      df.pt.y = 0;
-      df.fNC = FALSE;
-      df.fWide = TRUE; //we will use WIDE CHAR for storing the file paths
+      oMemoryBuffer.clear();
+      return false;
+    }
+    oMemoryBuffer.resize(size);
+    conversion.End(true, size);
 
-      //Build the buffer content
-      MemoryBuffer buff;
+    return scope.End(true, data.getSize());
+  }
 
-      //append the DROPFILES structure
-      buff.assign((const char *)&df, sizeof(df));
+  bool Clipboard::SetImage(const Image & iImage)
+  {
+    OperationScope scope(ClipboardStats::OperationSet, ClipboardStats::KindImage);
 
-      //append each files
-      for(size_t i=0; i<iFiles.size(); i++)
-      {
-        const std::string & utf8_file_path = iFiles[i];
+    if (iImage.GetPixels() == NULL)
+      return false;
 
-        //Convert utf8 to unicode
-        std::wstring unicode_file_path = utf8_to_unicode(utf8_file_path);
+    //encode the PNG before modifying the clipboard: the content is not lost if the encoding fails
+    std::string png;
+    StatsScope png_conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindImage);
+    bool png_encoded = encode_png(iImage, png); //before png.size(): the order of evaluation of the arguments is unspecified
+    if (!png_conversion.End(png_encoded, png.size()))
+      return false;
 
-        //append
-        const char * data_buffer = (const char*)unicode_file_path.c_str();
-        const size_t data_size_bytes = (unicode_file_path.size() + 1) * sizeof(unicode_file_path[0]); // +1 for including the NULL terminating character
-        buff.append(data_buffer, data_size_bytes);
-      }
-        
-      //Append final empty filepath
-      {
-        //Convert utf8 to unicode
-        std::wstring unicode_file_path = utf8_to_unicode("");
+    //encode the image directly into global allocated memory
+    const size_t buffer_size = get_dib_size(iImage);
+    HGLOBAL hMem = globalAlloc(GMEM_MOVEABLE, buffer_size);
+    if (hMem == NULL)
+      return false;
+    void * buffer = GlobalLock(hMem);
+    StatsScope dib_conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindImage);
+    bool encoded = dib_conversion.End(encode_dib(iImage, buffer, buffer_size), buffer_size);
+    GlobalUnlock(hMem);
+    if (!encoded)
+    {
+      GlobalFree(hMem);
+      return false;
+    }
 
-        //append
-        const char * data_buffer = (const char*)unicode_file_path.c_str();
-        const size_t data_size_bytes = (unicode_file_path.size() + 1) * sizeof(unicode_file_path[0]); // +1 for including the NULL terminating character
-        buff.append(data_buffer, data_size_bytes);
-      }
+    HGLOBAL hPng = globalAlloc(GMEM_MOVEABLE, png.size());
+    if (hPng == NULL)
+    {
+      GlobalFree(hMem);
+      return false;
+    }
+    memcpy(GlobalLock(hPng), png.data(), png.size());
+    GlobalUnlock(hPng);
 
-      //copy data to global allocated memory
-      HGLOBAL hMem = GlobalAlloc(GMEM_ZEROINIT|GMEM_MOVEABLE|GMEM_DDESHARE, buff.size());
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened() || !emptyClipboard())
+    {
+      GlobalFree(hMem);
+      GlobalFree(hPng);
+      return false;
+    }
+
+    //put it on the clipboard
+    HANDLE hData = setClipboardData(CF_DIBV5, hMem);
+    if (hData != hMem)
+    {
+      GlobalFree(hMem);
+      GlobalFree(hPng);
+      return false;
+    }
+
+    //also publish the image as PNG for applications that prefer a compressed format.
+    //The image is already published: the PNG format is optional.
+    hData = setClipboardData(gFormatDescriptorPng, hPng);
+    if (hData != hPng)
+    {
+      GlobalFree(hPng);
+      return scope.End(true, buffer_size);
+    }
+
+    return scope.End(true, buffer_size + png.size());
+  }
+
+  bool Clipboard::GetAsImage(Image & oImage)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindImage);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //CF_DIBV5 keeps the alpha channel, CF_DIB is the most widely available
+    const UINT formats[] = { CF_DIBV5, CF_DIB };
+    static const size_t num_formats = sizeof(formats) / sizeof(formats[0]);
+    for(size_t i=0; i<num_formats; i++)
+    {
+      LockedData data( getClipboardData(formats[i]) );
+      if (!data.isLocked())
+        continue;
+
+      //view the pixels in place and convert them once into the output image
+      DibView view;
+      if (!parse_dib(data.getData(), data.getSize(), view))
+        continue;
+
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindImage);
+      decode_dib(view, oImage);
+      conversion.End(true, oImage.GetStride() * oImage.GetHeight());
+      return scope.End(true, data.getSize());
+    }
+
+    //some applications only publish PNG images
+    LockedData png( getClipboardData(gFormatDescriptorPng) );
+    if (!png.isLocked())
+      return false;
+
+    StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindImage);
+    bool decoded = decode_png(png.getData(), png.getSize(), oImage);
+    if (!conversion.End(decoded, oImage.GetStride() * oImage.GetHeight()))
+      return false;
+
+    return scope.End(true, png.getSize());
+  }
+
+  bool Clipboard::SetHtml(const std::string & iFragment, const std::string & iText)
+  {
+    OperationScope scope(ClipboardStats::OperationSet, ClipboardStats::KindHtml);
+
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //flush existing content
+    if (!emptyClipboard())
+      return false;
+
+    //the size of the header is fixed: encode the header and the document directly into global allocated memory
+    const size_t buffer_size = get_cf_html_size(iFragment.size());
+    HGLOBAL hMem = globalAlloc(GMEM_MOVEABLE, buffer_size);
+    if (hMem == NULL)
+      return false;
+    void * buffer = GlobalLock(hMem);
+    StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindHtml);
+    bool encoded = conversion.End(encode_cf_html(iFragment.data(), iFragment.size(), buffer, buffer_size), buffer_size);
+    GlobalUnlock(hMem);
+    if (!encoded)
+    {
+      GlobalFree(hMem);
+      return false;
+    }
+
+    //put it on the clipboard
+    HANDLE hData = setClipboardData(gFormatDescriptorHtml, hMem);
+    if (hData != hMem)
+      return false;
+
+    //plain text alternative
+    if (!iText.empty())
+    {
+      HGLOBAL hText = globalAlloc(GMEM_MOVEABLE, iText.size() + 1);
+      if (hText == NULL)
+        return false;
+      memcpy(GlobalLock(hText), iText.c_str(), iText.size() + 1);
+      GlobalUnlock(hText);
+
+      hData = setClipboardData(CF_TEXT, hText);
+      if (hData != hText)
+        return false;
+    }
+
+    return scope.End(true, buffer_size + (iText.empty() ? 0 : iText.size() + 1));
+  }
+
+  bool Clipboard::GetAsHtml(std::string & oFragment)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindHtml);
+
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    LockedData data( getClipboardData(gFormatDescriptorHtml) );
+    if (!data.isLocked())
+      return false;
+
+    //locate the fragment from the offsets of the header and only copy the fragment
+    HtmlView view;
+    if (!parse_cf_html(data.getData(), data.getSize(), view))
+      return false;
+
+    oFragment.assign(view.fragment, view.fragment_size);
+    return scope.End(true, view.fragment_size);
+  }
+
+  bool Clipboard::GetAsTable(Table & oTable, char iDelimiter)
+  {
+    std::string text;
+    if (!GetAsText(text))
+      return false;
+
+    //the table keeps the text and only records the position of the cells
+    return oTable.Assign(text, iDelimiter);
+  }
+
+  bool Clipboard::SetDragDropFiles(const Clipboard::DragDropType & iDragDropType, const Clipboard::StringVector & iFiles)
+  {
+    //http://support.microsoft.com/kb/231721/en-us
+    //http://aclacl.brinkster.net/MFC/ch19b.htm
+    //http://read.pudn.com/downloads22/sourcecode/windows/multimedia/73340/ShitClass3/%E7%B1%BB%E5%8C%85/SManageFile.cpp__.htm
+
+    OperationScope scope(ClipboardStats::OperationSet, ClipboardStats::KindDragDropFiles);
+
+    //Validate drag drop type
+    if (iDragDropType != Clipboard::DragDropCopy && iDragDropType != Clipboard::DragDropCut)
+      return false;
+
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //flush existing content
+    if (!emptyClipboard())
+      return false;
+
+    //compute the exact size of the CF_HDROP buffer once: it is also the size reported to the statistics
+    const size_t buffer_size = get_dropfiles_size(iFiles);
+
+    //Register iFiles
+    {
+      //encode the files directly into global allocated memory
+      HGLOBAL hMem = globalAlloc(GMEM_ZEROINIT|GMEM_MOVEABLE|GMEM_DDESHARE, buffer_size);
       if (hMem == NULL)
         return false;
       void * buffer = GlobalLock(hMem);
-      memcpy(buffer, buff.c_str(), buff.size());
+      StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindDragDropFiles);
+      bool encoded = conversion.End(encode_dropfiles(iFiles, buffer, buffer_size), buffer_size);
       GlobalUnlock(hMem);
+      if (!encoded)
+      {
+        GlobalFree(hMem);
+        return false;
+      }
 
       //put it on the clipboard
-      HANDLE hData = SetClipboardData( CF_HDROP, hMem );
+      HANDLE hData = setClipboardData( CF_HDROP, hMem );
       if (hData != hMem)
         return false;
     }
 
     //Register iDragDropType
     {
-      HGLOBAL hDropEffect = GlobalAlloc(GMEM_ZEROINIT|GMEM_MOVEABLE|GMEM_DDESHARE,sizeof(DWORD));
+      HGLOBAL hDropEffect = globalAlloc(GMEM_ZEROINIT|GMEM_MOVEABLE|GMEM_DDESHARE,sizeof(DWORD));
       DWORD * dwDropEffect = (DWORD*)GlobalLock(hDropEffect);
       if (iDragDropType == Clipboard::DragDropCopy)
         (*dwDropEffect) = DROPEFFECT_COPY /*| DROPEFFECT_LINK*/;
@@ -580,19 +1282,29 @@ namespace win32clipboard
       GlobalUnlock(hDropEffect);
 
       //put it on the clipboard
-      HANDLE hData = SetClipboardData( gFormatDescriptorDropEffect, hDropEffect );
+      HANDLE hData = setClipboardData( gFormatDescriptorDropEffect, hDropEffect );
       if (hData != hDropEffect)
         return false;
     }
 
-    return true;
+    return scope.End(true, buffer_size + sizeof(DWORD));
   }
 
   bool Clipboard::GetAsDragDropFiles(DragDropType & oDragDropType, Clipboard::StringVector & oFiles)
   {
+    DropFileList files;
+    bool success = GetAsDragDropFiles(oDragDropType, files);
+    files.ToVector(oFiles);
+    return success;
+  }
+
+  bool Clipboard::GetAsDragDropFiles(DragDropType & oDragDropType, DropFileList & oFiles)
+  {
+    OperationScope scope(ClipboardStats::OperationGet, ClipboardStats::KindDragDropFiles);
+
     //Invalidate
     oDragDropType = Clipboard::DragDropType(-1);
-    oFiles.clear();
+    oFiles.Clear();
 
     ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
     if (!obj.isOpened())
@@ -600,25 +1312,20 @@ namespace win32clipboard
 
     //Detect if CUT or COPY
     {
-      HANDLE hDropEffect = ::GetClipboardData (gFormatDescriptorDropEffect);
-      if (hDropEffect)
+      LockedData drop_effect( getClipboardData(gFormatDescriptorDropEffect) );
+      if (drop_effect.isLocked() && drop_effect.getSize() >= sizeof(DWORD))
       {
-        LPVOID lpResults = GlobalLock(hDropEffect);
-        {
-          SIZE_T lBufferSize = GlobalSize(lpResults);
-          DWORD dropEffect = *((DWORD*)lpResults);
-          //if (dropEffect == DROPEFFECT_NONE)
-          //  "NONE:"
-          if (dropEffect & DROPEFFECT_COPY)
-            oDragDropType = DragDropCopy;
-          else if (dropEffect & DROPEFFECT_MOVE)
-            oDragDropType = DragDropCut;
-          //if (dropEffect & DROPEFFECT_LINK)
-          //  "LINK:"
-          //if (dropEffect & DROPEFFECT_SCROLL)
-          //  "SCROLL:"
-        }
-        GlobalUnlock(hDropEffect);
+        DWORD dropEffect = *((const DWORD*)drop_effect.getData());
+        //if (dropEffect == DROPEFFECT_NONE)
+        //  "NONE:"
+        if (dropEffect & DROPEFFECT_COPY)
+          oDragDropType = DragDropCopy;
+        else if (dropEffect & DROPEFFECT_MOVE)
+          oDragDropType = DragDropCut;
+        //if (dropEffect & DROPEFFECT_LINK)
+        //  "LINK:"
+        //if (dropEffect & DROPEFFECT_SCROLL)
+        //  "SCROLL:"
       }
 
       if (oDragDropType == -1)
@@ -629,55 +1336,294 @@ namespace win32clipboard
     }
 
     //Retreive files
-    HDROP hDrop = (HDROP) ::GetClipboardData (CF_HDROP);
-    if (hDrop == NULL)
+    //The DROPFILES structure is parsed directly instead of calling DragQueryFile() for each file
+    //which limits the length of the file paths to MAX_PATH.
+    LockedData drop( getClipboardData(CF_HDROP) );
+    if (!drop.isLocked())
       return false;
 
-    LPVOID lpResults = GlobalLock(hDrop);
-    if (hDrop == NULL)
+    StatsScope conversion(gStats, ClipboardStats::OperationConvert, ClipboardStats::KindDragDropFiles);
+    bool is_wide = false;
+    if (!decode_dropfiles(drop.getData(), drop.getSize(), oFiles, is_wide))
       return false;
 
-    SIZE_T lBufferSize = GlobalSize(lpResults);
-              
-    // Find out how many file names the HDROP Contains.
-    int nCount = ::DragQueryFile (hDrop, (UINT) -1, NULL, 0);
-    if (nCount == 0)
+    //Convert ansi file paths to utf8
+    if (!is_wide)
+    {
+      DropFileList ansi_files = oFiles;
+      oFiles.Clear();
+      for(size_t i=0; i<ansi_files.GetCount(); i++)
+      {
+        std::string file_path = ansi_to_utf8(std::string(ansi_files.GetPath(i), ansi_files.GetLength(i)));
+        oFiles.Append(file_path.c_str(), file_path.size());
+      }
+    }
+
+    conversion.End(true, drop.getSize());
+
+    if (oFiles.GetCount() == 0)
       return false;
+          
+    return scope.End(true, drop.getSize());
+  }
 
-    //Find out if files are unicode or ansi
-    DROPFILES df = {0};
-    df = *( ((DROPFILES*)lpResults) );
-    bool isUnicode = (df.fWide == 1);
+  bool Clipboard::Hash(Clipboard::Format iClipboardFormat, uint64_t & oHash)
+  {
+    OperationScope scope(ClipboardStats::OperationHash, (ClipboardStats::Kind)iClipboardFormat);
 
-    // Enumerate the file names.
-    for (int i=0; i<nCount; i++)
-    {
-      std::string file_path;
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
 
-      if (isUnicode)
-      {
-        WCHAR szFile[MAX_PATH];
-        UINT length = ::DragQueryFileW (hDrop, i, szFile, sizeof (szFile) / sizeof (WCHAR));
-                  
-        std::wstring utf16_file_path = szFile;
+    UINT uFormat = getFormatDescriptor(iClipboardFormat);
+    if (uFormat == 0)
+      return false;
+
+    return scope.End(hashClipboardData(uFormat, oHash), 0);
+  }
+
+  bool Clipboard::GetFingerprint(uint64_t & oFingerprint)
+  {
+    OperationScope scope(ClipboardStats::OperationHash, ClipboardStats::KindAll);
 
-        //Convert from unicode to ansi
-        file_path = unicode_to_ansi( utf16_file_path );
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    const UINT formats[] = {
+      CF_TEXT,
+      CF_UNICODETEXT,
+      CF_DIB,
+      gFormatDescriptorBinary,
+      CF_HDROP,
+      gFormatDescriptorDropEffect,
+      gFormatDescriptorHtml,
+    };
+    static const size_t num_formats = sizeof(formats) / sizeof(formats[0]);
+
+    //hash the hash of each available format
+    uint64_t records[2 * num_formats] = {0};
+    for(size_t i=0; i<num_formats; i++)
+    {
+      uint64_t hash = 0;
+      if (hashClipboardData(formats[i], hash))
+      {
+        records[2*i + 0] = formats[i];
+        records[2*i + 1] = hash;
       }
-      else
+    }
+
+    oFingerprint = hash64(records, sizeof(records));
+    return scope.End(true, 0);
+  }
+
+  bool Clipboard::Find(Clipboard::Format iClipboardFormat, const std::string & iPattern, size_t & oOffset)
+  {
+    OperationScope scope(ClipboardStats::OperationFind, (ClipboardStats::Kind)iClipboardFormat);
+
+    std::string pattern;
+    if (!getSearchPattern(iClipboardFormat, iPattern, pattern))
+      return false;
+
+    FindQuery query;
+    query.pattern = &pattern;
+    query.offset = 0;
+    query.found = false;
+    if (!queryClipboardData(iClipboardFormat, query))
+      return false;
+    scope.End(true, 0);
+
+    if (query.found)
+      oOffset = query.offset;
+    return query.found;
+  }
+
+  bool Clipboard::FindAny(Clipboard::Format iClipboardFormat, const PatternSet & iPatterns, SearchMatch & oMatch)
+  {
+    OperationScope scope(ClipboardStats::OperationFind, (ClipboardStats::Kind)iClipboardFormat);
+
+    //the patterns must be encoded like the value of the format
+    const PatternSet::Encoding encoding = (iClipboardFormat == FormatUnicode ? PatternSet::EncodingUtf16 : PatternSet::EncodingBytes);
+    if (iPatterns.GetEncoding() != encoding)
+      return false;
+
+    FindAnyQuery query;
+    query.patterns = &iPatterns;
+    query.found = false;
+    if (!queryClipboardData(iClipboardFormat, query))
+      return false;
+    scope.End(true, 0);
+
+    if (query.found)
+      oMatch = query.match;
+    return query.found;
+  }
+
+  bool Clipboard::StartsWith(Clipboard::Format iClipboardFormat, const std::string & iPattern)
+  {
+    OperationScope scope(ClipboardStats::OperationFind, (ClipboardStats::Kind)iClipboardFormat);
+
+    std::string pattern;
+    if (!getSearchPattern(iClipboardFormat, iPattern, pattern))
+      return false;
+
+    AffixQuery query;
+    query.pattern = &pattern;
+    query.suffix = false;
+    query.found = false;
+    if (!queryClipboardData(iClipboardFormat, query))
+      return false;
+    scope.End(true, 0);
+
+    return query.found;
+  }
+
+  bool Clipboard::EndsWith(Clipboard::Format iClipboardFormat, const std::string & iPattern)
+  {
+    OperationScope scope(ClipboardStats::OperationFind, (ClipboardStats::Kind)iClipboardFormat);
+
+    std::string pattern;
+    if (!getSearchPattern(iClipboardFormat, iPattern, pattern))
+      return false;
+
+    AffixQuery query;
+    query.pattern = &pattern;
+    query.suffix = true;
+    query.found = false;
+    if (!queryClipboardData(iClipboardFormat, query))
+      return false;
+    scope.End(true, 0);
+
+    return query.found;
+  }
+
+  //Standard clipboard formats that can be exchanged with a Backend. Other formats are registered by name.
+  static const struct
+  {
+    UINT id;
+    const char * name;
+  } gStandardFormats[] = {
+    { CF_TEXT,        "CF_TEXT"         },
+    { CF_OEMTEXT,     "CF_OEMTEXT"      },
+    { CF_UNICODETEXT, "CF_UNICODETEXT"  },
+    { CF_LOCALE,      "CF_LOCALE"       },
+    { CF_DIB,         "CF_DIB"          },
+    { CF_DIBV5,       "CF_DIBV5"        },
+    { CF_HDROP,       "CF_HDROP"        },
+  };
+  static const size_t gNumStandardFormats = sizeof(gStandardFormats) / sizeof(gStandardFormats[0]);
+
+  static UINT getFormatId(const std::string & iFormat)
+  {
+    for(size_t i=0; i<gNumStandardFormats; i++)
+    {
+      if (iFormat == gStandardFormats[i].name)
+        return gStandardFormats[i].id;
+    }
+    return RegisterClipboardFormat(iFormat.c_str());
+  }
+
+  static std::string getFormatName(UINT uFormat)
+  {
+    for(size_t i=0; i<gNumStandardFormats; i++)
+    {
+      if (uFormat == gStandardFormats[i].id)
+        return gStandardFormats[i].name;
+    }
+    char name[256] = {0};
+    int length = GetClipboardFormatName(uFormat, name, (int)sizeof(name));
+    if (length <= 0)
+      return std::string();
+    return std::string(name, length);
+  }
+
+  Win32Backend::Win32Backend()
+  {
+  }
+
+  Win32Backend::~Win32Backend()
+  {
+  }
+
+  bool Win32Backend::Write(const ItemList & iItems)
+  {
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    //flush existing content
+    if (!EmptyClipboard())
+      return false;
+
+    for(size_t i=0; i<iItems.size(); i++)
+    {
+      const Item & item = iItems[i];
+      UINT uFormat = getFormatId(item.format);
+      if (uFormat == 0)
+        return false;
+
+      //copy data to global allocated memory
+      HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, item.data.size());
+      if (hMem == NULL)
+        return false;
+      memcpy(GlobalLock(hMem), item.data.data(), item.data.size());
+      GlobalUnlock(hMem);
+
+      //put it on the clipboard
+      HANDLE hData = SetClipboardData(uFormat, hMem);
+      if (hData != hMem)
       {
-        char szFile[MAX_PATH];
-        ::DragQueryFileA (hDrop, i, szFile, sizeof (szFile) / sizeof (char));
-        file_path = szFile;
+        GlobalFree(hMem);
+        return false;
       }
+    }
+
+    return true;
+  }
+
+  bool Win32Backend::Read(const std::string & iFormat, std::string & oData)
+  {
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    UINT uFormat = getFormatId(iFormat);
+    if (uFormat == 0)
+      return false;
+
+    LockedData data( GetClipboardData(uFormat) );
+    if (!data.isLocked())
+      return false;
+
+    oData.assign((const char *)data.getData(), data.getSize());
+    return true;
+  }
+
+  bool Win32Backend::GetFormats(StringVector & oFormats)
+  {
+    oFormats.clear();
 
-      //Add to output files
-      //printf("Reading from clipboard %02d/%02d: %s\n", i+1, nCount, filePath.c_str());
-      oFiles.push_back(file_path);
+    ClipboardObject obj( DEFAULT_READ_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    UINT uFormat = 0;
+    while ((uFormat = EnumClipboardFormats(uFormat)) != 0)
+    {
+      std::string name = getFormatName(uFormat);
+      if (!name.empty())
+        oFormats.push_back(name);
     }
 
-    GlobalUnlock(hDrop);
-          
     return true;
   }
+
+  bool Win32Backend::Empty()
+  {
+    ClipboardObject obj( DEFAULT_WRITE_CLIPBOARD_HANDLE );
+    if (!obj.isOpened())
+      return false;
+
+    return (EmptyClipboard() == TRUE);
+  }
 } //namespace win32clipboard
@@ -0,0 +1,377 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestBackend.h"
+
+#include "win32clipboard/backend.h"
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static Backend::ItemList getSampleItems()
+  {
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.assign("hello\0", 6);
+    items[1].format = Backend::FORMAT_BINARY;
+    for(size_t i=0; i<1000; i++)
+      items[1].data += (char)i;
+    return items;
+  }
+
+  //Write, read and clear the given backend.
+  static void testBackend(Backend & backend)
+  {
+    Backend::StringVector formats;
+    ASSERT_TRUE( backend.Empty() );
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(0, formats.size());
+
+    const Backend::ItemList items = getSampleItems();
+    ASSERT_TRUE( backend.Write(items) );
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(2, formats.size());
+    ASSERT_EQ(std::string(Backend::FORMAT_TEXT), formats[0]);
+    ASSERT_EQ(std::string(Backend::FORMAT_BINARY), formats[1]);
+
+    std::string data;
+    ASSERT_TRUE( backend.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ(items[0].data, data);
+    ASSERT_TRUE( backend.Read(Backend::FORMAT_BINARY, data) );
+    ASSERT_EQ(items[1].data, data);
+    ASSERT_FALSE( backend.Read(Backend::FORMAT_HTML, data) );
+
+    //writing replaces all formats
+    Backend::ItemList html(1);
+    html[0].format = Backend::FORMAT_HTML;
+    html[0].data = "<b>bold</b>";
+    ASSERT_TRUE( backend.Write(html) );
+    ASSERT_FALSE( backend.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_TRUE( backend.Read(Backend::FORMAT_HTML, data) );
+    ASSERT_EQ(html[0].data, data);
+
+    ASSERT_TRUE( backend.Empty() );
+    ASSERT_FALSE( backend.Read(Backend::FORMAT_HTML, data) );
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(0, formats.size());
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestBackend::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestBackend::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestBackend, testMemoryBackend)
+  {
+    MemoryBackend backend;
+    testBackend(backend);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestBackend, testMemoryBackendConcurrentReads)
+  {
+    MemoryBackend backend;
+    const uint64_t sequence = backend.GetSequence();
+    ASSERT_TRUE( backend.Write(getSampleItems()) );
+    ASSERT_EQ(sequence + 1, backend.GetSequence());
+    ASSERT_TRUE( backend.Empty() );
+    ASSERT_EQ(sequence + 2, backend.GetSequence());
+
+    //readers always see a complete value while a writer replaces it
+    static const size_t NUM_READERS = 8;
+    std::atomic<bool> done(false);
+    std::atomic<size_t> errors(0);
+    std::vector<std::thread> readers;
+    for(size_t i=0; i<NUM_READERS; i++)
+    {
+      readers.push_back(std::thread([&]()
+      {
+        std::string data;
+        Backend::StringVector formats;
+        while(!done.load())
+        {
+          if (backend.Read(Backend::FORMAT_TEXT, data) && data.find_first_not_of(data[0]) != std::string::npos)
+            errors++;
+          if (!backend.GetFormats(formats) || formats.size() > 1)
+            errors++;
+        }
+      }));
+    }
+
+    for(size_t i=0; i<2000; i++)
+    {
+      Backend::ItemList items(1);
+      items[0].format = Backend::FORMAT_TEXT;
+      items[0].data.assign(100 + i, (char)('a' + i % 26));
+      ASSERT_TRUE( backend.Write(items) );
+      if (i % 100 == 0)
+      {
+        ASSERT_TRUE( backend.Empty() );
+      }
+    }
+    done = true;
+    for(size_t i=0; i<readers.size(); i++)
+      readers[i].join();
+
+    ASSERT_EQ(0, errors.load());
+    std::string data;
+    ASSERT_TRUE( backend.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ(std::string(2099, (char)('a' + 1999 % 26)), data);
+  }
+
+  TEST_F(TestBackend, testFileBackend)
+  {
+    const std::string path = "TestBackend.testFileBackend.clip";
+    FileBackend backend(path);
+    ASSERT_EQ(path, backend.GetPath());
+    testBackend(backend);
+
+    //the content is shared between backends of the same file
+    const Backend::ItemList items = getSampleItems();
+    ASSERT_TRUE( backend.Write(items) );
+    FileBackend other(path);
+    std::string data;
+    ASSERT_TRUE( other.Read(Backend::FORMAT_BINARY, data) );
+    ASSERT_EQ(items[1].data, data);
+    ASSERT_TRUE( other.Empty() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestBackend, testFileBackendMalformed)
+  {
+    const std::string path = "TestBackend.testFileBackendMalformed.clip";
+    FileBackend backend(path);
+    const Backend::ItemList items = getSampleItems();
+    ASSERT_TRUE( backend.Write(items) );
+
+    //read the file back and truncate it
+    std::string content;
+    {
+      FILE * f = fopen(path.c_str(), "rb");
+      ASSERT_TRUE( f != NULL );
+      char buffer[4096];
+      size_t read = 0;
+      while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+        content.append(buffer, read);
+      fclose(f);
+    }
+
+    for(size_t size=0; size<content.size(); size += 7)
+    {
+      FILE * f = fopen(path.c_str(), "wb");
+      ASSERT_TRUE( f != NULL );
+      fwrite(content.data(), 1, size, f);
+      fclose(f);
+
+      std::string data;
+      Backend::StringVector formats;
+      ASSERT_FALSE( backend.Read(Backend::FORMAT_BINARY, data) );
+      ASSERT_FALSE( backend.GetFormats(formats) );
+    }
+
+    ASSERT_TRUE( backend.Empty() );
+  }
+
+#ifdef __linux__
+  static int waitChild(pid_t pid)
+  {
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+      return -1;
+    return WEXITSTATUS(status);
+  }
+
+  TEST_F(TestBackend, testSharedMemoryBackend)
+  {
+    const std::string name = "/TestBackend.testSharedMemoryBackend";
+    SharedMemoryBackend::Remove(name);
+
+    SharedMemoryBackend backend(name, 64*1024);
+    ASSERT_TRUE( backend.IsValid() );
+    ASSERT_EQ(64*1024, backend.GetCapacity());
+    testBackend(backend);
+
+    //a second instance attaches to the same segment
+    SharedMemoryBackend other(name, 0);
+    ASSERT_TRUE( other.IsValid() );
+    ASSERT_EQ(64*1024, other.GetCapacity());
+    const Backend::ItemList items = getSampleItems();
+    const uint64_t sequence = other.GetSequence();
+    ASSERT_TRUE( backend.Write(items) );
+    ASSERT_GT(other.GetSequence(), sequence);
+    std::string data;
+    ASSERT_TRUE( other.Read(Backend::FORMAT_BINARY, data) );
+    ASSERT_EQ(items[1].data, data);
+
+    //payloads that do not fit are rejected without modifying the clipboard
+    Backend::ItemList big(1);
+    big[0].format = Backend::FORMAT_BINARY;
+    big[0].data.assign(64*1024 + 1, 'x');
+    ASSERT_FALSE( backend.Write(big) );
+    ASSERT_TRUE( other.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ(items[0].data, data);
+
+    ASSERT_TRUE( SharedMemoryBackend::Remove(name) );
+  }
+
+  TEST_F(TestBackend, testSharedMemoryBackendOpenClose)
+  {
+    const std::string name = "/TestBackend.testSharedMemoryBackendOpenClose";
+    SharedMemoryBackend::Remove(name);
+
+    SharedMemoryBackend backend(name, 1024);
+    ASSERT_TRUE( backend.IsValid() );
+
+    //the clipboard must be opened
+    const char * data = NULL;
+    size_t size = 0;
+    ASSERT_FALSE( backend.Clear() );
+    ASSERT_FALSE( backend.SetData(Backend::FORMAT_TEXT, "foo", 3) );
+    ASSERT_FALSE( backend.GetData(Backend::FORMAT_TEXT, data, size) );
+    ASSERT_FALSE( backend.Close() );
+
+    ASSERT_TRUE( backend.Open() );
+    ASSERT_FALSE( backend.Open() );
+    ASSERT_TRUE( backend.Clear() );
+    ASSERT_TRUE( backend.SetData(Backend::FORMAT_TEXT, "foo", 3) );
+    ASSERT_TRUE( backend.SetData(Backend::FORMAT_TEXT, "foobar", 6) );
+    ASSERT_FALSE( backend.SetData(Backend::FORMAT_BINARY, "", 2048) );
+
+    //views point to the shared memory segment
+    ASSERT_TRUE( backend.GetData(Backend::FORMAT_TEXT, data, size) );
+    ASSERT_EQ(std::string("foobar"), std::string(data, size));
+    ASSERT_FALSE( backend.GetData(Backend::FORMAT_BINARY, data, size) );
+    ASSERT_TRUE( backend.Close() );
+
+    Backend::StringVector formats;
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(1, formats.size());
+    ASSERT_EQ(std::string(Backend::FORMAT_TEXT), formats[0]);
+
+    ASSERT_TRUE( SharedMemoryBackend::Remove(name) );
+  }
+
+  TEST_F(TestBackend, testSharedMemoryBackendMultiProcess)
+  {
+    const std::string name = "/TestBackend.testSharedMemoryBackendMultiProcess";
+    SharedMemoryBackend::Remove(name);
+
+    SharedMemoryBackend backend(name, 64*1024);
+    ASSERT_TRUE( backend.IsValid() );
+
+    //each child process copies a value and waits for the next one
+    static const int NUM_CHILDS = 4;
+    pid_t childs[NUM_CHILDS];
+    for(int i=0; i<NUM_CHILDS; i++)
+    {
+      childs[i] = fork();
+      ASSERT_GE(childs[i], 0);
+      if (childs[i] == 0)
+      {
+        SharedMemoryBackend child(name, 0);
+        if (!child.IsValid())
+          _exit(1);
+        for(int j=0; j<100; j++)
+        {
+          Backend::ItemList items(1);
+          items[0].format = Backend::FORMAT_TEXT;
+          items[0].data.assign(1000 + j, (char)('a' + i));
+          if (!child.Write(items))
+            _exit(2);
+        }
+        _exit(0);
+      }
+    }
+
+    //values are never torn
+    for(int j=0; j<1000; j++)
+    {
+      std::string data;
+      if (backend.Read(Backend::FORMAT_TEXT, data))
+      {
+        ASSERT_GE(data.size(), 1000);
+        ASSERT_EQ(std::string::npos, data.find_first_not_of(data[0]));
+      }
+    }
+
+    for(int i=0; i<NUM_CHILDS; i++)
+    {
+      ASSERT_EQ(0, waitChild(childs[i]));
+    }
+
+    ASSERT_TRUE( SharedMemoryBackend::Remove(name) );
+  }
+
+  TEST_F(TestBackend, testSharedMemoryBackendOwnerDead)
+  {
+    const std::string name = "/TestBackend.testSharedMemoryBackendOwnerDead";
+    SharedMemoryBackend::Remove(name);
+
+    SharedMemoryBackend backend(name, 64*1024);
+    ASSERT_TRUE( backend.IsValid() );
+    ASSERT_TRUE( backend.Write(getSampleItems()) );
+    const uint64_t sequence = backend.GetSequence();
+
+    //the child dies while the clipboard is opened
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+      SharedMemoryBackend other(name, 0);
+      if (!other.Open() || !other.SetData(Backend::FORMAT_TEXT, "partial", 7))
+        _exit(1);
+      _exit(0);
+    }
+    ASSERT_EQ(0, waitChild(child));
+
+    //the clipboard is recovered and its content is discarded
+    Backend::StringVector formats;
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(0, formats.size());
+    ASSERT_GT(backend.GetSequence(), sequence);
+
+    ASSERT_TRUE( backend.Write(getSampleItems()) );
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ(2, formats.size());
+
+    ASSERT_TRUE( SharedMemoryBackend::Remove(name) );
+  }
+#endif //__linux__
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,338 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestChunkStore.h"
+
+#include "win32clipboard/chunkstore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string getRandomBuffer(size_t size)
+  {
+    std::string buffer(size, '\0');
+    for(size_t i=0; i<size; i++)
+      buffer[i] = (char)(rand() & 0xFF);
+    return buffer;
+  }
+
+  //Delete the files and the directory of a store.
+  static void deleteStore(const std::string & directory)
+  {
+    remove((directory + "/chunks.pack").c_str());
+    remove((directory + "/chunks.idx").c_str());
+    remove((directory + "/payloads.idx").c_str());
+#ifdef _WIN32
+    _rmdir(directory.c_str());
+#else
+    rmdir(directory.c_str());
+#endif
+  }
+
+  static uint64_t getFileSize(const std::string & path)
+  {
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f == NULL)
+      return 0;
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fclose(f);
+    return (uint64_t)size;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestChunkStore::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestChunkStore::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestChunkStore, testFindChunkBoundary)
+  {
+    srand(0);
+    const std::string data = getRandomBuffer(4 * 1024 * 1024);
+
+    //sizes are within the limits and close to the average
+    std::vector<size_t> sizes;
+    for(size_t offset=0; offset<data.size(); )
+    {
+      const size_t size = find_chunk_boundary(data.data() + offset, data.size() - offset, 2048, 8192, 65536);
+      ASSERT_LE( 1, size );
+      ASSERT_GE( 65536, size );
+      if (offset + size < data.size())
+      {
+        ASSERT_LE( 2048, size );
+      }
+      sizes.push_back(size);
+      offset += size;
+    }
+    const size_t average = data.size() / sizes.size();
+    ASSERT_LT( 4096, average );
+    ASSERT_GT( 16384, average );
+
+    //an insertion only changes the chunks around it
+    std::string edited = data;
+    edited.insert(1000000, "inserted");
+    std::vector<size_t> edited_sizes;
+    for(size_t offset=0; offset<edited.size(); )
+    {
+      const size_t size = find_chunk_boundary(edited.data() + offset, edited.size() - offset, 2048, 8192, 65536);
+      edited_sizes.push_back(size);
+      offset += size;
+    }
+    size_t changed = 0;
+    for(size_t i=0, j=0; i<sizes.size() && j<edited_sizes.size(); i++, j++)
+    {
+      if (sizes[i] != edited_sizes[j])
+        changed++;
+    }
+    ASSERT_GE( 3u, changed );
+
+    //small buffers are a single chunk
+    ASSERT_EQ( 100, find_chunk_boundary(data.data(), 100, 2048, 8192, 65536) );
+    ASSERT_EQ( 0, find_chunk_boundary(data.data(), 0, 2048, 8192, 65536) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestChunkStore, testPutGet)
+  {
+    const std::string directory = "TestChunkStore.testPutGet";
+    deleteStore(directory);
+    {
+      ChunkStore store(directory);
+      ASSERT_TRUE( store.IsValid() );
+      ASSERT_EQ( 0, store.GetPayloadCount() );
+
+      srand(1);
+      const std::string first = getRandomBuffer(1024 * 1024);
+      ChunkStore::Id first_id;
+      ASSERT_TRUE( store.Put(first, first_id) );
+      ASSERT_TRUE( store.Contains(first_id) );
+
+      std::string payload;
+      ASSERT_TRUE( store.Get(first_id, payload) );
+      ASSERT_TRUE( first == payload );
+
+      //a new version of the same document only stores the chunks that changed
+      std::string second = first;
+      second.replace(500000, 10, "0123456789");
+      second.insert(10, "inserted");
+      ChunkStore::Id second_id;
+      const uint64_t bytes_before = store.GetChunkBytes();
+      ASSERT_TRUE( store.Put(second, second_id) );
+      ASSERT_NE( first_id, second_id );
+      ASSERT_GT( 4u * 65536, store.GetChunkBytes() - bytes_before );
+      ASSERT_EQ( first.size() + second.size(), store.GetPayloadBytes() );
+
+      ASSERT_TRUE( store.Get(second_id, payload) );
+      ASSERT_TRUE( second == payload );
+      ASSERT_TRUE( store.Get(first_id, payload) );
+      ASSERT_TRUE( first == payload );
+
+      //storing a payload twice does not use more space
+      const size_t chunks = store.GetChunkCount();
+      ChunkStore::Id id;
+      ASSERT_TRUE( store.Put(first, id) );
+      ASSERT_EQ( first_id, id );
+      ASSERT_EQ( chunks, store.GetChunkCount() );
+      ASSERT_EQ( 2, store.GetPayloadCount() );
+
+      //empty payload
+      ASSERT_TRUE( store.Put("", id) );
+      ASSERT_TRUE( store.Get(id, payload) );
+      ASSERT_TRUE( payload.empty() );
+
+      ChunkStore::Id unknown = { 1, 2 };
+      ASSERT_FALSE( store.Contains(unknown) );
+      ASSERT_FALSE( store.Get(unknown, payload) );
+    }
+
+    //the store is loaded from its files
+    {
+      ChunkStore store(directory);
+      ASSERT_TRUE( store.IsValid() );
+      ASSERT_EQ( 3, store.GetPayloadCount() );
+
+      srand(1);
+      const std::string first = getRandomBuffer(1024 * 1024);
+      ChunkStore::Id first_id;
+      const size_t chunks = store.GetChunkCount();
+      ASSERT_TRUE( store.Put(first, first_id) );
+      ASSERT_EQ( chunks, store.GetChunkCount() );
+      std::string payload;
+      ASSERT_TRUE( store.Get(first_id, payload) );
+      ASSERT_TRUE( first == payload );
+    }
+    deleteStore(directory);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestChunkStore, testInterruptedWrite)
+  {
+    const std::string directory = "TestChunkStore.testInterruptedWrite";
+    deleteStore(directory);
+
+    srand(2);
+    const std::string first = getRandomBuffer(100000);
+    const std::string second = getRandomBuffer(100000);
+    ChunkStore::Id first_id;
+    ChunkStore::Id second_id;
+    {
+      ChunkStore store(directory);
+      ASSERT_TRUE( store.Put(first, first_id) );
+    }
+
+    //incomplete records at the end of the files
+    const char garbage[] = "incomplete record";
+    const char * files[] = { "/chunks.pack", "/chunks.idx", "/payloads.idx" };
+    for(size_t i=0; i<3; i++)
+    {
+      FILE * f = fopen((directory + files[i]).c_str(), "ab");
+      ASSERT_TRUE( f != NULL );
+      fwrite(garbage, 1, sizeof(garbage), f);
+      fclose(f);
+    }
+
+    {
+      ChunkStore store(directory);
+      ASSERT_TRUE( store.IsValid() );
+      ASSERT_EQ( 1, store.GetPayloadCount() );
+      ASSERT_TRUE( store.Put(second, second_id) );
+    }
+
+    //the incomplete records were overwritten
+    ChunkStore store(directory);
+    ASSERT_EQ( 2, store.GetPayloadCount() );
+    ASSERT_EQ( store.GetChunkBytes(), getFileSize(directory + "/chunks.pack") );
+    std::string payload;
+    ASSERT_TRUE( store.Get(first_id, payload) );
+    ASSERT_TRUE( first == payload );
+    ASSERT_TRUE( store.Get(second_id, payload) );
+    ASSERT_TRUE( second == payload );
+
+    deleteStore(directory);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestChunkStore, testCollision)
+  {
+    const std::string directory = "TestChunkStore.testCollision";
+    deleteStore(directory);
+
+    srand(3);
+    const std::string first = getRandomBuffer(100000);
+    ChunkStore::Id first_id;
+    {
+      ChunkStore store(directory);
+      ASSERT_TRUE( store.Put(first, first_id) );
+      ASSERT_TRUE( store.Put(first, first_id) );
+    }
+
+    //change the stored bytes: the stored content now differs from the content its identifiers were computed from,
+    //like a different content with the same identifiers
+    FILE * f = fopen((directory + "/chunks.pack").c_str(), "r+b");
+    ASSERT_TRUE( f != NULL );
+    fseek(f, 10, SEEK_SET);
+    fputc(first[10] ^ 0xFF, f);
+    fclose(f);
+
+    ChunkStore store(directory);
+    ASSERT_TRUE( store.IsValid() );
+
+    //identifiers are not reused for a different content
+    ChunkStore::Id id;
+    ASSERT_FALSE( store.Put(first, id) );
+    ASSERT_FALSE( store.Put(first + "suffix", id) );
+    ASSERT_EQ( 1, store.GetPayloadCount() );
+
+    //other payloads are still stored
+    const std::string second = getRandomBuffer(100000);
+    std::string payload;
+    ASSERT_TRUE( store.Put(second, id) );
+    ASSERT_TRUE( store.Get(id, payload) );
+    ASSERT_TRUE( second == payload );
+
+    deleteStore(directory);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestChunkStore, testSnapshot)
+  {
+    const std::string directory = "TestChunkStore.testSnapshot";
+    deleteStore(directory);
+    ChunkStore store(directory);
+
+    srand(3);
+    MemoryBackend backend;
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.assign("hello\0", 6);
+    items[1].format = Backend::FORMAT_BINARY;
+    items[1].data = getRandomBuffer(500000);
+    ASSERT_TRUE( backend.Write(items) );
+
+    ChunkStore::Id first_id;
+    ASSERT_TRUE( store.SaveSnapshot(backend, first_id) );
+
+    items[0].data.assign("world\0", 6);
+    ASSERT_TRUE( backend.Write(items) );
+    const uint64_t bytes_before = store.GetChunkBytes();
+    ChunkStore::Id second_id;
+    ASSERT_TRUE( store.SaveSnapshot(backend, second_id) );
+    ASSERT_GT( 1024u, store.GetChunkBytes() - bytes_before );
+
+    MemoryBackend restored;
+    ASSERT_TRUE( store.RestoreSnapshot(first_id, restored) );
+    Backend::StringVector formats;
+    ASSERT_TRUE( restored.GetFormats(formats) );
+    ASSERT_EQ( 2, formats.size() );
+    std::string data;
+    ASSERT_TRUE( restored.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ( std::string("hello\0", 6), data );
+    ASSERT_TRUE( restored.Read(Backend::FORMAT_BINARY, data) );
+    ASSERT_TRUE( items[1].data == data );
+
+    ASSERT_TRUE( store.RestoreSnapshot(second_id, restored) );
+    ASSERT_TRUE( restored.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ( std::string("world\0", 6), data );
+
+    //a payload that is not a snapshot
+    ChunkStore::Id id;
+    ASSERT_TRUE( store.Put("not a snapshot", id) );
+    ASSERT_FALSE( store.RestoreSnapshot(id, restored) );
+
+    deleteStore(directory);
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,306 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestClipboardHistory.h"
+
+#include <string.h>
+
+#include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/history.h"
+#include "win32clipboard/transcode.h"
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //--------------------------------------------------------------------------------------------------
+  void TestClipboardHistory::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestClipboardHistory::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  static Backend::ItemList getItem(const char * iFormat, const std::string & iData)
+  {
+    Backend::ItemList items(1);
+    items[0].format = iFormat;
+    items[0].data = iData;
+    return items;
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testBackendText)
+  {
+    MemoryBackend backend;
+    ClipboardHistory history(backend, 10, 1024*1024);
+
+    //the backend stores null terminated strings
+    const std::u16string unicode = utf8_to_utf16("caf\xC3\xA9");
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.assign("foo", 4);
+    items[1].format = Backend::FORMAT_UNICODE;
+    items[1].data.assign((const char *)unicode.c_str(), (unicode.size() + 1) * sizeof(char16_t));
+    ASSERT_TRUE( backend.Write(items) );
+    ASSERT_TRUE( history.Update() );
+
+    //content did not change
+    ASSERT_FALSE( history.Update() );
+    ASSERT_EQ( 1, history.GetCount() );
+
+    const ClipboardHistory::Entry * entry = history.Find(1);
+    ASSERT_TRUE( entry != NULL );
+
+    std::string text;
+    ASSERT_TRUE( entry->GetAsText(text) );
+    ASSERT_EQ( std::string("foo"), text );
+
+    std::wstring wide;
+    ASSERT_TRUE( entry->GetAsTextUnicode(wide) );
+    ASSERT_EQ( std::wstring(L"caf\u00E9"), wide );
+
+    ASSERT_FALSE( entry->Contains(Clipboard::FormatImage) );
+    ASSERT_FALSE( entry->Contains(Clipboard::FormatBinary) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testBackendImage)
+  {
+    MemoryBackend backend;
+    ClipboardHistory history(backend, 10, 1024*1024);
+
+    Image image;
+    image.Create(3, 2);
+    for(size_t i=0; i<image.GetStride() * image.GetHeight(); i++)
+      image.GetPixels()[i] = (i % 4 == 3 ? 255 : (unsigned char)(i * 7));
+
+    std::string dib(get_dib_size(image), '\0');
+    ASSERT_TRUE( encode_dib(image, &dib[0], dib.size()) );
+    ASSERT_TRUE( backend.Write(getItem(Backend::FORMAT_DIB, dib)) );
+    ASSERT_TRUE( history.Update() );
+
+    const ClipboardHistory::Entry * entry = history.Find(1);
+    ASSERT_TRUE( entry != NULL );
+    ASSERT_TRUE( entry->Contains(Clipboard::FormatImage) );
+
+    Image output;
+    ASSERT_TRUE( entry->GetAsImage(output) );
+    ASSERT_EQ( image.GetWidth(), output.GetWidth() );
+    ASSERT_EQ( image.GetHeight(), output.GetHeight() );
+    ASSERT_EQ( 0, memcmp(image.GetPixels(), output.GetPixels(), image.GetStride() * image.GetHeight()) );
+
+    //invalid bitmaps are not captured
+    ASSERT_TRUE( backend.Write(getItem(Backend::FORMAT_DIB, "not a bitmap")) );
+    ASSERT_FALSE( history.Update() );
+    ASSERT_EQ( 1, history.GetCount() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testBackendDragDropFiles)
+  {
+    MemoryBackend backend;
+    ClipboardHistory history(backend, 10, 1024*1024);
+
+    std::vector<std::string> files;
+    files.push_back("C:\\temp\\foo.txt");
+    files.push_back("C:\\temp\\caf\xC3\xA9.txt");
+    std::string hdrop(get_dropfiles_size(files), '\0');
+    ASSERT_TRUE( encode_dropfiles(files, &hdrop[0], hdrop.size()) );
+
+    //DROPEFFECT_MOVE
+    const char move[] = {2, 0, 0, 0};
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_HDROP;
+    items[0].data = hdrop;
+    items[1].format = Backend::FORMAT_DROP_EFFECT;
+    items[1].data.assign(move, sizeof(move));
+    ASSERT_TRUE( backend.Write(items) );
+    ASSERT_TRUE( history.Update() );
+
+    //same files, copied instead of moved
+    items[1].data[0] = 1;
+    ASSERT_TRUE( backend.Write(items) );
+    ASSERT_TRUE( history.Update() );
+    ASSERT_EQ( 2, history.GetCount() );
+    ASSERT_NE( history.Find(1)->GetHash(), history.Find(2)->GetHash() );
+
+    Clipboard::DragDropType type = Clipboard::DragDropCopy;
+    DropFileList list;
+    std::vector<std::string> output;
+    ASSERT_TRUE( history.Find(1)->GetAsDragDropFiles(type, list) );
+    ASSERT_EQ( Clipboard::DragDropCut, type );
+    list.ToVector(output);
+    ASSERT_EQ( files, output );
+
+    ASSERT_TRUE( history.Find(2)->GetAsDragDropFiles(type, list) );
+    ASSERT_EQ( Clipboard::DragDropCopy, type );
+    list.ToVector(output);
+    ASSERT_EQ( files, output );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testArena)
+  {
+    MemoryBackend backend;
+    ClipboardHistory history(backend, 4, 1024*1024);
+
+    //mix entries that share a chunk with entries bigger than a chunk while the oldest are evicted
+    static const size_t sizes[] = {10, 1000, 100*1024, 30, 70*1024, 5, 40*1024, 40*1024, 3, 200*1024, 1, 17};
+    static const size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    for(size_t round=0; round<3; round++)
+    {
+      for(size_t i=0; i<num_sizes; i++)
+      {
+        const std::string data(sizes[i], (char)('a' + round * num_sizes + i));
+        ASSERT_TRUE( backend.Write(getItem(Backend::FORMAT_BINARY, data)) );
+        ASSERT_TRUE( history.Update() );
+      }
+    }
+    ASSERT_EQ( 4, history.GetCount() );
+
+    //the most recent entries are intact
+    for(size_t i=0; i<4; i++)
+    {
+      const size_t index = num_sizes - 4 + i;
+      Clipboard::MemoryBuffer buffer;
+      ASSERT_TRUE( history.Find(history.GetFirstSequence() + i)->GetAsBinary(buffer) );
+      ASSERT_EQ( std::string(sizes[index], (char)('a' + 2 * num_sizes + index)), buffer );
+    }
+
+    history.Clear();
+    ASSERT_EQ( 0, history.GetMemoryUsage() );
+  }
+  //--------------------------------------------------------------------------------------------------
+#ifdef _WIN32
+  TEST_F(TestClipboardHistory, testUpdate)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    ClipboardHistory history(c, 10, 1024*1024);
+
+    ASSERT_TRUE( c.SetText("foo") );
+    ASSERT_TRUE( history.Update() );
+    ASSERT_TRUE( c.SetText("bar") );
+    ASSERT_TRUE( history.Update() );
+
+    //content did not change
+    ASSERT_FALSE( history.Update() );
+
+    ASSERT_EQ( 2, history.GetCount() );
+    ASSERT_EQ( 1, history.GetFirstSequence() );
+    ASSERT_EQ( 2, history.GetLastSequence() );
+
+    std::string text;
+    const ClipboardHistory::Entry * entry = history.Find(1);
+    ASSERT_TRUE( entry != NULL );
+    ASSERT_TRUE( entry->GetAsText(text) );
+    ASSERT_EQ( std::string("foo"), text );
+
+    entry = history.Find(2);
+    ASSERT_TRUE( entry != NULL );
+    ASSERT_TRUE( entry->GetAsText(text) );
+    ASSERT_EQ( std::string("bar"), text );
+
+    ASSERT_TRUE( history.Find(0) == NULL );
+    ASSERT_TRUE( history.Find(3) == NULL );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testCapacity)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    ClipboardHistory history(c, 3, 1024*1024);
+
+    static const char * values[] = {
+      "1",
+      "2",
+      "3",
+      "4",
+      "5",
+    };
+    static const size_t num_values = sizeof(values) / sizeof(values[0]);
+
+    for(size_t i=0; i<num_values; i++)
+    {
+      ASSERT_TRUE( c.SetText(values[i]) );
+      ASSERT_TRUE( history.Update() );
+    }
+
+    //oldest entries are evicted first
+    ASSERT_EQ( 3, history.GetCount() );
+    ASSERT_EQ( 3, history.GetFirstSequence() );
+    ASSERT_EQ( 5, history.GetLastSequence() );
+    ASSERT_TRUE( history.Find(2) == NULL );
+
+    std::string text;
+    ASSERT_TRUE( history.Find(3)->GetAsText(text) );
+    ASSERT_EQ( std::string("3"), text );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testDeduplication)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    ClipboardHistory history(c, 10, 1024*1024);
+
+    Clipboard::MemoryBuffer buffer(1000, 'a');
+    Clipboard::MemoryBuffer other(1000, 'b');
+
+    ASSERT_TRUE( c.SetBinary(buffer) );
+    ASSERT_TRUE( history.Update() );
+    const size_t usage = history.GetMemoryUsage();
+
+    ASSERT_TRUE( c.SetBinary(other) );
+    ASSERT_TRUE( history.Update() );
+    ASSERT_EQ( 2*usage, history.GetMemoryUsage() );
+
+    //same content than the first entry, the payload is shared
+    ASSERT_TRUE( c.SetBinary(buffer) );
+    ASSERT_TRUE( history.Update() );
+    ASSERT_EQ( 3, history.GetCount() );
+    ASSERT_EQ( 2*usage, history.GetMemoryUsage() );
+    ASSERT_EQ( history.Find(1)->GetHash(), history.Find(3)->GetHash() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardHistory, testMemoryBudget)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    ClipboardHistory history(c, 10, 2500);
+
+    for(char value = 'a'; value <= 'e'; value++)
+    {
+      ASSERT_TRUE( c.SetBinary(Clipboard::MemoryBuffer(1000, value)) );
+      ASSERT_TRUE( history.Update() );
+      ASSERT_LE( history.GetMemoryUsage(), (size_t)2500 );
+    }
+
+    //only the 2 most recent entries fit in the budget
+    ASSERT_EQ( 2, history.GetCount() );
+    ASSERT_EQ( 4, history.GetFirstSequence() );
+
+    //payloads bigger than the budget are rejected
+    ASSERT_TRUE( c.SetBinary(Clipboard::MemoryBuffer(3000, 'z')) );
+    ASSERT_FALSE( history.Update() );
+    ASSERT_EQ( 2, history.GetCount() );
+  }
+#endif //_WIN32
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
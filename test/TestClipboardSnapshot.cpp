@@ -0,0 +1,271 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestClipboardSnapshot.h"
+
+#include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/snapshot.h"
+#include "win32clipboard/html.h"
+#include "win32clipboard/transcode.h"
+
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //--------------------------------------------------------------------------------------------------
+  void TestClipboardSnapshot::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestClipboardSnapshot::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  static Backend::Item getItem(const char * iFormat, const std::string & iData)
+  {
+    Backend::Item item;
+    item.format = iFormat;
+    item.data = iData;
+    return item;
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardSnapshot, testBackendCapture)
+  {
+    MemoryBackend backend;
+    ClipboardSnapshot snapshot;
+    ASSERT_FALSE( snapshot.Capture(backend) );
+    ASSERT_TRUE( snapshot.IsEmpty() );
+
+    //the backend stores the formats as the Clipboard: null terminated strings, bitmaps and CF_HTML and CF_HDROP buffers
+    const std::u16string unicode = utf8_to_utf16("caf\xC3\xA9");
+
+    Image image;
+    image.Create(2, 2);
+    for(size_t i=0; i<image.GetStride() * image.GetHeight(); i++)
+      image.GetPixels()[i] = (i % 4 == 3 ? 255 : (unsigned char)(i * 13));
+    std::string dib(get_dib_size(image), '\0');
+    ASSERT_TRUE( encode_dib(image, &dib[0], dib.size()) );
+
+    const std::string fragment = "<b>foo</b>";
+    std::string html(get_cf_html_size(fragment.size()), '\0');
+    ASSERT_TRUE( encode_cf_html(fragment.data(), fragment.size(), &html[0], html.size()) );
+
+    std::vector<std::string> files;
+    files.push_back("C:\\temp\\foo.txt");
+    files.push_back("C:\\temp\\bar.txt");
+    std::string hdrop(get_dropfiles_size(files), '\0');
+    ASSERT_TRUE( encode_dropfiles(files, &hdrop[0], hdrop.size()) );
+    const char move[] = {2, 0, 0, 0}; //DROPEFFECT_MOVE
+
+    Backend::ItemList items;
+    items.push_back(getItem(Backend::FORMAT_TEXT, std::string("foo", 4)));
+    items.push_back(getItem(Backend::FORMAT_UNICODE, std::string((const char *)unicode.c_str(), (unicode.size() + 1) * sizeof(char16_t))));
+    items.push_back(getItem(Backend::FORMAT_DIB, dib));
+    items.push_back(getItem(Backend::FORMAT_BINARY, "bin"));
+    items.push_back(getItem(Backend::FORMAT_HTML, html));
+    items.push_back(getItem(Backend::FORMAT_HDROP, hdrop));
+    items.push_back(getItem(Backend::FORMAT_DROP_EFFECT, std::string(move, sizeof(move))));
+    ASSERT_TRUE( backend.Write(items) );
+
+    ASSERT_TRUE( snapshot.Capture(backend) );
+    ASSERT_FALSE( snapshot.IsEmpty() );
+    for(size_t i=0; i<Clipboard::NUM_FORMATS; i++)
+      ASSERT_TRUE( snapshot.Contains((Clipboard::Format)i) );
+
+    uint64_t fingerprint = 0;
+    ASSERT_FALSE( snapshot.GetFingerprint(fingerprint) );
+
+    std::string text;
+    ASSERT_TRUE( snapshot.GetAsText(text) );
+    ASSERT_EQ( std::string("foo"), text );
+
+    std::wstring wide;
+    ASSERT_TRUE( snapshot.GetAsTextUnicode(wide) );
+    ASSERT_EQ( std::wstring(L"caf\u00E9"), wide );
+
+    Image output;
+    ASSERT_TRUE( snapshot.GetAsImage(output) );
+    ASSERT_EQ( image.GetWidth(), output.GetWidth() );
+    ASSERT_EQ( image.GetHeight(), output.GetHeight() );
+    ASSERT_EQ( 0, memcmp(image.GetPixels(), output.GetPixels(), image.GetStride() * image.GetHeight()) );
+
+    Clipboard::MemoryBuffer binary;
+    ASSERT_TRUE( snapshot.GetAsBinary(binary) );
+    ASSERT_EQ( std::string("bin"), binary );
+
+    ASSERT_TRUE( snapshot.GetAsHtml(text) );
+    ASSERT_EQ( fragment, text );
+
+    Clipboard::DragDropType type = Clipboard::DragDropCopy;
+    DropFileList list;
+    std::vector<std::string> output_files;
+    ASSERT_TRUE( snapshot.GetAsDragDropFiles(type, list) );
+    ASSERT_EQ( Clipboard::DragDropCut, type );
+    list.ToVector(output_files);
+    ASSERT_EQ( files, output_files );
+
+    const size_t expected_size = 3 + 4 * sizeof(wchar_t) + dib.size() + 3 + fragment.size() + hdrop.size();
+    ASSERT_EQ( expected_size, snapshot.GetMemoryUsage() );
+
+    snapshot.Clear();
+    ASSERT_TRUE( snapshot.IsEmpty() );
+    ASSERT_FALSE( snapshot.GetAsHtml(text) );
+    ASSERT_FALSE( snapshot.GetAsDragDropFiles(type, list) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardSnapshot, testBackendSharedBuffers)
+  {
+    MemoryBackend backend;
+    const std::u16string unicode(1000, u'a');
+    Backend::ItemList items;
+    items.push_back(getItem(Backend::FORMAT_UNICODE, std::string((const char *)unicode.data(), unicode.size() * sizeof(char16_t))));
+    items.push_back(getItem(Backend::FORMAT_BINARY, std::string(100000, 'a')));
+    ASSERT_TRUE( backend.Write(items) );
+
+    ClipboardSnapshot snapshot;
+    ASSERT_TRUE( snapshot.Capture(backend) );
+
+    //the unicode text is kept as a wide string and shared by the copies
+    ClipboardSnapshot copy = snapshot;
+    ClipboardSnapshot::UnicodeBuffer buffer = snapshot.GetUnicodeBuffer();
+    ASSERT_TRUE( buffer != NULL );
+    ASSERT_TRUE( buffer == copy.GetUnicodeBuffer() );
+    ASSERT_EQ( std::wstring(1000, L'a'), *buffer );
+    ASSERT_TRUE( snapshot.GetBuffer(Clipboard::FormatUnicode) == NULL );
+
+    const char * data = NULL;
+    size_t size = 0;
+    ASSERT_TRUE( copy.GetData(Clipboard::FormatUnicode, data, size) );
+    ASSERT_TRUE( data == (const char *)buffer->data() );
+    ASSERT_EQ( 1000 * sizeof(wchar_t), size );
+
+    ASSERT_TRUE( snapshot.GetBuffer(Clipboard::FormatBinary) == copy.GetBuffer(Clipboard::FormatBinary) );
+
+    //the buffers outlive the snapshots
+    ASSERT_TRUE( backend.Empty() );
+    ASSERT_FALSE( snapshot.Capture(backend) );
+    copy.Clear();
+    ASSERT_EQ( std::wstring(1000, L'a'), *buffer );
+    ASSERT_EQ( 1, buffer.use_count() );
+  }
+  //--------------------------------------------------------------------------------------------------
+#ifdef _WIN32
+  TEST_F(TestClipboardSnapshot, testCapture)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    ClipboardSnapshot snapshot;
+    ASSERT_TRUE( snapshot.IsEmpty() );
+    ASSERT_EQ( 0, snapshot.GetMemoryUsage() );
+    ASSERT_FALSE( snapshot.Contains(Clipboard::FormatText) );
+    ASSERT_TRUE( snapshot.GetBuffer(Clipboard::FormatText) == NULL );
+
+    ASSERT_TRUE( c.SetText("foo") );
+    ASSERT_TRUE( snapshot.Capture(c) );
+    ASSERT_FALSE( snapshot.IsEmpty() );
+    ASSERT_TRUE( snapshot.Contains(Clipboard::FormatText) );
+
+    std::string text;
+    ASSERT_TRUE( snapshot.GetAsText(text) );
+    ASSERT_EQ( std::string("foo"), text );
+
+    const char * data = NULL;
+    size_t size = 0;
+    ASSERT_TRUE( snapshot.GetData(Clipboard::FormatText, data, size) );
+    ASSERT_EQ( std::string("foo"), std::string(data, size) );
+
+    snapshot.Clear();
+    ASSERT_TRUE( snapshot.IsEmpty() );
+    ASSERT_FALSE( snapshot.GetAsText(text) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardSnapshot, testSharedBuffers)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    const Clipboard::MemoryBuffer value(100000, 'a');
+    ASSERT_TRUE( c.SetBinary(value) );
+
+    ClipboardSnapshot snapshot;
+    ASSERT_TRUE( snapshot.Capture(c) );
+    ASSERT_EQ( value.size(), snapshot.GetMemoryUsage() );
+
+    //copies share the same buffer
+    ClipboardSnapshot copy = snapshot;
+    ClipboardSnapshot::Buffer buffer = snapshot.GetBuffer(Clipboard::FormatBinary);
+    ASSERT_TRUE( buffer != NULL );
+    ASSERT_TRUE( buffer == copy.GetBuffer(Clipboard::FormatBinary) );
+    ASSERT_EQ( value, *buffer );
+
+    //the buffer outlives the snapshots
+    ASSERT_TRUE( c.SetBinary(Clipboard::MemoryBuffer(10, 'b')) );
+    ASSERT_TRUE( snapshot.Capture(c) );
+    copy.Clear();
+    ASSERT_EQ( Clipboard::MemoryBuffer(10, 'b'), *snapshot.GetBuffer(Clipboard::FormatBinary) );
+    ASSERT_EQ( value, *buffer );
+    ASSERT_EQ( 1, buffer.use_count() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestClipboardSnapshot, testThreads)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    const Clipboard::MemoryBuffer value(100000, 'z');
+    ASSERT_TRUE( c.SetBinary(value) );
+
+    ClipboardSnapshot snapshot;
+    ASSERT_TRUE( snapshot.Capture(c) );
+
+    //each thread reads its own copy of the snapshot
+    static const size_t NUM_THREADS = 8;
+    std::vector<std::thread> threads;
+    std::vector<int> matches(NUM_THREADS, 0);
+    for(size_t i=0; i<NUM_THREADS; i++)
+    {
+      ClipboardSnapshot copy = snapshot;
+      int * match = &matches[i];
+      threads.push_back(std::thread([copy, match, &value]()
+      {
+        for(size_t j=0; j<100; j++)
+        {
+          const char * data = NULL;
+          size_t size = 0;
+          if (copy.GetData(Clipboard::FormatBinary, data, size) && value.compare(0, value.size(), data, size) == 0)
+            (*match)++;
+        }
+      }));
+    }
+    snapshot.Clear();
+    for(size_t i=0; i<NUM_THREADS; i++)
+    {
+      threads[i].join();
+      ASSERT_EQ( 100, matches[i] );
+    }
+  }
+#endif //_WIN32
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,195 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestDelta.h"
+
+#include "win32clipboard/delta.h"
+
+#include <stdlib.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string getRandomBuffer(size_t size)
+  {
+    std::string buffer(size, '\0');
+    for(size_t i=0; i<size; i++)
+      buffer[i] = (char)(rand() & 0xFF);
+    return buffer;
+  }
+
+  //Encode the target as a delta against the base and rebuild it.
+  static void testRoundTrip(const std::string & base, const std::string & target, size_t block_size, size_t & delta_size)
+  {
+    DeltaSignature signature;
+    compute_signature(base.data(), base.size(), block_size, signature);
+    ASSERT_EQ( base.size() / block_size, signature.weak_sums.size() );
+
+    std::string delta;
+    compute_delta(signature, target.data(), target.size(), delta);
+    delta_size = delta.size();
+
+    std::string rebuilt;
+    ASSERT_TRUE( apply_delta(base.data(), base.size(), delta.data(), delta.size(), rebuilt) );
+    ASSERT_EQ( target.size(), rebuilt.size() );
+    ASSERT_TRUE( target == rebuilt );
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestDelta::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestDelta::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testIdentical)
+  {
+    srand(0);
+    const std::string base = getRandomBuffer(100000);
+    size_t delta_size = 0;
+    testRoundTrip(base, base, 1024, delta_size);
+    //a single copy and the incomplete last block
+    ASSERT_LT( 100000 % 1024, delta_size );
+    ASSERT_GT( 100000 % 1024 + 32, delta_size );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testEdits)
+  {
+    srand(1);
+    const std::string base = getRandomBuffer(4 * 1024 * 1024);
+
+    //insertions, deletions and modifications at unaligned offsets
+    std::string target = base;
+    target.insert(12345, "inserted text");
+    target.erase(1000000, 777);
+    target.replace(2500000, 10, "0123456789");
+    target.insert(0, "prefix");
+    target += "suffix";
+
+    size_t delta_size = 0;
+    testRoundTrip(base, target, 1024, delta_size);
+    ASSERT_GT( 8u * 1024, delta_size );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testUnrelated)
+  {
+    srand(2);
+    const std::string base = getRandomBuffer(50000);
+    const std::string target = getRandomBuffer(60000);
+    size_t delta_size = 0;
+    testRoundTrip(base, target, 512, delta_size);
+    ASSERT_GT( target.size() + 32, delta_size );
+
+    //small and empty buffers
+    testRoundTrip(base, "", 512, delta_size);
+    testRoundTrip("", target, 512, delta_size);
+    testRoundTrip("abc", "abcd", 512, delta_size);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testRandomEdits)
+  {
+    srand(3);
+    for(size_t iteration=0; iteration<50; iteration++)
+    {
+      const size_t block_size = 1 + rand() % 64;
+      const std::string base = getRandomBuffer(rand() % 5000);
+      std::string target = base;
+      for(size_t i=0; i<5 && !target.empty(); i++)
+      {
+        const size_t offset = rand() % target.size();
+        if (rand() % 2)
+          target.insert(offset, getRandomBuffer(rand() % 100));
+        else
+          target.erase(offset, rand() % 100);
+      }
+
+      size_t delta_size = 0;
+      testRoundTrip(base, target, block_size, delta_size);
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testInvalidDelta)
+  {
+    srand(4);
+    const std::string base = getRandomBuffer(10000);
+    std::string target = base;
+    target[5000] ^= 1;
+
+    DeltaSignature signature;
+    compute_signature(base.data(), base.size(), 256, signature);
+    std::string delta;
+    compute_delta(signature, target.data(), target.size(), delta);
+
+    //another base version
+    std::string other = base;
+    other[0] ^= 1;
+    std::string rebuilt;
+    ASSERT_FALSE( apply_delta(other.data(), other.size(), delta.data(), delta.size(), rebuilt) );
+
+    //truncated delta
+    ASSERT_FALSE( apply_delta(base.data(), base.size(), delta.data(), delta.size() - 1, rebuilt) );
+    ASSERT_FALSE( apply_delta(base.data(), base.size(), delta.data(), 4, rebuilt) );
+
+    //copy of a block out of the base version
+    std::string copy = delta.substr(0, 8);
+    copy += (char)16;     //block size
+    copy += (char)16;     //target size
+    copy += 'C';
+    copy += (char)100;    //block
+    copy += (char)1;      //count
+    ASSERT_FALSE( apply_delta(base.data(), 100, copy.data(), copy.size(), rebuilt) );
+
+    //size longer than 64 bits
+    std::string overlong = delta.substr(0, 8);
+    overlong.append(10, (char)0x80);
+    overlong += (char)1;
+    ASSERT_FALSE( apply_delta(base.data(), base.size(), overlong.data(), overlong.size(), rebuilt) );
+
+    //truncated size
+    std::string truncated = delta.substr(0, 8);
+    truncated += (char)0x80;
+    ASSERT_FALSE( apply_delta(base.data(), base.size(), truncated.data(), truncated.size(), rebuilt) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDelta, testSizeBoundaries)
+  {
+    srand(5);
+
+    //sizes on each side of the length boundaries of the variable length integers
+    static const size_t sizes[] = { 0, 1, 127, 128, 129, 16383, 16384, 16385 };
+    for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+      const std::string target = getRandomBuffer(sizes[i]);
+      size_t delta_size = 0;
+      testRoundTrip(std::string(), target, 64, delta_size);
+      testRoundTrip(target, target, 64, delta_size);
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,253 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestDropFiles.h"
+
+#include "win32clipboard/dropfiles.h"
+
+#include <stdio.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  typedef std::vector<std::string> StringVector;
+
+  //--------------------------------------------------------------------------------------------------
+  void TestDropFiles::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestDropFiles::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testEncodeDecode)
+  {
+    static const char * values[] = {
+      "C:\\Windows\\System32\\notepad.exe",
+      "C:\\Program Files (x86)\\Windows Media Player\\wmplayer.exe",
+      "C:\\temp\\\xC3\xA9" "cole.txt",                       //school in french, U+00E9
+      "C:\\temp\\\xE2\x82\xAC.txt",                          //euro sign, U+20AC
+      "C:\\temp\\\xF0\x9F\x98\x80.txt",                      //emoji, U+1F600, encoded as a surrogate pair
+    };
+    static const size_t num_values = sizeof(values) / sizeof(values[0]);
+
+    StringVector input_files;
+    for(size_t i=0; i<num_values; i++)
+      input_files.push_back(values[i]);
+
+    size_t size = get_dropfiles_size(input_files);
+    std::string buffer(size, '\xFF');
+    ASSERT_TRUE( encode_dropfiles(input_files, &buffer[0], buffer.size()) );
+
+    //the buffer ends with 2 empty wide characters
+    ASSERT_EQ( '\0', buffer[size-1] );
+    ASSERT_EQ( '\0', buffer[size-2] );
+    ASSERT_EQ( '\0', buffer[size-3] );
+    ASSERT_EQ( '\0', buffer[size-4] );
+
+    StringVector output_files;
+    bool is_wide = false;
+    ASSERT_TRUE( decode_dropfiles(buffer.data(), buffer.size(), output_files, is_wide) );
+    ASSERT_TRUE( is_wide );
+    ASSERT_EQ( input_files, output_files );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testExactSize)
+  {
+    StringVector files;
+    files.push_back("a");
+    files.push_back("\xC3\xA9");          // 1 code unit
+    files.push_back("\xF0\x9F\x98\x80");  // 2 code units
+
+    // header + (1+1)*2 + (1+1)*2 + (2+1)*2 + 2
+    ASSERT_EQ( DROPFILES_HEADER_SIZE + 4 + 4 + 6 + 2, get_dropfiles_size(files) );
+
+    //the encoder never writes outside of the exact size
+    std::string buffer(get_dropfiles_size(files), '\0');
+    ASSERT_TRUE ( encode_dropfiles(files, &buffer[0], buffer.size()) );
+    ASSERT_FALSE( encode_dropfiles(files, &buffer[0], buffer.size() - 1) );
+
+    //empty list
+    ASSERT_EQ( DROPFILES_HEADER_SIZE + 2, get_dropfiles_size(StringVector()) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testHeader)
+  {
+    StringVector files;
+    files.push_back("foo");
+
+    std::string buffer(get_dropfiles_size(files), '\xFF');
+    ASSERT_TRUE( encode_dropfiles(files, &buffer[0], buffer.size()) );
+
+    //pFiles
+    ASSERT_EQ( (char)DROPFILES_HEADER_SIZE, buffer[0] );
+    ASSERT_EQ( std::string(3, '\0'), buffer.substr(1, 3) );
+    //pt, fNC
+    ASSERT_EQ( std::string(12, '\0'), buffer.substr(4, 12) );
+    //fWide
+    ASSERT_EQ( std::string("\x01\0\0\0", 4), buffer.substr(16, 4) );
+    //file path
+    ASSERT_EQ( std::string("f\0o\0o\0\0\0\0\0", 10), buffer.substr(20) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testInvalidUtf8)
+  {
+    StringVector files;
+    files.push_back("\xC3");           //truncated sequence
+    std::string buffer(get_dropfiles_size(files) + 16, '\0');
+    ASSERT_FALSE( encode_dropfiles(files, &buffer[0], buffer.size()) );
+
+    files[0] = "\xED\xA0\x80";         //surrogate
+    ASSERT_FALSE( encode_dropfiles(files, &buffer[0], buffer.size()) );
+
+    files[0] = "\xC0\xAF";             //overlong
+    ASSERT_FALSE( encode_dropfiles(files, &buffer[0], buffer.size()) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testDecodeAnsi)
+  {
+    std::string buffer(DROPFILES_HEADER_SIZE, '\0');
+    buffer[0] = (char)DROPFILES_HEADER_SIZE;
+    buffer.append("C:\\foo.txt", 11);
+    buffer.append("C:\\bar.txt", 11);
+    buffer.append(1, '\0');
+
+    StringVector files;
+    bool is_wide = true;
+    ASSERT_TRUE( decode_dropfiles(buffer.data(), buffer.size(), files, is_wide) );
+    ASSERT_FALSE( is_wide );
+    ASSERT_EQ( 2, files.size() );
+    ASSERT_EQ( std::string("C:\\foo.txt"), files[0] );
+    ASSERT_EQ( std::string("C:\\bar.txt"), files[1] );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testDecodeMalformed)
+  {
+    StringVector files;
+    bool is_wide = false;
+
+    //too small for the DROPFILES structure
+    ASSERT_FALSE( decode_dropfiles("\x14\0\0\0", 4, files, is_wide) );
+
+    //file list outside of the buffer
+    std::string buffer(DROPFILES_HEADER_SIZE, '\0');
+    buffer[0] = (char)0x40;
+    ASSERT_FALSE( decode_dropfiles(buffer.data(), buffer.size(), files, is_wide) );
+
+    //file path not terminated
+    buffer[0] = (char)DROPFILES_HEADER_SIZE;
+    buffer[16] = 1;
+    buffer.append("f\0o\0o\0", 6);
+    ASSERT_FALSE( decode_dropfiles(buffer.data(), buffer.size(), files, is_wide) );
+
+    //unpaired surrogate is replaced
+    buffer.resize(DROPFILES_HEADER_SIZE);
+    buffer.append("\x00\xD8" "a\0" "\0\0" "\0\0", 8);
+    ASSERT_TRUE( decode_dropfiles(buffer.data(), buffer.size(), files, is_wide) );
+    ASSERT_EQ( 1, files.size() );
+    ASSERT_EQ( std::string("\xEF\xBF\xBD" "a"), files[0] );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testDropFileList)
+  {
+    DropFileList list;
+    ASSERT_EQ( 0, list.GetCount() );
+    ASSERT_TRUE( list.GetPath(0) == NULL );
+
+    list.Append("foo", 3);
+    list.Append("", 0);
+    list.Append("barbaz", 6);
+
+    ASSERT_EQ( 3, list.GetCount() );
+    ASSERT_EQ( std::string("foo"), list.GetPath(0) );
+    ASSERT_EQ( 3, list.GetLength(0) );
+    ASSERT_EQ( std::string(""), list.GetPath(1) );
+    ASSERT_EQ( 0, list.GetLength(1) );
+    ASSERT_EQ( std::string("barbaz"), list.GetPath(2) );
+    ASSERT_EQ( 6, list.GetLength(2) );
+
+    StringVector files;
+    list.ToVector(files);
+    ASSERT_EQ( 3, files.size() );
+    ASSERT_EQ( std::string("barbaz"), files[2] );
+
+    list.Clear();
+    ASSERT_EQ( 0, list.GetCount() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testLongFilePaths)
+  {
+    //file paths longer than MAX_PATH must not be truncated
+    std::string long_path = "\\\\?\\C:";
+    while (long_path.size() < 2000)
+      long_path += "\\directory\xC3\xA9";
+    long_path += "\\file.txt";
+
+    StringVector input_files;
+    input_files.push_back(long_path);
+    input_files.push_back("C:\\short.txt");
+
+    std::string buffer(get_dropfiles_size(input_files), '\0');
+    ASSERT_TRUE( encode_dropfiles(input_files, &buffer[0], buffer.size()) );
+
+    DropFileList list;
+    bool is_wide = false;
+    ASSERT_TRUE( decode_dropfiles(buffer.data(), buffer.size(), list, is_wide) );
+    ASSERT_EQ( 2, list.GetCount() );
+    ASSERT_EQ( long_path.size(), list.GetLength(0) );
+    ASSERT_EQ( long_path, list.GetPath(0) );
+    ASSERT_EQ( std::string("C:\\short.txt"), list.GetPath(1) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestDropFiles, testManyFiles)
+  {
+    static const size_t NUM_FILES = 100000;
+
+    StringVector input_files;
+    input_files.reserve(NUM_FILES);
+    for(size_t i=0; i<NUM_FILES; i++)
+    {
+      char path[64];
+      sprintf(path, "C:\\temp\\directory\\file%06d.txt", (int)i);
+      input_files.push_back(path);
+    }
+
+    std::string buffer(get_dropfiles_size(input_files), '\0');
+    ASSERT_TRUE( encode_dropfiles(input_files, &buffer[0], buffer.size()) );
+
+    DropFileList list;
+    bool is_wide = false;
+    ASSERT_TRUE( decode_dropfiles(buffer.data(), buffer.size(), list, is_wide) );
+    ASSERT_EQ( NUM_FILES, list.GetCount() );
+    for(size_t i=0; i<NUM_FILES; i++)
+    {
+      ASSERT_EQ( input_files[i], list.GetPath(i) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
@@ -83,6 +83,14 @@ namespace win32clipboard { namespace test
     ASSERT_TRUE ( win32clipboard::is_utf8_valid("\xC3\xA9" "cole") );       //school in french
 
     ASSERT_TRUE ( win32clipboard::is_utf8_valid("\x0d\x0a") );    //CRLF
+
+    //invalid sequences
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("\x80") );             //unexpected continuation byte
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("\xC0\xAF") );         //overlong encoding of '/'
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("\xED\xA0\x80") );     //surrogate U+D800
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("\xF4\x90\x80\x80") ); //above U+10FFFF
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("espa" "\xC3") );     //truncated sequence
+    ASSERT_FALSE( win32clipboard::is_utf8_valid("\xE9" "cole") );       //CP1252 text
   }
   //--------------------------------------------------------------------------------------------------
   TEST_F(TestEncodingConversion, testAnsiUnicode)
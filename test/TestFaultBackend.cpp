@@ -0,0 +1,248 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include "TestFaultBackend.h"
+
+#include "win32clipboard/faultbackend.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static Backend::ItemList getSampleItems()
+  {
+    Backend::ItemList items(3);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.assign("hello\0", 6);
+    items[1].format = Backend::FORMAT_HTML;
+    items[1].data = "<b>hello</b>";
+    items[2].format = Backend::FORMAT_BINARY;
+    for(size_t i=0; i<1000; i++)
+      items[2].data += (char)i;
+    return items;
+  }
+
+  //Returns the result of each call of a sequence of writes and reads, as a string of '0' and '1'.
+  static std::string runSequence(const FaultOptions & options, size_t count)
+  {
+    MemoryBackend memory;
+    FaultBackend backend(memory, options);
+    const Backend::ItemList items = getSampleItems();
+    std::string results;
+    std::string data;
+    for(size_t i=0; i<count; i++)
+    {
+      const bool success = (i % 2 == 0 ? backend.Write(items) : backend.Read(Backend::FORMAT_TEXT, data));
+      results += (success ? '1' : '0');
+    }
+    return results;
+  }
+
+  //Returns the result of the writes of each thread, as strings of '0' and '1'.
+  static std::vector<std::string> runThreads(const FaultOptions & options, size_t num_threads, size_t count)
+  {
+    MemoryBackend memory;
+    FaultBackend backend(memory, options);
+    std::vector<std::string> results(num_threads);
+    std::vector<std::thread> threads;
+    for(size_t i=0; i<num_threads; i++)
+    {
+      threads.push_back(std::thread([&, i]()
+      {
+        FaultBackend::SetThreadIndex(i + 1);
+        const Backend::ItemList items = getSampleItems();
+        for(size_t j=0; j<count; j++)
+          results[i] += (backend.Write(items) ? '1' : '0');
+      }));
+    }
+    for(size_t i=0; i<threads.size(); i++)
+      threads[i].join();
+    return results;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestFaultBackend::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestFaultBackend::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testNoFaults)
+  {
+    MemoryBackend memory;
+    FaultBackend backend(memory, FaultOptions());
+
+    const Backend::ItemList items = getSampleItems();
+    ASSERT_TRUE( backend.Write(items) );
+    std::string data;
+    ASSERT_TRUE( backend.Read(Backend::FORMAT_BINARY, data) );
+    ASSERT_EQ( items[2].data, data );
+    Backend::StringVector formats;
+    ASSERT_TRUE( backend.GetFormats(formats) );
+    ASSERT_EQ( 3, formats.size() );
+    ASSERT_TRUE( backend.Empty() );
+
+    FaultStats stats;
+    backend.GetStats(stats);
+    ASSERT_EQ( 4, stats.operations );
+    ASSERT_EQ( 0, stats.open_retries );
+    ASSERT_EQ( 0, stats.open_failures );
+    ASSERT_EQ( 0, stats.partial_writes );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testOpenFailures)
+  {
+    MemoryBackend memory;
+    FaultOptions options;
+    options.open_failure_rate = 1.0;
+    options.open_attempts = 3;
+    options.open_retry_delay_us = 0;
+    FaultBackend backend(memory, options);
+
+    std::string data;
+    ASSERT_FALSE( backend.Write(getSampleItems()) );
+    ASSERT_FALSE( backend.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_FALSE( memory.Read(Backend::FORMAT_TEXT, data) );
+
+    FaultStats stats;
+    backend.GetStats(stats);
+    ASSERT_EQ( 2, stats.operations );
+    ASSERT_EQ( 4, stats.open_retries );
+    ASSERT_EQ( 2, stats.open_failures );
+    ASSERT_EQ( 6, stats.injected_failures );
+    ASSERT_EQ( 0, stats.contended_opens );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testPartialWrite)
+  {
+    MemoryBackend memory;
+    FaultOptions options;
+    options.partial_write_rate = 1.0;
+    FaultBackend backend(memory, options);
+
+    //the first format is complete and the second one is truncated
+    const Backend::ItemList items = getSampleItems();
+    ASSERT_FALSE( backend.Write(items) );
+    Backend::StringVector formats;
+    ASSERT_TRUE( memory.GetFormats(formats) );
+    ASSERT_EQ( 2, formats.size() );
+    std::string data;
+    ASSERT_TRUE( memory.Read(Backend::FORMAT_TEXT, data) );
+    ASSERT_EQ( items[0].data, data );
+    ASSERT_TRUE( memory.Read(Backend::FORMAT_HTML, data) );
+    ASSERT_EQ( items[1].data.substr(0, items[1].data.size() / 2), data );
+    ASSERT_FALSE( memory.Read(Backend::FORMAT_BINARY, data) );
+
+    FaultStats stats;
+    backend.GetStats(stats);
+    ASSERT_EQ( 1, stats.partial_writes );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testDeterministic)
+  {
+    FaultOptions options;
+    options.seed = 12345;
+    options.open_failure_rate = 0.3;
+    options.open_attempts = 1;
+    options.partial_write_rate = 0.2;
+
+    //the same seed injects the same faults
+    const std::string first = runSequence(options, 200);
+    ASSERT_EQ( first, runSequence(options, 200) );
+    ASSERT_NE( std::string::npos, first.find('0') );
+    ASSERT_NE( std::string::npos, first.find('1') );
+
+    options.seed = 54321;
+    ASSERT_NE( first, runSequence(options, 200) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testContention)
+  {
+    MemoryBackend memory;
+    FaultOptions options;
+    options.open_attempts = 1000;
+    options.open_retry_delay_us = 10;
+    options.max_hold_time_us = 20;
+    FaultBackend backend(memory, options);
+
+    //all operations succeed eventually: the threads wait for each other
+    static const size_t NUM_THREADS = 4;
+    static const size_t NUM_OPERATIONS = 50;
+    std::vector<std::thread> threads;
+    std::vector<size_t> failures(NUM_THREADS, 0);
+    for(size_t i=0; i<NUM_THREADS; i++)
+    {
+      threads.push_back(std::thread([&, i]()
+      {
+        const Backend::ItemList items = getSampleItems();
+        std::string data;
+        for(size_t j=0; j<NUM_OPERATIONS; j++)
+        {
+          if (!backend.Write(items) || !backend.Read(Backend::FORMAT_BINARY, data) || data != items[2].data)
+            failures[i]++;
+        }
+      }));
+    }
+    for(size_t i=0; i<threads.size(); i++)
+      threads[i].join();
+
+    for(size_t i=0; i<NUM_THREADS; i++)
+      ASSERT_EQ( 0, failures[i] );
+
+    FaultStats stats;
+    backend.GetStats(stats);
+    ASSERT_EQ( 2 * NUM_THREADS * NUM_OPERATIONS, stats.operations );
+    ASSERT_EQ( stats.contended_opens, stats.open_retries );
+    ASSERT_EQ( 0, stats.open_failures );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestFaultBackend, testDeterministicThreads)
+  {
+    FaultOptions options;
+    options.seed = 12345;
+    options.open_failure_rate = 0.2;
+    options.open_attempts = 100000; //the threads wait for each other: the operations only fail because of the partial writes
+    options.open_retry_delay_us = 10;
+    options.partial_write_rate = 0.3;
+
+    //each thread gets the same faults whatever the scheduling and the retries of the other threads
+    static const size_t NUM_THREADS = 4;
+    const std::vector<std::string> first = runThreads(options, NUM_THREADS, 100);
+    for(size_t run=0; run<3; run++)
+      ASSERT_EQ( first, runThreads(options, NUM_THREADS, 100) );
+
+    //the threads have different faults
+    for(size_t i=1; i<NUM_THREADS; i++)
+      ASSERT_NE( first[0], first[i] );
+    ASSERT_NE( std::string::npos, first[0].find('0') );
+    ASSERT_NE( std::string::npos, first[0].find('1') );
+  }
+  //--------------------------------------------------------------------------------------------------
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,80 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestHash.h"
+
+#include "win32clipboard/hash.h"
+
+#include <string>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //--------------------------------------------------------------------------------------------------
+  void TestHash::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestHash::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHash, testHash64)
+  {
+    //reference values computed with the official XXH64 implementation
+    ASSERT_EQ( 0xEF46DB3751D8E999ULL, hash64("", 0) );
+    ASSERT_EQ( 0xD24EC4F1A98C6E5BULL, hash64("a", 1) );
+    ASSERT_EQ( 0x44BC2CF5AD770999ULL, hash64("abc", 3) );
+
+    const std::string text = "Nobody inspects the spammish repetition";
+    ASSERT_EQ( 0xFBCEA83C8A378BF1ULL, hash64(text.data(), text.size()) );
+
+    std::string buffer;
+    for(size_t i=0; i<1024; i++)
+      buffer.push_back((char)(i%256));
+    ASSERT_EQ( 0x6F3914F18FE4DF57ULL, hash64(buffer.data(), buffer.size()) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHash, testSeed)
+  {
+    ASSERT_EQ( 0xD5AFBA1336A3BE4BULL, hash64("", 0, 1) );
+    ASSERT_EQ( 0xBEA9CA8199328908ULL, hash64("abc", 3, 1) );
+    ASSERT_NE( hash64("abc", 3, 0), hash64("abc", 3, 1) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHash, testUnaligned)
+  {
+    std::string buffer(100, 'x');
+    for(size_t i=0; i<buffer.size(); i++)
+      buffer[i] = (char)(i*7);
+
+    //same content at a different alignment must give the same hash
+    std::string shifted = "?" + buffer;
+    ASSERT_EQ( hash64(buffer.data(), buffer.size()), hash64(shifted.data() + 1, buffer.size()) );
+  }
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,142 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestHtml.h"
+
+#include "win32clipboard/html.h"
+
+#include <string>
+#include <stdlib.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string encode(const std::string & fragment)
+  {
+    std::string buffer(get_cf_html_size(fragment.size()), '#');
+    if (!encode_cf_html(fragment.data(), fragment.size(), &buffer[0], buffer.size()))
+      return std::string();
+    return buffer;
+  }
+
+  //Returns the value of the given header field.
+  static long getHeaderValue(const std::string & buffer, const std::string & name)
+  {
+    size_t pos = buffer.find(name + ":");
+    if (pos == std::string::npos)
+      return -2;
+    return atol(buffer.c_str() + pos + name.size() + 1);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestHtml::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestHtml::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHtml, testEncode)
+  {
+    static const std::string FRAGMENT = "<b>bold</b> text";
+    std::string buffer = encode(FRAGMENT);
+    ASSERT_FALSE( buffer.empty() );
+
+    //terminated by a \0 character
+    ASSERT_EQ( '\0', buffer[buffer.size() - 1] );
+
+    //the offsets of the header match the content
+    const long start_html = getHeaderValue(buffer, "StartHTML");
+    const long end_html = getHeaderValue(buffer, "EndHTML");
+    const long start_fragment = getHeaderValue(buffer, "StartFragment");
+    const long end_fragment = getHeaderValue(buffer, "EndFragment");
+    ASSERT_EQ( std::string("<html>"), buffer.substr(start_html, 6) );
+    ASSERT_EQ( (long)buffer.size() - 1, end_html );
+    ASSERT_EQ( FRAGMENT, buffer.substr(start_fragment, end_fragment - start_fragment) );
+    ASSERT_EQ( std::string("<!--StartFragment-->"), buffer.substr(start_fragment - 20, 20) );
+
+    //buffer too small
+    ASSERT_FALSE( encode_cf_html(FRAGMENT.data(), FRAGMENT.size(), &buffer[0], buffer.size() - 1) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHtml, testRoundTrip)
+  {
+    static const char * fragments[] = { "", "a", "<p>caf\xC3\xA9</p>", "<a href=\"x\">StartFragment:0000000001</a>" };
+    for(size_t i=0; i<sizeof(fragments)/sizeof(fragments[0]); i++)
+    {
+      const std::string fragment = fragments[i];
+      const std::string buffer = encode(fragment);
+
+      HtmlView view;
+      ASSERT_TRUE( parse_cf_html(buffer.data(), buffer.size(), view) );
+      ASSERT_EQ( fragment, std::string(view.fragment, view.fragment_size) );
+      ASSERT_EQ( std::string("<html><body>"), std::string(view.html, 12) );
+      ASSERT_EQ( std::string("</body></html>"), std::string(view.html + view.html_size - 14, 14) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHtml, testParseThirdParty)
+  {
+    //header with a SourceURL, variable width offsets and no context
+    static const std::string BUFFER =
+      "Version:1.0\r\n"
+      "StartHTML:-1\r\n"
+      "EndHTML:-1\r\n"
+      "StartFragment:127\r\n"
+      "EndFragment:139\r\n"
+      "SourceURL:https://example.com/\r\n"
+      "<!--StartFragment--><i>hello</i><!--EndFragment-->";
+    ASSERT_EQ( std::string("<i>"), BUFFER.substr(127, 3) );
+
+    HtmlView view;
+    ASSERT_TRUE( parse_cf_html(BUFFER.data(), BUFFER.size(), view) );
+    ASSERT_EQ( std::string("<i>hello</i>"), std::string(view.fragment, view.fragment_size) );
+    ASSERT_EQ( view.fragment, view.html );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestHtml, testParseMalformed)
+  {
+    const std::string buffer = encode("<b>x</b>");
+    HtmlView view;
+
+    //fragment out of range
+    ASSERT_FALSE( parse_cf_html(buffer.data(), buffer.size() - 40, view) );
+
+    //missing header
+    ASSERT_FALSE( parse_cf_html("<html></html>", 13, view) );
+
+    //invalid value
+    std::string invalid = buffer;
+    invalid.replace(invalid.find("StartFragment:") + 14, 1, "x");
+    ASSERT_FALSE( parse_cf_html(invalid.data(), invalid.size(), view) );
+
+    //fragment end before fragment start
+    static const std::string REVERSED = "Version:0.9\r\nStartFragment:50\r\nEndFragment:40\r\n";
+    ASSERT_FALSE( parse_cf_html(REVERSED.data(), REVERSED.size(), view) );
+  }
+  //--------------------------------------------------------------------------------------------------
+} //namespace test
+} //namespace win32clipboard
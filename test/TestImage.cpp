@@ -0,0 +1,204 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestImage.h"
+
+#include "win32clipboard/image.h"
+
+#include <string>
+#include <string.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //Build a BITMAPINFOHEADER bitmap with the given pixels.
+  static std::string buildDib(int width, int height, int bit_count, const std::string & pixels)
+  {
+    std::string header(40, '\0');
+    header[0] = 40;
+    header[4] = (char)(width & 0xFF);
+    header[8] = (char)(height & 0xFF);
+    header[9] = header[10] = header[11] = (height < 0 ? (char)0xFF : 0);
+    header[12] = 1;
+    header[14] = (char)bit_count;
+    return header + pixels;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestImage::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestImage::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testSwapRedBlue)
+  {
+    //test all lengths around the vectorized block size
+    for(size_t count=0; count<=19; count++)
+    {
+      std::string src(count*4, '\0');
+      for(size_t i=0; i<src.size(); i++)
+        src[i] = (char)(i*13 + 1);
+
+      std::string dst(src.size(), '\0');
+      swap_red_blue((const unsigned char *)src.data(), (unsigned char *)&dst[0], count, 0);
+      for(size_t i=0; i<count; i++)
+      {
+        ASSERT_EQ( src[4*i+2], dst[4*i+0] );
+        ASSERT_EQ( src[4*i+1], dst[4*i+1] );
+        ASSERT_EQ( src[4*i+0], dst[4*i+2] );
+        ASSERT_EQ( src[4*i+3], dst[4*i+3] );
+      }
+
+      //in place, opaque
+      swap_red_blue((const unsigned char *)dst.data(), (unsigned char *)&dst[0], count, 0xFF);
+      for(size_t i=0; i<count; i++)
+      {
+        ASSERT_EQ( src[4*i+0], dst[4*i+0] );
+        ASSERT_EQ( src[4*i+1], dst[4*i+1] );
+        ASSERT_EQ( src[4*i+2], dst[4*i+2] );
+        ASSERT_EQ( (char)0xFF, dst[4*i+3] );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testExpandBgrToRgba)
+  {
+    for(size_t count=0; count<=19; count++)
+    {
+      std::string src(count*3, '\0');
+      for(size_t i=0; i<src.size(); i++)
+        src[i] = (char)(i*7 + 3);
+
+      std::string dst(count*4, '\0');
+      expand_bgr_to_rgba((const unsigned char *)src.data(), (unsigned char *)&dst[0], count);
+      for(size_t i=0; i<count; i++)
+      {
+        ASSERT_EQ( src[3*i+2], dst[4*i+0] );
+        ASSERT_EQ( src[3*i+1], dst[4*i+1] );
+        ASSERT_EQ( src[3*i+0], dst[4*i+2] );
+        ASSERT_EQ( (char)0xFF, dst[4*i+3] );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testParse24Bits)
+  {
+    //2x2 bottom-up image, each row is padded to 4 bytes
+    std::string pixels;
+    pixels.append("\x01\x02\x03" "\x04\x05\x06" "\0\0", 8); //bottom row
+    pixels.append("\x11\x12\x13" "\x14\x15\x16" "\0\0", 8); //top row
+    std::string dib = buildDib(2, 2, 24, pixels);
+
+    DibView view;
+    ASSERT_TRUE( parse_dib(dib.data(), dib.size(), view) );
+    ASSERT_EQ( 2, view.width );
+    ASSERT_EQ( 2, view.height );
+    ASSERT_EQ( 8, view.stride );
+    ASSERT_TRUE( view.bottom_up );
+
+    Image image;
+    decode_dib(view, image);
+    ASSERT_EQ( 2, image.GetWidth() );
+    ASSERT_EQ( 2, image.GetHeight() );
+    const std::string expected("\x13\x12\x11\xFF" "\x16\x15\x14\xFF" "\x03\x02\x01\xFF" "\x06\x05\x04\xFF", 16);
+    ASSERT_EQ( expected, std::string((const char *)image.GetPixels(), 16) );
+
+    //truncated pixels
+    ASSERT_FALSE( parse_dib(dib.data(), dib.size() - 1, view) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testParse32BitsTopDown)
+  {
+    //1x2 top-down image. The alpha channel of BI_RGB bitmaps is ignored.
+    std::string pixels("\x01\x02\x03\x00" "\x11\x12\x13\x00", 8);
+    std::string dib = buildDib(1, -2, 32, pixels);
+
+    DibView view;
+    ASSERT_TRUE( parse_dib(dib.data(), dib.size(), view) );
+    ASSERT_FALSE( view.bottom_up );
+    ASSERT_FALSE( view.has_alpha );
+
+    Image image;
+    decode_dib(view, image);
+    const std::string expected("\x03\x02\x01\xFF" "\x13\x12\x11\xFF", 8);
+    ASSERT_EQ( expected, std::string((const char *)image.GetPixels(), 8) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testEncodeDecode)
+  {
+    Image input;
+    input.Create(7, 5);
+    for(size_t i=0; i<7*5*4; i++)
+      input.GetPixels()[i] = (unsigned char)(i*31);
+
+    std::string dib(get_dib_size(input), '\0');
+    ASSERT_TRUE( encode_dib(input, &dib[0], dib.size()) );
+    ASSERT_FALSE( encode_dib(input, &dib[0], dib.size() - 1) );
+
+    DibView view;
+    ASSERT_TRUE( parse_dib(dib.data(), dib.size(), view) );
+    ASSERT_EQ( 7, view.width );
+    ASSERT_EQ( 5, view.height );
+    ASSERT_EQ( 32, view.bit_count );
+    ASSERT_TRUE( view.bottom_up );
+    ASSERT_TRUE( view.has_alpha );
+
+    Image output;
+    decode_dib(view, output);
+    ASSERT_EQ( input.GetWidth(), output.GetWidth() );
+    ASSERT_EQ( input.GetHeight(), output.GetHeight() );
+    ASSERT_EQ( 0, memcmp(input.GetPixels(), output.GetPixels(), 7*5*4) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestImage, testParseUnsupported)
+  {
+    DibView view;
+    ASSERT_FALSE( parse_dib("", 0, view) );
+
+    //8 bits per pixel
+    std::string dib = buildDib(4, 1, 8, std::string(4, '\0'));
+    ASSERT_FALSE( parse_dib(dib.data(), dib.size(), view) );
+
+    //compressed
+    dib = buildDib(1, 1, 32, std::string(4, '\0'));
+    dib[16] = 1; //BI_RLE8
+    ASSERT_FALSE( parse_dib(dib.data(), dib.size(), view) );
+
+    //channel masks truncated by the end of the header or of the buffer
+    dib = buildDib(1, 1, 32, "");
+    dib[0] = 44;
+    dib[16] = 3; //BI_BITFIELDS
+    dib += std::string(4, '\0');
+    ASSERT_FALSE( parse_dib(dib.data(), dib.size(), view) );
+    dib[0] = 40;
+    ASSERT_FALSE( parse_dib(dib.data(), dib.size(), view) );
+  }
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,228 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestMirror.h"
+
+#include "win32clipboard/mirror.h"
+
+#include <stdlib.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string getRandomBuffer(size_t size)
+  {
+    std::string buffer(size, '\0');
+    for(size_t i=0; i<size; i++)
+      buffer[i] = (char)(rand() & 0xFF);
+    return buffer;
+  }
+
+  //Assert that both backends have the same content.
+  static void assertSameContent(Backend & expected, Backend & actual)
+  {
+    Backend::StringVector expected_formats;
+    Backend::StringVector actual_formats;
+    ASSERT_TRUE( expected.GetFormats(expected_formats) );
+    ASSERT_TRUE( actual.GetFormats(actual_formats) );
+    ASSERT_EQ( expected_formats, actual_formats );
+    for(size_t i=0; i<expected_formats.size(); i++)
+    {
+      std::string expected_data;
+      std::string actual_data;
+      ASSERT_TRUE( expected.Read(expected_formats[i], expected_data) );
+      ASSERT_TRUE( actual.Read(expected_formats[i], actual_data) );
+      ASSERT_TRUE( expected_data == actual_data ) << "Format " << expected_formats[i];
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestMirror::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestMirror::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestMirror, testLocalTransport)
+  {
+    LocalTransport first;
+    LocalTransport second;
+    std::string message;
+    ASSERT_FALSE( first.Send("lost") );
+
+    LocalTransport::Connect(first, second);
+    ASSERT_TRUE( first.Send("hello") );
+    ASSERT_TRUE( first.Send("world") );
+    ASSERT_TRUE( second.Send("!") );
+    ASSERT_EQ( 10, first.GetBytesSent() );
+    ASSERT_EQ( 1, second.GetBytesSent() );
+
+    ASSERT_TRUE( second.Receive(message) );
+    ASSERT_EQ( "hello", message );
+    ASSERT_TRUE( second.Receive(message) );
+    ASSERT_EQ( "world", message );
+    ASSERT_FALSE( second.Receive(message) );
+    ASSERT_TRUE( first.Receive(message) );
+    ASSERT_EQ( "!", message );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestMirror, testMirror)
+  {
+    MemoryBackend source;
+    MemoryBackend destination;
+    LocalTransport sender_end;
+    LocalTransport receiver_end;
+    LocalTransport::Connect(sender_end, receiver_end);
+    MirrorSender sender(source, sender_end);
+    MirrorReceiver receiver(destination, receiver_end);
+
+    //the first update is always sent
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+    ASSERT_FALSE( sender.Update() );
+    ASSERT_FALSE( receiver.Update() );
+
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_TEXT;
+    items[0].data.assign("hello\0", 6);
+    items[1].format = Backend::FORMAT_BINARY;
+    items[1].data = "data";
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+
+    //multiple changes are applied in order
+    items[0].data.assign("world\0", 6);
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    items.pop_back();
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+
+    ASSERT_TRUE( source.Empty() );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+    ASSERT_EQ( 0, receiver.GetErrorCount() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestMirror, testLargePayloadDelta)
+  {
+    MemoryBackend source;
+    MemoryBackend destination;
+    LocalTransport sender_end;
+    LocalTransport receiver_end;
+    LocalTransport::Connect(sender_end, receiver_end);
+    MirrorSender sender(source, sender_end);
+    MirrorReceiver receiver(destination, receiver_end);
+
+    srand(0);
+    Backend::ItemList items(2);
+    items[0].format = Backend::FORMAT_BINARY;
+    items[0].data = getRandomBuffer(8 * 1024 * 1024);
+    items[1].format = Backend::FORMAT_TEXT;
+    items[1].data = getRandomBuffer(1024 * 1024);
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+
+    //small edits of a multi-megabytes payload, the other format is unchanged
+    items[0].data.insert(100000, "inserted");
+    items[0].data.replace(5000000, 4, "edit");
+    ASSERT_TRUE( source.Write(items) );
+    const uint64_t bytes_before = sender_end.GetBytesSent();
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+
+    const uint64_t bytes_sent = sender_end.GetBytesSent() - bytes_before;
+    ASSERT_GT( 8u * 1024, bytes_sent );
+
+    MirrorStats stats;
+    sender.GetStats(stats);
+    ASSERT_EQ( 2, stats.updates );
+    ASSERT_EQ( 2, stats.full_formats );
+    ASSERT_EQ( 1, stats.delta_formats );
+    ASSERT_EQ( 0, stats.resyncs );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestMirror, testResync)
+  {
+    MemoryBackend source;
+    MemoryBackend destination;
+    LocalTransport sender_end;
+    LocalTransport receiver_end;
+    LocalTransport::Connect(sender_end, receiver_end);
+    MirrorSender sender(source, sender_end);
+
+    srand(1);
+    Backend::ItemList items(1);
+    items[0].format = Backend::FORMAT_BINARY;
+    items[0].data = getRandomBuffer(100000);
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    {
+      MirrorReceiver receiver(destination, receiver_end);
+      ASSERT_TRUE( receiver.Update() );
+    }
+
+    //a restarted receiver does not have the base version of the next delta
+    MirrorReceiver receiver(destination, receiver_end);
+    items[0].data[50000] ^= 1;
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    items[0].data[60000] ^= 1;
+    ASSERT_TRUE( source.Write(items) );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_FALSE( receiver.Update() );
+    ASSERT_EQ( 1, receiver.GetErrorCount() );
+
+    //the sender resends the content in full
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+
+    MirrorStats stats;
+    sender.GetStats(stats);
+    ASSERT_EQ( 1, stats.resyncs );
+
+    //corrupted messages are detected
+    ASSERT_TRUE( sender_end.Send("M\0garbage") );
+    ASSERT_FALSE( receiver.Update() );
+    ASSERT_EQ( 2, receiver.GetErrorCount() );
+    ASSERT_TRUE( sender.Update() );
+    ASSERT_TRUE( receiver.Update() );
+    assertSameContent(source, destination);
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,168 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestNewline.h"
+
+#include "win32clipboard/newline.h"
+
+#include <string>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //Straightforward implementations used as reference.
+  template <typename T>
+  static std::basic_string<T> toCrlf(const std::basic_string<T> & str)
+  {
+    std::basic_string<T> result;
+    for(size_t i=0; i<str.size(); i++)
+    {
+      if (str[i] == '\n' && (i == 0 || str[i-1] != '\r'))
+        result.push_back('\r');
+      result.push_back(str[i]);
+    }
+    return result;
+  }
+
+  template <typename T>
+  static std::basic_string<T> toLf(const std::basic_string<T> & str)
+  {
+    std::basic_string<T> result;
+    for(size_t i=0; i<str.size(); i++)
+    {
+      if (str[i] == '\r' && i + 1 < str.size() && str[i+1] == '\n')
+        continue;
+      result.push_back(str[i]);
+    }
+    return result;
+  }
+
+  //Build a string of the given length with line endings at pseudo-random positions.
+  template <typename T>
+  static std::basic_string<T> buildText(size_t length, unsigned seed)
+  {
+    static const char characters[] = "ab\r\n\n\r\nc";
+    std::basic_string<T> text;
+    for(size_t i=0; i<length; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      text.push_back((T)characters[(seed >> 16) % (sizeof(characters) - 1)]);
+    }
+    return text;
+  }
+
+  template <typename T>
+  static void checkConversions(const std::basic_string<T> & text)
+  {
+    //LF to CRLF with exact output size
+    const std::basic_string<T> expected_crlf = toCrlf(text);
+    ASSERT_EQ( expected_crlf.size(), get_crlf_length(text.data(), text.size()) );
+    std::basic_string<T> crlf(expected_crlf.size() + 1, (T)'#');
+    ASSERT_EQ( expected_crlf.size(), lf_to_crlf(text.data(), text.size(), &crlf[0]) );
+    ASSERT_EQ( (T)'#', crlf[expected_crlf.size()] ); //no overflow
+    crlf.resize(expected_crlf.size());
+    ASSERT_TRUE( expected_crlf == crlf );
+
+    //CRLF to LF
+    const std::basic_string<T> expected_lf = toLf(text);
+    std::basic_string<T> lf(text.size() + 1, (T)'#');
+    ASSERT_EQ( expected_lf.size(), crlf_to_lf(text.data(), text.size(), &lf[0]) );
+    lf.resize(expected_lf.size());
+    ASSERT_TRUE( expected_lf == lf );
+
+    //CRLF to LF, in place
+    std::basic_string<T> in_place = text;
+    size_t length = crlf_to_lf(&in_place[0], in_place.size(), &in_place[0]);
+    in_place.resize(length);
+    ASSERT_TRUE( expected_lf == in_place );
+
+    //round trip of the converted text
+    std::basic_string<T> round_trip = crlf;
+    length = crlf_to_lf(&round_trip[0], round_trip.size(), &round_trip[0]);
+    round_trip.resize(length);
+    ASSERT_TRUE( toLf(expected_crlf) == round_trip );
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestNewline::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestNewline::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNewline, testBasic)
+  {
+    std::string text = "line1\nline2\r\nline3\rline4\n";
+    char buffer[64] = {0};
+    ASSERT_EQ( 27, get_crlf_length(text.data(), text.size()) );
+    size_t length = lf_to_crlf(text.data(), text.size(), buffer);
+    ASSERT_EQ( std::string("line1\r\nline2\r\nline3\rline4\r\n"), std::string(buffer, length) );
+
+    length = crlf_to_lf(buffer, length, buffer);
+    ASSERT_EQ( std::string("line1\nline2\nline3\rline4\n"), std::string(buffer, length) );
+
+    //empty string
+    ASSERT_EQ( 0, get_crlf_length("", 0) );
+    ASSERT_EQ( 0, lf_to_crlf("", 0, buffer) );
+    ASSERT_EQ( 0, crlf_to_lf("", 0, buffer) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNewline, testBlockBoundaries)
+  {
+    //a CR at the end of a block followed by a LF at the beginning of the next block
+    for(size_t position=0; position<40; position++)
+    {
+      std::string text(40, 'x');
+      text[position] = '\r';
+      if (position + 1 < text.size())
+        text[position + 1] = '\n';
+      checkConversions(text);
+
+      std::wstring wtext(40, L'x');
+      wtext[position] = L'\r';
+      if (position + 1 < wtext.size())
+        wtext[position + 1] = L'\n';
+      checkConversions(wtext);
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNewline, testRandom)
+  {
+    for(size_t length=0; length<100; length++)
+    {
+      for(unsigned seed=0; seed<5; seed++)
+      {
+        checkConversions(buildText<char>(length, seed));
+        checkConversions(buildText<wchar_t>(length, seed));
+      }
+    }
+    checkConversions(buildText<char>(100000, 7));
+    checkConversions(buildText<wchar_t>(100000, 7));
+  }
+  //--------------------------------------------------------------------------------------------------
+} //namespace test
+} //namespace win32clipboard
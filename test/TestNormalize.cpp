@@ -0,0 +1,146 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestNormalize.h"
+
+#include "win32clipboard/normalize.h"
+#include "win32clipboard/dropfiles.h"
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string normalize(const std::string & str, NormalizationForm form)
+  {
+    std::string normalized;
+    if (!normalize_utf8(str.data(), str.size(), form, normalized))
+      return "invalid";
+    return normalized;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestNormalize::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestNormalize::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNormalize, testCompose)
+  {
+    //ASCII only
+    ASSERT_EQ( std::string("C:\\temp\\file.txt"), normalize("C:\\temp\\file.txt", NormalizationNFC) );
+    ASSERT_EQ( std::string(""), normalize("", NormalizationNFC) );
+
+    //e + combining acute accent => U+00E9
+    ASSERT_EQ( std::string("\xC3\xA9" "cole.txt"), normalize("e\xCC\x81" "cole.txt", NormalizationNFC) );
+
+    //a + combining dot below + combining circumflex => U+1EAD, the combining marks are reordered first
+    ASSERT_EQ( std::string("\xE1\xBA\xAD"), normalize("a\xCC\x82\xCC\xA3", NormalizationNFC) );
+
+    //hangul jamo L + V + T => U+D4DB
+    ASSERT_EQ( std::string("\xED\x93\x9B"), normalize("\xE1\x84\x91\xE1\x85\xB1\xE1\x86\xB6", NormalizationNFC) );
+
+    //singleton decomposition: ohm sign U+2126 => greek capital omega U+03A9
+    ASSERT_EQ( std::string("\xCE\xA9"), normalize("\xE2\x84\xA6", NormalizationNFC) );
+
+    //composition exclusion: U+0958 is decomposed and never recomposed
+    ASSERT_EQ( std::string("\xE0\xA4\x95\xE0\xA4\xBC"), normalize("\xE0\xA5\x98", NormalizationNFC) );
+
+    //already composed strings are not modified
+    ASSERT_EQ( std::string("\xC3\xA9" "t\xC3\xA9"), normalize("\xC3\xA9" "t\xC3\xA9", NormalizationNFC) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNormalize, testDecompose)
+  {
+    ASSERT_EQ( std::string("e\xCC\x81" "cole.txt"), normalize("\xC3\xA9" "cole.txt", NormalizationNFD) );
+    ASSERT_EQ( std::string("a\xCC\xA3\xCC\x82"), normalize("\xE1\xBA\xAD", NormalizationNFD) );
+    ASSERT_EQ( std::string("\xE1\x84\x91\xE1\x85\xB1\xE1\x86\xB6"), normalize("\xED\x93\x9B", NormalizationNFD) );
+
+    //code points outside of the basic multilingual plane: U+1D15E musical symbol half note
+    ASSERT_EQ( std::string("\xF0\x9D\x85\x97\xF0\x9D\x85\xA5"), normalize("\xF0\x9D\x85\x9E", NormalizationNFD) );
+    ASSERT_EQ( std::string("\xF0\x9F\x98\x80"), normalize("\xF0\x9F\x98\x80", NormalizationNFD) );
+
+    //invalid UTF-8
+    ASSERT_EQ( std::string("invalid"), normalize("abc\xC3", NormalizationNFD) );
+    ASSERT_EQ( std::string("invalid"), normalize("\xED\xA0\x80", NormalizationNFC) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNormalize, testIsNormalized)
+  {
+    const std::string composed = "C:\\Users\\ren\xC3\xA9\\r\xC3\xA9sum\xC3\xA9.docx";
+    const std::string decomposed = "C:\\Users\\rene\xCC\x81\\re\xCC\x81sume\xCC\x81.docx";
+
+    ASSERT_TRUE( is_normalized_utf8(composed.data(), composed.size(), NormalizationNFC) );
+    ASSERT_FALSE( is_normalized_utf8(composed.data(), composed.size(), NormalizationNFD) );
+    ASSERT_FALSE( is_normalized_utf8(decomposed.data(), decomposed.size(), NormalizationNFC) );
+    ASSERT_TRUE( is_normalized_utf8(decomposed.data(), decomposed.size(), NormalizationNFD) );
+
+    //a combining mark that does not compose with the previous character
+    const std::string maybe = "x\xCC\x81";
+    ASSERT_TRUE( is_normalized_utf8(maybe.data(), maybe.size(), NormalizationNFC) );
+    ASSERT_EQ( maybe, normalize(maybe, NormalizationNFC) );
+
+    //combining marks in the wrong order
+    const std::string unordered = "a\xCC\x82\xCC\xA3";
+    ASSERT_FALSE( is_normalized_utf8(unordered.data(), unordered.size(), NormalizationNFD) );
+
+    //long strings cross the boundaries of the vectorized ASCII scan
+    std::string long_path(1000, 'a');
+    long_path += "e\xCC\x81";
+    long_path += std::string(1000, 'b');
+    ASSERT_FALSE( is_normalized_utf8(long_path.data(), long_path.size(), NormalizationNFC) );
+    ASSERT_EQ( std::string(1000, 'a') + "\xC3\xA9" + std::string(1000, 'b'), normalize(long_path, NormalizationNFC) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestNormalize, testDropFileList)
+  {
+    DropFileList list;
+    list.Append("C:\\temp\\a.txt", 13);
+    list.Append("C:\\temp\\e\xCC\x81" "cole.txt", 19);
+    list.Append("C:\\temp\\\xFF.txt", 13);
+    list.Append("C:\\temp\\e\xCC\x81t\xC3\xA9", 14);
+
+    //the invalid file path is left unmodified
+    ASSERT_FALSE( list.Normalize(NormalizationNFC) );
+    ASSERT_EQ( 4, list.GetCount() );
+    ASSERT_EQ( std::string("C:\\temp\\a.txt"), list.GetPath(0) );
+    ASSERT_EQ( std::string("C:\\temp\\\xC3\xA9" "cole.txt"), list.GetPath(1) );
+    ASSERT_EQ( 18, list.GetLength(1) );
+    ASSERT_EQ( std::string("C:\\temp\\\xFF.txt"), list.GetPath(2) );
+    ASSERT_EQ( std::string("C:\\temp\\\xC3\xA9t\xC3\xA9"), list.GetPath(3) );
+    ASSERT_EQ( 13, list.GetLength(3) );
+
+    DropFileList composed;
+    composed.Append("C:\\temp\\\xC3\xA9" "cole.txt", 18);
+    ASSERT_TRUE( composed.Normalize(NormalizationNFC) );
+    ASSERT_EQ( std::string("C:\\temp\\\xC3\xA9" "cole.txt"), composed.GetPath(0) );
+    ASSERT_TRUE( composed.Normalize(NormalizationNFD) );
+    ASSERT_EQ( std::string("C:\\temp\\e\xCC\x81" "cole.txt"), composed.GetPath(0) );
+  }
+  //--------------------------------------------------------------------------------------------------
+ 
+} //namespace test
+} //namespace win32clipboard
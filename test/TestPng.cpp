@@ -0,0 +1,220 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestPng.h"
+
+#include "win32clipboard/png.h"
+
+#include <string>
+#include <string.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //24x16 RGB gradient encoded by a third party encoder with dynamic Huffman blocks.
+  //Pixel (x, y) is (x*10, y*16, x*y).
+  static const unsigned char RGB_24X16_PNG[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x10, 0x08, 0x02, 0x00, 0x00, 0x00, 0x83, 0x46, 0x28,
+    0xc2, 0x00, 0x00, 0x00, 0x63, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0xad, 0xd2, 0x39, 0x0e, 0x80,
+    0x30, 0x0c, 0x44, 0xd1, 0x09, 0x84, 0x9d, 0x00, 0x12, 0x88, 0xfb, 0x1f, 0x95, 0x2e, 0xb2, 0x08,
+    0x49, 0xbc, 0x20, 0xbd, 0x62, 0xdc, 0xfc, 0xca, 0x0e, 0xc0, 0xfc, 0x07, 0x8f, 0x03, 0x80, 0xb3,
+    0x8b, 0xa1, 0xc6, 0x88, 0x86, 0x5a, 0x8b, 0x57, 0xc8, 0xab, 0xa5, 0xa1, 0x4e, 0xe7, 0x33, 0xd4,
+    0x2b, 0xe4, 0x42, 0x83, 0x54, 0x21, 0x34, 0x8a, 0x94, 0x43, 0x13, 0x5f, 0x35, 0xc4, 0xfd, 0x6d,
+    0x4e, 0x68, 0xe1, 0x60, 0x86, 0xd6, 0x2a, 0x7e, 0x28, 0xe4, 0xdd, 0x40, 0x10, 0x85, 0xb6, 0xc4,
+    0x15, 0xb7, 0x34, 0xb4, 0x13, 0x27, 0x3d, 0x1f, 0xf7, 0x73, 0x0a, 0xbf, 0x83, 0x17, 0x7d, 0x12,
+    0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+  };
+
+  //5x3 palette image, 2 bits per pixel, with transparency.
+  //Pixel (x, y) uses the palette entry (x+y)%4.
+  static const unsigned char PALETTE_5X3_PNG[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x03, 0x02, 0x03, 0x00, 0x00, 0x00, 0x26, 0x58, 0x2d,
+    0x6b, 0x00, 0x00, 0x00, 0x0c, 0x50, 0x4c, 0x54, 0x45, 0xff, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0xff, 0xff, 0xfb, 0x00, 0x60, 0xf6, 0x00, 0x00, 0x00, 0x04, 0x74, 0x52, 0x4e,
+    0x53, 0xff, 0x80, 0xff, 0x00, 0x1f, 0x87, 0x86, 0x99, 0x00, 0x00, 0x00, 0x11, 0x49, 0x44, 0x41,
+    0x54, 0x78, 0x9c, 0x63, 0x90, 0x66, 0x60, 0x09, 0xbc, 0xc2, 0xe2, 0x2a, 0x02, 0x00, 0x06, 0x88,
+    0x01, 0xa2, 0xab, 0xe6, 0xb7, 0x5b, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42,
+    0x60, 0x82,
+  };
+
+  //Fill an image with a pattern which exercises all filter types.
+  static void fillImage(Image & image, size_t width, size_t height, bool opaque)
+  {
+    image.Create(width, height);
+    unsigned char * pixels = image.GetPixels();
+    for(size_t y=0; y<height; y++)
+    {
+      for(size_t x=0; x<width; x++)
+      {
+        unsigned char * p = pixels + 4*(y*width + x);
+        p[0] = (unsigned char)(x*3 + y);
+        p[1] = (unsigned char)(y*5);
+        p[2] = (unsigned char)((x ^ y) * 7 + (x*x*y) % 11);
+        p[3] = (opaque ? 0xFF : (unsigned char)(x + y*7));
+      }
+    }
+  }
+
+  static bool isSameImage(const Image & a, const Image & b)
+  {
+    if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight())
+      return false;
+    return memcmp(a.GetPixels(), b.GetPixels(), a.GetStride() * a.GetHeight()) == 0;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestPng::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestPng::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testRoundTrip)
+  {
+    static const size_t sizes[][2] = { {1, 1}, {2, 3}, {5, 1}, {17, 9}, {64, 64}, {333, 211} };
+    static const size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    for(size_t i=0; i<num_sizes; i++)
+    {
+      for(int opaque=0; opaque<2; opaque++)
+      {
+        Image image;
+        fillImage(image, sizes[i][0], sizes[i][1], opaque != 0);
+
+        std::string png;
+        ASSERT_TRUE( encode_png(image, png, 1) );
+        ASSERT_GT( png.size(), 8u );
+
+        //opaque images are encoded without alpha channel
+        ASSERT_EQ( (opaque ? 2 : 6), png[8 + 8 + 9] );
+
+        Image decoded;
+        ASSERT_TRUE( decode_png(png.data(), png.size(), decoded) );
+        ASSERT_TRUE( isSameImage(image, decoded) );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testParallelEncoding)
+  {
+    //big enough to be split in multiple blocks
+    Image image;
+    fillImage(image, 1000, 700, false);
+
+    std::string reference;
+    ASSERT_TRUE( encode_png(image, reference, 1) );
+
+    static const size_t threads[] = { 2, 3, 8, 0 };
+    for(size_t i=0; i<sizeof(threads)/sizeof(threads[0]); i++)
+    {
+      std::string png;
+      ASSERT_TRUE( encode_png(image, png, threads[i]) );
+
+      //the dictionary of each block keeps the compression ratio close to a single block
+      ASSERT_LT( png.size(), reference.size() + reference.size() / 50 );
+
+      Image decoded;
+      ASSERT_TRUE( decode_png(png.data(), png.size(), decoded) );
+      ASSERT_TRUE( isSameImage(image, decoded) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testEncodeEmpty)
+  {
+    Image image;
+    std::string png;
+    ASSERT_FALSE( encode_png(image, png) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testDecodeThirdParty)
+  {
+    Image image;
+    ASSERT_TRUE( decode_png(RGB_24X16_PNG, sizeof(RGB_24X16_PNG), image) );
+    ASSERT_EQ( 24, image.GetWidth() );
+    ASSERT_EQ( 16, image.GetHeight() );
+    for(size_t y=0; y<16; y++)
+    {
+      for(size_t x=0; x<24; x++)
+      {
+        const unsigned char * p = image.GetPixels() + y*image.GetStride() + 4*x;
+        ASSERT_EQ( (unsigned char)(x*10), p[0] );
+        ASSERT_EQ( (unsigned char)(y*16), p[1] );
+        ASSERT_EQ( (unsigned char)(x*y),  p[2] );
+        ASSERT_EQ( 0xFF, p[3] );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testDecodePalette)
+  {
+    static const unsigned char expected[4][4] = {
+      {0xFF, 0x00, 0x00, 0xFF},
+      {0x00, 0xFF, 0x00, 0x80},
+      {0x00, 0x00, 0xFF, 0xFF},
+      {0xFF, 0xFF, 0xFF, 0x00},
+    };
+
+    Image image;
+    ASSERT_TRUE( decode_png(PALETTE_5X3_PNG, sizeof(PALETTE_5X3_PNG), image) );
+    ASSERT_EQ( 5, image.GetWidth() );
+    ASSERT_EQ( 3, image.GetHeight() );
+    for(size_t y=0; y<3; y++)
+    {
+      for(size_t x=0; x<5; x++)
+      {
+        const unsigned char * p = image.GetPixels() + y*image.GetStride() + 4*x;
+        ASSERT_EQ( 0, memcmp(expected[(x + y) % 4], p, 4) );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestPng, testDecodeMalformed)
+  {
+    const std::string valid((const char *)RGB_24X16_PNG, sizeof(RGB_24X16_PNG));
+    Image image;
+
+    //not a png file
+    ASSERT_FALSE( decode_png("hello", 5, image) );
+
+    //truncated at every position
+    for(size_t size=0; size<valid.size(); size++)
+    {
+      ASSERT_FALSE( decode_png(valid.data(), size, image) );
+    }
+
+    //corrupted: either the chunk checksum or the decoder rejects the file
+    for(size_t i=8; i<valid.size(); i++)
+    {
+      std::string corrupted = valid;
+      corrupted[i] ^= 0x10;
+      ASSERT_FALSE( decode_png(corrupted.data(), corrupted.size(), image) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,81 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include "TestResult.h"
+
+#include "win32clipboard/result.h"
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static ClipboardResult makeResult(ClipboardResult::Code iCode, uint32_t iSystemCode, ClipboardStats::Operation iOperation, ClipboardStats::Kind iKind)
+  {
+    ClipboardResult result;
+    result.code = iCode;
+    result.system_code = iSystemCode;
+    result.operation = iOperation;
+    result.kind = iKind;
+    return result;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestResult::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestResult::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestResult, testIsSuccess)
+  {
+    ASSERT_TRUE ( makeResult(ClipboardResult::CodeSuccess, 0, ClipboardStats::OperationGet, ClipboardStats::KindText).IsSuccess() );
+    ASSERT_FALSE( makeResult(ClipboardResult::CodeFailed, 0, ClipboardStats::OperationGet, ClipboardStats::KindText).IsSuccess() );
+    ASSERT_FALSE( makeResult(ClipboardResult::CodeOpenFailed, 5, ClipboardStats::OperationSet, ClipboardStats::KindText).IsSuccess() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestResult, testGetDescription)
+  {
+    ASSERT_EQ( "Get unicode text succeeded",
+               makeResult(ClipboardResult::CodeSuccess, 0, ClipboardStats::OperationGet, ClipboardStats::KindUnicode).GetDescription() );
+    ASSERT_EQ( "Get binary failed: the clipboard does not contain the format",
+               makeResult(ClipboardResult::CodeFormatNotAvailable, 0, ClipboardStats::OperationGet, ClipboardStats::KindBinary).GetDescription() );
+    ASSERT_EQ( "Empty all formats failed: the operation failed",
+               makeResult(ClipboardResult::CodeFailed, 0, ClipboardStats::OperationEmpty, ClipboardStats::KindAll).GetDescription() );
+
+    //the system code is appended to the description. The message of the system code depends on the platform and the language.
+    const std::string description = makeResult(ClipboardResult::CodeOpenFailed, 5, ClipboardStats::OperationSet, ClipboardStats::KindText).GetDescription();
+    const std::string expected = "Set text failed: the clipboard could not be opened (error 5";
+    ASSERT_EQ( expected, description.substr(0, expected.size()) );
+    ASSERT_EQ( ')', description[description.size() - 1] );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestResult, testInvalidOperation)
+  {
+    //only the code is described if the operation is unknown
+    ASSERT_EQ( "the clipboard memory could not be allocated",
+               makeResult(ClipboardResult::CodeOutOfMemory, 0, ClipboardStats::OperationUnknown, ClipboardStats::KindText).GetDescription() );
+  }
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,260 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestSearch.h"
+
+#include "win32clipboard/search.h"
+#include "win32clipboard/transcode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //Returns a random string of the given size over a small alphabet, to get many partial matches.
+  static std::string getRandomString(size_t size, const char * alphabet)
+  {
+    const size_t alphabet_size = strlen(alphabet);
+    std::string str(size, '\0');
+    for(size_t i=0; i<size; i++)
+      str[i] = alphabet[rand() % alphabet_size];
+    return str;
+  }
+
+  //Find all occurrences of the patterns, one pattern at a time.
+  static std::vector<SearchMatch> findAllNaive(const std::string & data, const std::vector<std::string> & patterns, size_t alignment)
+  {
+    std::vector<SearchMatch> matches;
+    for(size_t end=1; end<=data.size(); end++)
+    {
+      //longest pattern first. Duplicates are reported once.
+      std::vector<size_t> candidates;
+      for(size_t i=0; i<patterns.size(); i++)
+      {
+        const std::string & pattern = patterns[i];
+        if (pattern.empty() || pattern.size() > end || (end - pattern.size()) % alignment != 0)
+          continue;
+        if (data.compare(end - pattern.size(), pattern.size(), pattern) != 0)
+          continue;
+        bool duplicate = false;
+        for(size_t j=0; j<candidates.size(); j++)
+          duplicate = duplicate || patterns[candidates[j]] == pattern;
+        if (!duplicate)
+          candidates.push_back(i);
+      }
+      for(size_t i=0; i<candidates.size(); i++)
+      {
+        for(size_t j=i+1; j<candidates.size(); j++)
+        {
+          if (patterns[candidates[j]].size() > patterns[candidates[i]].size())
+            std::swap(candidates[i], candidates[j]);
+        }
+        SearchMatch match;
+        match.pattern = candidates[i];
+        match.offset = end - patterns[candidates[i]].size();
+        match.size = patterns[candidates[i]].size();
+        matches.push_back(match);
+      }
+    }
+    return matches;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestSearch::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestSearch::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testFindBytes)
+  {
+    const std::string data = "The quick brown fox jumps over the lazy dog. The quick brown fox.";
+    ASSERT_EQ( 0, find_bytes(data.data(), data.size(), "The", 3) );
+    ASSERT_EQ( 16, find_bytes(data.data(), data.size(), "fox", 3) );
+    ASSERT_EQ( 40, find_bytes(data.data(), data.size(), "dog.", 4) );
+    ASSERT_EQ( 4, find_bytes(data.data(), data.size(), "q", 1) );
+    ASSERT_EQ( 0, find_bytes(data.data(), data.size(), "", 0) );
+    ASSERT_EQ( SEARCH_NOT_FOUND, find_bytes(data.data(), data.size(), "cat", 3) );
+    ASSERT_EQ( SEARCH_NOT_FOUND, find_bytes(data.data(), 2, "The", 3) );
+
+    //binary data
+    const char binary[] = { 0, 1, 2, 0, 0, 3, 0 };
+    const char pattern[] = { 0, 3 };
+    ASSERT_EQ( 4, find_bytes(binary, sizeof(binary), pattern, sizeof(pattern)) );
+
+    //compare with std::string::find() at every position of the vectorized loop
+    srand(0);
+    for(size_t iteration=0; iteration<2000; iteration++)
+    {
+      const std::string haystack = getRandomString(rand() % 100, "abc");
+      const std::string needle = getRandomString(1 + rand() % 6, "abc");
+      const size_t expected = haystack.find(needle);
+      const size_t offset = find_bytes(haystack.data(), haystack.size(), needle.data(), needle.size());
+      ASSERT_EQ( expected == std::string::npos ? SEARCH_NOT_FOUND : expected, offset ) << haystack << " " << needle;
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testFindBytesAligned)
+  {
+    //the first "ab" is at an odd offset
+    const std::string data = "xab" + std::string(17, 'x') + "ab";
+    ASSERT_EQ( 1, find_bytes(data.data(), data.size(), "ab", 2) );
+    ASSERT_EQ( 20, find_bytes(data.data(), data.size(), "ab", 2, 2) );
+    ASSERT_EQ( SEARCH_NOT_FOUND, find_bytes(data.data(), data.size() - 1, "ab", 2, 2) );
+
+    //utf16 text
+    const std::u16string text = utf8_to_utf16("\xC3\xA9" "cole " "\xE2\x82\xAC" " 100");
+    const std::u16string euro = utf8_to_utf16("\xE2\x82\xAC");
+    const size_t offset = find_bytes((const char *)text.data(), text.size() * 2, (const char *)euro.data(), euro.size() * 2, 2);
+    ASSERT_EQ( 6 * 2, offset );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testStartsEndsWith)
+  {
+    const std::string data = "https://www.example.com/index.html";
+    ASSERT_TRUE ( starts_with(data.data(), data.size(), "https://", 8) );
+    ASSERT_FALSE( starts_with(data.data(), data.size(), "http:", 5) );
+    ASSERT_TRUE ( ends_with(data.data(), data.size(), ".html", 5) );
+    ASSERT_FALSE( ends_with(data.data(), data.size(), ".htm", 4) );
+    ASSERT_TRUE ( starts_with(data.data(), data.size(), "", 0) );
+    ASSERT_TRUE ( ends_with(data.data(), data.size(), "", 0) );
+    ASSERT_FALSE( starts_with("ab", 2, "abc", 3) );
+    ASSERT_FALSE( ends_with("bc", 2, "abc", 3) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testPatternSet)
+  {
+    std::vector<std::string> patterns;
+    patterns.push_back("he");
+    patterns.push_back("she");
+    patterns.push_back("his");
+    patterns.push_back("hers");
+    PatternSet set(patterns);
+    ASSERT_EQ( 4, set.GetCount() );
+    ASSERT_EQ( PatternSet::EncodingBytes, set.GetEncoding() );
+
+    //the first match is the one ending first, the longest one at the same end
+    const std::string data = "ushers";
+    SearchMatch match;
+    ASSERT_TRUE( set.Find(data.data(), data.size(), match) );
+    ASSERT_EQ( 1, match.pattern );
+    ASSERT_EQ( 1, match.offset );
+    ASSERT_EQ( 3, match.size );
+
+    std::vector<SearchMatch> matches;
+    ASSERT_EQ( 3, set.FindAll(data.data(), data.size(), matches) );
+    ASSERT_EQ( 1, matches[0].pattern );
+    ASSERT_EQ( 0, matches[1].pattern );
+    ASSERT_EQ( 2, matches[1].offset );
+    ASSERT_EQ( 3, matches[2].pattern );
+    ASSERT_EQ( 2, matches[2].offset );
+
+    ASSERT_FALSE( set.Find("nothing", 7, match) );
+    ASSERT_EQ( 0, set.FindAll("", 0, matches) );
+
+    //an empty set never matches
+    PatternSet empty(std::vector<std::string>(1, ""));
+    ASSERT_FALSE( empty.Find(data.data(), data.size(), match) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testPatternSetRandom)
+  {
+    //compare with a naive search, with few (vectorized skip) and many distinct first bytes
+    static const char * alphabets[] = { "ab", "abcd", "abcdefgh" };
+    srand(1);
+    for(size_t iteration=0; iteration<600; iteration++)
+    {
+      const char * alphabet = alphabets[iteration % 3];
+      std::vector<std::string> patterns(1 + rand() % 8);
+      for(size_t i=0; i<patterns.size(); i++)
+        patterns[i] = getRandomString(rand() % 5, alphabet);
+
+      //long runs of bytes that do not start a pattern
+      std::string data = getRandomString(rand() % 200, "abcdefgh");
+      for(size_t i=0; i<data.size(); i++)
+      {
+        if (rand() % 4 != 0)
+          data[i] = 'z';
+      }
+
+      const size_t alignment = 1;
+      const std::vector<SearchMatch> expected = findAllNaive(data, patterns, alignment);
+
+      PatternSet set(patterns);
+      std::vector<SearchMatch> matches;
+      ASSERT_EQ( expected.size(), set.FindAll(data.data(), data.size(), matches) );
+      for(size_t i=0; i<matches.size(); i++)
+      {
+        ASSERT_EQ( expected[i].pattern, matches[i].pattern ) << "Iteration " << iteration << " match " << i;
+        ASSERT_EQ( expected[i].offset, matches[i].offset ) << "Iteration " << iteration << " match " << i;
+        ASSERT_EQ( expected[i].size, matches[i].size ) << "Iteration " << iteration << " match " << i;
+      }
+
+      SearchMatch match;
+      ASSERT_EQ( !expected.empty(), set.Find(data.data(), data.size(), match) );
+      if (!expected.empty())
+      {
+        ASSERT_EQ( expected[0].pattern, match.pattern );
+        ASSERT_EQ( expected[0].offset, match.offset );
+      }
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestSearch, testPatternSetUtf16)
+  {
+    std::vector<std::string> patterns;
+    patterns.push_back("\xE2\x82\xAC");  //euro sign
+    patterns.push_back("cole");
+    PatternSet set(patterns, PatternSet::EncodingUtf16);
+    ASSERT_EQ( PatternSet::EncodingUtf16, set.GetEncoding() );
+
+    const std::u16string text = utf8_to_utf16("\xC3\xA9" "cole " "\xE2\x82\xAC" " 100");
+    std::vector<SearchMatch> matches;
+    ASSERT_EQ( 2, set.FindAll((const char *)text.data(), text.size() * 2, matches) );
+    ASSERT_EQ( 1, matches[0].pattern );
+    ASSERT_EQ( 1 * 2, matches[0].offset );
+    ASSERT_EQ( 4 * 2, matches[0].size );
+    ASSERT_EQ( 0, matches[1].pattern );
+    ASSERT_EQ( 6 * 2, matches[1].offset );
+
+    //U+6120 U+6200 U+2000 contains the bytes of "ab" in utf16 (61 00 62 00) at an odd offset only
+    std::vector<std::string> ab(1, "ab");
+    PatternSet utf16(ab, PatternSet::EncodingUtf16);
+    const char16_t odd[] = { 0x6120, 0x6200, 0x2000 };
+    const char16_t ab16[] = { 0x0061, 0x0062 };
+    SearchMatch match;
+    ASSERT_EQ( 1, find_bytes((const char *)odd, sizeof(odd), (const char *)ab16, sizeof(ab16)) );
+    ASSERT_FALSE( utf16.Find((const char *)odd, sizeof(odd), match) );
+    const char16_t even[] = { 0x0020, 0x0061, 0x0062 };
+    ASSERT_TRUE( utf16.Find((const char *)even, sizeof(even), match) );
+    ASSERT_EQ( 2, match.offset );
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
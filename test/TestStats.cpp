@@ -0,0 +1,202 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestStats.h"
+
+#include "win32clipboard/stats.h"
+
+#include <vector>
+#include <thread>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  struct TraceLog
+  {
+    std::vector<TraceEvent> events;
+  };
+
+  static void traceCallback(const TraceEvent & iEvent, void * iUserData)
+  {
+    TraceLog * log = (TraceLog *)iUserData;
+    log->events.push_back(iEvent);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestStats::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestStats::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testBuckets)
+  {
+    ASSERT_EQ(0, LatencyHistogram::GetBucket(0));
+    ASSERT_EQ(1, LatencyHistogram::GetBucket(1));
+    ASSERT_EQ(2, LatencyHistogram::GetBucket(2));
+    ASSERT_EQ(2, LatencyHistogram::GetBucket(3));
+    ASSERT_EQ(3, LatencyHistogram::GetBucket(4));
+    ASSERT_EQ(11, LatencyHistogram::GetBucket(1024));
+    ASSERT_EQ(LatencyHistogram::NUM_BUCKETS - 1, LatencyHistogram::GetBucket((uint64_t)-1));
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testPercentiles)
+  {
+    StatsRecorder recorder;
+    ClipboardStats stats;
+    recorder.GetStats(stats);
+    ASSERT_EQ(0, stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindText).latency.GetPercentile(50.0));
+
+    //90 fast operations and 10 slow operations
+    for(size_t i=0; i<90; i++)
+      recorder.Record(ClipboardStats::OperationSet, ClipboardStats::KindText, true, 10, 1000);
+    for(size_t i=0; i<10; i++)
+      recorder.Record(ClipboardStats::OperationSet, ClipboardStats::KindText, true, 10, 1000000);
+    recorder.GetStats(stats);
+
+    const LatencyHistogram & latency = stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindText).latency;
+    ASSERT_EQ(100, latency.count);
+    ASSERT_EQ(90*1000 + 10*1000000, latency.total_ns);
+    ASSERT_EQ(1000000, latency.max_ns);
+    ASSERT_EQ(90, latency.buckets[LatencyHistogram::GetBucket(1000)]);
+
+    //percentiles are rounded up to the end of their bucket
+    ASSERT_EQ(1023, latency.GetPercentile(50.0));
+    ASSERT_EQ(1023, latency.GetPercentile(90.0));
+    ASSERT_EQ(1000000, latency.GetPercentile(91.0));
+    ASSERT_EQ(1000000, latency.GetPercentile(100.0));
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testRecordAndReset)
+  {
+    StatsRecorder recorder;
+    recorder.Record(ClipboardStats::OperationGet, ClipboardStats::KindBinary, true, 100, 50);
+    recorder.Record(ClipboardStats::OperationGet, ClipboardStats::KindBinary, false, 0, 70);
+    recorder.RecordOpen(true, 2, 100000);
+    recorder.RecordOpen(false, 4, 250000);
+
+    ClipboardStats stats;
+    recorder.GetStats(stats);
+    const OperationStats & get = stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindBinary);
+    ASSERT_EQ(2, get.calls);
+    ASSERT_EQ(1, get.failures);
+    ASSERT_EQ(100, get.bytes);
+    ASSERT_EQ(0, stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindBinary).calls);
+    ASSERT_EQ(1, stats.opens);
+    ASSERT_EQ(6, stats.open_retries);
+    ASSERT_EQ(1, stats.open_failures);
+    ASSERT_EQ(2, stats.open_latency.count);
+
+    recorder.Reset();
+    recorder.GetStats(stats);
+    ASSERT_EQ(0, stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindBinary).calls);
+    ASSERT_EQ(0, stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindBinary).latency.max_ns);
+    ASSERT_EQ(0, stats.opens);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testConcurrentRecording)
+  {
+    static const size_t NUM_THREADS = 4;
+    static const size_t NUM_OPERATIONS = 20000;
+
+    StatsRecorder recorder;
+    std::vector<std::thread> threads;
+    for(size_t i=0; i<NUM_THREADS; i++)
+    {
+      threads.push_back(std::thread([&recorder, i]()
+      {
+        for(size_t j=0; j<NUM_OPERATIONS; j++)
+          recorder.Record(ClipboardStats::OperationSet, ClipboardStats::KindUnicode, true, 2, i * NUM_OPERATIONS + j);
+      }));
+    }
+    for(size_t i=0; i<threads.size(); i++)
+      threads[i].join();
+
+    ClipboardStats stats;
+    recorder.GetStats(stats);
+    const OperationStats & set = stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindUnicode);
+    ASSERT_EQ(NUM_THREADS * NUM_OPERATIONS, set.calls);
+    ASSERT_EQ(NUM_THREADS * NUM_OPERATIONS * 2, set.bytes);
+    ASSERT_EQ(NUM_THREADS * NUM_OPERATIONS - 1, set.latency.max_ns);
+
+    uint64_t count = 0;
+    for(size_t i=0; i<LatencyHistogram::NUM_BUCKETS; i++)
+      count += set.latency.buckets[i];
+    ASSERT_EQ(set.latency.count, count);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testTraceCallback)
+  {
+    StatsRecorder recorder;
+    TraceLog log;
+    recorder.SetTraceCallback(&traceCallback, &log);
+
+    recorder.TraceBegin(ClipboardStats::OperationGet, ClipboardStats::KindHtml);
+    recorder.Record(ClipboardStats::OperationGet, ClipboardStats::KindHtml, true, 42, 1000);
+    ASSERT_EQ(2, log.events.size());
+    ASSERT_EQ(TraceEvent::TypeBegin, log.events[0].type);
+    ASSERT_EQ(ClipboardStats::OperationGet, log.events[0].operation);
+    ASSERT_EQ(ClipboardStats::KindHtml, log.events[0].kind);
+    ASSERT_EQ(TraceEvent::TypeEnd, log.events[1].type);
+    ASSERT_TRUE(log.events[1].success);
+    ASSERT_EQ(42, log.events[1].bytes);
+    ASSERT_EQ(1000, log.events[1].duration_ns);
+
+    recorder.SetTraceCallback(NULL, NULL);
+    recorder.Record(ClipboardStats::OperationGet, ClipboardStats::KindHtml, true, 42, 1000);
+    ASSERT_EQ(2, log.events.size());
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestStats, testScope)
+  {
+    StatsRecorder recorder;
+    {
+      StatsScope scope(recorder, ClipboardStats::OperationSet, ClipboardStats::KindImage);
+      ASSERT_TRUE( scope.End(true, 64) );
+    }
+    {
+      //not ended: recorded as a failure
+      StatsScope scope(recorder, ClipboardStats::OperationSet, ClipboardStats::KindImage);
+    }
+
+    ClipboardStats stats;
+    recorder.GetStats(stats);
+    const OperationStats & set = stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindImage);
+    if (StatsRecorder::IsEnabled())
+    {
+      ASSERT_EQ(2, set.calls);
+      ASSERT_EQ(1, set.failures);
+      ASSERT_EQ(64, set.bytes);
+    }
+    else
+    {
+      ASSERT_EQ(0, set.calls);
+    }
+  }
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,321 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestTable.h"
+
+#include "win32clipboard/table.h"
+
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#include <locale.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  typedef std::vector<std::string> Row;
+  typedef std::vector<Row> Rows;
+
+  //Reference parser, one character at a time.
+  static Rows parseReference(const std::string & text, char delimiter)
+  {
+    Rows rows;
+    if (text.empty())
+      return rows;
+
+    Row row;
+    std::string cell;
+    bool in_quotes = false;
+    bool cell_started = false;
+    bool trailing_cr = false; //the cell ends with a '\r' outside of the quotes
+    for(size_t i=0; i<text.size(); i++)
+    {
+      const char c = text[i];
+      if (in_quotes)
+      {
+        if (c == '"' && i + 1 < text.size() && text[i + 1] == '"')
+        {
+          cell += '"';
+          i++;
+        }
+        else if (c == '"')
+          in_quotes = false;
+        else
+          cell += c;
+        continue;
+      }
+      if (c == '"' && !cell_started)
+      {
+        in_quotes = cell_started = true;
+        continue;
+      }
+      if (c == delimiter || c == '\n')
+      {
+        if (c == '\n' && trailing_cr)
+          cell.erase(cell.size() - 1);
+        row.push_back(cell);
+        cell.clear();
+        cell_started = trailing_cr = false;
+        if (c == '\n')
+        {
+          rows.push_back(row);
+          row.clear();
+        }
+        continue;
+      }
+      cell += c;
+      cell_started = true;
+      trailing_cr = (c == '\r');
+    }
+    if (text[text.size() - 1] != '\n' || cell_started || !row.empty())
+    {
+      if (!in_quotes && trailing_cr)
+        cell.erase(cell.size() - 1);
+      row.push_back(cell);
+      rows.push_back(row);
+    }
+    return rows;
+  }
+
+  static Rows getRows(const Table & table)
+  {
+    Rows rows(table.GetRowCount());
+    for(size_t i=0; i<rows.size(); i++)
+    {
+      rows[i].resize(table.GetCellCount(i));
+      for(size_t j=0; j<rows[i].size(); j++)
+        table.GetCellValue(i, j, rows[i][j]);
+    }
+    return rows;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestTable::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestTable::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testTabSeparatedValues)
+  {
+    const std::string text = "name\tqty\tprice\r\napple\t3\t1.25\r\npear\t\t0.5\r\n";
+    Table table;
+    ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+
+    ASSERT_EQ(3, table.GetRowCount());
+    ASSERT_EQ(3, table.GetCellCount(0));
+    ASSERT_EQ(3, table.GetCellCount(1));
+    ASSERT_EQ(3, table.GetCellCount(2));
+    ASSERT_EQ(0, table.GetCellCount(3));
+
+    //cells are views over the text
+    const char * data = NULL;
+    size_t size = 0;
+    ASSERT_TRUE( table.GetCell(1, 0, data, size) );
+    ASSERT_EQ(text.data() + text.find("apple"), data);
+    ASSERT_EQ(std::string("apple"), std::string(data, size));
+
+    //line endings are excluded from the last cell
+    std::string value;
+    ASSERT_TRUE( table.GetCellValue(0, 2, value) );
+    ASSERT_EQ(std::string("price"), value);
+    ASSERT_TRUE( table.GetCellValue(2, 1, value) );
+    ASSERT_EQ(std::string(""), value);
+    ASSERT_FALSE( table.GetCellValue(2, 3, value) );
+    ASSERT_FALSE( table.IsQuoted(1, 0) );
+
+    //without a trailing line ending
+    ASSERT_TRUE( table.Parse(text.data(), text.size() - 2) );
+    ASSERT_EQ(3, table.GetRowCount());
+    ASSERT_TRUE( table.GetCellValue(2, 2, value) );
+    ASSERT_EQ(std::string("0.5"), value);
+
+    //empty lines are rows with a single empty cell
+    const std::string empty_lines = "a\n\nb";
+    ASSERT_TRUE( table.Parse(empty_lines.data(), empty_lines.size()) );
+    ASSERT_EQ(3, table.GetRowCount());
+    ASSERT_EQ(1, table.GetCellCount(1));
+
+    ASSERT_TRUE( table.Parse(NULL, 0) );
+    ASSERT_EQ(0, table.GetRowCount());
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testQuotedCells)
+  {
+    const std::string text = "\"multi\nline\"\t\"say \"\"hi\"\"\"\t\"a\tb\"\r\nx\"y\t\"\"\tz\n";
+    Table table;
+    ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+    ASSERT_EQ(2, table.GetRowCount());
+    ASSERT_EQ(3, table.GetCellCount(0));
+    ASSERT_EQ(3, table.GetCellCount(1));
+
+    std::string value;
+    ASSERT_TRUE( table.IsQuoted(0, 0) );
+    ASSERT_TRUE( table.GetCellValue(0, 0, value) );
+    ASSERT_EQ(std::string("multi\nline"), value);
+    ASSERT_TRUE( table.GetCellValue(0, 1, value) );
+    ASSERT_EQ(std::string("say \"hi\""), value);
+    ASSERT_TRUE( table.GetCellValue(0, 2, value) );
+    ASSERT_EQ(std::string("a\tb"), value);
+
+    //the raw view keeps the escaped quotes
+    const char * data = NULL;
+    size_t size = 0;
+    ASSERT_TRUE( table.GetCell(0, 1, data, size) );
+    ASSERT_EQ(std::string("say \"\"hi\"\""), std::string(data, size));
+
+    //quotes are only special at the beginning of a cell
+    ASSERT_FALSE( table.IsQuoted(1, 0) );
+    ASSERT_TRUE( table.GetCellValue(1, 0, value) );
+    ASSERT_EQ(std::string("x\"y"), value);
+    ASSERT_TRUE( table.IsQuoted(1, 1) );
+    ASSERT_TRUE( table.GetCellValue(1, 1, value) );
+    ASSERT_EQ(std::string(""), value);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testCommaSeparatedValues)
+  {
+    std::string text = "a,\"b,c\",d\n1,2,3";
+    Table table;
+    ASSERT_TRUE( table.Assign(text, ',') );
+    ASSERT_TRUE( text.empty() );
+    ASSERT_EQ(2, table.GetRowCount());
+
+    std::string value;
+    ASSERT_TRUE( table.GetCellValue(0, 1, value) );
+    ASSERT_EQ(std::string("b,c"), value);
+
+    ASSERT_FALSE( table.Parse("a", 1, '"') );
+    ASSERT_FALSE( table.Parse("a", 1, '\n') );
+    ASSERT_EQ(0, table.GetRowCount());
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testColumnAsNumbers)
+  {
+    const std::string text =
+      "id\tvalue\n"
+      "1\t42\n"
+      "2\t-3.5\n"
+      "3\t\"1e3\"\n"
+      "4\tabc\n"
+      "5\n"
+      "6\t 0.1 \n"
+      "7\t12345678901234567890\n"
+      "8\tinf\n";
+    Table table;
+    ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+
+    std::vector<double> values;
+    ASSERT_EQ(5, table.GetColumnAsNumbers(1, values));
+    ASSERT_EQ(9, values.size());
+    ASSERT_TRUE( isnan(values[0]) );
+    ASSERT_EQ(42.0, values[1]);
+    ASSERT_EQ(-3.5, values[2]);
+    ASSERT_EQ(1000.0, values[3]);
+    ASSERT_TRUE( isnan(values[4]) );
+    ASSERT_TRUE( isnan(values[5]) );
+    ASSERT_EQ(0.1, values[6]);
+    ASSERT_EQ(12345678901234567890.0, values[7]);
+    ASSERT_TRUE( isnan(values[8]) );
+
+    ASSERT_EQ(8, table.GetColumnAsNumbers(0, values));
+    ASSERT_EQ(8.0, values[8]);
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testNumberFormats)
+  {
+    const std::string text =
+      "1.5e3\n"
+      "-2E-2\n"
+      "+25e+1\n"
+      "1e22\n"
+      "1e-22\n"
+      "1.25e300\n"
+      "123456789012345678e-10\n"
+      "1e\n"
+      "1,5\n";
+
+    //numbers use the C locale format whatever the current locale
+    static const char * locales[] = { "de_DE.UTF-8", "fr_FR.UTF-8", "de_DE", "fr_FR", "German", "French" };
+    const std::string previous = setlocale(LC_NUMERIC, NULL);
+    for(size_t i=0; i<sizeof(locales)/sizeof(locales[0]); i++)
+    {
+      if (setlocale(LC_NUMERIC, locales[i]) != NULL)
+        break;
+    }
+
+    Table table;
+    ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+    std::vector<double> values;
+    const size_t count = table.GetColumnAsNumbers(0, values);
+    setlocale(LC_NUMERIC, previous.c_str());
+
+    ASSERT_EQ(7, count);
+    ASSERT_EQ(1500.0, values[0]);
+    ASSERT_EQ(-0.02, values[1]);
+    ASSERT_EQ(250.0, values[2]);
+    ASSERT_EQ(1e22, values[3]);
+    ASSERT_EQ(1e-22, values[4]);
+    ASSERT_EQ(1.25e300, values[5]);
+    ASSERT_EQ(12345678.9012345678, values[6]);
+    ASSERT_TRUE( isnan(values[7]) );
+    ASSERT_TRUE( isnan(values[8]) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testBlockBoundaries)
+  {
+    //special characters at every position around the 64 bytes blocks
+    for(size_t offset=0; offset<140; offset++)
+    {
+      const std::string text = std::string(offset, 'x') + "\"a\"\"\tb\"\t\"\"\"\"\r\nc";
+      Table table;
+      ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+      ASSERT_EQ(parseReference(text, '\t'), getRows(table)) << "offset=" << offset;
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTable, testRandomInputs)
+  {
+    static const char alphabet[] = { 'a', 'b', '"', '"', '\t', ',', '\r', '\n' };
+    srand(1234);
+    for(size_t i=0; i<2000; i++)
+    {
+      std::string text(rand() % 300, '\0');
+      for(size_t j=0; j<text.size(); j++)
+        text[j] = alphabet[rand() % sizeof(alphabet)];
+
+      Table table;
+      ASSERT_TRUE( table.Parse(text.data(), text.size()) );
+      ASSERT_EQ(parseReference(text, '\t'), getRows(table)) << "iteration=" << i;
+      ASSERT_TRUE( table.Parse(text.data(), text.size(), ',') );
+      ASSERT_EQ(parseReference(text, ','), getRows(table)) << "iteration=" << i;
+    }
+  }
+
+} //namespace test
+} //namespace win32clipboard
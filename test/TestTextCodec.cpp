@@ -0,0 +1,191 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include "TestTextCodec.h"
+
+#include "win32clipboard/textcodec.h"
+
+#include <string>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static std::string encodeBase64(const std::string & data)
+  {
+    std::string text(get_base64_encoded_size(data.size()), '\0');
+    encode_base64(data.data(), data.size(), &text[0]);
+    return text;
+  }
+
+  static bool decodeBase64(const std::string & text, std::string & data)
+  {
+    data.assign(get_base64_decoded_size(text.size()), '\0');
+    size_t size = 0;
+    if (!decode_base64(text.data(), text.size(), &data[0], size))
+      return false;
+    data.resize(size);
+    return true;
+  }
+
+  static std::string encodeHex(const std::string & data)
+  {
+    std::string text(get_hex_encoded_size(data.size()), '\0');
+    encode_hex(data.data(), data.size(), &text[0]);
+    return text;
+  }
+
+  static bool decodeHex(const std::string & text, std::string & data)
+  {
+    data.assign(get_hex_decoded_size(text.size()), '\0');
+    size_t size = 0;
+    if (!decode_hex(text.data(), text.size(), &data[0], size))
+      return false;
+    data.resize(size);
+    return true;
+  }
+
+  static std::string generateData(size_t size)
+  {
+    std::string data(size, '\0');
+    uint32_t state = 2463534242u;
+    for(size_t i=0; i<size; i++)
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      data[i] = (char)state;
+    }
+    return data;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestTextCodec::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestTextCodec::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTextCodec, testBase64Vectors)
+  {
+    //test vectors of RFC 4648
+    ASSERT_EQ( "", encodeBase64("") );
+    ASSERT_EQ( "Zg==", encodeBase64("f") );
+    ASSERT_EQ( "Zm8=", encodeBase64("fo") );
+    ASSERT_EQ( "Zm9v", encodeBase64("foo") );
+    ASSERT_EQ( "Zm9vYg==", encodeBase64("foob") );
+    ASSERT_EQ( "Zm9vYmE=", encodeBase64("fooba") );
+    ASSERT_EQ( "Zm9vYmFy", encodeBase64("foobar") );
+
+    //all characters of the alphabet
+    ASSERT_EQ( "+/+/", encodeBase64("\xFB\xFF\xBF") );
+    ASSERT_EQ( "VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", encodeBase64("The quick brown fox jumps over the lazy dog.") );
+
+    std::string data;
+    ASSERT_TRUE( decodeBase64("Zm9vYmE=", data) );
+    ASSERT_EQ( "fooba", data );
+    ASSERT_TRUE( decodeBase64("VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4=", data) );
+    ASSERT_EQ( "The quick brown fox jumps over the lazy dog.", data );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTextCodec, testBase64RoundTrip)
+  {
+    //every size of the last block and of the scalar tail
+    for(size_t size=0; size<100; size++)
+    {
+      const std::string data = generateData(size);
+      const std::string text = encodeBase64(data);
+      ASSERT_EQ( get_base64_encoded_size(size), text.size() );
+      std::string decoded;
+      ASSERT_TRUE( decodeBase64(text, decoded) ) << "size=" << size;
+      ASSERT_EQ( data, decoded ) << "size=" << size;
+    }
+
+    const std::string data = generateData(1024*1024 + 1);
+    std::string decoded;
+    ASSERT_TRUE( decodeBase64(encodeBase64(data), decoded) );
+    ASSERT_EQ( data, decoded );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTextCodec, testBase64Decode)
+  {
+    std::string data;
+
+    //the padding is optional
+    ASSERT_TRUE( decodeBase64("Zm9vYg", data) );
+    ASSERT_EQ( "foob", data );
+    ASSERT_TRUE( decodeBase64("Zm9vYmE", data) );
+    ASSERT_EQ( "fooba", data );
+
+    //spaces and line breaks are ignored, also in the middle of a group
+    const std::string text = encodeBase64(generateData(120));
+    std::string wrapped;
+    for(size_t i=0; i<text.size(); i+=38)
+      wrapped += text.substr(i, 38) + "\r\n";
+    ASSERT_TRUE( decodeBase64(wrapped, data) );
+    ASSERT_EQ( generateData(120), data );
+    ASSERT_TRUE( decodeBase64(" Zm9v\tYmFy \n", data) );
+    ASSERT_EQ( "foobar", data );
+
+    //invalid characters, in the vectorized blocks and in the tail
+    ASSERT_FALSE( decodeBase64("Zm9vYmFyZm9vYmFyZm9v-mFy", data) );
+    ASSERT_FALSE( decodeBase64("Zm9vYmFyZm9vYmFyZm9vY\xC3\xA9" "Fy", data) );
+    ASSERT_FALSE( decodeBase64("Zm9v_", data) );
+
+    //invalid padding
+    ASSERT_FALSE( decodeBase64("Z", data) );
+    ASSERT_FALSE( decodeBase64("Zg=", data) );
+    ASSERT_FALSE( decodeBase64("Zm9v=", data) );
+    ASSERT_FALSE( decodeBase64("Zg===", data) );
+    ASSERT_FALSE( decodeBase64("Zg==Zg==", data) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTextCodec, testHex)
+  {
+    ASSERT_EQ( "", encodeHex("") );
+    ASSERT_EQ( "00ff7f80", encodeHex(std::string("\x00\xFF\x7F\x80", 4)) );
+    ASSERT_EQ( "0123456789abcdeffedcba9876543210", encodeHex("\x01\x23\x45\x67\x89\xAB\xCD\xEF\xFE\xDC\xBA\x98\x76\x54\x32\x10") );
+
+    for(size_t size=0; size<70; size++)
+    {
+      const std::string data = generateData(size);
+      std::string decoded;
+      ASSERT_TRUE( decodeHex(encodeHex(data), decoded) ) << "size=" << size;
+      ASSERT_EQ( data, decoded ) << "size=" << size;
+    }
+
+    //uppercase digits and spaces between bytes
+    std::string data;
+    ASSERT_TRUE( decodeHex("0123456789ABCDEFfedcba9876543210 0A\r\n0b", data) );
+    ASSERT_EQ( "\x01\x23\x45\x67\x89\xAB\xCD\xEF\xFE\xDC\xBA\x98\x76\x54\x32\x10\x0A\x0B", data );
+
+    //invalid characters and odd number of digits
+    ASSERT_FALSE( decodeHex("0123456789abcdef0123456789abcdeg", data) );
+    ASSERT_FALSE( decodeHex("0g", data) );
+    ASSERT_FALSE( decodeHex("012", data) );
+    ASSERT_FALSE( decodeHex("0 1", data) );
+  }
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,233 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestTranscode.h"
+
+#include "win32clipboard/transcode.h"
+
+#include <stdlib.h>
+#include <vector>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  //Encode the given code points in each encoding with a reference implementation.
+  static void encodeReference(const std::vector<uint32_t> & code_points, std::string & utf8, std::u16string & utf16, std::u32string & utf32)
+  {
+    utf8.clear();
+    utf16.clear();
+    utf32.clear();
+    for(size_t i=0; i<code_points.size(); i++)
+    {
+      const uint32_t c = code_points[i];
+      utf32 += (char32_t)c;
+      if (c < 0x10000)
+        utf16 += (char16_t)c;
+      else
+      {
+        utf16 += (char16_t)(0xD800 | ((c - 0x10000) >> 10));
+        utf16 += (char16_t)(0xDC00 | ((c - 0x10000) & 0x3FF));
+      }
+      if (c < 0x80)
+        utf8 += (char)c;
+      else if (c < 0x800)
+      {
+        utf8 += (char)(0xC0 | (c >> 6));
+        utf8 += (char)(0x80 | (c & 0x3F));
+      }
+      else if (c < 0x10000)
+      {
+        utf8 += (char)(0xE0 | (c >> 12));
+        utf8 += (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8 += (char)(0x80 | (c & 0x3F));
+      }
+      else
+      {
+        utf8 += (char)(0xF0 | (c >> 18));
+        utf8 += (char)(0x80 | ((c >> 12) & 0x3F));
+        utf8 += (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8 += (char)(0x80 | (c & 0x3F));
+      }
+    }
+  }
+
+  static uint32_t getRandomCodePoint()
+  {
+    //mostly ASCII, with code points of every length
+    switch(rand() % 5)
+    {
+    case 0:
+    case 1:
+      return (uint32_t)(rand() % 0x80);
+    case 2:
+      return 0x80 + (uint32_t)(rand() % (0x800 - 0x80));
+    case 3:
+      {
+        uint32_t c = 0x800 + (uint32_t)(rand() % (0x10000 - 0x800));
+        if (0xD800 <= c && c <= 0xDFFF)
+          c -= 0x800;
+        return c;
+      }
+    default:
+      return 0x10000 + (uint32_t)(rand() % (0x110000 - 0x10000));
+    };
+  }
+
+  template <typename From, typename To>
+  static void testPair(const std::basic_string<From> & src, const std::basic_string<To> & expected)
+  {
+    std::basic_string<To> output;
+    ASSERT_TRUE( transcode(src, output) );
+    ASSERT_TRUE( expected == output );
+  }
+
+  //--------------------------------------------------------------------------------------------------
+  void TestTranscode::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestTranscode::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTranscode, testEntryPoints)
+  {
+    //school in french and a musical symbol outside of the basic multilingual plane
+    const std::string utf8 = "\xC3\xA9" "cole \xF0\x9D\x84\x9E";
+    const std::u16string utf16 = u"\u00E9cole \U0001D11E";
+    const std::u32string utf32 = U"\u00E9cole \U0001D11E";
+
+    ASSERT_TRUE( utf16 == utf8_to_utf16(utf8) );
+    ASSERT_TRUE( utf32 == utf8_to_utf32(utf8) );
+    ASSERT_EQ( utf8, utf16_to_utf8(utf16) );
+    ASSERT_EQ( utf8, utf32_to_utf8(utf32) );
+    ASSERT_TRUE( utf32 == utf16_to_utf32(utf16) );
+    ASSERT_TRUE( utf16 == utf32_to_utf16(utf32) );
+
+    ASSERT_TRUE( utf8_to_utf16("").empty() );
+    ASSERT_TRUE( utf8_to_utf16("\xFF").empty() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTranscode, testAllPairs)
+  {
+    srand(0);
+    for(size_t iteration=0; iteration<200; iteration++)
+    {
+      std::vector<uint32_t> code_points(rand() % 64);
+      for(size_t i=0; i<code_points.size(); i++)
+        code_points[i] = getRandomCodePoint();
+
+      std::string utf8;
+      std::u16string utf16;
+      std::u32string utf32;
+      encodeReference(code_points, utf8, utf16, utf32);
+
+      testPair(utf8, utf8);
+      testPair(utf8, utf16);
+      testPair(utf8, utf32);
+      testPair(utf16, utf8);
+      testPair(utf16, utf16);
+      testPair(utf16, utf32);
+      testPair(utf32, utf8);
+      testPair(utf32, utf16);
+      testPair(utf32, utf32);
+
+      //wchar_t is utf16 or utf32 depending on its size
+      std::wstring wide;
+      ASSERT_TRUE( transcode(utf8, wide) );
+      if (sizeof(wchar_t) == 2)
+        ASSERT_EQ( utf16.size(), wide.size() );
+      else
+        ASSERT_EQ( utf32.size(), wide.size() );
+      testPair(wide, utf8);
+      testPair(wide, utf16);
+      testPair(wide, utf32);
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTranscode, testInvalidUtf8)
+  {
+    static const char * values[] = {
+      "\x80",               //continuation byte
+      "\xC0\xAF",           //overlong
+      "\xC1\xBF",           //overlong
+      "\xE0\x80\xAF",       //overlong
+      "\xF0\x80\x80\xAF",   //overlong
+      "\xED\xA0\x80",       //surrogate U+D800
+      "\xF4\x90\x80\x80",   //U+110000
+      "\xF5\x80\x80\x80",   //invalid lead byte
+      "\xC3",               //truncated
+      "\xE2\x82",           //truncated
+      "\xC3\x28",           //invalid continuation byte
+      "\xFF",
+    };
+    static const size_t num_values = sizeof(values) / sizeof(values[0]);
+
+    for(size_t i=0; i<num_values; i++)
+    {
+      const std::string value = std::string("foo") + values[i] + "bar";
+      std::u16string utf16 = u"x";
+      std::u32string utf32;
+      ASSERT_FALSE( transcode(value, utf16) ) << "Value " << i;
+      ASSERT_FALSE( transcode(value, utf32) ) << "Value " << i;
+      ASSERT_TRUE( utf16.empty() );
+    }
+
+    //boundaries of each sequence length are valid
+    static const char * boundaries[] = {
+      "\x7F",
+      "\xC2\x80",
+      "\xDF\xBF",
+      "\xE0\xA0\x80",
+      "\xED\x9F\xBF",
+      "\xEE\x80\x80",
+      "\xEF\xBF\xBF",
+      "\xF0\x90\x80\x80",
+      "\xF4\x8F\xBF\xBF",
+    };
+    static const uint32_t code_points[] = { 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFF, 0x10000, 0x10FFFF };
+    for(size_t i=0; i<sizeof(boundaries)/sizeof(boundaries[0]); i++)
+    {
+      std::u32string utf32;
+      ASSERT_TRUE( transcode(std::string(boundaries[i]), utf32) );
+      ASSERT_EQ( 1, utf32.size() );
+      ASSERT_EQ( code_points[i], (uint32_t)utf32[0] );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestTranscode, testInvalidUtf16Utf32)
+  {
+    std::string utf8;
+    ASSERT_FALSE( transcode(std::u16string(1, (char16_t)0xD800), utf8) );   //unpaired high surrogate
+    ASSERT_FALSE( transcode(std::u16string(1, (char16_t)0xDC00), utf8) );   //unpaired low surrogate
+    const char16_t pair[] = { 0xD800, 'a' };
+    ASSERT_FALSE( transcode(pair, 2, utf8) );                               //high surrogate followed by a character
+    ASSERT_FALSE( transcode(std::u32string(1, (char32_t)0xD800), utf8) );   //surrogate
+    ASSERT_FALSE( transcode(std::u32string(1, (char32_t)0x110000), utf8) ); //out of range
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
@@ -0,0 +1,194 @@
+/**********************************************************************************
+ * MIT License
+ * 
+ * Copyright (c) 2018 Antoine Beauchamp
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+
+#include "TestUtf8.h"
+
+#include "win32clipboard/utf8.h"
+#include "win32clipboard/transcode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace win32clipboard;
+
+namespace win32clipboard { namespace test
+{
+  static const std::string REPLACEMENT = "\xEF\xBF\xBD"; //U+FFFD
+
+  //--------------------------------------------------------------------------------------------------
+  void TestUtf8::SetUp()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  void TestUtf8::TearDown()
+  {
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestUtf8, testValidate)
+  {
+    static const char * valid[] = {
+      "",
+      "foobar",
+      "espa" "\xC3\xB1" "ol",
+      "\xE2\x82\xAC",           //euro sign
+      "\xF0\x9D\x84\x9E",       //musical symbol G clef
+      "\xED\x9F\xBF",           //U+D7FF
+      "\xF4\x8F\xBF\xBF",       //U+10FFFF
+    };
+    for(size_t i=0; i<sizeof(valid)/sizeof(valid[0]); i++)
+    {
+      Utf8Report report;
+      ASSERT_TRUE( validate_utf8(valid[i], strlen(valid[i]), report) ) << "Value " << i;
+      ASSERT_EQ( 0, report.num_errors );
+      ASSERT_EQ( strlen(valid[i]), report.first_error );
+    }
+
+    static const char * invalid[] = {
+      "\x80",
+      "\xC0\xAF",               //overlong
+      "\xE0\x9F\xBF",           //overlong
+      "\xED\xA0\x80",           //surrogate
+      "\xF4\x90\x80\x80",       //above U+10FFFF
+      "\xF5",
+      "\xC3",                   //truncated
+    };
+    for(size_t i=0; i<sizeof(invalid)/sizeof(invalid[0]); i++)
+    {
+      const std::string value = std::string("foo") + invalid[i];
+      Utf8Report report;
+      ASSERT_FALSE( validate_utf8(value.data(), value.size(), report) ) << "Value " << i;
+      ASSERT_LE( 1, report.num_errors );
+      ASSERT_EQ( 3, report.first_error );
+    }
+
+    //\0 characters are valid
+    Utf8Report report;
+    ASSERT_TRUE( validate_utf8("a\0b", 3, report) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestUtf8, testMaximalSubparts)
+  {
+    //example of the Unicode standard, section 3.9: each maximal subpart is replaced by one U+FFFD
+    const std::string input = "\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64";
+    const std::string expected = "a" + REPLACEMENT + REPLACEMENT + REPLACEMENT + "b" + REPLACEMENT + "c" + REPLACEMENT + REPLACEMENT + "d";
+
+    std::string output;
+    Utf8Report report;
+    ASSERT_FALSE( sanitize_utf8(input.data(), input.size(), output, report) );
+    ASSERT_EQ( expected, output );
+    ASSERT_EQ( 6, report.num_errors );
+    ASSERT_EQ( 1, report.first_error );
+
+    std::u16string utf16;
+    ASSERT_FALSE( sanitize_utf8(input.data(), input.size(), utf16, report) );
+    ASSERT_TRUE( utf8_to_utf16(expected) == utf16 );
+
+    //each byte of an invalid lead byte or surrogate sequence is replaced
+    const std::string surrogate = "\xED\xA0\x80";
+    ASSERT_FALSE( sanitize_utf8(surrogate.data(), surrogate.size(), output, report) );
+    ASSERT_EQ( REPLACEMENT + REPLACEMENT + REPLACEMENT, output );
+    ASSERT_EQ( 3, report.num_errors );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestUtf8, testValidStrings)
+  {
+    //random valid strings are copied and converted as is, with errors at the end of long ASCII runs
+    srand(0);
+    for(size_t iteration=0; iteration<200; iteration++)
+    {
+      std::u32string code_points(rand() % 200, 0);
+      for(size_t i=0; i<code_points.size(); i++)
+      {
+        const int kind = rand() % 8;
+        if (kind < 5)
+          code_points[i] = (char32_t)(0x20 + rand() % 0x5F);
+        else if (kind == 5)
+          code_points[i] = (char32_t)(0x80 + rand() % 0x780);
+        else if (kind == 6)
+          code_points[i] = (char32_t)(0xE000 + rand() % 0x1000);
+        else
+          code_points[i] = (char32_t)(0x10000 + rand() % 0x100000);
+      }
+      const std::string utf8 = utf32_to_utf8(code_points);
+
+      std::string output;
+      std::u16string utf16;
+      Utf8Report report;
+      ASSERT_TRUE( sanitize_utf8(utf8.data(), utf8.size(), output, report) );
+      ASSERT_EQ( utf8, output );
+      ASSERT_TRUE( sanitize_utf8(utf8.data(), utf8.size(), utf16, report) );
+      ASSERT_TRUE( utf32_to_utf16(code_points) == utf16 );
+
+      //an invalid byte at the end
+      const std::string invalid = utf8 + "\xFF";
+      ASSERT_FALSE( sanitize_utf8(invalid.data(), invalid.size(), output, report) );
+      ASSERT_EQ( utf8 + REPLACEMENT, output );
+      ASSERT_EQ( 1, report.num_errors );
+      ASSERT_EQ( utf8.size(), report.first_error );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestUtf8, testOutputGrowth)
+  {
+    //every byte is replaced by 3 bytes
+    const std::string input(1000, '\x80');
+    std::string output;
+    Utf8Report report;
+    ASSERT_FALSE( sanitize_utf8(input.data(), input.size(), output, report) );
+    ASSERT_EQ( 1000, report.num_errors );
+    ASSERT_EQ( 0, report.first_error );
+    ASSERT_EQ( 3000, output.size() );
+    for(size_t i=0; i<output.size(); i+=3)
+    {
+      ASSERT_EQ( REPLACEMENT, output.substr(i, 3) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestUtf8, testConvertLineEndings)
+  {
+    std::string input;
+    std::string expected;
+    for(size_t i=0; i<20; i++)
+    {
+      input += "line\r\n\xC3\xA9\r\n\r\xC3\xA9\r\r\n\xFF\r\n";
+      expected += "line\n\xC3\xA9\n\r\xC3\xA9\r\n\xEF\xBF\xBD\n";
+    }
+    input += "\r";
+    expected += "\r";
+
+    std::string output;
+    Utf8Report report;
+    ASSERT_FALSE( sanitize_utf8(input.data(), input.size(), output, report, true) );
+    ASSERT_EQ( 20, report.num_errors );
+    ASSERT_EQ( 16, report.first_error );
+    ASSERT_EQ( expected, output );
+
+    //the conversion is disabled by default
+    ASSERT_FALSE( sanitize_utf8(input.data(), input.size(), output, report) );
+    ASSERT_EQ( input.size() + 40, output.size() );
+  }
+  //--------------------------------------------------------------------------------------------------
+
+} //namespace test
+} //namespace win32clipboard
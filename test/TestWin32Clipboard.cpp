@@ -24,7 +24,11 @@
 
 #include "TestWin32Clipboard.h"
 
+#include <string.h>
+
 #include "win32clipboard/win32clipboard.h"
+#include "win32clipboard/hash.h"
+#include "win32clipboard/transcode.h"
 
 #include "rapidassist/testing.h"
 #include "rapidassist/filesystem.h"
@@ -42,6 +46,8 @@ namespace win32clipboard { namespace test
   //--------------------------------------------------------------------------------------------------
   void TestWin32Clipboard::TearDown()
   {
+    //restore the default settings of the clipboard singleton
+    Clipboard::GetInstance().SetLineEndingConversion(false);
   }
   //--------------------------------------------------------------------------------------------------
   TEST_F(TestWin32Clipboard, testSetGetText)
@@ -102,6 +108,182 @@ namespace win32clipboard { namespace test
     }
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testSetGetUtf16Utf32)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    //school in french and a musical symbol outside of the basic multilingual plane
+    const std::u16string utf16 = u"\u00E9cole \U0001D11E";
+    const std::u32string utf32 = U"\u00E9cole \U0001D11E";
+
+    ASSERT_TRUE( c.SetTextUnicode(utf16) );
+    std::u16string text16;
+    ASSERT_TRUE( c.GetAsTextUnicode(text16) );
+    ASSERT_TRUE( utf16 == text16 );
+    std::u32string text32;
+    ASSERT_TRUE( c.GetAsTextUnicode(text32) );
+    ASSERT_TRUE( utf32 == text32 );
+
+    //the same text is available as wide characters
+    std::wstring wide;
+    std::wstring expected;
+    ASSERT_TRUE( c.GetAsTextUnicode(wide) );
+    ASSERT_TRUE( transcode(utf16, expected) );
+    ASSERT_EQ( expected, wide );
+
+    ASSERT_TRUE( c.SetTextUnicode(U"foo") );
+    ASSERT_TRUE( c.GetAsTextUnicode(text16) );
+    ASSERT_TRUE( u"foo" == text16 );
+
+    //unpaired surrogates are not valid utf32
+    ASSERT_FALSE( c.SetTextUnicode(std::u32string(1, (char32_t)0xD800)) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testGetAsTextSanitized)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    //valid utf8 text is returned as is
+    const std::string valid = "espa" "\xC3\xB1" "ol";
+    ASSERT_TRUE( c.SetText(valid) );
+    std::string text;
+    Utf8Report report;
+    ASSERT_TRUE( c.GetAsText(text, report) );
+    ASSERT_EQ( valid, text );
+    ASSERT_EQ( 0, report.num_errors );
+
+    //CP1252 text is repaired
+    ASSERT_TRUE( c.SetText("\xE9" "cole") );
+    ASSERT_TRUE( c.GetAsText(text, report) );
+    ASSERT_EQ( "\xEF\xBF\xBD" "cole", text );
+    ASSERT_EQ( 1, report.num_errors );
+    ASSERT_EQ( 0, report.first_error );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testGetText)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    //unicode text is converted to utf8
+    ASSERT_TRUE( c.SetTextUnicode(L"espa\u00F1ol \u6F22\u5B57") );
+    std::string text;
+    ASSERT_TRUE( c.GetText(text) );
+    ASSERT_EQ( "espa" "\xC3\xB1" "ol " "\xE6\xBC\xA2\xE5\xAD\x97", text );
+
+    //ascii text is identical in all encodings
+    ASSERT_TRUE( c.SetText("The quick brown fox") );
+    ASSERT_TRUE( c.GetText(text) );
+    ASSERT_EQ( "The quick brown fox", text );
+
+    //the clipboard does not contain text
+    ASSERT_TRUE( c.SetBinary(std::string("\x01\x02\x03", 3)) );
+    ASSERT_FALSE( c.GetText(text) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testBinaryAsText)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    std::string data;
+    for(size_t i=0; i<1000; i++)
+      data += (char)i;
+
+    //base64
+    ASSERT_TRUE( c.SetBinaryAsText(std::string("foobar\xFF", 7), Clipboard::TextEncodingBase64) );
+    std::string text;
+    ASSERT_TRUE( c.GetAsText(text) );
+    ASSERT_EQ( "Zm9vYmFy/w==", text );
+    ASSERT_TRUE( c.SetBinaryAsText(data, Clipboard::TextEncodingBase64) );
+    std::string buffer;
+    ASSERT_TRUE( c.GetAsBinaryFromText(buffer, Clipboard::TextEncodingBase64) );
+    ASSERT_EQ( data, buffer );
+
+    //hexadecimal
+    ASSERT_TRUE( c.SetBinaryAsText(std::string("\x00\x7F\xFF", 3), Clipboard::TextEncodingHex) );
+    ASSERT_TRUE( c.GetAsText(text) );
+    ASSERT_EQ( "007fff", text );
+    ASSERT_TRUE( c.SetBinaryAsText(data, Clipboard::TextEncodingHex) );
+    ASSERT_TRUE( c.GetAsBinaryFromText(buffer, Clipboard::TextEncodingHex) );
+    ASSERT_EQ( data, buffer );
+
+    //the text is not encoded binary data
+    ASSERT_TRUE( c.SetText("not base64!") );
+    ASSERT_FALSE( c.GetAsBinaryFromText(buffer, Clipboard::TextEncodingBase64) );
+    ASSERT_FALSE( c.GetAsBinaryFromText(buffer, Clipboard::TextEncodingHex) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testGetLastResult)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    ASSERT_TRUE( c.SetText("The quick brown fox") );
+    ClipboardResult result = c.GetLastResult();
+    ASSERT_TRUE( result.IsSuccess() );
+    ASSERT_EQ( ClipboardStats::OperationSet, result.operation );
+    ASSERT_EQ( ClipboardStats::KindText, result.kind );
+
+    //the failure is caused by the missing format, not by a system call
+    std::string buffer;
+    ASSERT_FALSE( c.GetAsBinary(buffer) );
+    result = c.GetLastResult();
+    ASSERT_FALSE( result.IsSuccess() );
+    ASSERT_EQ( ClipboardResult::CodeFormatNotAvailable, result.code );
+    ASSERT_EQ( 0, result.system_code );
+    ASSERT_EQ( ClipboardStats::OperationGet, result.operation );
+    ASSERT_EQ( ClipboardStats::KindBinary, result.kind );
+    ASSERT_EQ( "Get binary failed: the clipboard does not contain the format", result.GetDescription() );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testFind)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    ASSERT_TRUE( c.SetText("Visit https://www.example.com/ today") );
+    size_t offset = 0;
+    ASSERT_TRUE ( c.Find(Clipboard::FormatText, "https://", offset) );
+    ASSERT_EQ( 6, offset );
+    ASSERT_FALSE( c.Find(Clipboard::FormatText, "ftp://", offset) );
+    ASSERT_FALSE( c.Find(Clipboard::FormatUnicode, "https://", offset) );
+    ASSERT_TRUE ( c.StartsWith(Clipboard::FormatText, "Visit") );
+    ASSERT_FALSE( c.StartsWith(Clipboard::FormatText, "https") );
+    ASSERT_TRUE ( c.EndsWith(Clipboard::FormatText, "today") );
+    ASSERT_FALSE( c.EndsWith(Clipboard::FormatText, "today\n") );
+
+    std::vector<std::string> patterns;
+    patterns.push_back("ftp://");
+    patterns.push_back("https://");
+    patterns.push_back("www.");
+    PatternSet set(patterns);
+    SearchMatch match;
+    ASSERT_TRUE( c.FindAny(Clipboard::FormatText, set, match) );
+    ASSERT_EQ( 1, match.pattern );
+    ASSERT_EQ( 6, match.offset );
+    ASSERT_EQ( 8, match.size );
+
+    //unicode patterns are utf8-encoded and offsets are in characters
+    ASSERT_TRUE( c.SetTextUnicode(utf8_to_utf16("\xC3\xA9" "cole " "\xE2\x82\xAC" " 100")) );
+    ASSERT_TRUE( c.Find(Clipboard::FormatUnicode, "\xE2\x82\xAC", offset) );
+    ASSERT_EQ( 6, offset );
+    ASSERT_TRUE( c.StartsWith(Clipboard::FormatUnicode, "\xC3\xA9" "cole") );
+    ASSERT_TRUE( c.EndsWith(Clipboard::FormatUnicode, "100") );
+    PatternSet unicode_set(patterns, PatternSet::EncodingUtf16);
+    ASSERT_FALSE( c.FindAny(Clipboard::FormatUnicode, set, match) ); //wrong encoding
+    ASSERT_FALSE( c.FindAny(Clipboard::FormatUnicode, unicode_set, match) );
+    patterns.push_back("cole");
+    PatternSet cole_set(patterns, PatternSet::EncodingUtf16);
+    ASSERT_TRUE( c.FindAny(Clipboard::FormatUnicode, cole_set, match) );
+    ASSERT_EQ( 3, match.pattern );
+    ASSERT_EQ( 1, match.offset );
+    ASSERT_EQ( 4, match.size );
+
+    //binary data
+    const char buffer[] = { 0, 1, 2, 3, 0, 4 };
+    ASSERT_TRUE( c.SetBinary(Clipboard::MemoryBuffer(buffer, sizeof(buffer))) );
+    ASSERT_TRUE( c.Find(Clipboard::FormatBinary, std::string(buffer + 3, 2), offset) );
+    ASSERT_EQ( 3, offset );
+    ASSERT_TRUE( c.EndsWith(Clipboard::FormatBinary, std::string(buffer + 4, 2)) );
+  }
+  //--------------------------------------------------------------------------------------------------
   TEST_F(TestWin32Clipboard, testEmpty)
   {
     Clipboard & c = Clipboard::GetInstance();
@@ -178,6 +360,116 @@ namespace win32clipboard { namespace test
     ASSERT_EQ( SAMPLE_TEXT, text ) << "Failed setting clipboard to value '" << SAMPLE_TEXT << "'. The returned value is '" << text << "'.";
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testLineEndingConversion)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+    c.SetLineEndingConversion(true);
+    ASSERT_TRUE( c.IsLineEndingConversionEnabled() );
+
+    //the clipboard stores CRLF line endings
+    static const std::string SAMPLE_TEXT = "1\n2\r\n3\n4\n5";
+    ASSERT_TRUE( c.SetText(SAMPLE_TEXT) );
+
+    uint64_t hash = 0;
+    ASSERT_TRUE( c.Hash(Clipboard::FormatText, hash) );
+    static const std::string CLIPBOARD_TEXT = "1\r\n2\r\n3\r\n4\r\n5";
+    ASSERT_EQ( hash64(CLIPBOARD_TEXT.data(), CLIPBOARD_TEXT.size()), hash );
+
+    std::string text;
+    ASSERT_TRUE( c.GetAsText(text) );
+    ASSERT_EQ( std::string("1\n2\n3\n4\n5"), text );
+
+    static const std::wstring SAMPLE_UNICODE_TEXT = L"1\n2\r\n3";
+    ASSERT_TRUE( c.SetTextUnicode(SAMPLE_UNICODE_TEXT) );
+    std::wstring unicode_text;
+    ASSERT_TRUE( c.GetAsTextUnicode(unicode_text) );
+    ASSERT_TRUE( std::wstring(L"1\n2\n3") == unicode_text );
+
+    c.SetLineEndingConversion(false);
+    ASSERT_TRUE( c.GetAsTextUnicode(unicode_text) );
+    ASSERT_TRUE( std::wstring(L"1\r\n2\r\n3") == unicode_text );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testSetGetHtml)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    static const std::string FRAGMENT = "<p>caf\xC3\xA9 <b>bold</b></p>";
+    static const std::string TEXT = "cafe bold";
+    ASSERT_TRUE( c.SetHtml(FRAGMENT, TEXT) );
+
+    std::string fragment;
+    ASSERT_TRUE( c.GetAsHtml(fragment) );
+    ASSERT_EQ( FRAGMENT, fragment );
+
+    //the plain text alternative is also available
+    std::string text;
+    ASSERT_TRUE( c.GetAsText(text) );
+    ASSERT_EQ( TEXT, text );
+
+    c.SetText(TEXT);
+    ASSERT_FALSE( c.GetAsHtml(fragment) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testGetAsTable)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    ASSERT_TRUE( c.SetText("name\tqty\r\napple\t3\r\n") );
+
+    Table table;
+    ASSERT_TRUE( c.GetAsTable(table, '\t') );
+    ASSERT_EQ(2, table.GetRowCount());
+    ASSERT_EQ(2, table.GetCellCount(1));
+
+    std::string value;
+    ASSERT_TRUE( table.GetCellValue(1, 0, value) );
+    ASSERT_EQ(std::string("apple"), value);
+
+    c.Empty();
+    ASSERT_FALSE( c.GetAsTable(table, '\t') );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testStats)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    c.ResetStats();
+    ASSERT_TRUE( c.SetText("stats") );
+    std::string text;
+    ASSERT_TRUE( c.GetAsText(text) );
+    ASSERT_FALSE( c.GetAsHtml(text) );
+
+    ClipboardStats stats;
+    c.GetStats(stats);
+    if (!StatsRecorder::IsEnabled())
+    {
+      ASSERT_EQ(0, stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindText).calls);
+      return;
+    }
+
+    const OperationStats & set = stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindText);
+    ASSERT_EQ(1, set.calls);
+    ASSERT_EQ(0, set.failures);
+    ASSERT_EQ(6, set.bytes); //including the \0 character
+    ASSERT_EQ(1, set.latency.count);
+
+    const OperationStats & get = stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindText);
+    ASSERT_EQ(1, get.calls);
+    ASSERT_EQ(6, get.bytes);
+
+    const OperationStats & html = stats.Get(ClipboardStats::OperationGet, ClipboardStats::KindHtml);
+    ASSERT_EQ(1, html.calls);
+    ASSERT_EQ(1, html.failures);
+
+    ASSERT_EQ(3, stats.opens + stats.open_failures);
+
+    c.ResetStats();
+    c.GetStats(stats);
+    ASSERT_EQ(0, stats.Get(ClipboardStats::OperationSet, ClipboardStats::KindText).calls);
+    ASSERT_EQ(0, stats.opens);
+  }
+  //--------------------------------------------------------------------------------------------------
   TEST_F(TestWin32Clipboard, testDragDropFiles)
   {
     Clipboard & c = Clipboard::GetInstance();
@@ -219,6 +511,91 @@ namespace win32clipboard { namespace test
     }
   }
   //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testDragDropFilesUtf8)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    //file paths longer than MAX_PATH with non-ascii characters
+    std::string long_path = "C:\\temp";
+    while (long_path.size() < 1000)
+      long_path += "\\\xC3\xA9" "cole";
+    long_path += "\\file.txt";
+
+    Clipboard::StringVector input_files;
+    input_files.push_back(long_path);
+    input_files.push_back("C:\\temp\\\xE2\x82\xAC.txt"); //euro sign
+
+    ASSERT_TRUE( c.SetDragDropFiles(Clipboard::DragDropCut, input_files) );
+
+    Clipboard::DragDropType output_type;
+    DropFileList output_files;
+    ASSERT_TRUE( c.GetAsDragDropFiles(output_type, output_files) );
+    ASSERT_EQ( (int)Clipboard::DragDropCut, (int)output_type );
+
+    ASSERT_EQ( input_files.size(), output_files.GetCount() );
+    for(size_t i=0; i<input_files.size(); i++)
+    {
+      ASSERT_EQ( input_files[i], output_files.GetPath(i) );
+    }
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testSetGetImage)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    Image input;
+    input.Create(33, 17);
+    for(size_t i=0; i<33*17*4; i++)
+      input.GetPixels()[i] = (unsigned char)(i%251);
+
+    ASSERT_TRUE( c.SetImage(input) );
+    ASSERT_TRUE( c.Contains(Clipboard::FormatImage) );
+
+    Image output;
+    ASSERT_TRUE( c.GetAsImage(output) );
+    ASSERT_EQ( input.GetWidth(), output.GetWidth() );
+    ASSERT_EQ( input.GetHeight(), output.GetHeight() );
+    ASSERT_EQ( 0, memcmp(input.GetPixels(), output.GetPixels(), 33*17*4) );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testHash)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    static const std::string SAMPLE_TEXT = "hash me";
+    ASSERT_TRUE( c.SetText(SAMPLE_TEXT) );
+
+    uint64_t hash = 0;
+    ASSERT_TRUE( c.Hash(Clipboard::FormatText, hash) );
+    ASSERT_EQ( hash64(SAMPLE_TEXT.data(), SAMPLE_TEXT.size()), hash );
+
+    //format not available
+    ASSERT_FALSE( c.Hash(Clipboard::FormatBinary, hash) );
+
+    Clipboard::MemoryBuffer buffer(1000, 'a');
+    ASSERT_TRUE( c.SetBinary(buffer) );
+    ASSERT_TRUE( c.Hash(Clipboard::FormatBinary, hash) );
+    ASSERT_EQ( hash64(buffer.data(), buffer.size()), hash );
+  }
+  //--------------------------------------------------------------------------------------------------
+  TEST_F(TestWin32Clipboard, testFingerprint)
+  {
+    Clipboard & c = Clipboard::GetInstance();
+
+    uint64_t fingerprint1 = 0;
+    uint64_t fingerprint2 = 0;
+    uint64_t fingerprint3 = 0;
+
+    ASSERT_TRUE( c.SetText("foo") );
+    ASSERT_TRUE( c.GetFingerprint(fingerprint1) );
+    ASSERT_TRUE( c.GetFingerprint(fingerprint2) );
+    ASSERT_EQ( fingerprint1, fingerprint2 );
+
+    ASSERT_TRUE( c.SetText("bar") );
+    ASSERT_TRUE( c.GetFingerprint(fingerprint3) );
+    ASSERT_NE( fingerprint1, fingerprint3 );
+  }
+  //--------------------------------------------------------------------------------------------------
  
 } //namespace test
 } //namespace win32clipboard